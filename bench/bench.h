@@ -0,0 +1,58 @@
+/******************************************************************************
+    clist_bench shared helpers: timing, allocation counting, CSV reporting
+******************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* one measured region, see BenchStart/BenchStop */
+typedef struct BenchMark {
+
+	double		dStartNs;
+	long long	nStartAllocs;
+	long long	nStartFrees;
+
+} BenchMark;
+
+/* CSV header matching the rows written by BenchStop */
+void BenchPrintHeader(void);
+
+/* monotonic clock in nanoseconds */
+double BenchNowNs(void);
+
+/* allocator calls made by the calling thread, -1 if not counted */
+long long BenchAllocCount(void);
+long long BenchFreeCount(void);
+
+/* current and peak resident set size in kB, -1 if unknown */
+long BenchRssKb(void);
+long BenchPeakRssKb(void);
+
+void BenchStart(BenchMark *pMark);
+void BenchStop(const BenchMark *pMark, const char *pszImpl, const char *pszOp,
+		long nSize, int nPayload, long nOps);
+
+/* FindIndex cases: number of lookups for a list of nSize elements, bounded
+ * so the total walk stays around 1e8 steps, and the index of lookup i */
+long BenchFindIndexQueries(long nSize);
+long BenchQueryIndex(long i, long nSize);
+
+/* step through 0..nSize-1 in scattered order: (i * stride) % nSize */
+long BenchCoprimeStride(long nSize);
+
+/* keeps traversal results alive without the optimizer dropping the loop */
+extern volatile unsigned long g_nBenchSink;
+
+/* std::list, std::deque and array baselines, bench_baseline.cpp.
+ * Returns -1 if nPayload has no compiled-in record type. */
+int BenchRunBaselines(long nSize, int nPayload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
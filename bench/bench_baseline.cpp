@@ -0,0 +1,262 @@
+/******************************************************************************
+    clist_bench baselines: the same operations on std::list, std::deque and a
+    growable array (std::vector) holding fixed-size records
+******************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <new>
+#include <vector>
+
+#include "bench.h"
+
+/*-----------------------------------------------------------------------------
+ * route operator new/delete through malloc/free so the allocator wrappers in
+ * bench_util.c count container allocations as well
+ * --------------------------------------------------------------------------*/
+void *operator new(std::size_t nSize) {
+
+	void *p = std::malloc(nSize != 0 ? nSize : 1);
+
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+
+	std::free(p);
+}
+
+namespace {
+
+template <std::size_t N>
+struct Record {
+
+	unsigned char	data[N];
+};
+
+template <std::size_t N>
+void BenchStdList(long nSize, int nPayload) {
+
+	typedef std::list< Record<N> > List;
+
+	const char	*pszImpl = "std_list";
+	List		list;
+	Record<N>	record;
+	BenchMark	mark;
+	unsigned long nSum = 0;
+	long		i;
+
+	std::memset(&record, 0, sizeof(record));
+	record.data[0] = 1;
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		list.push_back(record);
+	BenchStop(&mark, pszImpl, "add_tail", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (typename List::iterator it = list.begin(); it != list.end(); ++it)
+		nSum += it->data[0];
+	BenchStop(&mark, pszImpl, "traverse_next", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (typename List::reverse_iterator it = list.rbegin(); it != list.rend(); ++it)
+		nSum += it->data[0];
+	BenchStop(&mark, pszImpl, "traverse_prev", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+
+	long nQueries = BenchFindIndexQueries(nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nQueries; i++) {
+		typename List::iterator it = list.begin();
+		std::advance(it, BenchQueryIndex(i, nSize));
+		g_nBenchSink += it->data[0];
+	}
+	BenchStop(&mark, pszImpl, "find_index", nSize, nPayload, nQueries);
+
+	BenchStart(&mark);
+	list.clear();
+	BenchStop(&mark, pszImpl, "remove_all", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		list.push_front(record);
+	BenchStop(&mark, pszImpl, "add_head", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		list.pop_front();
+	BenchStop(&mark, pszImpl, "remove_head", nSize, nPayload, nSize);
+
+	for (i = 0; i < nSize; i++)
+		list.push_back(record);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		list.pop_back();
+	BenchStop(&mark, pszImpl, "remove_tail", nSize, nPayload, nSize);
+
+	std::vector<typename List::iterator> positions;
+	positions.reserve((std::size_t)nSize);
+	for (i = 0; i < nSize; i++)
+		positions.push_back(list.insert(list.end(), record));
+
+	long nStride = BenchCoprimeStride(nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		list.erase(positions[(std::size_t)((i * nStride) % nSize)]);
+	BenchStop(&mark, pszImpl, "remove_at", nSize, nPayload, nSize);
+}
+
+template <std::size_t N>
+void BenchStdDeque(long nSize, int nPayload) {
+
+	typedef std::deque< Record<N> > Deque;
+
+	const char	*pszImpl = "std_deque";
+	Deque		deque;
+	Record<N>	record;
+	BenchMark	mark;
+	unsigned long nSum = 0;
+	long		i;
+
+	std::memset(&record, 0, sizeof(record));
+	record.data[0] = 1;
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		deque.push_back(record);
+	BenchStop(&mark, pszImpl, "add_tail", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (typename Deque::iterator it = deque.begin(); it != deque.end(); ++it)
+		nSum += it->data[0];
+	BenchStop(&mark, pszImpl, "traverse_next", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (typename Deque::reverse_iterator it = deque.rbegin(); it != deque.rend(); ++it)
+		nSum += it->data[0];
+	BenchStop(&mark, pszImpl, "traverse_prev", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+
+	long nQueries = BenchFindIndexQueries(nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nQueries; i++)
+		g_nBenchSink += deque[(std::size_t)BenchQueryIndex(i, nSize)].data[0];
+	BenchStop(&mark, pszImpl, "find_index", nSize, nPayload, nQueries);
+
+	BenchStart(&mark);
+	deque.clear();
+	BenchStop(&mark, pszImpl, "remove_all", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		deque.push_front(record);
+	BenchStop(&mark, pszImpl, "add_head", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		deque.pop_front();
+	BenchStop(&mark, pszImpl, "remove_head", nSize, nPayload, nSize);
+
+	for (i = 0; i < nSize; i++)
+		deque.push_back(record);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		deque.pop_back();
+	BenchStop(&mark, pszImpl, "remove_tail", nSize, nPayload, nSize);
+}
+
+/* contiguous growable array: only the operations it supports cheaply */
+template <std::size_t N>
+void BenchArray(long nSize, int nPayload) {
+
+	typedef std::vector< Record<N> > Array;
+
+	const char	*pszImpl = "array";
+	Array		array;
+	Record<N>	record;
+	BenchMark	mark;
+	unsigned long nSum = 0;
+	long		i;
+
+	std::memset(&record, 0, sizeof(record));
+	record.data[0] = 1;
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		array.push_back(record);
+	BenchStop(&mark, pszImpl, "add_tail", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		nSum += array[(std::size_t)i].data[0];
+	BenchStop(&mark, pszImpl, "traverse_next", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = nSize - 1; i >= 0; i--)
+		nSum += array[(std::size_t)i].data[0];
+	BenchStop(&mark, pszImpl, "traverse_prev", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+
+	long nQueries = BenchFindIndexQueries(nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nQueries; i++)
+		g_nBenchSink += array[(std::size_t)BenchQueryIndex(i, nSize)].data[0];
+	BenchStop(&mark, pszImpl, "find_index", nSize, nPayload, nQueries);
+
+	BenchStart(&mark);
+	array.clear();
+	BenchStop(&mark, pszImpl, "remove_all", nSize, nPayload, nSize);
+
+	for (i = 0; i < nSize; i++)
+		array.push_back(record);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		array.pop_back();
+	BenchStop(&mark, pszImpl, "remove_tail", nSize, nPayload, nSize);
+}
+
+template <std::size_t N>
+void BenchAll(long nSize, int nPayload) {
+
+	BenchStdList<N>(nSize, nPayload);
+	BenchStdDeque<N>(nSize, nPayload);
+	BenchArray<N>(nSize, nPayload);
+}
+
+} /* namespace */
+
+extern "C" int BenchRunBaselines(long nSize, int nPayload) {
+
+	switch (nPayload) {
+	case 8:		BenchAll<8>(nSize, nPayload);		break;
+	case 16:	BenchAll<16>(nSize, nPayload);		break;
+	case 32:	BenchAll<32>(nSize, nPayload);		break;
+	case 64:	BenchAll<64>(nSize, nPayload);		break;
+	case 128:	BenchAll<128>(nSize, nPayload);		break;
+	case 256:	BenchAll<256>(nSize, nPayload);		break;
+	case 512:	BenchAll<512>(nSize, nPayload);		break;
+	case 1024:	BenchAll<1024>(nSize, nPayload);	break;
+	default:
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,202 @@
+/******************************************************************************
+    CList benchmark body, included by clist_bench.c once per call style.
+
+    Before including define:
+    	BENCH_CASE    name of the generated function
+    	BENCH_OP(op)  how an operation is called, e.g. List##op for the
+    	              direct-call API or list.pOps->op for the table
+    	BENCH_FOR_EACH  defined to also time ListForEach
+******************************************************************************/
+
+static void BENCH_CASE(const char *pszImpl, BenchInitFn pfnInit, long nSize,
+		int nPayload, const void *pRecord) {
+
+	CList		list;
+	BenchMark	mark;
+	POSITION	pos;
+	POSITION	*pPositions;
+	void		*apData[BENCH_TRAVERSE_BATCH];
+	unsigned char	*pRecords;
+	unsigned long nSum;
+	long		i;
+	long		nQueries;
+	long		nStride;
+	int			nKey;
+	int			nGot;
+
+	if (pfnInit(&list, nPayload, nSize) != 0) {
+		fprintf(stderr, "%s: init failed\n", pszImpl);
+		return;
+	}
+
+	/* fill from the tail, then walk the list both ways */
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		BENCH_OP(AddTail)(&list, pRecord);
+	BenchStop(&mark, pszImpl, "add_tail", nSize, nPayload, nSize);
+
+	nSum = 0;
+	BenchStart(&mark);
+	pos = BENCH_OP(GetHeadPosition)(&list);
+	while (pos != NULL)
+		nSum += *(const unsigned char *)BENCH_OP(GetNext)(&list, &pos);
+	BenchStop(&mark, pszImpl, "traverse_next", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	pos = BENCH_OP(GetTailPosition)(&list);
+	while (pos != NULL)
+		nSum += *(const unsigned char *)BENCH_OP(GetPrev)(&list, &pos);
+	BenchStop(&mark, pszImpl, "traverse_prev", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	pos = BENCH_OP(GetHeadPosition)(&list);
+	while ((nGot = BENCH_OP(GetNextBatch)(&list, &pos, apData, BENCH_TRAVERSE_BATCH)) > 0) {
+		for (i = 0; i < nGot; i++)
+			nSum += *(const unsigned char *)apData[i];
+	}
+	BenchStop(&mark, pszImpl, "traverse_batch", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+
+#ifdef BENCH_FOR_EACH
+	nSum = 0;
+	BenchStart(&mark);
+	ListForEach(&list, BenchSumFirstByte, &nSum);
+	BenchStop(&mark, pszImpl, "traverse_for_each", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+#endif
+
+	nQueries = BenchFindIndexQueries(nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nQueries; i++) {
+		pos = BENCH_OP(FindIndex)(&list, (int)BenchQueryIndex(i, nSize));
+		g_nBenchSink += (unsigned long)(size_t)pos;
+	}
+	BenchStop(&mark, pszImpl, "find_index", nSize, nPayload, nQueries);
+
+	/* for (i = 0; i < n; i++) FindIndex(i), as reporting loops do */
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++) {
+		pos = BENCH_OP(FindIndex)(&list, (int)i);
+		g_nBenchSink += (unsigned long)(size_t)pos;
+	}
+	BenchStop(&mark, pszImpl, "find_index_seq", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	BENCH_OP(RemoveAll)(&list);
+	BenchStop(&mark, pszImpl, "remove_all", nSize, nPayload, nSize);
+
+	/* head and tail churn */
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		BENCH_OP(AddHead)(&list, pRecord);
+	BenchStop(&mark, pszImpl, "add_head", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		BENCH_OP(RemoveHead)(&list);
+	BenchStop(&mark, pszImpl, "remove_head", nSize, nPayload, nSize);
+
+	for (i = 0; i < nSize; i++)
+		BENCH_OP(AddTail)(&list, pRecord);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		BENCH_OP(RemoveTail)(&list);
+	BenchStop(&mark, pszImpl, "remove_tail", nSize, nPayload, nSize);
+
+	/* queue use: AddTail + RemoveHead around a short backlog */
+	for (i = 0; i < BENCH_FIFO_DEPTH; i++)
+		BENCH_OP(AddTail)(&list, pRecord);
+
+	nSum = 0;
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++) {
+		BENCH_OP(AddTail)(&list, pRecord);
+		nSum += *(const unsigned char *)BENCH_OP(GetHead)(&list);
+		BENCH_OP(RemoveHead)(&list);
+	}
+	BenchStop(&mark, pszImpl, "fifo", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+
+	BENCH_OP(RemoveAll)(&list);
+
+	/* remove by position in scattered order; only node storage keeps
+	   positions valid across RemoveAt */
+	pPositions = NULL;
+	if (LIST_IS_NODE_STORAGE(&list))
+		pPositions = (POSITION *)malloc(sizeof(POSITION) * (size_t)nSize);
+	if (pPositions != NULL) {
+
+		for (i = 0; i < nSize; i++)
+			pPositions[i] = BENCH_OP(AddTail)(&list, pRecord);
+
+		nStride = BenchCoprimeStride(nSize);
+
+		BenchStart(&mark);
+		for (i = 0; i < nSize; i++)
+			BENCH_OP(RemoveAt)(&list, pPositions[(i * nStride) % nSize]);
+		BenchStop(&mark, pszImpl, "remove_at", nSize, nPayload, nSize);
+
+		free(pPositions);
+	}
+
+	/* bulk fill and drain, BENCH_BATCH_RECORDS records per call */
+	pRecords = BenchMakeRecords(pRecord, nPayload, BENCH_BATCH_RECORDS);
+	if (pRecords != NULL) {
+
+		BENCH_OP(RemoveAll)(&list);
+
+		BenchStart(&mark);
+		for (i = 0; i < nSize; i += BENCH_BATCH_RECORDS)
+			ListAddTailBatch(&list, pRecords, (int)BenchMin(nSize - i, BENCH_BATCH_RECORDS));
+		BenchStop(&mark, pszImpl, "add_tail_batch", nSize, nPayload, nSize);
+
+		BenchStart(&mark);
+		for (i = 0; i < nSize; i += BENCH_BATCH_RECORDS)
+			ListRemoveHeadN(&list, BENCH_BATCH_RECORDS);
+		BenchStop(&mark, pszImpl, "remove_head_n", nSize, nPayload, nSize);
+
+		free(pRecords);
+	}
+
+	/* lookup by content; every record carries its index as an int key */
+	pRecords = (unsigned char *)malloc((size_t)nPayload);
+	if (pRecords != NULL && nPayload >= (int)sizeof(int)) {
+
+		BENCH_OP(RemoveAll)(&list);
+		memcpy(pRecords, pRecord, (size_t)nPayload);
+
+		for (i = 0; i < nSize; i++) {
+			nKey = (int)i;
+			memcpy(pRecords, &nKey, sizeof(int));
+			BENCH_OP(AddTail)(&list, pRecords);
+		}
+
+		nQueries = BenchFindIndexQueries(nSize);
+
+		BenchStart(&mark);
+		for (i = 0; i < nQueries; i++) {
+			nKey = (int)BenchQueryIndex(i, nSize);
+			pos = ListFind(&list, &nKey, BenchCompareKey, NULL);
+			g_nBenchSink += (unsigned long)(size_t)pos;
+		}
+		BenchStop(&mark, pszImpl, "find", nSize, nPayload, nQueries);
+
+		if (list.pHash != NULL) {
+
+			nStride = BenchCoprimeStride(nSize);
+
+			BenchStart(&mark);
+			for (i = 0; i < nSize; i++) {
+				nKey = (int)((i * nStride) % nSize);
+				pos = ListFindKey(&list, &nKey);
+				g_nBenchSink += (unsigned long)(size_t)pos;
+			}
+			BenchStop(&mark, pszImpl, "find_key", nSize, nPayload, nSize);
+		}
+	}
+	free(pRecords);
+
+	DestroyList(&list);
+}
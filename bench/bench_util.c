@@ -0,0 +1,199 @@
+/******************************************************************************
+    clist_bench shared helpers: timing, allocation counting, CSV reporting
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "bench.h"
+
+/* FindIndex: at most this many lookups and list steps per case */
+#define BENCH_FIND_INDEX_QUERIES	1000L
+#define BENCH_FIND_INDEX_STEPS		100000000L
+
+volatile unsigned long g_nBenchSink;
+
+/*-----------------------------------------------------------------------------
+ * allocation counting. The build links clist_bench with --wrap for the
+ * allocator entry points, so every call from the library, the benchmark and
+ * the C++ baselines passes through here.
+ * --------------------------------------------------------------------------*/
+#ifdef BENCH_WRAP_MALLOC
+
+static _Thread_local long long s_nAllocs;
+static _Thread_local long long s_nFrees;
+
+void *__real_malloc(size_t nSize);
+void *__real_calloc(size_t nMemb, size_t nSize);
+void *__real_realloc(void *p, size_t nSize);
+void *__real_aligned_alloc(size_t nAlign, size_t nSize);
+int __real_posix_memalign(void **pp, size_t nAlign, size_t nSize);
+void __real_free(void *p);
+
+void *__wrap_malloc(size_t nSize) {
+
+	s_nAllocs++;
+	return __real_malloc(nSize);
+}
+
+void *__wrap_calloc(size_t nMemb, size_t nSize) {
+
+	s_nAllocs++;
+	return __real_calloc(nMemb, nSize);
+}
+
+void *__wrap_realloc(void *p, size_t nSize) {
+
+	s_nAllocs++;
+	return __real_realloc(p, nSize);
+}
+
+void *__wrap_aligned_alloc(size_t nAlign, size_t nSize) {
+
+	s_nAllocs++;
+	return __real_aligned_alloc(nAlign, nSize);
+}
+
+int __wrap_posix_memalign(void **pp, size_t nAlign, size_t nSize) {
+
+	s_nAllocs++;
+	return __real_posix_memalign(pp, nAlign, nSize);
+}
+
+void __wrap_free(void *p) {
+
+	if (p != NULL)
+		s_nFrees++;
+	__real_free(p);
+}
+
+long long BenchAllocCount(void) {
+
+	return s_nAllocs;
+}
+
+long long BenchFreeCount(void) {
+
+	return s_nFrees;
+}
+
+#else
+
+long long BenchAllocCount(void) {
+
+	return -1;
+}
+
+long long BenchFreeCount(void) {
+
+	return -1;
+}
+
+#endif
+
+double BenchNowNs(void) {
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+long BenchRssKb(void) {
+
+	FILE *fp;
+	long nPages = -1;
+	long nResident = -1;
+
+	fp = fopen("/proc/self/statm", "r");
+	if (fp == NULL)
+		return -1;
+
+	if (fscanf(fp, "%ld %ld", &nPages, &nResident) != 2)
+		nResident = -1;
+	fclose(fp);
+
+	if (nResident < 0)
+		return -1;
+
+	return nResident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+long BenchPeakRssKb(void) {
+
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+		return -1;
+
+	/* kilobytes on Linux */
+	return ru.ru_maxrss;
+}
+
+void BenchPrintHeader(void) {
+
+	printf("impl,op,n,payload,ns_per_op,allocs_per_op,frees_per_op,rss_kb,peak_rss_kb\n");
+}
+
+void BenchStart(BenchMark *pMark) {
+
+	pMark->nStartAllocs = BenchAllocCount();
+	pMark->nStartFrees = BenchFreeCount();
+	pMark->dStartNs = BenchNowNs();
+}
+
+void BenchStop(const BenchMark *pMark, const char *pszImpl, const char *pszOp,
+		long nSize, int nPayload, long nOps) {
+
+	double dElapsed = BenchNowNs() - pMark->dStartNs;
+	long long nAllocs = BenchAllocCount();
+	long long nFrees = BenchFreeCount();
+	double dOps = (nOps > 0) ? (double)nOps : 1.0;
+
+	printf("%s,%s,%ld,%d,%.2f,%.3f,%.3f,%ld,%ld\n",
+			pszImpl, pszOp, nSize, nPayload, dElapsed / dOps,
+			(nAllocs < 0) ? -1.0 : (double)(nAllocs - pMark->nStartAllocs) / dOps,
+			(nFrees < 0) ? -1.0 : (double)(nFrees - pMark->nStartFrees) / dOps,
+			BenchRssKb(), BenchPeakRssKb());
+}
+
+long BenchFindIndexQueries(long nSize) {
+
+	long nQueries = BENCH_FIND_INDEX_STEPS / nSize;
+
+	if (nQueries < 1)
+		nQueries = 1;
+	if (nQueries > BENCH_FIND_INDEX_QUERIES)
+		nQueries = BENCH_FIND_INDEX_QUERIES;
+
+	return nQueries;
+}
+
+long BenchQueryIndex(long i, long nSize) {
+
+	return (i * 7919 + nSize / 3) % nSize;
+}
+
+long BenchCoprimeStride(long nSize) {
+
+	long nStride = 1000003L;
+	long a, b, t;
+
+	for (;;) {
+		a = nStride;
+		b = nSize;
+		while (b != 0) {
+			t = a % b;
+			a = b;
+			b = t;
+		}
+		if (a == 1)
+			return nStride % nSize;
+		nStride += 2;
+	}
+}
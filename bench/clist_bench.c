@@ -0,0 +1,626 @@
+/******************************************************************************
+    clist_bench: times CList operations over a range of list and payload
+    sizes and prints one CSV row per (implementation, operation, size).
+
+    usage: clist_bench [-n max_elements] [-p payload[,payload...]]
+                       [-m max_megabytes]
+
+    Built with -DCLIST_STATS=ON it also writes the global list counters to
+    stderr when done.
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "list_lru.h"
+#include "list_intrusive.h"
+#include "list_alloc.h"
+#include "list_typed.h"
+#include "bench.h"
+
+/* list sizes 1e3 .. 1e7 */
+#define BENCH_MIN_SIZE				1000L
+#define BENCH_MAX_SIZE				10000000L
+
+/* rough per-element overhead used to skip cases beyond the memory budget */
+#define BENCH_ELEM_OVERHEAD			48L
+
+#define BENCH_MAX_PAYLOADS			16
+
+/* records per ListAddTailBatch / ListRemoveHeadN call */
+#define BENCH_BATCH_RECORDS			1024L
+
+/* elements queued ahead of the fifo case's AddTail/RemoveHead pairs */
+#define BENCH_FIFO_DEPTH			256L
+
+/* payload pointers per GetNextBatch call of the traverse_batch case */
+#define BENCH_TRAVERSE_BATCH		64
+
+typedef int (*BenchInitFn)(CList *pList, int nPayload, long nSize);
+
+static long BenchMin(long a, long b) {
+
+	return (a < b) ? a : b;
+}
+
+/* nRecords copies of pRecord back to back */
+static unsigned char* BenchMakeRecords(const void *pRecord, int nPayload, long nRecords) {
+
+	unsigned char *pRecords;
+	long i;
+
+	pRecords = (unsigned char *)malloc((size_t)nPayload * (size_t)nRecords);
+	if (pRecords == NULL)
+		return NULL;
+
+	for (i = 0; i < nRecords; i++)
+		memcpy(pRecords + i * nPayload, pRecord, (size_t)nPayload);
+
+	return pRecords;
+}
+
+/* ListFind comparator: the int key at the start of a record */
+static int BenchCompareKey(const void *pKey, const void *pData) {
+
+	return memcmp(pKey, pData, sizeof(int));
+}
+
+/* ListForEach visitor, the same work as the traverse_next loop */
+static void BenchSumFirstByte(void *pData, void *pContext) {
+
+	*(unsigned long *)pContext += *(const unsigned char *)pData;
+}
+
+/* CList operations through the shared operation table */
+#define BENCH_CASE		BenchCListOps
+#define BENCH_OP(op)	list.pOps->op
+#include "bench_clist_case.h"
+#undef BENCH_CASE
+#undef BENCH_OP
+
+/* CList operations through the inline direct-call API */
+#define BENCH_CASE		BenchCListDirect
+#define BENCH_OP(op)	List##op
+#define BENCH_FOR_EACH
+#include "bench_clist_case.h"
+#undef BENCH_CASE
+#undef BENCH_OP
+#undef BENCH_FOR_EACH
+
+static int BenchInitDefault(CList *pList, int nPayload, long nSize) {
+
+	(void)nSize;
+
+	InitList(pList, nPayload);
+	return 0;
+}
+
+static int BenchInitPool(CList *pList, int nPayload, long nSize) {
+
+	return InitListWithCapacity(pList, nPayload, (int)nSize);
+}
+
+static int BenchInitIndexed(CList *pList, int nPayload, long nSize) {
+
+	(void)nSize;
+
+	InitList(pList, nPayload);
+	return ListEnableIndex(pList);
+}
+
+static int BenchInitHashed(CList *pList, int nPayload, long nSize) {
+
+	(void)nSize;
+
+	InitList(pList, nPayload);
+	return ListEnableHashIndex(pList, 0, (int)sizeof(int), NULL);
+}
+
+static int BenchInitChunk(CList *pList, int nPayload, long nSize) {
+
+	(void)nSize;
+
+	return InitListStorage(pList, nPayload, LIST_STORAGE_CHUNK);
+}
+
+static int BenchInitRing(CList *pList, int nPayload, long nSize) {
+
+	(void)nSize;
+
+	return InitListStorage(pList, nPayload, LIST_STORAGE_RING);
+}
+
+static int BenchInitDeque(CList *pList, int nPayload, long nSize) {
+
+	(void)nSize;
+
+	return InitListStorage(pList, nPayload, LIST_STORAGE_DEQUE);
+}
+
+static int BenchInitCompact(CList *pList, int nPayload, long nSize) {
+
+	return InitListCompact(pList, nPayload, (int)nSize);
+}
+
+/* LRU promotion: the cache against GetAt + AddHead + RemoveAt on a keyed
+ * list, the copying idiom it replaces. Records carry an int key first. */
+static void BenchLru(long nSize, int nPayload, const void *pRecord) {
+
+	CListLru	lru;
+	CList		list;
+	BenchMark	mark;
+	POSITION	pos;
+	unsigned char	*pEntry;
+	long		nStride;
+	long		i;
+	int			nKey;
+
+	pEntry = (unsigned char *)malloc((size_t)nPayload);
+	if (pEntry == NULL || nPayload < (int)sizeof(int) ||
+			InitListLru(&lru, nPayload, 0, (int)sizeof(int), (int)nSize, NULL) != 0) {
+		free(pEntry);
+		return;
+	}
+
+	memcpy(pEntry, pRecord, (size_t)nPayload);
+	nStride = BenchCoprimeStride(nSize);
+
+	for (i = 0; i < nSize; i++) {
+		nKey = (int)i;
+		memcpy(pEntry, &nKey, sizeof(int));
+		ListLruPut(&lru, pEntry, NULL);
+	}
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++) {
+		nKey = (int)((i * nStride) % nSize);
+		g_nBenchSink += (unsigned long)(size_t)ListLruGet(&lru, &nKey);
+	}
+	BenchStop(&mark, "clist_lru", "lru_get_hit", nSize, nPayload, nSize);
+
+	/* every key is new, so each Put evicts the tail */
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++) {
+		nKey = (int)(nSize + i);
+		memcpy(pEntry, &nKey, sizeof(int));
+		ListLruPut(&lru, pEntry, NULL);
+	}
+	BenchStop(&mark, "clist_lru", "lru_put_evict", nSize, nPayload, nSize);
+
+	DestroyListLru(&lru);
+
+	InitList(&list, nPayload);
+	if (ListEnableHashIndex(&list, 0, (int)sizeof(int), NULL) == 0) {
+
+		for (i = 0; i < nSize; i++) {
+			nKey = (int)i;
+			memcpy(pEntry, &nKey, sizeof(int));
+			ListAddTail(&list, pEntry);
+		}
+
+		BenchStart(&mark);
+		for (i = 0; i < nSize; i++) {
+			nKey = (int)((i * nStride) % nSize);
+			pos = ListFindKey(&list, &nKey);
+			memcpy(pEntry, ListGetAt(&list, pos), (size_t)nPayload);
+			ListRemoveAt(&list, pos);
+			ListAddHead(&list, pEntry);
+		}
+		BenchStop(&mark, "clist_hashed", "lru_get_hit", nSize, nPayload, nSize);
+	}
+	DestroyList(&list);
+
+	free(pEntry);
+}
+
+/* intrusive list over caller-owned objects: a CListLink followed by the
+ * payload, all of them in one array allocated up front */
+static void BenchIntrusive(long nSize, int nPayload, const void *pRecord) {
+
+	CListIntrusive	list;
+	BenchMark		mark;
+	CListLink		*pLink;
+	unsigned char	*pObjects;
+	size_t			nObjSize;
+	unsigned long	nSum;
+	long			nStride;
+	long			i;
+
+	nObjSize = sizeof(CListLink) + ((size_t)nPayload + sizeof(void *) - 1) /
+		sizeof(void *) * sizeof(void *);
+	pObjects = (unsigned char *)malloc(nObjSize * (size_t)nSize);
+	if (pObjects == NULL)
+		return;
+
+	for (i = 0; i < nSize; i++)
+		memcpy(pObjects + i * nObjSize + sizeof(CListLink), pRecord, (size_t)nPayload);
+
+#define BENCH_OBJ_LINK(i)	((CListLink *)(void *)(pObjects + (i) * nObjSize))
+
+	InitListIntrusive(&list);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		ListIntrusiveAddTail(&list, BENCH_OBJ_LINK(i));
+	BenchStop(&mark, "clist_intrusive", "add_tail", nSize, nPayload, nSize);
+
+	nSum = 0;
+	BenchStart(&mark);
+	pLink = ListIntrusiveGetHeadPosition(&list);
+	while (pLink != NULL)
+		nSum += *((const unsigned char *)ListIntrusiveGetNext(&list, &pLink) + sizeof(CListLink));
+	BenchStop(&mark, "clist_intrusive", "traverse_next", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+
+	nStride = BenchCoprimeStride(nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		ListIntrusiveRemoveAt(&list, BENCH_OBJ_LINK((i * nStride) % nSize));
+	BenchStop(&mark, "clist_intrusive", "remove_at", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		ListIntrusiveAddHead(&list, BENCH_OBJ_LINK(i));
+	BenchStop(&mark, "clist_intrusive", "add_head", nSize, nPayload, nSize);
+
+	BenchStart(&mark);
+	for (i = 0; i < nSize; i++)
+		ListIntrusiveRemoveHead(&list);
+	BenchStop(&mark, "clist_intrusive", "remove_head", nSize, nPayload, nSize);
+
+#undef BENCH_OBJ_LINK
+
+	free(pObjects);
+}
+
+/* snapshot restart: rebuild by AddTail per record, as from a text dump,
+ * against LoadList and the zero-copy mapped view, all from one file */
+static void BenchSnapshot(long nSize, int nPayload, const void *pRecord) {
+
+	CList		list;
+	CList		loaded;
+	BenchMark	mark;
+	POSITION	pos;
+	FILE		*pFile;
+	unsigned char	*pBuffer;
+	unsigned long	nSum;
+	long		i;
+	int			fd;
+
+	pFile = tmpfile();
+	pBuffer = (unsigned char *)malloc((size_t)nPayload);
+	if (pFile == NULL || pBuffer == NULL) {
+		if (pFile != NULL)
+			fclose(pFile);
+		free(pBuffer);
+		return;
+	}
+	fd = fileno(pFile);
+
+	InitList(&list, nPayload);
+	for (i = 0; i < nSize; i++)
+		ListAddTail(&list, pRecord);
+
+	BenchStart(&mark);
+	SaveList(&list, fd);
+	BenchStop(&mark, "clist", "snapshot_save", nSize, nPayload, nSize);
+
+	DestroyList(&list);
+
+	/* the old restart path: read the records one by one, AddTail each */
+	fseek(pFile, -(long)nSize * nPayload, SEEK_END);
+	BenchStart(&mark);
+	InitList(&loaded, nPayload);
+	for (i = 0; i < nSize && fread(pBuffer, (size_t)nPayload, 1, pFile) == 1; i++)
+		ListAddTail(&loaded, pBuffer);
+	BenchStop(&mark, "clist", "snapshot_add_tail", nSize, nPayload, nSize);
+	DestroyList(&loaded);
+
+	BenchStart(&mark);
+	InitList(&loaded, nPayload);
+	LoadList(&loaded, fd);
+	BenchStop(&mark, "clist", "snapshot_load", nSize, nPayload, nSize);
+	DestroyList(&loaded);
+
+	/* open the view and touch every payload once */
+	nSum = 0;
+	BenchStart(&mark);
+	if (InitListMapped(&loaded, fd) == 0) {
+		pos = ListGetHeadPosition(&loaded);
+		while (pos != NULL)
+			nSum += *(const unsigned char *)ListGetNext(&loaded, &pos);
+		DestroyList(&loaded);
+	}
+	BenchStop(&mark, "clist_mapped", "snapshot_traverse", nSize, nPayload, nSize);
+	g_nBenchSink += nSum;
+
+	fclose(pFile);
+	free(pBuffer);
+}
+
+/* node allocators: fill by AddTail, churn by RemoveHead + AddTail pairs,
+ * RemoveAll and, after a refill, DestroyList, with malloc, the bump arena,
+ * the fixed-size pool and a list's own arena (InitListWithArena). The
+ * destroy rows include releasing the arena's or pool's memory */
+static void BenchAllocators(long nSize, int nPayload, const void *pRecord) {
+
+	static const char * const apszImpl[] = {
+		"clist_malloc", "clist_arena", "clist_fixed_pool", "clist_list_arena"
+	};
+
+	CList			list;
+	CListArena		arena;
+	CListFixedPool	pool;
+	BenchMark		mark;
+	long			i;
+	int				nAllocator;
+
+	for (nAllocator = 0; nAllocator < 4; nAllocator++) {
+
+		if (nAllocator == 1) {
+			InitListArena(&arena, 0);
+			InitListWithAllocator(&list, nPayload, ListArenaAlloc, ListArenaFree, &arena);
+		}
+		else if (nAllocator == 2) {
+			InitListFixedPool(&pool, 0, 0);
+			InitListWithAllocator(&list, nPayload, ListFixedPoolAlloc, ListFixedPoolFree,
+					&pool);
+		}
+		else if (nAllocator == 3) {
+			InitListWithArena(&list, nPayload, 0);
+		}
+		else {
+			InitList(&list, nPayload);
+		}
+
+		BenchStart(&mark);
+		for (i = 0; i < nSize; i++)
+			ListAddTail(&list, pRecord);
+		BenchStop(&mark, apszImpl[nAllocator], "alloc_fill", nSize, nPayload, nSize);
+
+		BenchStart(&mark);
+		for (i = 0; i < nSize; i++) {
+			ListRemoveHead(&list);
+			ListAddTail(&list, pRecord);
+		}
+		BenchStop(&mark, apszImpl[nAllocator], "alloc_churn", nSize, nPayload, nSize);
+
+		BenchStart(&mark);
+		ListRemoveAll(&list);
+		BenchStop(&mark, apszImpl[nAllocator], "alloc_remove_all", nSize, nPayload, nSize);
+
+		for (i = 0; i < nSize; i++)
+			ListAddTail(&list, pRecord);
+
+		BenchStart(&mark);
+		DestroyList(&list);
+		if (nAllocator == 1)
+			DestroyListArena(&arena);
+		else if (nAllocator == 2)
+			DestroyListFixedPool(&pool);
+		BenchStop(&mark, apszImpl[nAllocator], "alloc_destroy", nSize, nPayload, nSize);
+	}
+}
+
+/* records of varying length, like log lines: lengths cycle through
+ * nPayload / 8 .. nPayload, averaging a bit over half of it. InitListSized
+ * allocates each node for its record, the fixed-size list takes nPayload
+ * bytes for every one. Built with -DCLIST_STATS=ON, held bytes of both are
+ * in ListGetStats. */
+static void BenchSized(long nSize, int nPayload, const void *pRecord) {
+
+	static const char * const apszImpl[] = { "clist_sized", "clist" };
+
+	CList		list;
+	BenchMark	mark;
+	POSITION	pos;
+	unsigned long	nSum;
+	long		i;
+	int			nMin = (nPayload >= 8) ? nPayload / 8 : 1;
+	int			nLength;
+	int			nImpl;
+
+	for (nImpl = 0; nImpl < 2; nImpl++) {
+
+		if (nImpl == 0)
+			InitListSized(&list, nPayload);
+		else
+			InitList(&list, nPayload);
+
+		BenchStart(&mark);
+		for (i = 0; i < nSize; i++) {
+			nLength = nMin + (int)((i * 7919) % (nPayload - nMin + 1));
+			ListAddTailSized(&list, pRecord, nLength);
+		}
+		BenchStop(&mark, apszImpl[nImpl], "sized_add_tail", nSize, nPayload, nSize);
+
+		nSum = 0;
+		BenchStart(&mark);
+		pos = ListGetHeadPosition(&list);
+		while (pos != NULL) {
+			nSum += *(const unsigned char *)ListGetAtSized(&list, pos, &nLength);
+			nSum += (unsigned long)nLength;
+			ListGetNext(&list, &pos);
+		}
+		BenchStop(&mark, apszImpl[nImpl], "sized_traverse", nSize, nPayload, nSize);
+		g_nBenchSink += nSum;
+
+		BenchStart(&mark);
+		DestroyList(&list);
+		BenchStop(&mark, apszImpl[nImpl], "sized_destroy", nSize, nPayload, nSize);
+	}
+}
+
+/* CLIST_DEFINE lists for the default payloads, the payload copies in them
+ * have a size known at compile time; other payloads have no typed row */
+#define BENCH_DEFINE_TYPED(nBytes) \
+	typedef struct BenchRecord##nBytes { \
+		unsigned char	data[nBytes]; \
+	} BenchRecord##nBytes; \
+	\
+	CLIST_DEFINE(BenchList##nBytes, BenchRecord##nBytes) \
+	\
+	static void BenchTyped##nBytes(long nSize, const void *pRecord) { \
+	\
+		BenchList##nBytes		list; \
+		BenchList##nBytes##Node	*pos; \
+		BenchRecord##nBytes		record; \
+		BenchMark		mark; \
+		unsigned long	nSum; \
+		long			i; \
+	\
+		memcpy(&record, pRecord, sizeof(record)); \
+		InitBenchList##nBytes(&list); \
+	\
+		BenchStart(&mark); \
+		for (i = 0; i < nSize; i++) \
+			BenchList##nBytes##AddTail(&list, &record); \
+		BenchStop(&mark, "clist_typed", "add_tail", nSize, nBytes, nSize); \
+	\
+		nSum = 0; \
+		BenchStart(&mark); \
+		pos = BenchList##nBytes##GetHeadPosition(&list); \
+		while (pos != NULL) \
+			nSum += BenchList##nBytes##GetNext(&list, &pos)->data[0]; \
+		BenchStop(&mark, "clist_typed", "traverse_next", nSize, nBytes, nSize); \
+		g_nBenchSink += nSum; \
+	\
+		BenchStart(&mark); \
+		for (i = 0; i < nSize; i++) \
+			BenchList##nBytes##RemoveHead(&list); \
+		BenchStop(&mark, "clist_typed", "remove_head", nSize, nBytes, nSize); \
+	\
+		BenchStart(&mark); \
+		for (i = 0; i < nSize; i++) \
+			BenchList##nBytes##AddHead(&list, &record); \
+		BenchStop(&mark, "clist_typed", "add_head", nSize, nBytes, nSize); \
+	\
+		BenchStart(&mark); \
+		DestroyBenchList##nBytes(&list); \
+		BenchStop(&mark, "clist_typed", "destroy", nSize, nBytes, nSize); \
+	}
+
+BENCH_DEFINE_TYPED(8)
+BENCH_DEFINE_TYPED(64)
+BENCH_DEFINE_TYPED(256)
+
+static void BenchTyped(long nSize, int nPayload, const void *pRecord) {
+
+	switch (nPayload) {
+	case 8:
+		BenchTyped8(nSize, pRecord);
+		break;
+	case 64:
+		BenchTyped64(nSize, pRecord);
+		break;
+	case 256:
+		BenchTyped256(nSize, pRecord);
+		break;
+	}
+}
+
+static int BenchParsePayloads(const char *pszArg, int *pnPayloads) {
+
+	int nPayloads = 0;
+	char *pszEnd;
+	long nValue;
+
+	while (*pszArg != '\0' && nPayloads < BENCH_MAX_PAYLOADS) {
+		nValue = strtol(pszArg, &pszEnd, 10);
+		if (pszEnd == pszArg || nValue <= 0)
+			return -1;
+		pnPayloads[nPayloads++] = (int)nValue;
+		pszArg = (*pszEnd == ',') ? pszEnd + 1 : pszEnd;
+	}
+
+	return nPayloads;
+}
+
+static void BenchUsage(const char *pszProg) {
+
+	fprintf(stderr, "usage: %s [-n max_elements] [-p payload[,payload...]] "
+			"[-m max_megabytes]\n", pszProg);
+}
+
+int main(int argc, char *argv[]) {
+
+	int			anPayloads[BENCH_MAX_PAYLOADS] = { 8, 64, 256 };
+	int			nPayloads = 3;
+	long		nMaxSize = BENCH_MAX_SIZE;
+	long		nMaxBytes = 1024L * 1024L * 1024L;
+	long		nSize;
+	int			i;
+	unsigned char	*pRecord;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			nMaxSize = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			nPayloads = BenchParsePayloads(argv[++i], anPayloads);
+			if (nPayloads <= 0) {
+				BenchUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+			nMaxBytes = atol(argv[++i]) * 1024L * 1024L;
+		}
+		else {
+			BenchUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	BenchPrintHeader();
+
+	for (i = 0; i < nPayloads; i++) {
+
+		pRecord = (unsigned char *)calloc(1, (size_t)anPayloads[i]);
+		if (pRecord == NULL)
+			return 1;
+		pRecord[0] = 1;
+
+		for (nSize = BENCH_MIN_SIZE; nSize <= nMaxSize; nSize *= 10) {
+
+			if (nSize * (anPayloads[i] + BENCH_ELEM_OVERHEAD) > nMaxBytes) {
+				fprintf(stderr, "skip n=%ld payload=%d: over memory budget\n",
+						nSize, anPayloads[i]);
+				continue;
+			}
+
+			BenchCListOps("clist", BenchInitDefault, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_direct", BenchInitDefault, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_pool", BenchInitPool, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_indexed", BenchInitIndexed, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_hashed", BenchInitHashed, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_chunk", BenchInitChunk, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_ring", BenchInitRing, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_deque", BenchInitDeque, nSize, anPayloads[i], pRecord);
+			BenchCListDirect("clist_compact", BenchInitCompact, nSize, anPayloads[i], pRecord);
+			BenchIntrusive(nSize, anPayloads[i], pRecord);
+			BenchLru(nSize, anPayloads[i], pRecord);
+			BenchSnapshot(nSize, anPayloads[i], pRecord);
+			BenchAllocators(nSize, anPayloads[i], pRecord);
+			BenchSized(nSize, anPayloads[i], pRecord);
+			BenchTyped(nSize, anPayloads[i], pRecord);
+
+			if (BenchRunBaselines(nSize, anPayloads[i]) != 0)
+				fprintf(stderr, "skip baselines for payload=%d\n", anPayloads[i]);
+
+			fflush(stdout);
+		}
+
+		free(pRecord);
+	}
+
+#ifdef CLIST_STATS
+	/* totals of every list the run created, the CSV stays on stdout */
+	ListDumpStats(stderr);
+#endif
+
+	return 0;
+}
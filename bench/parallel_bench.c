@@ -0,0 +1,198 @@
+/******************************************************************************
+    clist_parallel_bench: scaling of ListParallelForEach and
+    ListParallelReduce over 1, 2, 4, ... threads up to the core count.
+
+    uniform: every element costs the same number of mixing rounds.
+    skewed: the first tenth of the list costs 20 times as much, which a
+    static split into one range per thread would leave to one thread.
+
+    Each row reports time per element and the speedup over the same call
+    with one thread; the "serial" rows are a plain GetNext loop.
+
+    usage: clist_parallel_bench [-t max_threads] [-n elements] [-w rounds]
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "list.h"
+#include "bench.h"
+
+#define BENCH_PARALLEL_ELEMENTS		1000000L
+#define BENCH_PARALLEL_ROUNDS		64
+#define BENCH_PARALLEL_MAX_THREADS	64
+
+/* skewed workload: elements below nSize / BENCH_SKEW_PART cost more */
+#define BENCH_SKEW_PART				10
+#define BENCH_SKEW_FACTOR			20
+
+typedef struct BenchParallelWork {
+
+	int		nRounds;
+	long	nHeavyBelow;		/* elements with a key below cost more */
+
+} BenchParallelWork;
+
+/* a few rounds of integer mixing per element, the CPU-bound work */
+static unsigned long BenchMix(unsigned long nValue, int nRounds) {
+
+	int i;
+
+	for (i = 0; i < nRounds; i++) {
+		nValue ^= nValue >> 33;
+		nValue *= 0xff51afd7ed558ccdUL;
+		nValue ^= nValue >> 29;
+	}
+
+	return nValue;
+}
+
+static int BenchRounds(const BenchParallelWork *pWork, long nKey) {
+
+	return (nKey < pWork->nHeavyBelow) ?
+		pWork->nRounds * BENCH_SKEW_FACTOR : pWork->nRounds;
+}
+
+static void BenchVisit(void *pData, void *pContext) {
+
+	const BenchParallelWork *pWork = (const BenchParallelWork *)pContext;
+	long *pKey = (long *)pData;
+
+	pKey[1] = (long)BenchMix((unsigned long)pKey[0], BenchRounds(pWork, pKey[0]));
+}
+
+static void BenchReduce(void *pAccum, const void *pData, void *pContext) {
+
+	const BenchParallelWork *pWork = (const BenchParallelWork *)pContext;
+	const long *pKey = (const long *)pData;
+
+	*(unsigned long *)pAccum += BenchMix((unsigned long)pKey[0], BenchRounds(pWork, pKey[0]));
+}
+
+static void BenchCombine(void *pAccum, const void *pOther, void *pContext) {
+
+	(void)pContext;
+
+	*(unsigned long *)pAccum += *(const unsigned long *)pOther;
+}
+
+static void BenchReport(const char *pszImpl, const char *pszWorkload, int nThreads,
+		long nSize, double dNs, double dBaseNs) {
+
+	printf("%s,%s,%d,%ld,%.2f,%.2f\n", pszImpl, pszWorkload, nThreads, nSize,
+			dNs / (double)nSize, (dNs > 0.0) ? dBaseNs / dNs : 0.0);
+}
+
+static void BenchWorkload(CList *pList, const char *pszWorkload,
+		BenchParallelWork *pWork, int nMaxThreads) {
+
+	double	dStart;
+	double	dNs;
+	double	dForEachBase = 0.0;
+	double	dReduceBase = 0.0;
+	unsigned long	nSum;
+	POSITION	pos;
+	int		nThreads;
+
+	nSum = 0;
+	dStart = BenchNowNs();
+	pos = ListGetHeadPosition(pList);
+	while (pos != NULL)
+		BenchReduce(&nSum, ListGetNext(pList, &pos), pWork);
+	dNs = BenchNowNs() - dStart;
+	g_nBenchSink += nSum;
+	BenchReport("serial", pszWorkload, 1, pList->nCount, dNs, dNs);
+
+	for (nThreads = 1; nThreads <= nMaxThreads; nThreads *= 2) {
+
+		dStart = BenchNowNs();
+		ListParallelForEach(pList, BenchVisit, pWork, nThreads);
+		dNs = BenchNowNs() - dStart;
+		if (nThreads == 1)
+			dForEachBase = dNs;
+		BenchReport("for_each", pszWorkload, nThreads, pList->nCount, dNs, dForEachBase);
+
+		nSum = 0;
+		dStart = BenchNowNs();
+		ListParallelReduce(pList, BenchReduce, BenchCombine, &nSum, (int)sizeof(nSum),
+				pWork, nThreads);
+		dNs = BenchNowNs() - dStart;
+		if (nThreads == 1)
+			dReduceBase = dNs;
+		BenchReport("reduce", pszWorkload, nThreads, pList->nCount, dNs, dReduceBase);
+		g_nBenchSink += nSum;
+
+		fflush(stdout);
+	}
+}
+
+static void BenchUsage(const char *pszProg) {
+
+	fprintf(stderr, "usage: %s [-t max_threads] [-n elements] [-w rounds]\n", pszProg);
+}
+
+int main(int argc, char *argv[]) {
+
+	long	nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+	long	nSize = BENCH_PARALLEL_ELEMENTS;
+	long	anRecord[2];
+	int		nMaxThreads;
+	int		nRounds = BENCH_PARALLEL_ROUNDS;
+	long	i;
+	CList	list;
+	BenchParallelWork	work;
+
+	nMaxThreads = (nCpus > 0) ? (int)nCpus : 4;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			nMaxThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			nSize = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			nRounds = atoi(argv[++i]);
+		}
+		else {
+			BenchUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (nMaxThreads <= 0 || nSize <= 0 || nRounds <= 0) {
+		BenchUsage(argv[0]);
+		return 1;
+	}
+
+	if (nMaxThreads > BENCH_PARALLEL_MAX_THREADS)
+		nMaxThreads = BENCH_PARALLEL_MAX_THREADS;
+
+	InitListWithCapacity(&list, (int)sizeof(anRecord), (int)nSize);
+	for (i = 0; i < nSize; i++) {
+		anRecord[0] = i;
+		anRecord[1] = 0;
+		if (ListAddTail(&list, anRecord) == NULL) {
+			fprintf(stderr, "out of memory at %ld elements\n", i);
+			DestroyList(&list);
+			return 1;
+		}
+	}
+
+	printf("impl,workload,threads,elements,ns_per_elem,speedup\n");
+
+	work.nRounds = nRounds;
+	work.nHeavyBelow = 0;
+	BenchWorkload(&list, "uniform", &work, nMaxThreads);
+
+	work.nHeavyBelow = nSize / BENCH_SKEW_PART;
+	BenchWorkload(&list, "skewed", &work, nMaxThreads);
+
+	DestroyList(&list);
+
+	return 0;
+}
@@ -0,0 +1,462 @@
+/******************************************************************************
+    clist_queue_bench: multithreaded AddTail / RemoveHead throughput of the
+    lock-free CListQueue against a CList guarded by one mutex.
+
+    pairs: every thread runs nOps pairs of AddTail + RemoveHead on one shared
+    queue that starts with BENCH_QUEUE_PREFILL elements, for 1, 2, 4, ...
+    threads.
+
+    pipeline: one producer thread adds nOps elements and one consumer
+    thread removes them, which also covers the single producer/single
+    consumer CListSpscQueue.
+
+    usage: clist_queue_bench [-t max_threads] [-n ops_per_thread]
+                             [-p payload]
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "list.h"
+#include "list_queue.h"
+#include "bench.h"
+
+#define BENCH_QUEUE_OPS			200000L
+#define BENCH_QUEUE_PREFILL		1024
+#define BENCH_QUEUE_MAX_THREADS	256
+
+/* CListSpscQueue slots in the pipeline case */
+#define BENCH_SPSC_CAPACITY		1024
+
+/* payload bytes read back, keeps the copies from being optimized out */
+static atomic_ulong s_nSink;
+
+/* one implementation under test: shared queue plus its two operations */
+typedef struct BenchQueueImpl {
+
+	const char	*pszName;
+	int		(*Init)(void *pQueue, int nPayload);
+	void	(*Destroy)(void *pQueue);
+	int		(*AddTail)(void *pQueue, const void *pData);
+	int		(*RemoveHead)(void *pQueue, void *pData);
+
+} BenchQueueImpl;
+
+typedef struct BenchQueueRun {
+
+	const BenchQueueImpl	*pImpl;
+	void					*pQueue;
+	int						nPayload;
+	long					nOps;
+	atomic_int				*pnReady;
+	atomic_int				*pbGo;
+
+} BenchQueueRun;
+
+/*-----------------------------------------------------------------------------
+ * CList + mutex
+ * --------------------------------------------------------------------------*/
+typedef struct BenchLockedList {
+
+	CList	list;
+	mtx_t	lock;
+
+} BenchLockedList;
+
+/* room for any of the queue types on a case's stack */
+typedef union BenchQueueSpace {
+
+	BenchLockedList	locked;
+	CListQueue		queue;
+	CListSpscQueue	spsc;
+
+} BenchQueueSpace;
+
+static int BenchLockedInit(void *pQueue, int nPayload) {
+
+	BenchLockedList *pLocked = (BenchLockedList *)pQueue;
+
+	InitList(&pLocked->list, nPayload);
+	return (mtx_init(&pLocked->lock, mtx_plain) == thrd_success) ? 0 : -1;
+}
+
+static void BenchLockedDestroy(void *pQueue) {
+
+	BenchLockedList *pLocked = (BenchLockedList *)pQueue;
+
+	DestroyList(&pLocked->list);
+	mtx_destroy(&pLocked->lock);
+}
+
+static int BenchLockedAddTail(void *pQueue, const void *pData) {
+
+	BenchLockedList *pLocked = (BenchLockedList *)pQueue;
+	POSITION pos;
+
+	mtx_lock(&pLocked->lock);
+	pos = ListAddTail(&pLocked->list, pData);
+	mtx_unlock(&pLocked->lock);
+
+	return (pos != NULL) ? 0 : -1;
+}
+
+static int BenchLockedRemoveHead(void *pQueue, void *pData) {
+
+	BenchLockedList *pLocked = (BenchLockedList *)pQueue;
+	void *pHead;
+	int nResult = -1;
+
+	mtx_lock(&pLocked->lock);
+	pHead = ListGetHead(&pLocked->list);
+	if (pHead != NULL) {
+		memcpy(pData, pHead, (size_t)pLocked->list.nMaxDataSize);
+		nResult = ListRemoveHead(&pLocked->list);
+	}
+	mtx_unlock(&pLocked->lock);
+
+	return nResult;
+}
+
+/*-----------------------------------------------------------------------------
+ * CListQueue
+ * --------------------------------------------------------------------------*/
+static int BenchQueueInit(void *pQueue, int nPayload) {
+
+	return InitListQueue((CListQueue *)pQueue, nPayload);
+}
+
+static void BenchQueueDestroy(void *pQueue) {
+
+	DestroyListQueue((CListQueue *)pQueue);
+}
+
+static int BenchQueueAddTail(void *pQueue, const void *pData) {
+
+	return ListQueueAddTail((CListQueue *)pQueue, pData);
+}
+
+static int BenchQueueRemoveHead(void *pQueue, void *pData) {
+
+	return ListQueueTryRemoveHead((CListQueue *)pQueue, pData);
+}
+
+/*-----------------------------------------------------------------------------
+ * CListSpscQueue, pipeline case only
+ * --------------------------------------------------------------------------*/
+static int BenchSpscInit(void *pQueue, int nPayload) {
+
+	return InitListSpscQueue((CListSpscQueue *)pQueue, nPayload, BENCH_SPSC_CAPACITY);
+}
+
+static void BenchSpscDestroy(void *pQueue) {
+
+	DestroyListSpscQueue((CListSpscQueue *)pQueue);
+}
+
+static int BenchSpscAddTail(void *pQueue, const void *pData) {
+
+	return ListSpscQueueAddTail((CListSpscQueue *)pQueue, pData);
+}
+
+static int BenchSpscRemoveHead(void *pQueue, void *pData) {
+
+	return ListSpscQueueTryRemoveHead((CListSpscQueue *)pQueue, pData);
+}
+
+static const BenchQueueImpl s_aImpls[] = {
+	{ "mutex_list", BenchLockedInit, BenchLockedDestroy,
+			BenchLockedAddTail, BenchLockedRemoveHead },
+	{ "lockfree_queue", BenchQueueInit, BenchQueueDestroy,
+			BenchQueueAddTail, BenchQueueRemoveHead },
+};
+
+static const BenchQueueImpl s_spscImpl = {
+	"spsc_ring", BenchSpscInit, BenchSpscDestroy,
+			BenchSpscAddTail, BenchSpscRemoveHead
+};
+
+/*--------------------------------------------------------------------------*/
+
+static int BenchQueueWorker(void *pArg) {
+
+	BenchQueueRun *pRun = (BenchQueueRun *)pArg;
+	unsigned char *pIn;
+	unsigned char *pOut;
+	unsigned long nSum = 0;
+	long i;
+
+	pIn = (unsigned char *)calloc(2, (size_t)pRun->nPayload);
+	if (pIn == NULL)
+		return 1;
+	pOut = pIn + pRun->nPayload;
+
+	atomic_fetch_add(pRun->pnReady, 1);
+	while (!atomic_load(pRun->pbGo))
+		thrd_yield();
+
+	for (i = 0; i < pRun->nOps; i++) {
+		pIn[0] = (unsigned char)i;
+		pRun->pImpl->AddTail(pRun->pQueue, pIn);
+
+		/* never empty: this thread's own element is still queued */
+		while (pRun->pImpl->RemoveHead(pRun->pQueue, pOut) != 0)
+			thrd_yield();
+
+		nSum += pOut[0];
+	}
+
+	atomic_fetch_add(&s_nSink, nSum);
+
+	free(pIn);
+	return 0;
+}
+
+static int BenchQueueCase(const BenchQueueImpl *pImpl, int nThreads, int nPayload, long nOps) {
+
+	BenchQueueSpace	queue;
+	thrd_t			aThreads[BENCH_QUEUE_MAX_THREADS];
+	BenchQueueRun	run;
+	atomic_int		nReady;
+	atomic_int		bGo;
+	unsigned char	*pRecord;
+	double			dStart;
+	double			dElapsed;
+	long			nTotal;
+	int				nStarted;
+	int				i;
+
+	if (pImpl->Init(&queue, nPayload) != 0)
+		return -1;
+
+	pRecord = (unsigned char *)calloc(1, (size_t)nPayload);
+	if (pRecord == NULL) {
+		pImpl->Destroy(&queue);
+		return -1;
+	}
+
+	for (i = 0; i < BENCH_QUEUE_PREFILL; i++)
+		pImpl->AddTail(&queue, pRecord);
+
+	atomic_init(&nReady, 0);
+	atomic_init(&bGo, 0);
+
+	run.pImpl = pImpl;
+	run.pQueue = &queue;
+	run.nPayload = nPayload;
+	run.nOps = nOps;
+	run.pnReady = &nReady;
+	run.pbGo = &bGo;
+
+	for (nStarted = 0; nStarted < nThreads; nStarted++) {
+		if (thrd_create(&aThreads[nStarted], BenchQueueWorker, &run) != thrd_success)
+			break;
+	}
+
+	while (atomic_load(&nReady) < nStarted)
+		thrd_yield();
+
+	dStart = BenchNowNs();
+	atomic_store(&bGo, 1);
+
+	for (i = 0; i < nStarted; i++)
+		thrd_join(aThreads[i], NULL);
+
+	dElapsed = BenchNowNs() - dStart;
+
+	/* one AddTail and one RemoveHead per iteration */
+	nTotal = 2 * nOps * nStarted;
+
+	if (nStarted == nThreads && nTotal > 0) {
+		printf("%s,pairs,%d,%d,%ld,%.2f,%.3f\n",
+				pImpl->pszName, nThreads, nPayload, nTotal,
+				dElapsed / (double)nTotal, (double)nTotal / dElapsed * 1e3);
+	}
+	else {
+		fprintf(stderr, "skip %s threads=%d: only %d threads started\n",
+				pImpl->pszName, nThreads, nStarted);
+	}
+
+	free(pRecord);
+	pImpl->Destroy(&queue);
+
+	return 0;
+}
+
+static int BenchProducer(void *pArg) {
+
+	BenchQueueRun *pRun = (BenchQueueRun *)pArg;
+	unsigned char *pIn;
+	long i;
+
+	pIn = (unsigned char *)calloc(1, (size_t)pRun->nPayload);
+	if (pIn == NULL)
+		return 1;
+
+	atomic_fetch_add(pRun->pnReady, 1);
+	while (!atomic_load(pRun->pbGo))
+		thrd_yield();
+
+	for (i = 0; i < pRun->nOps; i++) {
+		pIn[0] = (unsigned char)i;
+		while (pRun->pImpl->AddTail(pRun->pQueue, pIn) != 0)
+			thrd_yield();
+	}
+
+	free(pIn);
+	return 0;
+}
+
+static int BenchConsumer(void *pArg) {
+
+	BenchQueueRun *pRun = (BenchQueueRun *)pArg;
+	unsigned char *pOut;
+	unsigned long nSum = 0;
+	long i;
+
+	pOut = (unsigned char *)calloc(1, (size_t)pRun->nPayload);
+	if (pOut == NULL)
+		return 1;
+
+	atomic_fetch_add(pRun->pnReady, 1);
+	while (!atomic_load(pRun->pbGo))
+		thrd_yield();
+
+	for (i = 0; i < pRun->nOps; i++) {
+		while (pRun->pImpl->RemoveHead(pRun->pQueue, pOut) != 0)
+			thrd_yield();
+		nSum += pOut[0];
+	}
+
+	atomic_fetch_add(&s_nSink, nSum);
+
+	free(pOut);
+	return 0;
+}
+
+static int BenchPipelineCase(const BenchQueueImpl *pImpl, int nPayload, long nOps) {
+
+	BenchQueueSpace	queue;
+	thrd_t			producer;
+	thrd_t			consumer;
+	BenchQueueRun	run;
+	atomic_int		nReady;
+	atomic_int		bGo;
+	double			dStart;
+	double			dElapsed;
+	long			nTotal = 2 * nOps;
+
+	if (pImpl->Init(&queue, nPayload) != 0)
+		return -1;
+
+	atomic_init(&nReady, 0);
+	atomic_init(&bGo, 0);
+
+	run.pImpl = pImpl;
+	run.pQueue = &queue;
+	run.nPayload = nPayload;
+	run.nOps = nOps;
+	run.pnReady = &nReady;
+	run.pbGo = &bGo;
+
+	if (thrd_create(&producer, BenchProducer, &run) != thrd_success) {
+		pImpl->Destroy(&queue);
+		return -1;
+	}
+	if (thrd_create(&consumer, BenchConsumer, &run) != thrd_success) {
+		/* drain on this thread so the producer can finish */
+		fprintf(stderr, "skip %s pipeline: consumer did not start\n", pImpl->pszName);
+		atomic_store(&bGo, 1);
+		BenchConsumer(&run);
+		thrd_join(producer, NULL);
+		pImpl->Destroy(&queue);
+		return 0;
+	}
+
+	while (atomic_load(&nReady) < 2)
+		thrd_yield();
+
+	dStart = BenchNowNs();
+	atomic_store(&bGo, 1);
+
+	thrd_join(producer, NULL);
+	thrd_join(consumer, NULL);
+
+	dElapsed = BenchNowNs() - dStart;
+
+	printf("%s,pipeline,2,%d,%ld,%.2f,%.3f\n",
+			pImpl->pszName, nPayload, nTotal,
+			dElapsed / (double)nTotal, (double)nTotal / dElapsed * 1e3);
+
+	pImpl->Destroy(&queue);
+
+	return 0;
+}
+
+static void BenchUsage(const char *pszProg) {
+
+	fprintf(stderr, "usage: %s [-t max_threads] [-n ops_per_thread] [-p payload]\n",
+			pszProg);
+}
+
+int main(int argc, char *argv[]) {
+
+	long	nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int		nMaxThreads;
+	int		nPayload = 64;
+	long	nOps = BENCH_QUEUE_OPS;
+	int		nThreads;
+	size_t	j;
+	int		i;
+
+	nMaxThreads = (nCpus > 0) ? (int)nCpus * 2 : 8;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			nMaxThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			nOps = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			nPayload = atoi(argv[++i]);
+		}
+		else {
+			BenchUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (nMaxThreads <= 0 || nOps <= 0 || nPayload <= 0) {
+		BenchUsage(argv[0]);
+		return 1;
+	}
+
+	if (nMaxThreads > BENCH_QUEUE_MAX_THREADS)
+		nMaxThreads = BENCH_QUEUE_MAX_THREADS;
+
+	printf("impl,workload,threads,payload,ops,ns_per_op,mops_per_s\n");
+
+	for (nThreads = 1; nThreads <= nMaxThreads; nThreads *= 2) {
+		for (j = 0; j < sizeof(s_aImpls) / sizeof(s_aImpls[0]); j++) {
+			if (BenchQueueCase(&s_aImpls[j], nThreads, nPayload, nOps) != 0)
+				fprintf(stderr, "skip %s threads=%d: init failed\n",
+						s_aImpls[j].pszName, nThreads);
+		}
+		fflush(stdout);
+	}
+
+	for (j = 0; j < sizeof(s_aImpls) / sizeof(s_aImpls[0]); j++) {
+		if (BenchPipelineCase(&s_aImpls[j], nPayload, nOps) != 0)
+			fprintf(stderr, "skip %s pipeline: init failed\n", s_aImpls[j].pszName);
+	}
+	if (BenchPipelineCase(&s_spscImpl, nPayload, nOps) != 0)
+		fprintf(stderr, "skip %s pipeline: init failed\n", s_spscImpl.pszName);
+
+	return 0;
+}
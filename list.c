@@ -1,42 +1,100 @@
-#include "list.h"
+#include <string.h>
+
+#include "list_internal.h"
 
 /*-----------------------------------------------------------------------------
  * static function declaration
  * --------------------------------------------------------------------------*/
-/* head, tail access */
-static void* CListGetHead(struct CList *pThis);
-static void* CListGetTail(struct CList *pThis);
+/* storage hooks */
+static POSITION CListEmplaceElem(struct CList *pThis, POSITION position, int bAfter);
+
+/* node allocation */
+static ListElem* CListAllocElem(struct CList *pThis, const void* pData);
+static void CListFreeElem(struct CList *pThis, ListElem *pListElem);
+static int CListGrowNodeHeader(struct CList *pThis, int nBytes);
+
+/* linking, CListLinkElem and CListUnlinkElem are in list_internal.h */
+static void CListMoveElem(struct CList *pThis, ListElem *pListElem,
+		ListElem *pPrev, ListElem *pNext);
+
+/* runs of adjacent elements (bulk operations) */
+static ListElem* CListAllocRun(struct CList *pThis, const void* pData,
+		int nItems, ListElem **ppLast);
+static void CListLinkRun(struct CList *pThis, ListElem *pFirst, ListElem *pLast,
+		int nItems, ListElem *pPrev, ListElem *pNext);
+static void CListRemoveRun(struct CList *pThis, ListElem *pFirst, int nItems);
+
+/* moving elements between lists */
+static int CListCountRange(struct CList *pThis, POSITION first, POSITION last,
+		POSITION posExclude);
+static int CListCountFromHead(struct CList *pThis, ListElem *pListElem);
+static int CListCountToTail(struct CList *pThis, ListElem *pListElem);
+static void CListSwapElements(struct CList *pDst, struct CList *pSrc);
+static void CListMoveRun(struct CList *pDst, ListElem *pNext, struct CList *pSrc,
+		ListElem *pFirst, ListElem *pLast, int nItems);
+static int CListCopyRun(struct CList *pDst, POSITION dstPos, struct CList *pSrc,
+		POSITION first, int nItems);
+
+/* node pool */
+static struct ListNodePool* CListCreatePool(struct CList *pThis, size_t nNodeSize,
+		int nCapacity);
+static void CListDestroyPool(struct CList *pThis, struct ListNodePool *pPool);
+static void* CListPoolAlloc(struct CList *pThis, struct ListNodePool *pPool);
+static void* CListPoolAllocRun(struct CList *pThis, struct ListNodePool *pPool,
+		int nNodes);
+static int CListPoolAddSlab(struct CList *pThis, struct ListNodePool *pPool,
+		int nMinNodes);
+
+/* node arena, the allocator of InitListWithArena lists */
+static void* CListArenaAllocNode(size_t nSize, void *pContext);
+static void CListArenaFreeNode(void *pBlock, size_t nSize, void *pContext);
+static void CListArenaClear(struct CList *pThis);
+
+/*--------------------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------------------
+ * operation table shared by every node-linked list
+ * --------------------------------------------------------------------------*/
+const CListOps g_CListNodeOps = {
+
+	/* head/tail access */
+	CListGetHead,
+	CListGetTail,
 
-/* operation */
-static POSITION CListAddHead(struct CList *pThis, const void* pData);
-static POSITION CListAddTail(struct CList *pThis, const void* pData);
-static int CListRemoveHead(struct CList *pThis);
-static int CListRemoveTail(struct CList *pThis);
-static int CListRemoveAll(struct CList *pThis);
+	/* Operation */
+	CListAddHead,
+	CListAddTail,
+	CListRemoveHead,
+	CListRemoveTail,
+	CListRemoveAll,
 
-/* for iteration */
-static POSITION CListGetHeadPosition(struct CList *pThis);
-static POSITION CListGetTailPosition(struct CList *pThis);
-static void* CListGetNext(struct CList *pThis, POSITION* position);
-static void* CListGetPrev(struct CList *pThis, POSITION* position);
+	/* for iteration */
+	CListGetHeadPosition,
+	CListGetTailPosition,
+	CListGetNext,
+	CListGetPrev,
 
-/* retrieval, modification */
-static void* CListGetAt(struct CList *pThis, POSITION position);
-static int CListRemoveAt(struct CList *pThis, POSITION position);
-static int CListSetAt(struct CList *pThis, POSITION position, const void* pData);
+	/* Retrieval, modification */
+	CListGetAt,
+	CListRemoveAt,
+	CListSetAt,
 
-/* Insertion */
-static POSITION CListInsertNext(struct CList *pThis, POSITION position, const void* pData);
-static POSITION CListInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+	/* Insertion */
+	CListInsertNext,
+	CListInsertPrev,
 
-/* Searching */
-static POSITION CListFindIndex(struct CList *pThis, int nIndex);
+	/* Search */
+	CListFindIndex,
 
-/* Status */
-static int CListGetCount(struct CList *pThis);
-static int CListIsEmpty(struct CList *pThis);
+	/* Status */
+	CListGetCount,
+	CListIsEmpty,
 
-/*--------------------------------------------------------------------------*/
+	CListDestroyNodes,
+	CListEmplaceElem,
+	CListGetNextBatch,
+	NULL			/* RemoveAt keeps later positions */
+};
 
 /*-----------------------------------------------------------------------------
  * Function: InitList
@@ -47,8 +105,8 @@ static int CListIsEmpty(struct CList *pThis);
  *
  * Return Value:
  *
- * Desc: Initialize list instance, binding list functions, initialize local 
- *       vars.
+ * Desc: Initialize list instance, binding list operation table, initialize
+ *       local vars.
  *
  *
  *
@@ -62,38 +120,179 @@ void InitList(struct CList *pThis, int nMaxDataSize)
 	pThis->pHeadNode = NULL;
 	pThis->pTailNode = pThis->pHeadNode;
 
-	/* head/tail access */
-	pThis->GetHead = CListGetHead;
-	pThis->GetTail = CListGetTail;
+	pThis->pPool = NULL;
+	pThis->nNodeHeader = 0;
 
-	/* Operation */
-	pThis->AddHead = CListAddHead;
-	pThis->AddTail = CListAddTail;
-	pThis->RemoveHead = CListRemoveHead;
-	pThis->RemoveTail = CListRemoveTail;
-	pThis->RemoveAll = CListRemoveAll;
+	pThis->pfnAlloc = NULL;
+	pThis->pfnFree = NULL;
+	pThis->pAllocContext = NULL;
+	pThis->pArena = NULL;
 
-	/* for iteration */
-	pThis->GetHeadPosition = CListGetHeadPosition;
-	pThis->GetTailPosition = CListGetTailPosition;
-	pThis->GetNext = CListGetNext;
-	pThis->GetPrev = CListGetPrev;
+	pThis->pCursorNode = NULL;
+	pThis->nCursorIndex = 0;
+	pThis->pIndex = NULL;
+	pThis->pHash = NULL;
+	pThis->pStorage = NULL;
 
-	/* Retrieval, modification */
-	pThis->GetAt = CListGetAt;
-	pThis->RemoveAt = CListRemoveAt;
-	pThis->SetAt = CListSetAt;
+	pThis->nLinkVersion = 0;
+	pThis->pSplits = NULL;
 
-	/* Insertion */
-	pThis->InsertNext = CListInsertNext;
-	pThis->InsertPrev = CListInsertPrev;
+#ifdef CLIST_STATS
+	memset(&pThis->stats, 0, sizeof(CListStats));
+#endif
 
-	/* Search */
-	pThis->FindIndex = CListFindIndex;
+	CListBindOps(pThis, &g_CListNodeOps);
+}
 
-	/* Status */
-	pThis->GetCount = CListGetCount;
-	pThis->IsEmpty = CListIsEmpty;
+/*-----------------------------------------------------------------------------
+ * Function: InitListWithCapacity
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nMaxDataSize : Max size of list element 
+ * 	- nCapacity : expected number of elements, sizes the first node slab
+ *
+ * Return Value:
+ * 	- Return -1 if pool can not be allocated, else returns 0
+ *
+ * Desc: Initialize list instance like InitList, but back it with slabs of
+ *       preallocated nodes. Removed nodes are kept on a free list and reused
+ *       by later inserts, so a list that stays within its capacity does not
+ *       call malloc or free. DestroyList releases the slabs at once.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListWithCapacity(struct CList *pThis, int nMaxDataSize, int nCapacity)
+{
+	if (pThis == NULL)
+		return -1;
+
+	InitList(pThis, nMaxDataSize);
+
+	pThis->pPool = CListCreatePool(pThis, LIST_ELEM_SIZE(nMaxDataSize), nCapacity);
+
+	if (pThis->pPool == NULL)
+		return -1;
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListWithAllocator
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nMaxDataSize : Max size of list element 
+ * 	- alloc : returns a block for one node, header and payload included
+ * 	- dealloc : gives a block back, with the size it was allocated with
+ * 	- pContext : passed to both, e.g. the arena or pool they work on
+ *
+ * Return Value:
+ * 	- Return -1 if only one of alloc and dealloc is given, else returns 0
+ *
+ * Desc: Initialize list instance like InitList, but take every node from
+ *       alloc and give removed nodes back through dealloc instead of malloc
+ *       and free. Both NULL keeps malloc and free. list_alloc.h has a bump
+ *       arena and a fixed-size pool to use here.
+ *       Nodes only move by relinking to lists with the same allocator;
+ *       ListSplice and ListMerge copy the payloads into other lists.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListWithAllocator(struct CList *pThis, int nMaxDataSize,
+		CListAllocFn alloc, CListFreeFn dealloc, void *pContext)
+{
+	if (pThis == NULL || (alloc == NULL) != (dealloc == NULL))
+		return -1;
+
+	InitList(pThis, nMaxDataSize);
+
+	pThis->pfnAlloc = alloc;
+	pThis->pfnFree = dealloc;
+	pThis->pAllocContext = pContext;
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListWithArena
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nMaxDataSize : Max size of list element 
+ * 	- nChunkSize : size of the arena's first chunk, 0 for the default
+ *
+ * Return Value:
+ * 	- Return -1 if the arena can not be allocated, else returns 0
+ *
+ * Desc: Initialize list instance like InitList, with an arena of its own
+ *       that every node is carved from. Removed nodes are reused by later
+ *       inserts. RemoveAll takes all nodes back by resetting the arena and
+ *       DestroyList releases its chunks, both without visiting the
+ *       elements, so a scratch list can be cleared and refilled each round
+ *       without allocating once the arena has grown to size.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListWithArena(struct CList *pThis, int nMaxDataSize, size_t nChunkSize)
+{
+	struct ListNodeArena *pArena;
+
+	if (pThis == NULL)
+		return -1;
+
+	InitList(pThis, nMaxDataSize);
+
+	pArena = (struct ListNodeArena *)malloc(sizeof(struct ListNodeArena));
+
+	if (pArena == NULL)
+		return -1;
+
+	InitListArena(&pArena->arena, nChunkSize);
+	pArena->pFree = NULL;
+
+	pThis->pArena = pArena;
+	pThis->pfnAlloc = CListArenaAllocNode;
+	pThis->pfnFree = CListArenaFreeNode;
+	pThis->pAllocContext = pArena;
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListStorage
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nMaxDataSize : Max size of list element 
+ * 	- nStorage : element storage, LIST_STORAGE_*
+ *
+ * Return Value:
+ * 	- Return -1 if storage is unknown or can not be allocated, else returns 0
+ *
+ * Desc: Initialize list instance with the given element storage. All of
+ *       them are used through the same operations; LIST_STORAGE_NODE is
+ *       what InitList sets up.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListStorage(struct CList *pThis, int nMaxDataSize, CListStorage nStorage)
+{
+	if (pThis == NULL || nMaxDataSize <= 0)
+		return -1;
+
+	InitList(pThis, nMaxDataSize);
+
+	switch (nStorage) {
+	case LIST_STORAGE_NODE:
+		return 0;
+	case LIST_STORAGE_CHUNK:
+		return CListChunkInit(pThis);
+	case LIST_STORAGE_RING:
+		return CListRingInit(pThis, 0);
+	case LIST_STORAGE_COMPACT:
+		return CListCompactInit(pThis, 0);
+	case LIST_STORAGE_DEQUE:
+		return CListDequeInit(pThis);
+	}
+
+	return -1;
 }
 
 /*-----------------------------------------------------------------------------
@@ -109,48 +308,113 @@ void InitList(struct CList *pThis, int nMaxDataSize)
  * --------------------------------------------------------------------------*/
 void DestroyList(struct CList *pThis) {
 
-	if (pThis == NULL)
+	if (pThis == NULL || pThis->pOps == NULL)
 		return;
 	
-	/* remove all list elements*/
-	pThis->RemoveAll(pThis);
+	/* remove all list elements and storage state */
+	pThis->pOps->Destroy(pThis);
+
+	free(pThis->pSplits);
+	pThis->pSplits = NULL;
 
 	/* initialize local var */
 	pThis->nCount = 0;
 
 	pThis->pHeadNode = NULL;
 	pThis->pTailNode = pThis->pHeadNode;
+	pThis->pCursorNode = NULL;
 
-	/* unbind all member functions */
-	/* head/tail access */
-	pThis->GetHead = NULL;
-	pThis->GetTail = NULL;
+	/* unbind operation table */
+	CListBindOps(pThis, NULL);
+}
 
-	/* Operation */
-	pThis->AddHead = NULL;
-	pThis->AddTail = NULL;
-	pThis->RemoveHead = NULL;
-	pThis->RemoveTail = NULL;
-	pThis->RemoveAll = NULL;
+/*-----------------------------------------------------------------------------
+ * Function: ListEnableIndex
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ * 	- Return -1 if list is not empty or the index can not be allocated,
+ * 	  else returns 0
+ *
+ * Desc: Switch an empty list to indexed mode. Every node then also carries a
+ *       treap node counting its subtree, which makes FindIndex O(log n);
+ *       inserts and removes pay O(log n) expected to keep it up to date.
+ *
+ * --------------------------------------------------------------------------*/
+int ListEnableIndex(struct CList *pThis) {
 
-	/* for iteration */
-	pThis->GetHeadPosition = NULL;
-	pThis->GetTailPosition = NULL;
-	pThis->GetNext = NULL;
-	pThis->GetPrev = NULL;
+	if (pThis == NULL || pThis->nCount != 0 || !LIST_IS_NODE_LINKED(pThis))
+		return -1;
 
-	/* Retrieval, modification */
-	pThis->GetAt = NULL;
-	pThis->RemoveAt = NULL;
-	pThis->SetAt = NULL;
+	if (pThis->pIndex != NULL)
+		return 0;
 
-	/* Insertion */
-	pThis->InsertNext = NULL;
-	pThis->InsertPrev = NULL;
+	pThis->pIndex = CListIndexCreate();
 
-	/* Status */
-	pThis->GetCount = NULL;
-	pThis->IsEmpty = NULL;
+	if (pThis->pIndex == NULL)
+		return -1;
+
+	if (CListGrowNodeHeader(pThis, (int)sizeof(ListRankNode)) != 0) {
+		free(pThis->pIndex);
+		pThis->pIndex = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListEnableHashIndex
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nKeyOffset : offset of the key in every payload, or in the object
+ * 	               every pointer of an InitListByRef list points at
+ * 	- nKeyLen : key size in bytes
+ * 	- hash : hash function over nKeyLen bytes, NULL for the built-in one
+ *
+ * Return Value:
+ * 	- Return -1 if list is not empty, is not node-linked, already has a
+ * 	  hash index, the key is out of the payload or the index can not be
+ * 	  allocated, else returns 0
+ *
+ * Desc: Switch an empty list to keyed mode for ListFindKey. Every node then
+ *       also carries a hash chain link; adding, inserting, removing and
+ *       SetAt keep the index up to date at O(1) average cost. Keys are
+ *       compared with memcmp, so padding inside a key must be initialized.
+ *       The ListEmplace* calls fail on such a list, as there is no key to
+ *       hash before the payload is written. By-reference lists read the key
+ *       through the stored pointer; it must not change while the object is
+ *       in the list.
+ *
+ * --------------------------------------------------------------------------*/
+int ListEnableHashIndex(struct CList *pThis, int nKeyOffset, int nKeyLen,
+		CListHashFn hash) {
+
+	if (pThis == NULL || pThis->nCount != 0 || !LIST_IS_NODE_LINKED(pThis) ||
+			pThis->pHash != NULL || nKeyOffset < 0 || nKeyLen <= 0)
+		return -1;
+
+	/* the object behind a stored pointer has no known size */
+	if (pThis->pOps != &g_CListRefOps && nKeyOffset + nKeyLen > pThis->nMaxDataSize)
+		return -1;
+
+	pThis->pHash = CListHashCreate((size_t)nKeyOffset, (size_t)nKeyLen, hash);
+
+	if (pThis->pHash == NULL)
+		return -1;
+
+	LIST_STAT_ALLOC(pThis, pThis->pHash->nBuckets * sizeof(ListElem *));
+
+	if (CListGrowNodeHeader(pThis, (int)sizeof(ListHashNode)) != 0) {
+		LIST_STAT_FREE(pThis, pThis->pHash->nBuckets * sizeof(ListElem *));
+		CListHashDestroy(pThis->pHash);
+		pThis->pHash = NULL;
+		return -1;
+	}
+
+	return 0;
 }
 
 /*-----------------------------------------------------------------------------
@@ -166,9 +430,9 @@ void DestroyList(struct CList *pThis) {
  *	- get headnode data pointer
  *
  * --------------------------------------------------------------------------*/
-static void* CListGetHead(struct CList *pThis) {
+void* CListGetHead(struct CList *pThis) {
 
-	if (pThis == NULL || pThis->pHeadNode == NULL || pThis->pHeadNode->data == NULL)
+	if (pThis == NULL || pThis->pHeadNode == NULL)
 		return NULL;
 
 	return pThis->pHeadNode->data;
@@ -187,9 +451,9 @@ static void* CListGetHead(struct CList *pThis) {
  *	- get tailnode data pointer
  *
  * --------------------------------------------------------------------------*/
-static void* CListGetTail(struct CList *pThis) {
+void* CListGetTail(struct CList *pThis) {
 
-	if (pThis == NULL || pThis->pHeadNode == NULL || pThis->pHeadNode->data == NULL)
+	if (pThis == NULL || pThis->pTailNode == NULL)
 		return NULL;
 
 	return pThis->pTailNode->data;
@@ -208,7 +472,7 @@ static void* CListGetTail(struct CList *pThis) {
  *	- add list element to list head
  *
  * --------------------------------------------------------------------------*/
-static POSITION CListAddHead(struct CList *pThis, const void* pData) {
+POSITION CListAddHead(struct CList *pThis, const void* pData) {
 
 	POSITION	pos;
 	ListElem	*pListElem;
@@ -216,34 +480,14 @@ static POSITION CListAddHead(struct CList *pThis, const void* pData) {
 	if ((pThis == NULL) || (pData == NULL))
 		return NULL;
 
-	pListElem = (ListElem *)calloc(1, sizeof(ListElem));
+	pListElem = CListAllocElem(pThis, pData);
 
 	if (pListElem == NULL)
 		return NULL;
 
-	pListElem->data = calloc(1, pThis->nMaxDataSize);
-
-	if (pListElem->data == NULL)
-		return NULL;
-
-	memcpy(pListElem->data, pData, pThis->nMaxDataSize);
-
-	if(pThis->pHeadNode == NULL) 
-    {
-		pThis->pHeadNode = pListElem;
-		pThis->pTailNode = pListElem;
-	}
-	else 
-    {
-		pListElem->prev = NULL;
-		pThis->pHeadNode->prev = pListElem;
-		pListElem->next = pThis->pHeadNode;
-
-		pThis->pHeadNode = pListElem;
-	}
+	CListLinkElem(pThis, pListElem, NULL, pThis->pHeadNode);
 
 	pos = (POSITION)pThis->pHeadNode;
-	pThis->nCount++;
 
 	return pos;
 }
@@ -261,7 +505,7 @@ static POSITION CListAddHead(struct CList *pThis, const void* pData) {
  * 	- add list element to list tail 
  *
  * --------------------------------------------------------------------------*/
-static POSITION CListAddTail(struct CList *pThis, const void* pData) {
+POSITION CListAddTail(struct CList *pThis, const void* pData) {
 
 	POSITION	pos;
 	ListElem	*pListElem;
@@ -269,34 +513,14 @@ static POSITION CListAddTail(struct CList *pThis, const void* pData) {
 	if (pThis == NULL || pData == NULL)
 		return NULL;
 
-	pListElem = (ListElem *)calloc(1, sizeof(ListElem));
+	pListElem = CListAllocElem(pThis, pData);
 
 	if (pListElem == NULL)
 		return NULL;
 
-	pListElem->data = calloc(1, pThis->nMaxDataSize);
-
-	if (pListElem->data == NULL)
-		return NULL;
-
-	memcpy(pListElem->data, pData, pThis->nMaxDataSize);
-
-	if(pThis->pHeadNode == NULL) 
-    {
-		pThis->pHeadNode = pListElem;
-		pThis->pTailNode = pListElem;
-	}
-	else 
-    {
-		pListElem->prev = pThis->pTailNode;
-		pThis->pTailNode->next = pListElem;
-		pListElem->next = NULL;
-
-		pThis->pTailNode = pListElem;
-	}
+	CListLinkElem(pThis, pListElem, pThis->pTailNode, NULL);
 
 	pos = (POSITION)pThis->pTailNode;
-	pThis->nCount++;
 	return pos;
 }
 /*-----------------------------------------------------------------------------
@@ -311,7 +535,7 @@ static POSITION CListAddTail(struct CList *pThis, const void* pData) {
  * Desc: remove head node
  *
  * --------------------------------------------------------------------------*/
-static int CListRemoveHead(CList *pThis) {
+int CListRemoveHead(CList *pThis) {
 
     ListElem    *pListElem;
 
@@ -322,15 +546,9 @@ static int CListRemoveHead(CList *pThis) {
         return -1;
 
     pListElem = pThis->pHeadNode;
-    pThis->pHeadNode = pThis->pHeadNode->next;
-    
-    if(pThis->pHeadNode != NULL)
-        pThis->pHeadNode->prev = NULL;
-
-    free(pListElem->data);
-    free(pListElem);
 
-    pThis->nCount--;
+    CListUnlinkElem(pThis, pListElem);
+    CListFreeElem(pThis, pListElem);
 
     return 0;
 }
@@ -347,7 +565,7 @@ static int CListRemoveHead(CList *pThis) {
  * Desc: remove tail node
  *
  * --------------------------------------------------------------------------*/
-static int CListRemoveTail(CList *pThis) {
+int CListRemoveTail(CList *pThis) {
 
     ListElem    *pListElem;
 
@@ -358,14 +576,9 @@ static int CListRemoveTail(CList *pThis) {
         return -1;
      
     pListElem = pThis->pTailNode;
-    pThis->pTailNode = pThis->pTailNode->prev;
 
-    if(pThis->pTailNode != NULL)
-        pThis->pTailNode->next = NULL;
-
-    free(pListElem->data);
-    free(pListElem);
-    pThis->nCount--;
+    CListUnlinkElem(pThis, pListElem);
+    CListFreeElem(pThis, pListElem);
 
     return 0;
 }
@@ -383,18 +596,37 @@ static int CListRemoveTail(CList *pThis) {
  * Desc: remove all list elements
  *
  * --------------------------------------------------------------------------*/
-static int CListRemoveAll(CList *pThis) {
+int CListRemoveAll(CList *pThis) {
+
+	ListElem *pListElem;
+	ListElem *pNext;
 
-    if (pThis->pHeadNode == NULL || pThis->nCount == 0)
+    if (pThis == NULL || pThis->pHeadNode == NULL || pThis->nCount == 0)
 		return 0;
 
-	while (pThis->pHeadNode != pThis->pTailNode) {
-		pThis->RemoveTail(pThis);
+	/* nothing survives, so free without unlinking one by one, or give the
+	 * whole arena back at once */
+	if (pThis->pArena != NULL) {
+		CListArenaClear(pThis);
+	}
+	else {
+		for (pListElem = pThis->pHeadNode; pListElem != NULL; pListElem = pNext) {
+			pNext = pListElem->next;
+			CListFreeElem(pThis, pListElem);
+		}
 	}
 
-    free (pThis->pHeadNode->data);
-    free (pThis->pHeadNode);
+    pThis->pHeadNode = NULL;
+    pThis->pTailNode = NULL;
+    pThis->pCursorNode = NULL;
     pThis->nCount = 0;
+    pThis->nLinkVersion++;
+
+	if (pThis->pIndex != NULL)
+		pThis->pIndex->pRoot = NULL;
+
+	if (pThis->pHash != NULL)
+		CListHashClear(pThis->pHash);
 
 	return 0;
 }
@@ -412,7 +644,7 @@ static int CListRemoveAll(CList *pThis) {
  * 	- To get headnode position. Using this, you can iterate whole list elements
  *
  * --------------------------------------------------------------------------*/
-static POSITION CListGetHeadPosition(CList *pThis) {
+POSITION CListGetHeadPosition(CList *pThis) {
 
 	POSITION pos;
 	
@@ -436,7 +668,7 @@ static POSITION CListGetHeadPosition(CList *pThis) {
  * 	- To get headnode position. Using this, you can iterate whole list elements
  *
  * --------------------------------------------------------------------------*/
-static POSITION CListGetTailPosition(CList *pThis) {
+POSITION CListGetTailPosition(CList *pThis) {
 
 	POSITION pos;
 	
@@ -461,7 +693,7 @@ static POSITION CListGetTailPosition(CList *pThis) {
  * 	- get current element's data pointer, returns next element position
  *
  * --------------------------------------------------------------------------*/
-static void* CListGetNext(CList *pThis, POSITION* position) {
+void* CListGetNext(CList *pThis, POSITION* position) {
 
 	ListElem *pListElem;
 
@@ -470,8 +702,8 @@ static void* CListGetNext(CList *pThis, POSITION* position) {
 
 	pListElem = (ListElem *)*position;
 
-    if (pListElem == NULL)
-        return NULL;
+	if (pListElem == NULL)
+		return NULL;
 
 	//move position
 	*position = (POSITION)pListElem->next;
@@ -480,6 +712,50 @@ static void* CListGetNext(CList *pThis, POSITION* position) {
 	return pListElem->data;
 	
 }
+/*-----------------------------------------------------------------------------
+ * Function: CListGetNextBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position of the first element wanted, advanced past the
+ * 	  last one handed out (NULL at the end)
+ * 	- ppData : receives the payload pointers
+ * 	- nMax : size of ppData
+ *
+ * Return Value:
+ * 	- number of payload pointers stored, 0 at the end of the list, -1 if
+ * 	  arguments are invalid
+ *
+ * Desc:
+ * 	- GetNext nMax times in one call. Each link is a load that depends on
+ * 	  the one before, so the walk itself can not be fetched ahead; what is
+ * 	  prefetched is what the caller reads after it: the payload lines past
+ * 	  the one holding the links, and the node the next batch starts at.
+ *
+ * --------------------------------------------------------------------------*/
+int CListGetNextBatch(CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	ListElem *pListElem;
+	int nGot = 0;
+
+	if (pThis == NULL || position == NULL || ppData == NULL || nMax < 0)
+		return -1;
+
+	pListElem = (ListElem *)*position;
+
+	while (nGot < nMax && pListElem != NULL) {
+		CListPrefetchPayload(pListElem->data, (size_t)pThis->nMaxDataSize);
+		ppData[nGot++] = pListElem->data;
+		pListElem = pListElem->next;
+	}
+
+	if (pListElem != NULL)
+		LIST_PREFETCH(pListElem);
+
+	*position = (POSITION)pListElem;
+
+	return nGot;
+}
 /*-----------------------------------------------------------------------------
  * Function: CListGetPrev
  *
@@ -494,7 +770,7 @@ static void* CListGetNext(CList *pThis, POSITION* position) {
  * 	- get previous element's data pointer, returns previous element position
  *
  * --------------------------------------------------------------------------*/
-static void* CListGetPrev(CList *pThis, POSITION* position) {
+void* CListGetPrev(CList *pThis, POSITION* position) {
 
 	ListElem *pListElem;
 
@@ -523,7 +799,7 @@ static void* CListGetPrev(CList *pThis, POSITION* position) {
  * 	- get specific element's data pointer which pointed by position var 
  *
  * --------------------------------------------------------------------------*/
-static void* CListGetAt(CList *pThis, POSITION position) {
+void* CListGetAt(CList *pThis, POSITION position) {
 
 	ListElem *pListElem;
 
@@ -548,7 +824,7 @@ static void* CListGetAt(CList *pThis, POSITION position) {
  * Desc: remove list element at position
  *
  * --------------------------------------------------------------------------*/
-static int CListRemoveAt(CList *pThis, POSITION position) {
+int CListRemoveAt(CList *pThis, POSITION position) {
 
 	ListElem *pListElem;
 
@@ -558,30 +834,8 @@ static int CListRemoveAt(CList *pThis, POSITION position) {
 
 	pListElem = (ListElem *)position;
 
-    if (pThis->pHeadNode == pListElem)
-    {
-        pThis->pHeadNode = pListElem->next;
-        pListElem->next = NULL;
-        pThis->pHeadNode->prev = NULL;
-
-    } 
-    else if (pThis->pTailNode == pListElem)
-    {
-        pThis->pTailNode = pListElem->prev;
-        pListElem->prev = NULL;
-        pThis->pTailNode->next = NULL;
-    }
-    else
-    {
-        pListElem->prev->next = pListElem->next;
-        pListElem->next->prev = pListElem->prev;
-        pListElem->prev = NULL;
-        pListElem->next = NULL;
-    }
-
-    free(pListElem->data);
-    free(pListElem);
-	pThis->nCount--;
+	CListUnlinkElem(pThis, pListElem);
+	CListFreeElem(pThis, pListElem);
 	return 0;
 }
 /*-----------------------------------------------------------------------------
@@ -599,7 +853,7 @@ static int CListRemoveAt(CList *pThis, POSITION position) {
  * Desc: Replace specific element's data
  *
  * --------------------------------------------------------------------------*/
-static int CListSetAt(CList *pThis, POSITION position, const void* pData) {
+int CListSetAt(CList *pThis, POSITION position, const void* pData) {
 
 	ListElem *pListElem;
 
@@ -607,11 +861,16 @@ static int CListSetAt(CList *pThis, POSITION position, const void* pData) {
 		return -1;
 
 	pListElem = (ListElem *)position;
-	if ((pListElem == NULL) || (pListElem->data == NULL))
-		return -1;
+
+	/* the key may change, so the element moves to its new bucket */
+	if (pThis->pHash != NULL)
+		CListHashRemove(pThis, pListElem);
 
 	memcpy(pListElem->data, pData, pThis->nMaxDataSize);
 
+	if (pThis->pHash != NULL)
+		CListHashInsert(pThis, pListElem);
+
 	return 0;
 }
 /*-----------------------------------------------------------------------------
@@ -631,7 +890,7 @@ static int CListSetAt(CList *pThis, POSITION position, const void* pData) {
  * 	- Insert new data to list element next to current position
  *
  * --------------------------------------------------------------------------*/
-static POSITION CListInsertNext(CList *pThis, POSITION position, const void* pData) {
+POSITION CListInsertNext(CList *pThis, POSITION position, const void* pData) {
 
 	POSITION	pos;
 	ListElem 	*pListElem;
@@ -640,33 +899,17 @@ static POSITION CListInsertNext(CList *pThis, POSITION position, const void* pDa
 	if ((pThis == NULL) || (pData == NULL) || position == NULL)
 		return NULL;
 
-	pListElem = (ListElem *)calloc(1, sizeof(ListElem));
+	pListElem = CListAllocElem(pThis, pData);
 
 	if (pListElem == NULL)
 		return NULL;
 
-	pListElem->data = calloc(1, pThis->nMaxDataSize);
-
-	if (pListElem->data == NULL)
-		return NULL;
-
-	memcpy(pListElem->data, pData, pThis->nMaxDataSize);
-
 	pListElemPrev = (ListElem *)position;
 
-	//if tailnode
-	if (pListElemPrev->next == NULL) {
-		pos = pThis->AddTail(pThis, pData);	
-	}
-	else {
-		//move position
-		pListElem->prev = pListElemPrev;
-		pListElem->next = pListElemPrev->next;
-		pListElem->next->prev = pListElem;
-		pListElemPrev->next = pListElem;
-		pos = (POSITION)pListElem;	
-	    pThis->nCount++;
-	}
+	//move position
+	CListLinkElem(pThis, pListElem, pListElemPrev, pListElemPrev->next);
+
+	pos = (POSITION)pListElem;	
 
 	//return value
 	return pos;
@@ -688,7 +931,7 @@ static POSITION CListInsertNext(CList *pThis, POSITION position, const void* pDa
  * 	- Insert new data to list element previous to current position
  *
  * --------------------------------------------------------------------------*/
-static POSITION CListInsertPrev(CList *pThis,  POSITION position, const void* pData) {
+POSITION CListInsertPrev(CList *pThis,  POSITION position, const void* pData) {
 
 	POSITION	pos;
 	ListElem 	*pListElem;
@@ -697,36 +940,17 @@ static POSITION CListInsertPrev(CList *pThis,  POSITION position, const void* pD
 	if ((pThis == NULL) || (pData == NULL) || position == NULL)
 		return NULL;
 
-	pListElem = (ListElem *)calloc(1, sizeof(ListElem));
+	pListElem = CListAllocElem(pThis, pData);
 
 	if (pListElem == NULL)
 		return NULL;
 
-	pListElem->data = calloc(1, pThis->nMaxDataSize);
-
-	if (pListElem->data == NULL)
-		return NULL;
-
-	memcpy(pListElem->data, pData, pThis->nMaxDataSize);
-
 	pListElemNext = (ListElem *)position;
 
+	//move position
+	CListLinkElem(pThis, pListElem, pListElemNext->prev, pListElemNext);
 
-	// if headnode
-	if (pListElemNext->prev == NULL) 
-    {
-		pos = pThis->AddHead(pThis, pData);	
-	}
-	else 
-    {
-		//move position
-		pListElem->next = pListElemNext;
-		pListElem->prev = pListElemNext->prev;
-		pListElem->prev->next= pListElem;
-		pListElemNext->prev = pListElem;
-		pos = (POSITION)pListElem;	
-        pThis->nCount++;
-	}
+	pos = (POSITION)pListElem;	
 
 	//return value
 	return pos;
@@ -736,31 +960,67 @@ static POSITION CListInsertPrev(CList *pThis,  POSITION position, const void* pD
  *
  * Parameter:
  * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nIndex : zero based element index
  *
  * Return Value:
  * 	- return positoin nIndex points
  *
  * Desc: 
+ * 	- walk from the head, the tail or the last found position, whichever is
+ * 	  closest, so sequential and nearby lookups take O(1) steps. Indexed
+ * 	  lists descend their rank tree instead of taking longer walks.
  *
  * --------------------------------------------------------------------------*/
-static POSITION CListFindIndex(struct CList *pThis, int nIndex) {
+POSITION CListFindIndex(struct CList *pThis, int nIndex) {
 
-	POSITION pos = NULL;
-	int i = 0;
+	ListElem *pListElem;
+	int nAt;
+	int nDistance;
 
-	if (nIndex < 0 || nIndex >= pThis->nCount) 
+	if (pThis == NULL || nIndex < 0 || nIndex >= pThis->nCount) 
     {
 		return NULL;
 	}
 
-    pos = pThis->GetHeadPosition(pThis);
+	if (nIndex <= pThis->nCount - 1 - nIndex) {
+		pListElem = pThis->pHeadNode;
+		nAt = 0;
+	}
+	else {
+		pListElem = pThis->pTailNode;
+		nAt = pThis->nCount - 1;
+	}
+
+	if (pThis->pCursorNode != NULL) {
+		nDistance = nIndex - pThis->nCursorIndex;
+		if (nDistance < 0)
+			nDistance = -nDistance;
 
-    for( i = 0 ; i < nIndex ; i++) 
-    {
-        pThis->GetNext(pThis, &pos);
-    }
+		if (nDistance < abs(nIndex - nAt)) {
+			pListElem = pThis->pCursorNode;
+			nAt = pThis->nCursorIndex;
+		}
+	}
 
-	return pos;
+	if (pThis->pIndex != NULL && abs(nIndex - nAt) > LIST_INDEX_WALK_LIMIT)
+	{
+		pListElem = CListIndexFind(pThis->pIndex, nIndex);
+	}
+	else
+	{
+		LIST_STAT_STEPS(pThis, abs(nIndex - nAt));
+
+		for (; nAt < nIndex; nAt++)
+			pListElem = pListElem->next;
+
+		for (; nAt > nIndex; nAt--)
+			pListElem = pListElem->prev;
+	}
+
+	pThis->pCursorNode = pListElem;
+	pThis->nCursorIndex = nIndex;
+
+	return (POSITION)pListElem;
 }
 /*-----------------------------------------------------------------------------
  * Function: CListGetCount
@@ -774,7 +1034,7 @@ static POSITION CListFindIndex(struct CList *pThis, int nIndex) {
  * Desc: 
  *
  * --------------------------------------------------------------------------*/
-static int CListGetCount(CList *pThis) {
+int CListGetCount(CList *pThis) {
 
 	if (pThis == NULL)
 		return 0;
@@ -793,13 +1053,1931 @@ static int CListGetCount(CList *pThis) {
  * Desc: 
  *
  * --------------------------------------------------------------------------*/
-static int CListIsEmpty(CList *pThis) {
+int CListIsEmpty(CList *pThis) {
 
 	if (pThis == NULL)
 		return 0;
 
-	if (pThis->pHeadNode->data != NULL)
+	if (pThis->pHeadNode != NULL)
 		return 1;
 	else
 		return 0;
 }
+/*-----------------------------------------------------------------------------
+ * Function: ListAddHeadBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : nItems records of nMaxDataSize bytes each
+ * 	- nItems : number of records
+ *
+ * Return Value:
+ * 	- position of the first record, which is the new headnode
+ * 	- Return NULL if arguments are invalid or allocation fails. A
+ * 	  LIST_STORAGE_NODE list is left as it was then; sized lists and
+ * 	  other storages keep the records added before the failure
+ *
+ * Desc: 
+ * 	- add records to list head, keeping their order. Nodes are allocated
+ * 	  and linked in one pass, see ListAddTailBatch.
+ * 	- sized lists and other storages add the records one at a time, and
+ * 	  records added before a failed allocation stay in the list
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListAddHeadBatch(struct CList *pThis, const void* pData, int nItems) {
+
+	const unsigned char *pRecords = (const unsigned char *)pData;
+	POSITION	pos = NULL;
+	ListElem	*pFirst;
+	ListElem	*pLast;
+	int			i;
+
+	if (pThis == NULL || pData == NULL || nItems <= 0)
+		return NULL;
+
+	if (!LIST_IS_NODE_LINKED(pThis)) {
+		for (i = nItems - 1; i >= 0; i--) {
+			pos = pThis->pOps->AddHead(pThis,
+					pRecords + (size_t)i * pThis->nMaxDataSize);
+			if (pos == NULL)
+				return NULL;
+		}
+		return pos;
+	}
+
+	pFirst = CListAllocRun(pThis, pData, nItems, &pLast);
+
+	if (pFirst == NULL)
+		return NULL;
+
+	CListLinkRun(pThis, pFirst, pLast, nItems, NULL, pThis->pHeadNode);
+
+	return (POSITION)pFirst;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListAddTailBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : nItems records of nMaxDataSize bytes each
+ * 	- nItems : number of records
+ *
+ * Return Value:
+ * 	- position of the first record
+ * 	- Return NULL if arguments are invalid or allocation fails. A
+ * 	  LIST_STORAGE_NODE list is left as it was then; sized lists and
+ * 	  other storages keep the records added before the failure
+ *
+ * Desc: 
+ * 	- append records to list tail. Lists of InitListWithCapacity take
+ * 	  the nodes as one block from their node pool, other node lists from
+ * 	  their allocator one by one. The run is linked in one pass and
+ * 	  attached to the list with O(1) link updates.
+ * 	- sized lists and other storages add the records one at a time, and
+ * 	  records added before a failed allocation stay in the list
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListAddTailBatch(struct CList *pThis, const void* pData, int nItems) {
+
+	const unsigned char *pRecords = (const unsigned char *)pData;
+	POSITION	pos;
+	ListElem	*pFirst;
+	ListElem	*pLast;
+	int			i;
+
+	if (pThis == NULL || pData == NULL || nItems <= 0)
+		return NULL;
+
+	if (!LIST_IS_NODE_LINKED(pThis)) {
+		for (i = 0; i < nItems; i++) {
+			pos = pThis->pOps->AddTail(pThis,
+					pRecords + (size_t)i * pThis->nMaxDataSize);
+			if (pos == NULL)
+				return NULL;
+		}
+		/* a ring that grew has moved the first record, look it up again */
+		return pThis->pOps->FindIndex(pThis, pThis->nCount - nItems);
+	}
+
+	pFirst = CListAllocRun(pThis, pData, nItems, &pLast);
+
+	if (pFirst == NULL)
+		return NULL;
+
+	CListLinkRun(pThis, pFirst, pLast, nItems, pThis->pTailNode, NULL);
+
+	return (POSITION)pFirst;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListInsertNextBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : list element location which to insert
+ * 	- pData : nItems records of nMaxDataSize bytes each
+ * 	- nItems : number of records
+ *
+ * Return Value:
+ * 	- position of the first record
+ * 	- Return NULL if arguments are invalid or allocation fails. A
+ * 	  LIST_STORAGE_NODE list is left as it was then; sized lists and
+ * 	  other storages keep the records added before the failure
+ *
+ * Desc: 
+ * 	- insert records next to position, keeping their order. Nodes are
+ * 	  allocated and linked in one pass, see ListAddTailBatch.
+ * 	- sized lists and other storages insert the records one at a time, and
+ * 	  records added before a failed allocation stay in the list
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListInsertNextBatch(struct CList *pThis, POSITION position,
+		const void* pData, int nItems) {
+
+	const unsigned char *pRecords = (const unsigned char *)pData;
+	POSITION	pos = position;
+	ListElem	*pFirst;
+	ListElem	*pLast;
+	ListElem	*pPrev;
+	int			i;
+
+	if (pThis == NULL || position == NULL || pData == NULL || nItems <= 0)
+		return NULL;
+
+	if (!LIST_IS_NODE_LINKED(pThis)) {
+		for (i = 0; i < nItems; i++) {
+			pos = pThis->pOps->InsertNext(pThis, pos,
+					pRecords + (size_t)i * pThis->nMaxDataSize);
+			if (pos == NULL)
+				return NULL;
+		}
+		/* inserts may move payloads, so find the first record from the last */
+		for (i = 1; i < nItems; i++)
+			pThis->pOps->GetPrev(pThis, &pos);
+		return pos;
+	}
+
+	pFirst = CListAllocRun(pThis, pData, nItems, &pLast);
+
+	if (pFirst == NULL)
+		return NULL;
+
+	pPrev = (ListElem *)position;
+	CListLinkRun(pThis, pFirst, pLast, nItems, pPrev, pPrev->next);
+
+	return (POSITION)pFirst;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListRemoveRange
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- posFrom : first element to remove
+ * 	- posTo : last element to remove, posFrom itself or one after it
+ *
+ * Return Value:
+ * 	- number of elements removed
+ * 	- Return -1 if arguments are invalid, the list is read-only
+ * 	  (InitListMapped) or posTo does not follow posFrom; nothing is
+ * 	  removed then
+ *
+ * Desc: 
+ * 	- remove posFrom .. posTo. The span is checked first, then detached
+ * 	  with O(1) link updates and its nodes released in one walk.
+ *
+ * --------------------------------------------------------------------------*/
+int ListRemoveRange(struct CList *pThis, POSITION posFrom, POSITION posTo) {
+
+	POSITION	pos;
+	POSITION	posAt;
+	ListElem	*pListElem;
+	int			nItems = 1;
+	int			i;
+
+	if (pThis == NULL || posFrom == NULL || posTo == NULL || pThis->nCount == 0 ||
+			LIST_IS_READ_ONLY(pThis))
+		return -1;
+
+	if (!LIST_IS_NODE_LINKED(pThis)) {
+
+		pos = posFrom;
+		pThis->pOps->GetNext(pThis, &pos);
+		for (posAt = posFrom; posAt != posTo; nItems++) {
+			if (pos == NULL)
+				return -1;
+			posAt = pos;
+			pThis->pOps->GetNext(pThis, &pos);
+		}
+
+		pos = posFrom;
+		for (i = 0; i < nItems; i++)
+			ListErase(pThis, &pos);
+		return nItems;
+	}
+
+	for (pListElem = (ListElem *)posFrom; pListElem != (ListElem *)posTo; nItems++) {
+		pListElem = pListElem->next;
+		if (pListElem == NULL)
+			return -1;
+	}
+
+	CListRemoveRun(pThis, (ListElem *)posFrom, nItems);
+
+	return nItems;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListRemoveHeadN
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nItems : number of elements to remove from list head
+ *
+ * Return Value:
+ * 	- number of elements removed, less than nItems if the list was shorter
+ * 	- Return -1 if pThis is NULL, read-only (InitListMapped) or nItems is
+ * 	  negative
+ *
+ * Desc: 
+ * 	- detach the first nItems elements with O(1) link updates and release
+ * 	  their nodes in one walk
+ *
+ * --------------------------------------------------------------------------*/
+int ListRemoveHeadN(struct CList *pThis, int nItems) {
+
+	int i;
+
+	if (pThis == NULL || nItems < 0 || LIST_IS_READ_ONLY(pThis))
+		return -1;
+
+	if (nItems > pThis->nCount)
+		nItems = pThis->nCount;
+
+	if (nItems == 0)
+		return 0;
+
+	if (nItems == pThis->nCount) {
+		pThis->pOps->RemoveAll(pThis);
+		return nItems;
+	}
+
+	if (!LIST_IS_NODE_LINKED(pThis)) {
+		for (i = 0; i < nItems; i++)
+			pThis->pOps->RemoveHead(pThis);
+		return nItems;
+	}
+
+	CListRemoveRun(pThis, pThis->pHeadNode, nItems);
+
+	return nItems;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListErase
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to remove, receives the element that followed it,
+ * 	  NULL if it was the tailnode
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid, the list is read-only
+ * 	  (InitListMapped) or the removal fails; *position is left as it was
+ * 	  then. Else returns 0
+ *
+ * Desc: 
+ * 	- RemoveAt for removing while walking forward, like std::deque::erase.
+ * 	  Works on every storage, including LIST_STORAGE_DEQUE whose RemoveAt
+ * 	  may move the elements that follow, so the usual loop of saving the
+ * 	  next position with GetNext before RemoveAt is not safe there:
+ *
+ * 	      pos = ListGetHeadPosition(&list);
+ * 	      while (pos != NULL) {
+ * 	          if (Unwanted(ListGetAt(&list, pos)))
+ * 	              ListErase(&list, &pos);
+ * 	          else
+ * 	              ListGetNext(&list, &pos);
+ * 	      }
+ *
+ * --------------------------------------------------------------------------*/
+int ListErase(struct CList *pThis, POSITION* position) {
+
+	POSITION posAt;
+
+	if (pThis == NULL || position == NULL || *position == NULL ||
+			LIST_IS_READ_ONLY(pThis))
+		return -1;
+
+	if (pThis->pOps->Erase != NULL)
+		return pThis->pOps->Erase(pThis, position);
+
+	posAt = *position;
+	pThis->pOps->GetNext(pThis, position);
+
+	if (pThis->pOps->RemoveAt(pThis, posAt) != 0) {
+		*position = posAt;
+		return -1;
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListEmplaceHead
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pPosition : receives the new headnode position, may be NULL
+ *
+ * Return Value:
+ * 	- payload of the new headnode, nMaxDataSize uninitialized bytes
+ * 	- Return NULL if allocation fails, the list is by-reference or has
+ * 	  a hash index
+ *
+ * Desc: 
+ * 	- add list element to list head without copying any data; the caller
+ * 	  builds the record in the returned payload
+ *
+ * --------------------------------------------------------------------------*/
+void* ListEmplaceHead(struct CList *pThis, POSITION* pPosition) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pThis->pOps->Emplace == NULL)
+		return NULL;
+
+	pos = pThis->pOps->Emplace(pThis, NULL, 0);
+
+	if (pos == NULL)
+		return NULL;
+
+	if (pPosition != NULL)
+		*pPosition = pos;
+
+	return pThis->pOps->GetAt(pThis, pos);
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListEmplaceTail
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pPosition : receives the new tail node position, may be NULL
+ *
+ * Return Value:
+ * 	- payload of the new tail node, nMaxDataSize uninitialized bytes
+ * 	- Return NULL if allocation fails, the list is by-reference or has
+ * 	  a hash index
+ *
+ * Desc: 
+ * 	- add list element to list tail without copying any data
+ *
+ * --------------------------------------------------------------------------*/
+void* ListEmplaceTail(struct CList *pThis, POSITION* pPosition) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pThis->pOps->Emplace == NULL)
+		return NULL;
+
+	pos = pThis->pOps->Emplace(pThis, NULL, 1);
+
+	if (pos == NULL)
+		return NULL;
+
+	if (pPosition != NULL)
+		*pPosition = pos;
+
+	return pThis->pOps->GetAt(pThis, pos);
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListEmplaceNext
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : list element location which to insert
+ * 	- pPosition : receives the new element position, may be NULL
+ *
+ * Return Value:
+ * 	- payload of the new element, nMaxDataSize uninitialized bytes
+ * 	- Return NULL if position is NULL, allocation fails, the list is
+ * 	  by-reference or has a hash index
+ *
+ * Desc: 
+ * 	- insert list element next to position without copying any data
+ *
+ * --------------------------------------------------------------------------*/
+void* ListEmplaceNext(struct CList *pThis, POSITION position, POSITION* pPosition) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pThis->pOps->Emplace == NULL)
+		return NULL;
+
+	pos = pThis->pOps->Emplace(pThis, position, 1);
+
+	if (pos == NULL)
+		return NULL;
+
+	if (pPosition != NULL)
+		*pPosition = pos;
+
+	return pThis->pOps->GetAt(pThis, pos);
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListEmplacePrev
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : list element location which to insert
+ * 	- pPosition : receives the new element position, may be NULL
+ *
+ * Return Value:
+ * 	- payload of the new element, nMaxDataSize uninitialized bytes
+ * 	- Return NULL if position is NULL, allocation fails, the list is
+ * 	  by-reference or has a hash index
+ *
+ * Desc: 
+ * 	- insert list element previous to position without copying any data
+ *
+ * --------------------------------------------------------------------------*/
+void* ListEmplacePrev(struct CList *pThis, POSITION position, POSITION* pPosition) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pThis->pOps->Emplace == NULL)
+		return NULL;
+
+	pos = pThis->pOps->Emplace(pThis, position, 0);
+
+	if (pos == NULL)
+		return NULL;
+
+	if (pPosition != NULL)
+		*pPosition = pos;
+
+	return pThis->pOps->GetAt(pThis, pos);
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListSplice
+ *
+ * Parameter:
+ * 	- pDst : list receiving the elements
+ * 	- dstPos : pDst element to insert in front of, NULL to append
+ * 	- pSrc : list giving the elements, may be pDst
+ * 	- first, last : first and last element of the pSrc range to move
+ *
+ * Return Value:
+ * 	- number of elements moved
+ * 	- Return -1 if arguments are invalid, the lists hold different data
+ * 	  sizes, only one of them is by-reference, last does not follow first
+ * 	  or dstPos lies inside the range; if either list is read-only
+ * 	  (InitListMapped); also if pSrc is a sized list (InitListSized) and
+ * 	  the elements would have to be copied
+ *
+ * Desc: 
+ * 	- move first .. last from pSrc to pDst. Node lists with the same node
+ * 	  layout and allocator (no node pool and the same InitListWithAllocator
+ * 	  functions, or both are the same list) relink the ListElems with O(1)
+ * 	  link updates; positions stay valid and move with their elements.
+ * 	  Otherwise elements are copied to pDst and removed from pSrc one at a
+ * 	  time.
+ * 	- finding nCount of both lists costs nothing for a whole list, and
+ * 	  O(min(k, n - k)) for a range that starts at the head or ends at the
+ * 	  tail; other ranges are walked. Indexed lists pay O(log n) per moved
+ * 	  element to keep their rank trees.
+ * 	- moving a whole list into an empty list of the same storage hands
+ * 	  over the elements together with their allocator, in O(1)
+ *
+ * --------------------------------------------------------------------------*/
+int ListSplice(struct CList *pDst, POSITION dstPos, struct CList *pSrc,
+		POSITION first, POSITION last) {
+
+	ListElem	*pFirst = (ListElem *)first;
+	ListElem	*pLast = (ListElem *)last;
+	int			bWholeList;
+	int			nItems;
+
+	if (pDst == NULL || pSrc == NULL || first == NULL || last == NULL ||
+			pSrc->nCount == 0 || pDst->nMaxDataSize != pSrc->nMaxDataSize)
+		return -1;
+
+	/* a copy would store the payload address in place of the pointer */
+	if ((pDst->pOps == &g_CListRefOps) != (pSrc->pOps == &g_CListRefOps))
+		return -1;
+
+	if (LIST_IS_READ_ONLY(pDst) || LIST_IS_READ_ONLY(pSrc))
+		return -1;
+
+	bWholeList = (first == pSrc->pOps->GetHeadPosition(pSrc) &&
+			last == pSrc->pOps->GetTailPosition(pSrc));
+
+	if (pDst != pSrc && bWholeList && pDst->nCount == 0 &&
+			pDst->pOps == pSrc->pOps && pDst->nNodeHeader == pSrc->nNodeHeader &&
+			pDst->pHash == NULL && pSrc->pHash == NULL) {
+		nItems = pSrc->nCount;
+		CListSwapElements(pDst, pSrc);
+		return nItems;
+	}
+
+	if (!LIST_IS_NODE_LINKED(pSrc) || !LIST_IS_NODE_LINKED(pDst)) {
+
+		/* copies would shift the payloads being walked, or read past the
+		 * end of sized ones */
+		if (pDst == pSrc || LIST_IS_SIZED(pSrc))
+			return -1;
+
+		nItems = CListCountRange(pSrc, first, last, NULL);
+		if (nItems < 0)
+			return -1;
+
+		return CListCopyRun(pDst, dstPos, pSrc, first, nItems);
+	}
+
+	if (pDst == pSrc)
+		nItems = CListCountRange(pSrc, first, last, dstPos);
+	else if (bWholeList)
+		nItems = pSrc->nCount;
+	else if (pFirst == pSrc->pHeadNode)
+		nItems = CListCountFromHead(pSrc, pLast);
+	else if (pLast == pSrc->pTailNode)
+		nItems = CListCountToTail(pSrc, pFirst);
+	else
+		nItems = CListCountRange(pSrc, first, last, NULL);
+
+	if (nItems < 0)
+		return -1;
+
+	if (pDst->nNodeHeader != pSrc->nNodeHeader || !LIST_SAME_ALLOCATOR(pDst, pSrc))
+		return CListCopyRun(pDst, dstPos, pSrc, first, nItems);
+
+	CListMoveRun(pDst, (ListElem *)dstPos, pSrc, pFirst, pLast, nItems);
+
+	return nItems;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListConcat
+ *
+ * Parameter:
+ * 	- pDst : list receiving the elements
+ * 	- pSrc : list giving all of its elements, empty afterwards
+ *
+ * Return Value:
+ * 	- number of elements moved
+ * 	- Return -1 if arguments are invalid or the lists hold different data
+ * 	  sizes
+ *
+ * Desc: 
+ * 	- append every element of pSrc to pDst, O(1) for relinked node lists.
+ * 	  See ListSplice.
+ *
+ * --------------------------------------------------------------------------*/
+int ListConcat(struct CList *pDst, struct CList *pSrc) {
+
+	if (pDst == NULL || pSrc == NULL || pDst == pSrc ||
+			pDst->nMaxDataSize != pSrc->nMaxDataSize)
+		return -1;
+
+	if (pSrc->nCount == 0)
+		return 0;
+
+	return ListSplice(pDst, NULL, pSrc, pSrc->pOps->GetHeadPosition(pSrc),
+			pSrc->pOps->GetTailPosition(pSrc));
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListSplitAt
+ *
+ * Parameter:
+ * 	- pSrc : list to split
+ * 	- position : first pSrc element to move
+ * 	- pDst : list receiving position .. tail of pSrc at its tail
+ *
+ * Return Value:
+ * 	- number of elements moved
+ * 	- Return -1 if arguments are invalid or the lists hold different data
+ * 	  sizes
+ *
+ * Desc: 
+ * 	- cut pSrc in front of position. Relinked node lists spend
+ * 	  O(min(k, n - k)) steps counting the moved elements, or none if
+ * 	  position was the last one FindIndex returned. See ListSplice.
+ *
+ * --------------------------------------------------------------------------*/
+int ListSplitAt(struct CList *pSrc, POSITION position, struct CList *pDst) {
+
+	if (pDst == NULL || pSrc == NULL || pDst == pSrc || position == NULL)
+		return -1;
+
+	return ListSplice(pDst, NULL, pSrc, position, pSrc->pOps->GetTailPosition(pSrc));
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListMoveToHead
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to move
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid or the list is not node-linked,
+ * 	  else returns 0
+ *
+ * Desc: 
+ * 	- make the element the head by relinking its node. Nothing is
+ * 	  allocated or copied and position stays valid; a hash index is left
+ * 	  as it is, a rank index pays O(log n).
+ *
+ * --------------------------------------------------------------------------*/
+int ListMoveToHead(struct CList *pThis, POSITION position) {
+
+	ListElem *pListElem = (ListElem *)position;
+
+	if (pThis == NULL || position == NULL || !LIST_IS_NODE_LINKED(pThis))
+		return -1;
+
+	if (pListElem != pThis->pHeadNode)
+		CListMoveElem(pThis, pListElem, NULL, pThis->pHeadNode);
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListMoveToTail
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to move
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid or the list is not node-linked,
+ * 	  else returns 0
+ *
+ * Desc: 
+ * 	- make the element the tail by relinking its node, see ListMoveToHead
+ *
+ * --------------------------------------------------------------------------*/
+int ListMoveToTail(struct CList *pThis, POSITION position) {
+
+	ListElem *pListElem = (ListElem *)position;
+
+	if (pThis == NULL || position == NULL || !LIST_IS_NODE_LINKED(pThis))
+		return -1;
+
+	if (pListElem != pThis->pTailNode)
+		CListMoveElem(pThis, pListElem, pThis->pTailNode, NULL);
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListFind
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pKey : what to look for, passed to cmp as its first argument
+ * 	- cmp : returns 0 if pKey matches the payload in its second argument
+ * 	        (the stored pointer for InitListByRef lists); NULL compares
+ * 	        nMaxDataSize bytes at pKey with the payload, or pKey with the
+ * 	        stored pointer
+ * 	- startPos : first element to test, NULL for the head
+ *
+ * Return Value:
+ * 	- position of the first match at or after startPos, NULL if none
+ *
+ * Desc: 
+ * 	- linear search by content. To find every match, continue from the
+ * 	  position following the last one found. Node-linked lists are walked
+ * 	  through their links without a call per element.
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListFind(struct CList *pThis, const void* pKey, CListCompareFn cmp,
+		POSITION startPos) {
+
+	ListElem	*pListElem;
+	POSITION	pos;
+	POSITION	posAt;
+	const void	*pData;
+	int			bRef;
+
+	/* sized payloads may be shorter than the key */
+	if (pThis == NULL || pKey == NULL || (cmp == NULL && LIST_IS_SIZED(pThis)))
+		return NULL;
+
+	if (LIST_IS_NODE_LINKED(pThis)) {
+
+		bRef = (pThis->pOps == &g_CListRefOps);
+		pListElem = (startPos != NULL) ? (ListElem *)startPos : pThis->pHeadNode;
+
+		for (; pListElem != NULL; pListElem = pListElem->next) {
+
+			pData = bRef ? *(void **)pListElem->data : (const void *)pListElem->data;
+
+			if (cmp != NULL ? cmp(pKey, pData) == 0 :
+					bRef ? pKey == pData :
+					memcmp(pKey, pData, pThis->nMaxDataSize) == 0)
+				return (POSITION)pListElem;
+		}
+
+		return NULL;
+	}
+
+	pos = (startPos != NULL) ? startPos : pThis->pOps->GetHeadPosition(pThis);
+
+	while (pos != NULL) {
+
+		posAt = pos;
+		pData = pThis->pOps->GetNext(pThis, &pos);
+
+		if (cmp != NULL ? cmp(pKey, pData) == 0 :
+				memcmp(pKey, pData, pThis->nMaxDataSize) == 0)
+			return posAt;
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListFindIf
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pred : returns nonzero for a wanted payload (the stored pointer for
+ * 	         InitListByRef lists)
+ * 	- pContext : passed to pred unchanged
+ * 	- startPos : first element to test, NULL for the head
+ *
+ * Return Value:
+ * 	- position of the first element at or after startPos that pred
+ * 	  accepts, NULL if none
+ *
+ * Desc: 
+ * 	- linear search by predicate, see ListFind
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListFindIf(struct CList *pThis, CListPredicateFn pred, void *pContext,
+		POSITION startPos) {
+
+	ListElem	*pListElem;
+	POSITION	pos;
+	POSITION	posAt;
+	int			bRef;
+
+	if (pThis == NULL || pred == NULL)
+		return NULL;
+
+	if (LIST_IS_NODE_LINKED(pThis)) {
+
+		bRef = (pThis->pOps == &g_CListRefOps);
+		pListElem = (startPos != NULL) ? (ListElem *)startPos : pThis->pHeadNode;
+
+		for (; pListElem != NULL; pListElem = pListElem->next) {
+			if (pred(bRef ? *(void **)pListElem->data : (const void *)pListElem->data,
+					pContext))
+				return (POSITION)pListElem;
+		}
+
+		return NULL;
+	}
+
+	pos = (startPos != NULL) ? startPos : pThis->pOps->GetHeadPosition(pThis);
+
+	while (pos != NULL) {
+		posAt = pos;
+		if (pred(pThis->pOps->GetNext(pThis, &pos), pContext))
+			return posAt;
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListFindKey
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pKey : nKeyLen bytes of key, see ListEnableHashIndex
+ *
+ * Return Value:
+ * 	- position of an element with that key, NULL if there is none or the
+ * 	  list has no hash index
+ *
+ * Desc: 
+ * 	- O(1) average lookup through the hash index. With duplicate keys any
+ * 	  one of the elements may be returned.
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListFindKey(struct CList *pThis, const void* pKey) {
+
+	if (pThis == NULL || pKey == NULL || pThis->pHash == NULL)
+		return NULL;
+
+	return (POSITION)CListHashFind(pThis, pKey);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListDestroyNodes
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- LIST_STORAGE_NODE teardown. Pooled nodes go away with their slabs,
+ * 	  arena nodes with the arena's chunks.
+ *
+ * --------------------------------------------------------------------------*/
+void CListDestroyNodes(struct CList *pThis) {
+
+	if (pThis->pPool != NULL) {
+		CListDestroyPool(pThis, pThis->pPool);
+		pThis->pPool = NULL;
+	}
+	else if (pThis->pArena != NULL) {
+		CListArenaClear(pThis);
+		DestroyListArena(&pThis->pArena->arena);
+		free(pThis->pArena);
+		pThis->pArena = NULL;
+		pThis->pAllocContext = NULL;
+	}
+	else {
+		CListRemoveAll(pThis);
+	}
+
+	free(pThis->pIndex);
+	pThis->pIndex = NULL;
+
+	if (pThis->pHash != NULL)
+		LIST_STAT_FREE(pThis, pThis->pHash->nBuckets * sizeof(ListElem *));
+
+	CListHashDestroy(pThis->pHash);
+	pThis->pHash = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListEmplaceElem
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to insert next to, NULL for head or tail
+ * 	- bAfter : insert after position (or at tail), else before (or at head)
+ *
+ * Return Value:
+ * 	- position of the new element, NULL if allocation fails
+ *
+ * Desc: 
+ * 	- LIST_STORAGE_NODE Emplace: link a node whose payload is left
+ * 	  uninitialized
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListEmplaceElem(struct CList *pThis, POSITION position, int bAfter) {
+
+	ListElem *pListElem;
+	ListElem *pAt = (ListElem *)position;
+
+	/* there is no key to hash until the caller writes the payload */
+	if (pThis->pHash != NULL)
+		return NULL;
+
+	pListElem = CListAllocElem(pThis, NULL);
+
+	if (pListElem == NULL)
+		return NULL;
+
+	if (pAt == NULL) {
+		if (bAfter)
+			CListLinkElem(pThis, pListElem, pThis->pTailNode, NULL);
+		else
+			CListLinkElem(pThis, pListElem, NULL, pThis->pHeadNode);
+	}
+	else if (bAfter) {
+		CListLinkElem(pThis, pListElem, pAt, pAt->next);
+	}
+	else {
+		CListLinkElem(pThis, pListElem, pAt->prev, pAt);
+	}
+
+	return (POSITION)pListElem;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListAllocElem
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : data copied into the new element, NULL to leave the payload
+ * 	          uninitialized
+ *
+ * Return Value:
+ * 	- new unlinked list element, NULL if allocation fails
+ *
+ * Desc: 
+ * 	- allocate node header, links and payload of a list element as one block
+ *
+ * --------------------------------------------------------------------------*/
+static ListElem* CListAllocElem(struct CList *pThis, const void* pData) {
+
+	unsigned char *pBlock;
+	ListElem *pListElem;
+	size_t nSize = pThis->nNodeHeader + LIST_ELEM_SIZE(pThis->nMaxDataSize);
+
+	if (pThis->pPool != NULL) {
+		pBlock = (unsigned char *)CListPoolAlloc(pThis, pThis->pPool);
+	}
+	else {
+		if (pThis->pfnAlloc != NULL)
+			pBlock = (unsigned char *)pThis->pfnAlloc(nSize, pThis->pAllocContext);
+		else
+			pBlock = (unsigned char *)malloc(nSize);
+
+		if (pBlock != NULL)
+			LIST_STAT_ALLOC(pThis, nSize);
+	}
+
+	if (pBlock == NULL) {
+		LIST_STAT_FAIL(pThis);
+		return NULL;
+	}
+
+	pListElem = (ListElem *)(pBlock + pThis->nNodeHeader);
+	pListElem->next = NULL;
+	pListElem->prev = NULL;
+
+	if (pData != NULL)
+		memcpy(pListElem->data, pData, pThis->nMaxDataSize);
+
+	return pListElem;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListFreeElem
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : unlinked list element
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- release list element allocated by CListAllocElem
+ *
+ * --------------------------------------------------------------------------*/
+static void CListFreeElem(struct CList *pThis, ListElem *pListElem) {
+
+	void *pBlock = LIST_NODE_BLOCK(pThis, pListElem);
+	size_t nSize = pThis->nNodeHeader + LIST_ELEM_SIZE(pThis->nMaxDataSize);
+
+	if (pThis->pPool != NULL) {
+		*(void **)pBlock = pThis->pPool->pFree;
+		pThis->pPool->pFree = pBlock;
+		return;
+	}
+
+	LIST_STAT_FREE(pThis, nSize);
+
+	if (pThis->pfnFree != NULL)
+		pThis->pfnFree(pBlock, nSize, pThis->pAllocContext);
+	else
+		free(pBlock);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListGrowNodeHeader
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer), empty
+ * 	- nBytes : bookkeeping bytes to add in front of every node
+ *
+ * Return Value:
+ * 	- Return -1 if the pool can not be recreated, else returns 0
+ *
+ * Desc: 
+ * 	- make room for an optional feature's per-node header. A pool's slabs
+ * 	  are carved for the old node size, so they are recreated.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListGrowNodeHeader(struct CList *pThis, int nBytes) {
+
+	struct ListNodePool *pPool;
+
+	if (pThis->pPool != NULL) {
+
+		pPool = CListCreatePool(pThis, nBytes + pThis->nNodeHeader +
+				LIST_ELEM_SIZE(pThis->nMaxDataSize), pThis->pPool->nCapacity);
+
+		if (pPool == NULL)
+			return -1;
+
+		CListDestroyPool(pThis, pThis->pPool);
+		pThis->pPool = pPool;
+	}
+
+	/* blocks kept for reuse are too small from now on */
+	if (pThis->pArena != NULL)
+		CListArenaClear(pThis);
+
+	pThis->nNodeHeader += nBytes;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListLinkElem
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : unlinked list element
+ * 	- pPrev, pNext : adjacent elements to link between, NULL at head/tail
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- link element and keep count, FindIndex cursor and indexes in step
+ *
+ * --------------------------------------------------------------------------*/
+void CListLinkElem(struct CList *pThis, ListElem *pListElem,
+		ListElem *pPrev, ListElem *pNext) {
+
+	pListElem->prev = pPrev;
+	pListElem->next = pNext;
+
+	if (pPrev != NULL)
+		pPrev->next = pListElem;
+	else
+		pThis->pHeadNode = pListElem;
+
+	if (pNext != NULL)
+		pNext->prev = pListElem;
+	else
+		pThis->pTailNode = pListElem;
+
+	pThis->nCount++;
+	pThis->nLinkVersion++;
+	LIST_STAT_COUNT(pThis);
+
+	/* the cursor index only moves if the element went in front of it */
+	if (pThis->pCursorNode != NULL && pNext != NULL) {
+		if (pPrev == NULL || pNext == pThis->pCursorNode)
+			pThis->nCursorIndex++;
+		else if (pPrev != pThis->pCursorNode)
+			pThis->pCursorNode = NULL;
+	}
+
+	if (pThis->pIndex != NULL)
+		CListIndexInsert(pThis->pIndex, pListElem, pPrev, pNext);
+
+	if (pThis->pHash != NULL)
+		CListHashInsert(pThis, pListElem);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListUnlinkElem
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : linked list element
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- unlink element and keep count, FindIndex cursor and indexes in step
+ *
+ * --------------------------------------------------------------------------*/
+void CListUnlinkElem(struct CList *pThis, ListElem *pListElem) {
+
+	ListElem *pCursor = pThis->pCursorNode;
+
+	if (pCursor != NULL) {
+		if (pListElem == pCursor) {
+			/* the next element inherits the cursor's index */
+			pThis->pCursorNode = pListElem->next;
+		}
+		else if (pListElem->prev == NULL || pListElem == pCursor->prev) {
+			pThis->nCursorIndex--;
+		}
+		else if (pListElem->next != NULL && pListElem != pCursor->next) {
+			pThis->pCursorNode = NULL;
+		}
+	}
+
+	if (pThis->pIndex != NULL)
+		CListIndexRemove(pThis->pIndex, pListElem);
+
+	if (pThis->pHash != NULL)
+		CListHashRemove(pThis, pListElem);
+
+	if (pListElem->prev != NULL)
+		pListElem->prev->next = pListElem->next;
+	else
+		pThis->pHeadNode = pListElem->next;
+
+	if (pListElem->next != NULL)
+		pListElem->next->prev = pListElem->prev;
+	else
+		pThis->pTailNode = pListElem->prev;
+
+	pThis->nCount--;
+	pThis->nLinkVersion++;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListMoveElem
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : linked list element
+ * 	- pPrev, pNext : adjacent elements to link between, NULL at head/tail,
+ * 	                 neither of them pListElem
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- move an element within its list. Count and hash chains do not
+ * 	  change; the rank index takes the element out and back in. The
+ * 	  FindIndex cursor survives only if it is the moved element and that
+ * 	  lands at head or tail.
+ *
+ * --------------------------------------------------------------------------*/
+static void CListMoveElem(struct CList *pThis, ListElem *pListElem,
+		ListElem *pPrev, ListElem *pNext) {
+
+	if (pThis->pIndex != NULL)
+		CListIndexRemove(pThis->pIndex, pListElem);
+
+	if (pListElem->prev != NULL)
+		pListElem->prev->next = pListElem->next;
+	else
+		pThis->pHeadNode = pListElem->next;
+
+	if (pListElem->next != NULL)
+		pListElem->next->prev = pListElem->prev;
+	else
+		pThis->pTailNode = pListElem->prev;
+
+	pListElem->prev = pPrev;
+	pListElem->next = pNext;
+
+	if (pPrev != NULL)
+		pPrev->next = pListElem;
+	else
+		pThis->pHeadNode = pListElem;
+
+	if (pNext != NULL)
+		pNext->prev = pListElem;
+	else
+		pThis->pTailNode = pListElem;
+
+	pThis->nLinkVersion++;
+
+	if (pThis->pIndex != NULL)
+		CListIndexInsert(pThis->pIndex, pListElem, pPrev, pNext);
+
+	/* the elements in between shift by one, in a direction not known here */
+	if (pListElem == pThis->pCursorNode && pPrev == NULL)
+		pThis->nCursorIndex = 0;
+	else if (pListElem == pThis->pCursorNode && pNext == NULL)
+		pThis->nCursorIndex = pThis->nCount - 1;
+	else
+		pThis->pCursorNode = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListAllocRun
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : nItems records copied into the new elements
+ * 	- nItems : number of elements
+ * 	- ppLast : receives the last element of the run
+ *
+ * Return Value:
+ * 	- first element of an unlinked run chained through next/prev, NULL if
+ * 	  allocation fails
+ *
+ * Desc: 
+ * 	- take the nodes of a run from the node pool: removed nodes first, the
+ * 	  rest as one block. Lists without a pool allocate them one by one,
+ * 	  like AddTail, so their nodes stay individually freed.
+ *
+ * --------------------------------------------------------------------------*/
+static ListElem* CListAllocRun(struct CList *pThis, const void* pData,
+		int nItems, ListElem **ppLast) {
+
+	const unsigned char *pRecord = (const unsigned char *)pData;
+	struct ListNodePool *pPool;
+	unsigned char	*pBlock = NULL;
+	void			*pFree;
+	ListElem		*pFirst = NULL;
+	ListElem		*pPrev = NULL;
+	ListElem		*pListElem;
+	int				nReuse = 0;
+	int				i;
+
+	pPool = pThis->pPool;
+
+	if (pPool != NULL) {
+
+		/* removed nodes are reused first, the rest is carved as one run */
+		for (pFree = pPool->pFree; pFree != NULL && nReuse < nItems; nReuse++)
+			pFree = *(void **)pFree;
+
+		if (nReuse < nItems) {
+			pBlock = (unsigned char *)CListPoolAllocRun(pThis, pPool, nItems - nReuse);
+			if (pBlock == NULL) {
+				LIST_STAT_FAIL(pThis);
+				return NULL;
+			}
+		}
+	}
+
+	for (i = 0; i < nItems; i++) {
+
+		if (pPool != NULL) {
+			if (i < nReuse) {
+				pFree = pPool->pFree;
+				pPool->pFree = *(void **)pFree;
+				pListElem = (ListElem *)((unsigned char *)pFree + pThis->nNodeHeader);
+			}
+			else {
+				pListElem = (ListElem *)(pBlock + pThis->nNodeHeader);
+				pBlock += pPool->nNodeSize;
+			}
+			memcpy(pListElem->data, pRecord, pThis->nMaxDataSize);
+		}
+		else {
+			pListElem = CListAllocElem(pThis, pRecord);
+			if (pListElem == NULL) {
+				for (; pPrev != NULL; pPrev = pListElem) {
+					pListElem = pPrev->prev;
+					CListFreeElem(pThis, pPrev);
+				}
+				return NULL;
+			}
+		}
+
+		pRecord += pThis->nMaxDataSize;
+
+		pListElem->prev = pPrev;
+		if (pPrev != NULL)
+			pPrev->next = pListElem;
+		else
+			pFirst = pListElem;
+		pPrev = pListElem;
+	}
+
+	pPrev->next = NULL;
+	*ppLast = pPrev;
+
+	return pFirst;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListLinkRun
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pFirst, pLast : ends of an unlinked run from CListAllocRun
+ * 	- nItems : number of elements in the run
+ * 	- pPrev, pNext : adjacent elements to link between, NULL at head/tail
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- attach the run with the link updates of a single element and keep
+ * 	  count, FindIndex cursor and indexes in step, see CListLinkElem
+ *
+ * --------------------------------------------------------------------------*/
+static void CListLinkRun(struct CList *pThis, ListElem *pFirst, ListElem *pLast,
+		int nItems, ListElem *pPrev, ListElem *pNext) {
+
+	ListElem *pListElem;
+
+	pFirst->prev = pPrev;
+	pLast->next = pNext;
+
+	if (pPrev != NULL)
+		pPrev->next = pFirst;
+	else
+		pThis->pHeadNode = pFirst;
+
+	if (pNext != NULL)
+		pNext->prev = pLast;
+	else
+		pThis->pTailNode = pLast;
+
+	pThis->nCount += nItems;
+	pThis->nLinkVersion++;
+	LIST_STAT_COUNT(pThis);
+
+	if (pThis->pCursorNode != NULL && pNext != NULL) {
+		if (pPrev == NULL || pNext == pThis->pCursorNode)
+			pThis->nCursorIndex += nItems;
+		else if (pPrev != pThis->pCursorNode)
+			pThis->pCursorNode = NULL;
+	}
+
+	/* every run element goes in between its predecessor and pNext */
+	if (pThis->pIndex != NULL) {
+		for (pListElem = pFirst; pListElem != pNext; pListElem = pListElem->next)
+			CListIndexInsert(pThis->pIndex, pListElem, pListElem->prev, pNext);
+	}
+
+	if (pThis->pHash != NULL) {
+		for (pListElem = pFirst; pListElem != pNext; pListElem = pListElem->next)
+			CListHashInsert(pThis, pListElem);
+	}
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListRemoveRun
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pFirst : first element of the run
+ * 	- nItems : number of elements in the run, all of them linked
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- release the run's nodes in one walk, then close the gap with the link
+ * 	  updates of a single element. Count, FindIndex cursor and indexes
+ * 	  are kept in step, see CListUnlinkElem.
+ *
+ * --------------------------------------------------------------------------*/
+static void CListRemoveRun(struct CList *pThis, ListElem *pFirst, int nItems) {
+
+	ListElem	*pPrev = pFirst->prev;
+	ListElem	*pNext = NULL;
+	ListElem	*pListElem = pFirst;
+	int			bCursorRemoved = 0;
+	int			i;
+
+	for (i = 0; i < nItems; i++) {
+
+		pNext = pListElem->next;
+
+		if (pListElem == pThis->pCursorNode)
+			bCursorRemoved = 1;
+
+		if (pThis->pIndex != NULL)
+			CListIndexRemove(pThis->pIndex, pListElem);
+
+		if (pThis->pHash != NULL)
+			CListHashRemove(pThis, pListElem);
+
+		CListFreeElem(pThis, pListElem);
+		pListElem = pNext;
+	}
+
+	if (pPrev != NULL)
+		pPrev->next = pNext;
+	else
+		pThis->pHeadNode = pNext;
+
+	if (pNext != NULL)
+		pNext->prev = pPrev;
+	else
+		pThis->pTailNode = pPrev;
+
+	pThis->nCount -= nItems;
+	pThis->nLinkVersion++;
+
+	/* a run in the middle may lie before or after the cursor */
+	if (pThis->pCursorNode != NULL) {
+		if (bCursorRemoved || (pPrev != NULL && pNext != NULL))
+			pThis->pCursorNode = NULL;
+		else if (pPrev == NULL)
+			pThis->nCursorIndex -= nItems;
+	}
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCountRange
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- first, last : ends of the range
+ * 	- posExclude : position that must not be inside the range, or NULL
+ *
+ * Return Value:
+ * 	- number of elements in first .. last, -1 if last does not follow
+ * 	  first or posExclude is inside
+ *
+ * Desc: 
+ * 	- walk the range with the list's own GetNext
+ *
+ * --------------------------------------------------------------------------*/
+static int CListCountRange(struct CList *pThis, POSITION first, POSITION last,
+		POSITION posExclude) {
+
+	POSITION	pos = first;
+	POSITION	posAt;
+	int			nItems = 0;
+
+	do {
+		if (pos == NULL || pos == posExclude)
+			return -1;
+		posAt = pos;
+		pThis->pOps->GetNext(pThis, &pos);
+		nItems++;
+	} while (posAt != last);
+
+	return nItems;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCountFromHead
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : linked list element
+ *
+ * Return Value:
+ * 	- number of elements from the headnode to pListElem, both included
+ *
+ * Desc: 
+ * 	- walk towards both ends at once and stop at whichever comes first,
+ * 	  so the cost is O(min(k, n - k)). The FindIndex cursor answers at once.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListCountFromHead(struct CList *pThis, ListElem *pListElem) {
+
+	ListElem	*pBack = pListElem;
+	ListElem	*pFore = pListElem;
+	int			nSteps;
+
+	if (pListElem == pThis->pCursorNode)
+		return pThis->nCursorIndex + 1;
+
+	for (nSteps = 0; ; nSteps++) {
+		if (pBack == pThis->pHeadNode)
+			return nSteps + 1;
+		if (pFore == pThis->pTailNode)
+			return pThis->nCount - nSteps;
+		pBack = pBack->prev;
+		pFore = pFore->next;
+	}
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCountToTail
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : linked list element
+ *
+ * Return Value:
+ * 	- number of elements from pListElem to the tailnode, both included
+ *
+ * Desc: 
+ * 	- see CListCountFromHead
+ *
+ * --------------------------------------------------------------------------*/
+static int CListCountToTail(struct CList *pThis, ListElem *pListElem) {
+
+	ListElem	*pBack = pListElem;
+	ListElem	*pFore = pListElem;
+	int			nSteps;
+
+	if (pListElem == pThis->pCursorNode)
+		return pThis->nCount - pThis->nCursorIndex;
+
+	for (nSteps = 0; ; nSteps++) {
+		if (pFore == pThis->pTailNode)
+			return nSteps + 1;
+		if (pBack == pThis->pHeadNode)
+			return pThis->nCount - nSteps;
+		pBack = pBack->prev;
+		pFore = pFore->next;
+	}
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListSwapElements
+ *
+ * Parameter:
+ * 	- pDst, pSrc : lists of the same storage and node layout
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- exchange the elements of two lists along with the allocator and
+ * 	  index that own them
+ *
+ * --------------------------------------------------------------------------*/
+static void CListSwapElements(struct CList *pDst, struct CList *pSrc) {
+
+	CList tmp = *pDst;
+
+	pDst->nCount = pSrc->nCount;
+	pDst->pHeadNode = pSrc->pHeadNode;
+	pDst->pTailNode = pSrc->pTailNode;
+	pDst->pPool = pSrc->pPool;
+	pDst->pfnAlloc = pSrc->pfnAlloc;
+	pDst->pfnFree = pSrc->pfnFree;
+	pDst->pAllocContext = pSrc->pAllocContext;
+	pDst->pArena = pSrc->pArena;
+	pDst->nCursorIndex = pSrc->nCursorIndex;
+	pDst->pCursorNode = pSrc->pCursorNode;
+	pDst->pIndex = pSrc->pIndex;
+	pDst->pStorage = pSrc->pStorage;
+
+	pSrc->nCount = tmp.nCount;
+	pSrc->pHeadNode = tmp.pHeadNode;
+	pSrc->pTailNode = tmp.pTailNode;
+	pSrc->pPool = tmp.pPool;
+	pSrc->pfnAlloc = tmp.pfnAlloc;
+	pSrc->pfnFree = tmp.pfnFree;
+	pSrc->pAllocContext = tmp.pAllocContext;
+	pSrc->pArena = tmp.pArena;
+	pSrc->nCursorIndex = tmp.nCursorIndex;
+	pSrc->pCursorNode = tmp.pCursorNode;
+	pSrc->pIndex = tmp.pIndex;
+	pSrc->pStorage = tmp.pStorage;
+
+	pDst->nLinkVersion++;
+	pSrc->nLinkVersion++;
+
+	LIST_STAT_SWAP(pDst, pSrc);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListMoveRun
+ *
+ * Parameter:
+ * 	- pDst : list receiving the run
+ * 	- pNext : pDst element to link the run in front of, NULL for the tail
+ * 	- pSrc : list holding the run, may be pDst
+ * 	- pFirst, pLast : ends of the run
+ * 	- nItems : number of elements in the run
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- detach the run from pSrc and link it into pDst, both with O(1) link
+ * 	  updates. Rank and hash indexes are updated per element; a moved
+ * 	  element is hashed again with pDst's key.
+ *
+ * --------------------------------------------------------------------------*/
+static void CListMoveRun(struct CList *pDst, ListElem *pNext, struct CList *pSrc,
+		ListElem *pFirst, ListElem *pLast, int nItems) {
+
+	ListElem *pListElem;
+
+	if (pSrc->pIndex != NULL) {
+		for (pListElem = pFirst; pListElem != pLast->next; pListElem = pListElem->next)
+			CListIndexRemove(pSrc->pIndex, pListElem);
+	}
+
+	if (pSrc->pHash != NULL) {
+		for (pListElem = pFirst; pListElem != pLast->next; pListElem = pListElem->next)
+			CListHashRemove(pSrc, pListElem);
+	}
+
+	if (pFirst->prev != NULL)
+		pFirst->prev->next = pLast->next;
+	else
+		pSrc->pHeadNode = pLast->next;
+
+	if (pLast->next != NULL)
+		pLast->next->prev = pFirst->prev;
+	else
+		pSrc->pTailNode = pFirst->prev;
+
+	pSrc->nCount -= nItems;
+	pSrc->pCursorNode = NULL;
+	pSrc->nLinkVersion++;
+
+	/* lists only exchange nodes they do not pool, see ListSplice */
+	if (pDst != pSrc) {
+		LIST_STAT_MOVE(pDst, pSrc, (size_t)nItems *
+				(pSrc->nNodeHeader + LIST_ELEM_SIZE(pSrc->nMaxDataSize)));
+	}
+
+	CListLinkRun(pDst, pFirst, pLast, nItems,
+			(pNext != NULL) ? pNext->prev : pDst->pTailNode, pNext);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCopyRun
+ *
+ * Parameter:
+ * 	- pDst : list receiving the elements
+ * 	- dstPos : pDst element to insert in front of, NULL to append
+ * 	- pSrc : another list holding the elements
+ * 	- first : first element to move
+ * 	- nItems : number of elements to move
+ *
+ * Return Value:
+ * 	- nItems, -1 if an allocation or a pSrc removal fails. Elements
+ * 	  moved until then stay in pDst.
+ *
+ * Desc: 
+ * 	- move elements by copying them through the operation tables, for
+ * 	  lists that can not hand over their nodes
+ *
+ * --------------------------------------------------------------------------*/
+static int CListCopyRun(struct CList *pDst, POSITION dstPos, struct CList *pSrc,
+		POSITION first, int nItems) {
+
+	POSITION	pos = first;
+	POSITION	posDst = NULL;
+	void		*pData;
+	int			i;
+
+	for (i = 0; i < nItems; i++) {
+
+		pData = pSrc->pOps->GetAt(pSrc, pos);
+
+		/* chain on the last insert, its position is the one known valid */
+		if (dstPos == NULL)
+			posDst = pDst->pOps->AddTail(pDst, pData);
+		else if (i == 0)
+			posDst = pDst->pOps->InsertPrev(pDst, dstPos, pData);
+		else
+			posDst = pDst->pOps->InsertNext(pDst, posDst, pData);
+
+		if (posDst == NULL)
+			return -1;
+
+		if (ListErase(pSrc, &pos) != 0)
+			return -1;
+	}
+
+	return nItems;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListCreatePool
+ *
+ * Parameter:
+ * 	- pThis : list the pool is created for, its slabs are counted there
+ * 	- nNodeSize : block size of every node, header and payload included
+ * 	- nCapacity : node count of the first slab
+ *
+ * Return Value:
+ * 	- new pool, NULL if allocation fails
+ *
+ * Desc: 
+ * 	- create node pool and allocate its first slab up front
+ *
+ * --------------------------------------------------------------------------*/
+static struct ListNodePool* CListCreatePool(struct CList *pThis, size_t nNodeSize,
+		int nCapacity) {
+
+	struct ListNodePool *pPool;
+
+	pPool = (struct ListNodePool *)calloc(1, sizeof(struct ListNodePool));
+
+	if (pPool == NULL)
+		return NULL;
+
+	pPool->nNodeSize = LIST_ALIGN_UP(nNodeSize, LIST_NODE_ALIGN);
+	pPool->nCapacity = (nCapacity > 0) ? nCapacity : LIST_POOL_DEFAULT_NODES;
+	pPool->nSlabNodes = pPool->nCapacity;
+
+	if (CListPoolAddSlab(pThis, pPool, 0) != 0) {
+		free(pPool);
+		return NULL;
+	}
+
+	return pPool;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListDestroyPool
+ *
+ * Parameter:
+ * 	- pThis : list owning the pool
+ * 	- pPool : node pool
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- release every slab, including nodes still linked in a list
+ *
+ * --------------------------------------------------------------------------*/
+static void CListDestroyPool(struct CList *pThis, struct ListNodePool *pPool) {
+
+	ListSlab *pSlab;
+
+	while (pPool->pSlabs != NULL) {
+		pSlab = pPool->pSlabs;
+		pPool->pSlabs = pSlab->pNext;
+		LIST_STAT_FREE(pThis, pSlab->nSize);
+		free(pSlab);
+	}
+
+	free(pPool);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListPoolAlloc
+ *
+ * Parameter:
+ * 	- pThis : list owning the pool
+ * 	- pPool : node pool
+ *
+ * Return Value:
+ * 	- uninitialized node block, NULL if a new slab can not be allocated
+ *
+ * Desc: 
+ * 	- reuse a removed node, else carve one from the current slab. A new slab
+ * 	  is allocated only when both are exhausted.
+ *
+ * --------------------------------------------------------------------------*/
+static void* CListPoolAlloc(struct CList *pThis, struct ListNodePool *pPool) {
+
+	void *pBlock;
+
+	if (pPool->pFree != NULL) {
+		pBlock = pPool->pFree;
+		pPool->pFree = *(void **)pBlock;
+		return pBlock;
+	}
+
+	if (pPool->pCursor == pPool->pLimit && CListPoolAddSlab(pThis, pPool, 0) != 0)
+		return NULL;
+
+	pBlock = pPool->pCursor;
+	pPool->pCursor += pPool->nNodeSize;
+
+	return pBlock;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListPoolAllocRun
+ *
+ * Parameter:
+ * 	- pThis : list owning the pool
+ * 	- pPool : node pool
+ * 	- nNodes : number of node blocks
+ *
+ * Return Value:
+ * 	- first of nNodes adjacent node blocks, NULL if a new slab can not be
+ * 	  allocated
+ *
+ * Desc: 
+ * 	- carve a run from the current slab, or from a new slab big enough to
+ * 	  hold it. What is left of the old slab goes to the free list.
+ *
+ * --------------------------------------------------------------------------*/
+static void* CListPoolAllocRun(struct CList *pThis, struct ListNodePool *pPool,
+		int nNodes) {
+
+	void *pBlock;
+
+	if ((size_t)(pPool->pLimit - pPool->pCursor) < pPool->nNodeSize * (size_t)nNodes) {
+
+		while (pPool->pCursor != pPool->pLimit) {
+			*(void **)pPool->pCursor = pPool->pFree;
+			pPool->pFree = pPool->pCursor;
+			pPool->pCursor += pPool->nNodeSize;
+		}
+
+		if (CListPoolAddSlab(pThis, pPool, nNodes) != 0)
+			return NULL;
+	}
+
+	pBlock = pPool->pCursor;
+	pPool->pCursor += pPool->nNodeSize * (size_t)nNodes;
+
+	return pBlock;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListPoolAddSlab
+ *
+ * Parameter:
+ * 	- pThis : list owning the pool
+ * 	- pPool : node pool
+ * 	- nMinNodes : the slab holds at least this many nodes
+ *
+ * Return Value:
+ * 	- Return -1 if slab can not be allocated, else returns 0
+ *
+ * Desc: 
+ * 	- allocate a slab of nSlabNodes nodes and carve from it from now on.
+ * 	  Every slab doubles the next one, up to LIST_POOL_MAX_SLAB_NODES.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListPoolAddSlab(struct CList *pThis, struct ListNodePool *pPool,
+		int nMinNodes) {
+
+	ListSlab *pSlab;
+	int nNodes = pPool->nSlabNodes;
+	size_t nSize;
+
+	if (nNodes < nMinNodes)
+		nNodes = nMinNodes;
+
+	nSize = LIST_SLAB_HEADER_SIZE + pPool->nNodeSize * (size_t)nNodes;
+	pSlab = (ListSlab *)malloc(nSize);
+
+	if (pSlab == NULL)
+		return -1;
+
+	LIST_STAT_ALLOC(pThis, nSize);
+
+#ifdef CLIST_STATS
+	pSlab->nSize = nSize;
+#endif
+	pSlab->pNext = pPool->pSlabs;
+	pPool->pSlabs = pSlab;
+
+	pPool->pCursor = (unsigned char *)pSlab + LIST_SLAB_HEADER_SIZE;
+	pPool->pLimit = pPool->pCursor + pPool->nNodeSize * (size_t)nNodes;
+
+	if (pPool->nSlabNodes < LIST_POOL_MAX_SLAB_NODES)
+		pPool->nSlabNodes *= 2;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListArenaAllocNode
+ *
+ * Parameter:
+ * 	- nSize : node block size
+ * 	- pContext : the list's ListNodeArena
+ *
+ * Return Value:
+ * 	- uninitialized node block, NULL if the arena can not grow
+ *
+ * Desc: 
+ * 	- reuse a removed node, else carve one from the arena
+ *
+ * --------------------------------------------------------------------------*/
+static void* CListArenaAllocNode(size_t nSize, void *pContext) {
+
+	struct ListNodeArena *pArena = (struct ListNodeArena *)pContext;
+	void *pBlock = pArena->pFree;
+
+	if (pBlock != NULL) {
+		pArena->pFree = *(void **)pBlock;
+		return pBlock;
+	}
+
+	return ListArenaAlloc(nSize, &pArena->arena);
+}
+
+/* keep a removed node for the next CListArenaAllocNode */
+static void CListArenaFreeNode(void *pBlock, size_t nSize, void *pContext) {
+
+	struct ListNodeArena *pArena = (struct ListNodeArena *)pContext;
+
+	(void)nSize;
+
+	*(void **)pBlock = pArena->pFree;
+	pArena->pFree = pBlock;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListArenaClear
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- take every node of an InitListWithArena list back by resetting its
+ * 	  arena, whatever the element count. The caller unlinks the elements.
+ *
+ * --------------------------------------------------------------------------*/
+static void CListArenaClear(struct CList *pThis) {
+
+	/* one node allocation each; removed nodes were counted when freed */
+	if (pThis->nCount > 0) {
+		LIST_STAT_FREE_BLOCKS(pThis, pThis->nCount, (size_t)pThis->nCount *
+				(pThis->nNodeHeader + LIST_ELEM_SIZE(pThis->nMaxDataSize)));
+	}
+
+	ListArenaReset(&pThis->pArena->arena);
+	pThis->pArena->pFree = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListBindOps
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pOps : operation table, NULL to unbind
+ *
+ * Return Value:
+ *
+ * Desc: 
+ * 	- point list at its operation table. Builds with CLIST_LEGACY_API also
+ * 	  get the per-instance function pointers filled in.
+ *
+ * --------------------------------------------------------------------------*/
+void CListBindOps(struct CList *pThis, const CListOps *pOps) {
+
+	pThis->pOps = pOps;
+
+#ifdef CLIST_LEGACY_API
+	if (pOps == NULL) {
+		static const CListOps nullOps;
+		pOps = &nullOps;
+	}
+
+	/* head/tail access */
+	pThis->GetHead = pOps->GetHead;
+	pThis->GetTail = pOps->GetTail;
+
+	/* Operation */
+	pThis->AddHead = pOps->AddHead;
+	pThis->AddTail = pOps->AddTail;
+	pThis->RemoveHead = pOps->RemoveHead;
+	pThis->RemoveTail = pOps->RemoveTail;
+	pThis->RemoveAll = pOps->RemoveAll;
+
+	/* for iteration */
+	pThis->GetHeadPosition = pOps->GetHeadPosition;
+	pThis->GetTailPosition = pOps->GetTailPosition;
+	pThis->GetNext = pOps->GetNext;
+	pThis->GetPrev = pOps->GetPrev;
+
+	/* Retrieval, modification */
+	pThis->GetAt = pOps->GetAt;
+	pThis->RemoveAt = pOps->RemoveAt;
+	pThis->SetAt = pOps->SetAt;
+
+	/* Insertion */
+	pThis->InsertNext = pOps->InsertNext;
+	pThis->InsertPrev = pOps->InsertPrev;
+
+	/* Search */
+	pThis->FindIndex = pOps->FindIndex;
+
+	/* Status */
+	pThis->GetCount = pOps->GetCount;
+	pThis->IsEmpty = pOps->IsEmpty;
+#endif
+}
@@ -28,6 +28,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+
+/* CList keeps its per-instance function pointers (l.AddTail(&l, p)) unless
+ * CLIST_NO_LEGACY_API is defined. That changes the struct layout, so the
+ * library and its users must agree on it. */
+#if !defined(CLIST_NO_LEGACY_API) && !defined(CLIST_LEGACY_API)
+#define CLIST_LEGACY_API
+#endif
 
 struct _POSITION {};
 
@@ -35,56 +43,552 @@ typedef struct _POSITION*	POSITION;
 
 typedef struct _ListElem {
 
-	void 	*data;
 	struct _ListElem	*next;
 	struct _ListElem	*prev;
+
+	/* payload is stored inline right after the links, so a node is one
+	 * allocation of LIST_ELEM_SIZE(nMaxDataSize) bytes */
+	unsigned char	data[];
 	
 }ListElem;
 
+#define LIST_ELEM_SIZE(nDataSize)	(offsetof(ListElem, data) + (size_t)(nDataSize))
+
+/* slab pool that recycles list elements, private to list.c */
+struct ListNodePool;
+
+/* arena owned by a list of InitListWithArena, private to list.c */
+struct ListNodeArena;
+
+/* order statistic index over the nodes, private to list_index.c */
+struct ListRankIndex;
+
+/* key hash index over the nodes, private to list_hash.c */
+struct ListHashIndex;
+
+/* range split points of parallel traversals, private to list_parallel.c */
+struct ListSplitCache;
+
+/*-----------------------------------------------------------------------------
+ * List operations. Every list points at one shared, read-only table of them
+ * instead of carrying its own copy of each function pointer.
+ * --------------------------------------------------------------------------*/
+struct CList;
+
+#define CLIST_OPS_MEMBERS \
+	/* head,tail access */ \
+	void* (*GetHead)(struct CList *pThis); \
+	void* (*GetTail)(struct CList *pThis); \
+ \
+	/* Operation */ \
+	POSITION (*AddHead)(struct CList *pThis, const void* pData); \
+	POSITION (*AddTail)(struct CList *pThis, const void* pData); \
+	int (*RemoveHead)(struct CList *pThis); \
+	int (*RemoveTail)(struct CList *pThis); \
+	int (*RemoveAll)(struct CList *pThis); \
+ \
+	/* for iteration */ \
+	POSITION (*GetHeadPosition)(struct CList *pThis); \
+	POSITION (*GetTailPosition)(struct CList *pThis); \
+	void* (*GetNext)(struct CList *pThis, POSITION* position); \
+	void* (*GetPrev)(struct CList *pThis, POSITION* position); \
+ \
+	/* Retrieval, modification */ \
+	void* (*GetAt)(struct CList *pThis, POSITION position); \
+	int (*RemoveAt)(struct CList *pThis, POSITION position); \
+	int (*SetAt)(struct CList *pThis, POSITION position, const void* pData); \
+ \
+	/* Insertion */ \
+	POSITION (*InsertNext)(struct CList *pThis, POSITION position, const void* pData); \
+	POSITION (*InsertPrev)(struct CList *pThis, POSITION position, const void* pData); \
+ \
+	/* Searching */ \
+	POSITION (*FindIndex)(struct CList *pThis, int nIndex); \
+ \
+	/* Status */ \
+	int (*GetCount)(struct CList *pThis); \
+	int (*IsEmpty)(struct CList *pThis);
+
+typedef struct CListOps {
+
+	CLIST_OPS_MEMBERS
+
+	/* release everything the storage owns, used by DestroyList */
+	void (*Destroy)(struct CList *pThis);
+
+	/* link an element with an uninitialized payload next to position, or
+	 * at head/tail if position is NULL; used by the ListEmplace* calls */
+	POSITION (*Emplace)(struct CList *pThis, POSITION position, int bAfter);
+
+	/* hand out up to nMax payload pointers from position on and advance it,
+	 * used by ListGetNextBatch; NULL steps with GetNext */
+	int (*GetNextBatch)(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+	/* RemoveAt that leaves *position at the element which followed, NULL at
+	 * the tail, like std::deque::erase; used by ListErase. NULL if RemoveAt
+	 * never moves the elements after position. */
+	int (*Erase)(struct CList *pThis, POSITION* position);
+
+} CListOps;
+
+/* element storage, chosen at InitListStorage */
+typedef enum CListStorage {
+
+	LIST_STORAGE_NODE = 0,		/* one linked node per element (InitList) */
+	LIST_STORAGE_CHUNK,			/* unrolled list, several elements per node */
+	LIST_STORAGE_RING,			/* circular array, see InitListRing */
+	LIST_STORAGE_COMPACT,		/* index-linked slot array, see InitListCompact */
+	LIST_STORAGE_DEQUE			/* blocks of slots behind a map, like std::deque */
+
+} CListStorage;
+
+/* node allocator of InitListWithAllocator. alloc returns nSize bytes aligned
+ * like malloc's, or NULL; dealloc gets the nSize alloc was called with. */
+typedef void* (*CListAllocFn)(size_t nSize, void *pContext);
+typedef void (*CListFreeFn)(void *pBlock, size_t nSize, void *pContext);
+
+/*-----------------------------------------------------------------------------
+ * Allocation and lookup counters, kept when the library is built with
+ * CLIST_STATS (cmake -DCLIST_STATS=ON). Byte counts cover element storage:
+ * nodes, pool and chunk slabs, slot arrays, deque blocks and maps, mapped
+ * snapshots and hash buckets; the fixed-size bookkeeping structs are left out.
+ * --------------------------------------------------------------------------*/
+typedef struct CListStats {
+
+	unsigned long long	nAllocs;			/* allocator calls that succeeded */
+	unsigned long long	nFrees;
+	unsigned long long	nFailedAllocs;		/* adds and inserts that ran out of memory */
+
+	long long	nHeldBytes;					/* element storage held right now */
+	long long	nPayloadBytes;				/* nCount * nMaxDataSize of it */
+	long long	nNodeBytes;					/* the rest: links, headers, spare slots */
+
+	int		nPeakCount;						/* largest nCount reached */
+	unsigned long long	nFindIndexSteps;	/* links followed by FindIndex */
+
+} CListStats;
+
 typedef struct CList {
 
+	const CListOps	*pOps;
+
 	int		nCount;
 	int		nMaxDataSize;
 	
 	ListElem	*pHeadNode;
 	ListElem	*pTailNode;
 
-	/* head,tail access */
-	void* (*GetHead)(struct CList *pThis);
-	void* (*GetTail)(struct CList *pThis);
-
-	/* Operation */
-	POSITION (*AddHead)(struct CList *pThis, const void* pData);
-	POSITION (*AddTail)(struct CList *pThis, const void* pData);
-	int (*RemoveHead)(struct CList *pThis);
-	int (*RemoveTail)(struct CList *pThis);
-	int (*RemoveAll)(struct CList *pThis);
-
-	/* for iteration */
-	POSITION (*GetHeadPosition)(struct CList *pThis);
-	POSITION (*GetTailPosition)(struct CList *pThis);
-	void* (*GetNext)(struct CList *pThis, POSITION* position);
-	void* (*GetPrev)(struct CList *pThis, POSITION* position);
-
-	/* Retrieval, modification */
-	void* (*GetAt)(struct CList *pThis, POSITION position);
-	int (*RemoveAt)(struct CList *pThis, POSITION position);
-	int (*SetAt)(struct CList *pThis, POSITION position, const void* pData);
-
-	/* Insertion */
-	POSITION (*InsertNext)(struct CList *pThis, POSITION position, const void* pData);
-	POSITION (*InsertPrev)(struct CList *pThis, POSITION position, const void* pData);
-
-	/* Searching */
-	POSITION (*FindIndex)(struct CList *pThis, int nIndex);
-
-	/* Status */
-	int (*GetCount)(struct CList *pThis);
-	int (*IsEmpty)(struct CList *pThis);
+	/* NULL unless created by InitListWithCapacity */
+	struct ListNodePool	*pPool;
+
+	/* where unpooled nodes come from, NULL for malloc and free */
+	CListAllocFn	pfnAlloc;
+	CListFreeFn		pfnFree;
+	void			*pAllocContext;
+
+	/* NULL unless created by InitListWithArena, then pAllocContext */
+	struct ListNodeArena	*pArena;
+
+	/* bytes of per-node bookkeeping in front of every ListElem */
+	int		nNodeHeader;
+
+	/* last FindIndex result, nearby lookups walk from here */
+	int		nCursorIndex;
+	ListElem	*pCursorNode;
+
+	/* NULL unless ListEnableIndex was called */
+	struct ListRankIndex	*pIndex;
+
+	/* NULL unless ListEnableHashIndex was called */
+	struct ListHashIndex	*pHash;
+
+	/* state of storages other than LIST_STORAGE_NODE */
+	void	*pStorage;
+
+	/* bumped by every relink of the node chain; cached split points are
+	 * good while it stays the same (ListParallelForEach) */
+	unsigned int	nLinkVersion;
+	struct ListSplitCache	*pSplits;
+
+#ifdef CLIST_STATS
+	/* counters of this list, changes the struct layout like the macro below */
+	CListStats	stats;
+#endif
+
+#ifdef CLIST_LEGACY_API
+	/* per-instance copies of pOps for l.AddTail(&l, p) style callers */
+	CLIST_OPS_MEMBERS
+#endif
 
 } CList;
 
+extern const CListOps g_CListNodeOps;
+
 void InitList(struct CList *pThis, int nMaxDataSize);
+int InitListWithCapacity(struct CList *pThis, int nMaxDataSize, int nCapacity);
+int InitListWithAllocator(struct CList *pThis, int nMaxDataSize,
+		CListAllocFn alloc, CListFreeFn dealloc, void *pContext);
+int InitListWithArena(struct CList *pThis, int nMaxDataSize, size_t nChunkSize);
+int InitListStorage(struct CList *pThis, int nMaxDataSize, CListStorage nStorage);
+void InitListByRef(struct CList *pThis);
+int InitListSized(struct CList *pThis, int nMaxDataSize);
+int InitListRing(struct CList *pThis, int nMaxDataSize, int nCapacity);
+int InitListCompact(struct CList *pThis, int nMaxDataSize, int nCapacity);
+int InitListMapped(struct CList *pThis, int fd);
 void DestroyList(struct CList *pThis);
 
+/* O(log n) FindIndex, must be called while the list is empty */
+int ListEnableIndex(struct CList *pThis);
+
+/* binary snapshots: SaveList writes the payloads in list order, LoadList
+ * appends them from a mapping of the file, InitListMapped (above) reads
+ * them in place */
+int SaveList(struct CList *pThis, int fd);
+int LoadList(struct CList *pThis, int fd);
+
+/* bulk operations, pData points at nItems records of nMaxDataSize bytes */
+POSITION ListAddHeadBatch(struct CList *pThis, const void* pData, int nItems);
+POSITION ListAddTailBatch(struct CList *pThis, const void* pData, int nItems);
+POSITION ListInsertNextBatch(struct CList *pThis, POSITION position,
+		const void* pData, int nItems);
+int ListRemoveRange(struct CList *pThis, POSITION posFrom, POSITION posTo);
+int ListRemoveHeadN(struct CList *pThis, int nItems);
+
+/* remove while walking forward: *position moves on to the element that
+ * followed. LIST_STORAGE_DEQUE lists need it, their RemoveAt may move the
+ * elements after the removed one, so a position saved by GetNext before
+ * RemoveAt can point at freed memory there. */
+int ListErase(struct CList *pThis, POSITION* position);
+
+/* elements of nSize bytes, up to nMaxDataSize. Lists made by InitListSized
+ * allocate each node for its own length and ListGetAtSized returns it; other
+ * lists store nMaxDataSize bytes with the rest zeroed. ListSetAtSized may
+ * move an element of a sized list and then updates *position. */
+POSITION ListAddHeadSized(struct CList *pThis, const void* pData, int nSize);
+POSITION ListAddTailSized(struct CList *pThis, const void* pData, int nSize);
+POSITION ListInsertNextSized(struct CList *pThis, POSITION position,
+		const void* pData, int nSize);
+POSITION ListInsertPrevSized(struct CList *pThis, POSITION position,
+		const void* pData, int nSize);
+int ListSetAtSized(struct CList *pThis, POSITION* position, const void* pData, int nSize);
+void* ListGetAtSized(struct CList *pThis, POSITION position, int *pnSize);
+
+/* add an element and return its uninitialized payload to build in place */
+void* ListEmplaceHead(struct CList *pThis, POSITION* pPosition);
+void* ListEmplaceTail(struct CList *pThis, POSITION* pPosition);
+void* ListEmplaceNext(struct CList *pThis, POSITION position, POSITION* pPosition);
+void* ListEmplacePrev(struct CList *pThis, POSITION position, POSITION* pPosition);
+
+/* move elements between lists by relinking, see list.c for the O(1) cases */
+int ListSplice(struct CList *pDst, POSITION dstPos, struct CList *pSrc,
+		POSITION first, POSITION last);
+int ListConcat(struct CList *pDst, struct CList *pSrc);
+int ListSplitAt(struct CList *pSrc, POSITION position, struct CList *pDst);
+
+/* O(1) reordering by relinking; position stays valid. Node-linked lists. */
+int ListMoveToHead(struct CList *pThis, POSITION position);
+int ListMoveToTail(struct CList *pThis, POSITION position);
+
+/* ordering; cmp compares two payloads like qsort's comparator (the stored
+ * pointers for InitListByRef lists) */
+typedef int (*CListCompareFn)(const void *pA, const void *pB);
+
+int ListSort(struct CList *pThis, CListCompareFn cmp);
+int ListSortParallel(struct CList *pThis, CListCompareFn cmp, int nThreads);
+POSITION ListInsertSorted(struct CList *pThis, const void* pData, CListCompareFn cmp);
+int ListMerge(struct CList *pDst, struct CList *pSrc, CListCompareFn cmp);
+
+/* searching by content. ListFind calls cmp(pKey, payload) and matches on 0;
+ * without cmp the whole payload is compared (the stored pointer for
+ * InitListByRef lists, sized lists need cmp). Both start at startPos, or at
+ * head if NULL. */
+typedef int (*CListPredicateFn)(const void *pData, void *pContext);
+
+POSITION ListFind(struct CList *pThis, const void* pKey, CListCompareFn cmp,
+		POSITION startPos);
+POSITION ListFindIf(struct CList *pThis, CListPredicateFn pred, void *pContext,
+		POSITION startPos);
+
+/* O(1) average lookup by a key of nKeyLen bytes at nKeyOffset in every
+ * payload (in the object pointed at for InitListByRef lists). hash may be
+ * NULL for the built-in one. Must be called while the list is empty. */
+typedef size_t (*CListHashFn)(const void *pKey, size_t nKeyLen);
+
+int ListEnableHashIndex(struct CList *pThis, int nKeyOffset, int nKeyLen,
+		CListHashFn hash);
+POSITION ListFindKey(struct CList *pThis, const void* pKey);
+
+/* parallel traversal on nThreads threads, the calling one included, from a
+ * small built-in pool. visit and reduce run concurrently on different
+ * elements, combine folds the per-range accumulators in list order. */
+typedef void (*CListVisitFn)(void *pData, void *pContext);
+typedef void (*CListReduceFn)(void *pAccum, const void *pData, void *pContext);
+typedef void (*CListCombineFn)(void *pAccum, const void *pOther, void *pContext);
+
+int ListParallelForEach(struct CList *pThis, CListVisitFn visit, void *pContext,
+		int nThreads);
+int ListParallelReduce(struct CList *pThis, CListReduceFn reduce,
+		CListCombineFn combine, void *pAccum, int nAccumSize, void *pContext,
+		int nThreads);
+
+/* counters of one list and of all lists together. The global nPayloadBytes
+ * and nNodeBytes are -1, they are not tracked across lists. Without
+ * CLIST_STATS the calls zero *pStats and return -1. ListDumpStats writes the
+ * global counters to pFile, or to stderr if NULL. */
+int ListGetStats(struct CList *pThis, CListStats *pStats);
+int ListGetGlobalStats(CListStats *pStats);
+int ListDumpStats(FILE *pFile);
+
+/*-----------------------------------------------------------------------------
+ * LIST_STORAGE_NODE implementation of the operations (g_CListNodeOps). Call
+ * these only on node lists; the List* API below works with any storage.
+ * --------------------------------------------------------------------------*/
+/* head, tail access */
+void* CListGetHead(struct CList *pThis);
+void* CListGetTail(struct CList *pThis);
+
+/* operation */
+POSITION CListAddHead(struct CList *pThis, const void* pData);
+POSITION CListAddTail(struct CList *pThis, const void* pData);
+int CListRemoveHead(struct CList *pThis);
+int CListRemoveTail(struct CList *pThis);
+int CListRemoveAll(struct CList *pThis);
+
+/* for iteration */
+POSITION CListGetHeadPosition(struct CList *pThis);
+POSITION CListGetTailPosition(struct CList *pThis);
+void* CListGetNext(struct CList *pThis, POSITION* position);
+void* CListGetPrev(struct CList *pThis, POSITION* position);
+int CListGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+void* CListGetAt(struct CList *pThis, POSITION position);
+int CListRemoveAt(struct CList *pThis, POSITION position);
+int CListSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion */
+POSITION CListInsertNext(struct CList *pThis, POSITION position, const void* pData);
+POSITION CListInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+
+/* Searching */
+POSITION CListFindIndex(struct CList *pThis, int nIndex);
+
+/* Status */
+int CListGetCount(struct CList *pThis);
+int CListIsEmpty(struct CList *pThis);
+
+/*-----------------------------------------------------------------------------
+ * Direct-call API. ListAddTail(&l, p) does the same as l.pOps->AddTail(&l, p)
+ * without the indirect call for node lists; accessors are expanded in place.
+ * Lists with another storage go through their operation table. pThis must be
+ * an initialized list.
+ * --------------------------------------------------------------------------*/
+#define LIST_IS_NODE_STORAGE(pThis)	((pThis)->pOps == &g_CListNodeOps)
+
+/* head, tail access */
+static inline void* ListGetHead(struct CList *pThis) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->GetHead(pThis);
+
+	return (pThis->pHeadNode != NULL) ? pThis->pHeadNode->data : NULL;
+}
+
+static inline void* ListGetTail(struct CList *pThis) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->GetTail(pThis);
+
+	return (pThis->pTailNode != NULL) ? pThis->pTailNode->data : NULL;
+}
+
+/* operation */
+static inline POSITION ListAddHead(struct CList *pThis, const void* pData) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->AddHead(pThis, pData);
+
+	return CListAddHead(pThis, pData);
+}
+
+static inline POSITION ListAddTail(struct CList *pThis, const void* pData) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->AddTail(pThis, pData);
+
+	return CListAddTail(pThis, pData);
+}
+
+static inline int ListRemoveHead(struct CList *pThis) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->RemoveHead(pThis);
+
+	return CListRemoveHead(pThis);
+}
+
+static inline int ListRemoveTail(struct CList *pThis) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->RemoveTail(pThis);
+
+	return CListRemoveTail(pThis);
+}
+
+static inline int ListRemoveAll(struct CList *pThis) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->RemoveAll(pThis);
+
+	return CListRemoveAll(pThis);
+}
+
+/* for iteration */
+static inline POSITION ListGetHeadPosition(struct CList *pThis) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->GetHeadPosition(pThis);
+
+	return (POSITION)pThis->pHeadNode;
+}
+
+static inline POSITION ListGetTailPosition(struct CList *pThis) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->GetTailPosition(pThis);
+
+	return (POSITION)pThis->pTailNode;
+}
+
+static inline void* ListGetNext(struct CList *pThis, POSITION* position) {
+
+	ListElem *pListElem = (ListElem *)*position;
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->GetNext(pThis, position);
+
+	if (pListElem == NULL)
+		return NULL;
+
+	*position = (POSITION)pListElem->next;
+	return pListElem->data;
+}
+
+static inline void* ListGetPrev(struct CList *pThis, POSITION* position) {
+
+	ListElem *pListElem = (ListElem *)*position;
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->GetPrev(pThis, position);
+
+	if (pListElem == NULL)
+		return NULL;
+
+	*position = (POSITION)pListElem->prev;
+	return pListElem->data;
+}
+
+/* up to nMax payload pointers into ppData, the count is returned and 0 at
+ * the end. Storage prefetches what the caller reads next, see GetNextBatch
+ * in the operation table. */
+static inline int ListGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	int nGot = 0;
+
+	if (LIST_IS_NODE_STORAGE(pThis))
+		return CListGetNextBatch(pThis, position, ppData, nMax);
+
+	if (pThis->pOps->GetNextBatch != NULL)
+		return pThis->pOps->GetNextBatch(pThis, position, ppData, nMax);
+
+	while (nGot < nMax && *position != NULL)
+		ppData[nGot++] = pThis->pOps->GetNext(pThis, position);
+
+	return nGot;
+}
+
+/* payloads fetched per ListGetNextBatch call of ListForEach */
+#define LIST_FOREACH_BATCH		64
+
+/* visit every element from head to tail, returns how many. Inlined with a
+ * known visit, the loop calls it directly and the list once per batch. */
+static inline int ListForEach(struct CList *pThis, CListVisitFn visit, void *pContext) {
+
+	void *apData[LIST_FOREACH_BATCH];
+	POSITION pos = ListGetHeadPosition(pThis);
+	int nVisited = 0;
+	int nGot;
+	int i;
+
+	while ((nGot = ListGetNextBatch(pThis, &pos, apData, LIST_FOREACH_BATCH)) > 0) {
+		for (i = 0; i < nGot; i++)
+			visit(apData[i], pContext);
+		nVisited += nGot;
+	}
+
+	return nVisited;
+}
+
+/* retrieval, modification */
+static inline void* ListGetAt(struct CList *pThis, POSITION position) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->GetAt(pThis, position);
+
+	return (position != NULL) ? ((ListElem *)position)->data : NULL;
+}
+
+static inline int ListRemoveAt(struct CList *pThis, POSITION position) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->RemoveAt(pThis, position);
+
+	return CListRemoveAt(pThis, position);
+}
+
+static inline int ListSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->SetAt(pThis, position, pData);
+
+	return CListSetAt(pThis, position, pData);
+}
+
+/* Insertion */
+static inline POSITION ListInsertNext(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->InsertNext(pThis, position, pData);
+
+	return CListInsertNext(pThis, position, pData);
+}
+
+static inline POSITION ListInsertPrev(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->InsertPrev(pThis, position, pData);
+
+	return CListInsertPrev(pThis, position, pData);
+}
+
+/* Searching */
+static inline POSITION ListFindIndex(struct CList *pThis, int nIndex) {
+
+	if (!LIST_IS_NODE_STORAGE(pThis))
+		return pThis->pOps->FindIndex(pThis, nIndex);
+
+	return CListFindIndex(pThis, nIndex);
+}
+
+/* Status, every storage keeps nCount */
+static inline int ListGetCount(struct CList *pThis) {
+
+	return pThis->nCount;
+}
+
+static inline int ListIsEmpty(struct CList *pThis) {
+
+	return (pThis->nCount != 0) ? 1 : 0;
+}
+
 #endif
@@ -0,0 +1,352 @@
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "list_alloc.h"
+
+/* blocks are aligned like malloc's, for any payload type */
+#define LIST_ALLOC_ALIGN			_Alignof(max_align_t)
+#define LIST_ALLOC_ALIGN_UP(n)		(((n) + LIST_ALLOC_ALIGN - 1) & ~(size_t)(LIST_ALLOC_ALIGN - 1))
+
+/* arena chunks start at this size and double up to the limit */
+#define LIST_ARENA_DEFAULT_CHUNK	(64 * 1024)
+#define LIST_ARENA_MAX_CHUNK		(4 * 1024 * 1024)
+
+/* fixed pool slabs start at this many blocks and double up to the limit */
+#define LIST_FIXED_POOL_DEFAULT_BLOCKS		64
+#define LIST_FIXED_POOL_MAX_SLAB_BLOCKS		65536
+
+struct ListAllocChunk {
+
+	struct ListAllocChunk	*pNext;
+	size_t					nSize;		/* bytes, header included */
+};
+
+#define LIST_ALLOC_CHUNK_HEADER		LIST_ALLOC_ALIGN_UP(sizeof(struct ListAllocChunk))
+
+static int CListArenaGrow(struct CListArena *pThis, size_t nSize);
+static int CListFixedPoolAddSlab(struct CListFixedPool *pThis);
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListArena
+ *
+ * Parameter:
+ * 	- pThis : CListArena instance pointer
+ * 	- nChunkSize : size of the first chunk, 0 for the default
+ *
+ * Return Value:
+ * 	- Return -1 if pThis is NULL, else returns 0
+ *
+ * Desc: Initialize an empty arena. The first chunk is allocated with the
+ *       first block.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListArena(struct CListArena *pThis, size_t nChunkSize) {
+
+	if (pThis == NULL)
+		return -1;
+
+	pThis->pChunks = NULL;
+	pThis->pCurrent = NULL;
+	pThis->pCursor = NULL;
+	pThis->pLimit = NULL;
+	pThis->nChunkSize = (nChunkSize > 0) ? nChunkSize : LIST_ARENA_DEFAULT_CHUNK;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: DestroyListArena
+ *
+ * Parameter:
+ * 	- pThis : CListArena instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: release every chunk. Lists using the arena must be destroyed
+ *       first, or never touched again.
+ *
+ * --------------------------------------------------------------------------*/
+void DestroyListArena(struct CListArena *pThis) {
+
+	struct ListAllocChunk *pChunk;
+
+	if (pThis == NULL)
+		return;
+
+	while (pThis->pChunks != NULL) {
+		pChunk = pThis->pChunks;
+		pThis->pChunks = pChunk->pNext;
+		free(pChunk);
+	}
+
+	pThis->pCurrent = NULL;
+	pThis->pCursor = NULL;
+	pThis->pLimit = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListArenaReset
+ *
+ * Parameter:
+ * 	- pThis : CListArena instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: take every block back at once, in O(1). The chunks are kept and
+ *       carved from again in the same order, so a list refilled to the same
+ *       size does not allocate. Blocks handed out before must no longer be
+ *       used, so lists in the arena are reset with InitList* after it.
+ *
+ * --------------------------------------------------------------------------*/
+void ListArenaReset(struct CListArena *pThis) {
+
+	if (pThis == NULL || pThis->pChunks == NULL)
+		return;
+
+	pThis->pCurrent = pThis->pChunks;
+	pThis->pCursor = (unsigned char *)pThis->pChunks + LIST_ALLOC_CHUNK_HEADER;
+	pThis->pLimit = (unsigned char *)pThis->pChunks + pThis->pChunks->nSize;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListArenaAlloc
+ *
+ * Parameter:
+ * 	- nSize : bytes wanted
+ * 	- pContext : CListArena instance pointer
+ *
+ * Return Value:
+ * 	- block of nSize bytes, NULL if a new chunk can not be allocated
+ *
+ * Desc:
+ * 	- carve the block from the current chunk, or from a new one if it does
+ * 	  not fit in what is left
+ *
+ * --------------------------------------------------------------------------*/
+void* ListArenaAlloc(size_t nSize, void *pContext) {
+
+	struct CListArena *pThis = (struct CListArena *)pContext;
+	void *pBlock;
+
+	nSize = LIST_ALLOC_ALIGN_UP(nSize);
+
+	if ((size_t)(pThis->pLimit - pThis->pCursor) < nSize && CListArenaGrow(pThis, nSize) != 0)
+		return NULL;
+
+	pBlock = pThis->pCursor;
+	pThis->pCursor += nSize;
+
+	return pBlock;
+}
+
+/* blocks of an arena are only given back all at once */
+void ListArenaFree(void *pBlock, size_t nSize, void *pContext) {
+
+	(void)pBlock;
+	(void)nSize;
+	(void)pContext;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListArenaGrow
+ *
+ * Parameter:
+ * 	- pThis : CListArena instance pointer
+ * 	- nSize : aligned size of the block that did not fit
+ *
+ * Return Value:
+ * 	- Return -1 if the chunk can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- move on to the chunk after the current one if a reset left one there
+ * 	  and nSize fits in it. Else allocate a chunk of nChunkSize bytes, or
+ * 	  bigger if nSize needs it, and put it next. The rest of the old chunk
+ * 	  is left unused.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListArenaGrow(struct CListArena *pThis, size_t nSize) {
+
+	struct ListAllocChunk *pChunk = NULL;
+	size_t nChunkSize = pThis->nChunkSize;
+
+	if (pThis->pCurrent != NULL)
+		pChunk = pThis->pCurrent->pNext;
+
+	if (pChunk == NULL || pChunk->nSize < LIST_ALLOC_CHUNK_HEADER + nSize) {
+
+		if (nChunkSize < LIST_ALLOC_CHUNK_HEADER + nSize)
+			nChunkSize = LIST_ALLOC_CHUNK_HEADER + nSize;
+
+		pChunk = (struct ListAllocChunk *)malloc(nChunkSize);
+
+		if (pChunk == NULL)
+			return -1;
+
+		pChunk->nSize = nChunkSize;
+
+		if (pThis->pCurrent != NULL) {
+			pChunk->pNext = pThis->pCurrent->pNext;
+			pThis->pCurrent->pNext = pChunk;
+		}
+		else {
+			pChunk->pNext = NULL;
+			pThis->pChunks = pChunk;
+		}
+
+		if (pThis->nChunkSize < LIST_ARENA_MAX_CHUNK)
+			pThis->nChunkSize *= 2;
+	}
+
+	pThis->pCurrent = pChunk;
+	pThis->pCursor = (unsigned char *)pChunk + LIST_ALLOC_CHUNK_HEADER;
+	pThis->pLimit = (unsigned char *)pChunk + pChunk->nSize;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: InitListFixedPool
+ *
+ * Parameter:
+ * 	- pThis : CListFixedPool instance pointer
+ * 	- nBlockSize : size of every block, 0 to take the first request's
+ * 	- nSlabBlocks : block count of the first slab, 0 for the default
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid, else returns 0
+ *
+ * Desc: Initialize an empty pool. The first slab is allocated with the
+ *       first block.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListFixedPool(struct CListFixedPool *pThis, size_t nBlockSize, int nSlabBlocks) {
+
+	if (pThis == NULL || nSlabBlocks < 0)
+		return -1;
+
+	pThis->pSlabs = NULL;
+	pThis->pFree = NULL;
+	pThis->pCursor = NULL;
+	pThis->pLimit = NULL;
+	pThis->nBlockSize = 0;
+	pThis->nSlabBlocks = (nSlabBlocks > 0) ? nSlabBlocks : LIST_FIXED_POOL_DEFAULT_BLOCKS;
+
+	/* a free block holds the free list link */
+	if (nBlockSize > 0) {
+		if (nBlockSize < sizeof(void *))
+			nBlockSize = sizeof(void *);
+		pThis->nBlockSize = LIST_ALLOC_ALIGN_UP(nBlockSize);
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: DestroyListFixedPool
+ *
+ * Parameter:
+ * 	- pThis : CListFixedPool instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: release every slab, blocks still in use included
+ *
+ * --------------------------------------------------------------------------*/
+void DestroyListFixedPool(struct CListFixedPool *pThis) {
+
+	struct ListAllocChunk *pSlab;
+
+	if (pThis == NULL)
+		return;
+
+	while (pThis->pSlabs != NULL) {
+		pSlab = pThis->pSlabs;
+		pThis->pSlabs = pSlab->pNext;
+		free(pSlab);
+	}
+
+	pThis->pFree = NULL;
+	pThis->pCursor = NULL;
+	pThis->pLimit = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListFixedPoolAlloc
+ *
+ * Parameter:
+ * 	- nSize : bytes wanted, at most the pool's block size
+ * 	- pContext : CListFixedPool instance pointer
+ *
+ * Return Value:
+ * 	- block of the pool's size, NULL if nSize is bigger or a new slab can
+ * 	  not be allocated
+ *
+ * Desc:
+ * 	- reuse a freed block, else carve one from the current slab
+ *
+ * --------------------------------------------------------------------------*/
+void* ListFixedPoolAlloc(size_t nSize, void *pContext) {
+
+	struct CListFixedPool *pThis = (struct CListFixedPool *)pContext;
+	void *pBlock;
+
+	if (pThis->nBlockSize == 0)
+		pThis->nBlockSize = LIST_ALLOC_ALIGN_UP(nSize < sizeof(void *) ? sizeof(void *) : nSize);
+
+	if (nSize > pThis->nBlockSize)
+		return NULL;
+
+	if (pThis->pFree != NULL) {
+		pBlock = pThis->pFree;
+		pThis->pFree = *(void **)pBlock;
+		return pBlock;
+	}
+
+	if (pThis->pCursor == pThis->pLimit && CListFixedPoolAddSlab(pThis) != 0)
+		return NULL;
+
+	pBlock = pThis->pCursor;
+	pThis->pCursor += pThis->nBlockSize;
+
+	return pBlock;
+}
+
+/* put the block on the free list for the next ListFixedPoolAlloc */
+void ListFixedPoolFree(void *pBlock, size_t nSize, void *pContext) {
+
+	struct CListFixedPool *pThis = (struct CListFixedPool *)pContext;
+
+	(void)nSize;
+
+	*(void **)pBlock = pThis->pFree;
+	pThis->pFree = pBlock;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListFixedPoolAddSlab
+ *
+ * Parameter:
+ * 	- pThis : CListFixedPool instance pointer
+ *
+ * Return Value:
+ * 	- Return -1 if the slab can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- allocate a slab of nSlabBlocks blocks and carve from it from now on.
+ * 	  Every slab doubles the next one, up to LIST_FIXED_POOL_MAX_SLAB_BLOCKS.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListFixedPoolAddSlab(struct CListFixedPool *pThis) {
+
+	struct ListAllocChunk *pSlab;
+	size_t nBytes = pThis->nBlockSize * (size_t)pThis->nSlabBlocks;
+
+	pSlab = (struct ListAllocChunk *)malloc(LIST_ALLOC_CHUNK_HEADER + nBytes);
+
+	if (pSlab == NULL)
+		return -1;
+
+	pSlab->nSize = LIST_ALLOC_CHUNK_HEADER + nBytes;
+	pSlab->pNext = pThis->pSlabs;
+	pThis->pSlabs = pSlab;
+
+	pThis->pCursor = (unsigned char *)pSlab + LIST_ALLOC_CHUNK_HEADER;
+	pThis->pLimit = pThis->pCursor + nBytes;
+
+	if (pThis->nSlabBlocks < LIST_FIXED_POOL_MAX_SLAB_BLOCKS)
+		pThis->nSlabBlocks *= 2;
+
+	return 0;
+}
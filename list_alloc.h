@@ -0,0 +1,70 @@
+/******************************************************************************
+    Reference node allocators for InitListWithAllocator.
+
+    CListArena is a bump allocator: blocks are carved one after another from
+    big chunks, and freeing a single block does nothing. Everything is given
+    back at once by ListArenaReset, which keeps the chunks to carve from
+    again, or DestroyListArena, so it suits lists that are filled, used and
+    thrown away as a whole. InitListWithArena gives a list its own one.
+
+    CListFixedPool hands out blocks of one size from slabs and keeps freed
+    blocks on a free list for the next allocation. Its block size is set by
+    the first allocation unless given up front, so one pool serves the
+    nodes of lists with the same payload size and features.
+
+    Neither is thread-safe; share one between lists of one thread only.
+******************************************************************************/
+
+#ifndef LIST_ALLOC_H
+#define LIST_ALLOC_H
+
+#include "list.h"
+
+/* chunk and slab list, private to list_alloc.c */
+struct ListAllocChunk;
+
+typedef struct CListArena {
+
+	struct ListAllocChunk	*pChunks;	/* oldest first */
+	struct ListAllocChunk	*pCurrent;	/* chunk carved from, the ones
+										   after it are free since a reset */
+	unsigned char	*pCursor;			/* free part of pCurrent */
+	unsigned char	*pLimit;
+
+	size_t	nChunkSize;					/* size of the next chunk */
+
+} CListArena;
+
+typedef struct CListFixedPool {
+
+	struct ListAllocChunk	*pSlabs;
+	void			*pFree;				/* freed blocks, chained through
+										   their first word */
+	unsigned char	*pCursor;			/* uncarved part of the newest slab */
+	unsigned char	*pLimit;
+
+	size_t	nBlockSize;					/* 0 until the first allocation */
+	int		nSlabBlocks;				/* block count of the next slab */
+
+} CListFixedPool;
+
+/* nChunkSize 0 picks a default; chunks double from there */
+int InitListArena(struct CListArena *pThis, size_t nChunkSize);
+void DestroyListArena(struct CListArena *pThis);
+void ListArenaReset(struct CListArena *pThis);
+
+/* CListAllocFn and CListFreeFn, pContext is the CListArena */
+void* ListArenaAlloc(size_t nSize, void *pContext);
+void ListArenaFree(void *pBlock, size_t nSize, void *pContext);
+
+/* nBlockSize 0 takes the size of the first allocation, nSlabBlocks 0 picks
+ * a default; slabs double from there */
+int InitListFixedPool(struct CListFixedPool *pThis, size_t nBlockSize, int nSlabBlocks);
+void DestroyListFixedPool(struct CListFixedPool *pThis);
+
+/* CListAllocFn and CListFreeFn, pContext is the CListFixedPool. Requests
+ * bigger than the block size fail. */
+void* ListFixedPoolAlloc(size_t nSize, void *pContext);
+void ListFixedPoolFree(void *pBlock, size_t nSize, void *pContext);
+
+#endif
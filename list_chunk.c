@@ -0,0 +1,909 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * LIST_STORAGE_CHUNK: unrolled linked list
+ *
+ * Every node (chunk) holds up to nPerChunk payloads back to back, so a scan
+ * touches one cache line run per nPerChunk elements. Chunks have a power of
+ * two size and are carved from slabs aligned to it; a POSITION is the address
+ * of the payload and its chunk is found by masking the low bits. The first
+ * chunk sized cell of a slab holds the slab link.
+ *
+ * Elements occupy slots nFirst .. nFirst + nUsed - 1 of a chunk, which lets
+ * AddHead/AddTail/RemoveHead/RemoveTail work without moving any payload.
+ * InsertNext/InsertPrev shift a chunk's payloads or split a full chunk, and
+ * RemoveAt shifts the payloads in front of the removed one and may merge the
+ * previous chunk into the freed space. Those calls can move the payloads of
+ * the chunk(s) they touch, which invalidates POSITIONs of the moved elements;
+ * RemoveAt never moves elements that follow the removed one, so removing
+ * while iterating forward with GetNext stays safe.
+ * --------------------------------------------------------------------------*/
+
+/* chunks span 1..4 cache lines, larger only if two payloads need more */
+#define LIST_CHUNK_MIN_SIZE			64
+#define LIST_CHUNK_MAX_SIZE			256
+#define LIST_CHUNK_TARGET_ELEMS		16
+
+/* slab growth in chunks, like the node pool */
+#define LIST_CHUNK_SLAB_MIN			16
+#define LIST_CHUNK_SLAB_MAX			256
+
+typedef struct ListChunk {
+
+	struct ListChunk	*pNext;
+	struct ListChunk	*pPrev;
+
+	int		nFirst;		/* slot of the first element */
+	int		nUsed;		/* number of elements */
+
+	unsigned char	data[];
+
+} ListChunk;
+
+typedef struct ListChunkStore {
+
+	ListChunk	*pHead;
+	ListChunk	*pTail;
+
+	ListSlab	*pSlabs;		/* chunk slabs, first cell is the link */
+	ListChunk	*pFree;			/* unused chunks, chained through pNext */
+	int			nSlabChunks;	/* cell count of the next slab */
+
+	size_t		nChunkSize;		/* power of two, chunk alignment */
+	size_t		nElemSize;
+	int			nPerChunk;
+
+} ListChunkStore;
+
+#define CHUNK_STORE(pThis)		((ListChunkStore *)(pThis)->pStorage)
+#define CHUNK_OF(pStore, pos) \
+	((ListChunk *)((uintptr_t)(pos) & ~(uintptr_t)((pStore)->nChunkSize - 1)))
+#define CHUNK_SLOT(pStore, pChunk, nSlot) \
+	((pChunk)->data + (size_t)(nSlot) * (pStore)->nElemSize)
+#define CHUNK_SLOT_INDEX(pStore, pChunk, pos) \
+	((int)(((unsigned char *)(pos) - (pChunk)->data) / (pStore)->nElemSize))
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+/* head, tail access */
+static void* CListChunkGetHead(struct CList *pThis);
+static void* CListChunkGetTail(struct CList *pThis);
+
+/* operation */
+static POSITION CListChunkAddHead(struct CList *pThis, const void* pData);
+static POSITION CListChunkAddTail(struct CList *pThis, const void* pData);
+static int CListChunkRemoveHead(struct CList *pThis);
+static int CListChunkRemoveTail(struct CList *pThis);
+static int CListChunkRemoveAll(struct CList *pThis);
+
+/* for iteration */
+static POSITION CListChunkGetHeadPosition(struct CList *pThis);
+static POSITION CListChunkGetTailPosition(struct CList *pThis);
+static void* CListChunkGetNext(struct CList *pThis, POSITION* position);
+static void* CListChunkGetPrev(struct CList *pThis, POSITION* position);
+static int CListChunkGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+static void* CListChunkGetAt(struct CList *pThis, POSITION position);
+static int CListChunkRemoveAt(struct CList *pThis, POSITION position);
+static int CListChunkSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion */
+static POSITION CListChunkInsertNext(struct CList *pThis, POSITION position, const void* pData);
+static POSITION CListChunkInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+
+/* Searching */
+static POSITION CListChunkFindIndex(struct CList *pThis, int nIndex);
+
+/* Status */
+static int CListChunkGetCount(struct CList *pThis);
+static int CListChunkIsEmpty(struct CList *pThis);
+
+static void CListChunkDestroy(struct CList *pThis);
+static POSITION CListChunkEmplace(struct CList *pThis, POSITION position, int bAfter);
+
+/* chunk management */
+static ListChunk* CListChunkNew(struct CList *pThis, ListChunk *pPrev, int nFirst);
+static void CListChunkFree(ListChunkStore *pStore, ListChunk *pChunk);
+static int CListChunkAddSlab(struct CList *pThis);
+static POSITION CListChunkInsertAt(struct CList *pThis, ListChunk *pChunk,
+		int nSlot);
+
+/*--------------------------------------------------------------------------*/
+
+static const CListOps g_CListChunkOps = {
+
+	/* head/tail access */
+	CListChunkGetHead,
+	CListChunkGetTail,
+
+	/* Operation */
+	CListChunkAddHead,
+	CListChunkAddTail,
+	CListChunkRemoveHead,
+	CListChunkRemoveTail,
+	CListChunkRemoveAll,
+
+	/* for iteration */
+	CListChunkGetHeadPosition,
+	CListChunkGetTailPosition,
+	CListChunkGetNext,
+	CListChunkGetPrev,
+
+	/* Retrieval, modification */
+	CListChunkGetAt,
+	CListChunkRemoveAt,
+	CListChunkSetAt,
+
+	/* Insertion */
+	CListChunkInsertNext,
+	CListChunkInsertPrev,
+
+	/* Search */
+	CListChunkFindIndex,
+
+	/* Status */
+	CListChunkGetCount,
+	CListChunkIsEmpty,
+
+	CListChunkDestroy,
+	CListChunkEmplace,
+	CListChunkGetNextBatch,
+	NULL			/* RemoveAt keeps later positions */
+};
+
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkInit
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer, freshly initialized by InitList
+ *
+ * Return Value:
+ * 	- Return -1 if storage state can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- pick the chunk size for nMaxDataSize and bind the chunk operations
+ *
+ * --------------------------------------------------------------------------*/
+int CListChunkInit(struct CList *pThis) {
+
+	ListChunkStore *pStore;
+	size_t nElemSize = (size_t)pThis->nMaxDataSize;
+	size_t nChunkSize = LIST_CHUNK_MIN_SIZE;
+
+	pStore = (ListChunkStore *)calloc(1, sizeof(ListChunkStore));
+
+	if (pStore == NULL)
+		return -1;
+
+	while (nChunkSize < LIST_CHUNK_MAX_SIZE &&
+			(nChunkSize - sizeof(ListChunk)) / nElemSize < LIST_CHUNK_TARGET_ELEMS)
+		nChunkSize *= 2;
+
+	/* splitting needs room for at least two payloads */
+	while ((nChunkSize - sizeof(ListChunk)) / nElemSize < 2)
+		nChunkSize *= 2;
+
+	pStore->nChunkSize = nChunkSize;
+	pStore->nElemSize = nElemSize;
+	pStore->nPerChunk = (int)((nChunkSize - sizeof(ListChunk)) / nElemSize);
+	pStore->nSlabChunks = LIST_CHUNK_SLAB_MIN;
+
+	pThis->pStorage = pStore;
+	CListBindOps(pThis, &g_CListChunkOps);
+
+	return 0;
+}
+
+static void* CListChunkGetHead(struct CList *pThis) {
+
+	ListChunkStore *pStore = CHUNK_STORE(pThis);
+	ListChunk *pChunk = pStore->pHead;
+
+	if (pChunk == NULL)
+		return NULL;
+
+	return CHUNK_SLOT(pStore, pChunk, pChunk->nFirst);
+}
+
+static void* CListChunkGetTail(struct CList *pThis) {
+
+	ListChunkStore *pStore = CHUNK_STORE(pThis);
+	ListChunk *pChunk = pStore->pTail;
+
+	if (pChunk == NULL)
+		return NULL;
+
+	return CHUNK_SLOT(pStore, pChunk, pChunk->nFirst + pChunk->nUsed - 1);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkAddHead
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : data insert to list
+ *
+ * Return Value:
+ *  - headnode position
+ *
+ * Desc:
+ *	- copy data into a slot from CListChunkEmplace
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListChunkAddHead(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListChunkEmplace(pThis, NULL, 0);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkAddTail
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : data insert to list
+ *
+ * Return Value:
+ * 	- tail node position
+ *
+ * Desc:
+ * 	- copy data into a slot from CListChunkEmplace
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListChunkAddTail(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListChunkEmplace(pThis, NULL, 1);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static int CListChunkRemoveHead(struct CList *pThis) {
+
+	ListChunkStore *pStore;
+	ListChunk *pChunk;
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = CHUNK_STORE(pThis);
+	pChunk = pStore->pHead;
+
+	pChunk->nFirst++;
+	pChunk->nUsed--;
+	pThis->nCount--;
+
+	if (pChunk->nUsed == 0)
+		CListChunkFree(pStore, pChunk);
+
+	return 0;
+}
+
+static int CListChunkRemoveTail(struct CList *pThis) {
+
+	ListChunkStore *pStore;
+	ListChunk *pChunk;
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = CHUNK_STORE(pThis);
+	pChunk = pStore->pTail;
+
+	pChunk->nUsed--;
+	pThis->nCount--;
+
+	if (pChunk->nUsed == 0)
+		CListChunkFree(pStore, pChunk);
+
+	return 0;
+}
+
+static int CListChunkRemoveAll(struct CList *pThis) {
+
+	ListChunkStore *pStore;
+	ListSlab *pSlab;
+
+	if (pThis == NULL)
+		return 0;
+
+	pStore = CHUNK_STORE(pThis);
+
+	/* every chunk lives in a slab, drop them all at once */
+	while (pStore->pSlabs != NULL) {
+		pSlab = pStore->pSlabs;
+		pStore->pSlabs = pSlab->pNext;
+		LIST_STAT_FREE(pThis, pSlab->nSize);
+		free(pSlab);
+	}
+
+	pStore->pHead = NULL;
+	pStore->pTail = NULL;
+	pStore->pFree = NULL;
+	pStore->nSlabChunks = LIST_CHUNK_SLAB_MIN;
+	pThis->nCount = 0;
+
+	return 0;
+}
+
+static POSITION CListChunkGetHeadPosition(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return (POSITION)CListChunkGetHead(pThis);
+}
+
+static POSITION CListChunkGetTailPosition(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return (POSITION)CListChunkGetTail(pThis);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkGetNext
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position next to current list element
+ *
+ * Return Value:
+ * 	- data pointer next to current element
+ *
+ * Desc:
+ * 	- step to the next slot, or the first slot of the next chunk
+ *
+ * --------------------------------------------------------------------------*/
+static void* CListChunkGetNext(struct CList *pThis, POSITION* position) {
+
+	ListChunkStore *pStore;
+	ListChunk *pChunk;
+	unsigned char *pSlot;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = CHUNK_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+	pChunk = CHUNK_OF(pStore, pSlot);
+
+	if (pSlot != CHUNK_SLOT(pStore, pChunk, pChunk->nFirst + pChunk->nUsed - 1))
+		*position = (POSITION)(pSlot + pStore->nElemSize);
+	else if (pChunk->pNext != NULL)
+		*position = (POSITION)CHUNK_SLOT(pStore, pChunk->pNext, pChunk->pNext->nFirst);
+	else
+		*position = NULL;
+
+	return pSlot;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkGetNextBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position of the first element wanted, advanced past the
+ * 	  last one handed out (NULL at the end)
+ * 	- ppData : receives the payload pointers
+ * 	- nMax : size of ppData
+ *
+ * Return Value:
+ * 	- number of payload pointers stored, 0 at the end of the list, -1 if
+ * 	  arguments are invalid
+ *
+ * Desc:
+ * 	- hand out the slots of a chunk one after another. The next chunk is
+ * 	  prefetched on entering one, so its header is in cache by the time
+ * 	  the slots of this one are done.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListChunkGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	ListChunkStore *pStore;
+	ListChunk *pChunk;
+	unsigned char *pSlot;
+	unsigned char *pLast;
+	int nGot = 0;
+
+	if (pThis == NULL || position == NULL || ppData == NULL || nMax < 0)
+		return -1;
+
+	if (*position == NULL || nMax == 0)
+		return 0;
+
+	pStore = CHUNK_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+	pChunk = CHUNK_OF(pStore, pSlot);
+	pLast = CHUNK_SLOT(pStore, pChunk, pChunk->nFirst + pChunk->nUsed - 1);
+
+	if (pChunk->pNext != NULL)
+		LIST_PREFETCH(pChunk->pNext);
+
+	while (nGot < nMax) {
+
+		ppData[nGot++] = pSlot;
+
+		if (pSlot != pLast) {
+			pSlot += pStore->nElemSize;
+			continue;
+		}
+
+		pChunk = pChunk->pNext;
+
+		if (pChunk == NULL) {
+			pSlot = NULL;
+			break;
+		}
+
+		if (pChunk->pNext != NULL)
+			LIST_PREFETCH(pChunk->pNext);
+
+		pSlot = CHUNK_SLOT(pStore, pChunk, pChunk->nFirst);
+		pLast = CHUNK_SLOT(pStore, pChunk, pChunk->nFirst + pChunk->nUsed - 1);
+	}
+
+	*position = (POSITION)pSlot;
+
+	return nGot;
+}
+
+static void* CListChunkGetPrev(struct CList *pThis, POSITION* position) {
+
+	ListChunkStore *pStore;
+	ListChunk *pChunk;
+	ListChunk *pPrev;
+	unsigned char *pSlot;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = CHUNK_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+	pChunk = CHUNK_OF(pStore, pSlot);
+	pPrev = pChunk->pPrev;
+
+	if (pSlot != CHUNK_SLOT(pStore, pChunk, pChunk->nFirst))
+		*position = (POSITION)(pSlot - pStore->nElemSize);
+	else if (pPrev != NULL)
+		*position = (POSITION)CHUNK_SLOT(pStore, pPrev, pPrev->nFirst + pPrev->nUsed - 1);
+	else
+		*position = NULL;
+
+	return pSlot;
+}
+
+static void* CListChunkGetAt(struct CList *pThis, POSITION position) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return (void *)position;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkRemoveAt
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position want to remove.
+ *
+ * Return Value:
+ *  - Return -1 if pThis is NULL.
+ *
+ * Desc:
+ * 	- close the gap by moving the payloads in front of it up one slot. When
+ * 	  the chunk and its predecessor together are at most half full, the
+ * 	  predecessor's payloads move into the free front slots and it is freed.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListChunkRemoveAt(struct CList *pThis, POSITION position) {
+
+	ListChunkStore *pStore;
+	ListChunk *pChunk;
+	ListChunk *pPrev;
+	int nSlot;
+
+	if (pThis == NULL || position == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = CHUNK_STORE(pThis);
+	pChunk = CHUNK_OF(pStore, position);
+	nSlot = CHUNK_SLOT_INDEX(pStore, pChunk, position);
+
+	memmove(CHUNK_SLOT(pStore, pChunk, pChunk->nFirst + 1),
+			CHUNK_SLOT(pStore, pChunk, pChunk->nFirst),
+			(size_t)(nSlot - pChunk->nFirst) * pStore->nElemSize);
+
+	pChunk->nFirst++;
+	pChunk->nUsed--;
+	pThis->nCount--;
+
+	if (pChunk->nUsed == 0) {
+		CListChunkFree(pStore, pChunk);
+		return 0;
+	}
+
+	pPrev = pChunk->pPrev;
+
+	if (pPrev != NULL && pPrev->nUsed <= pChunk->nFirst &&
+			pPrev->nUsed + pChunk->nUsed <= pStore->nPerChunk / 2) {
+
+		pChunk->nFirst -= pPrev->nUsed;
+		pChunk->nUsed += pPrev->nUsed;
+
+		memcpy(CHUNK_SLOT(pStore, pChunk, pChunk->nFirst),
+				CHUNK_SLOT(pStore, pPrev, pPrev->nFirst),
+				(size_t)pPrev->nUsed * pStore->nElemSize);
+
+		CListChunkFree(pStore, pPrev);
+	}
+
+	return 0;
+}
+
+static int CListChunkSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return -1;
+
+	memcpy(position, pData, (size_t)pThis->nMaxDataSize);
+
+	return 0;
+}
+
+static POSITION CListChunkInsertNext(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListChunkEmplace(pThis, position, 1);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListChunkInsertPrev(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListChunkEmplace(pThis, position, 0);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkFindIndex
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nIndex : zero based element index
+ *
+ * Return Value:
+ * 	- return positoin nIndex points
+ *
+ * Desc:
+ * 	- skip whole chunks from the nearer end
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListChunkFindIndex(struct CList *pThis, int nIndex) {
+
+	ListChunkStore *pStore;
+	ListChunk *pChunk;
+	int nFromTail;
+	int nSteps = 0;
+
+	if (pThis == NULL || nIndex < 0 || nIndex >= pThis->nCount)
+		return NULL;
+
+	pStore = CHUNK_STORE(pThis);
+
+	if (nIndex < pThis->nCount / 2) {
+		pChunk = pStore->pHead;
+		while (nIndex >= pChunk->nUsed) {
+			nIndex -= pChunk->nUsed;
+			pChunk = pChunk->pNext;
+			nSteps++;
+		}
+		LIST_STAT_STEPS(pThis, nSteps);
+		return (POSITION)CHUNK_SLOT(pStore, pChunk, pChunk->nFirst + nIndex);
+	}
+
+	nFromTail = pThis->nCount - 1 - nIndex;
+	pChunk = pStore->pTail;
+	while (nFromTail >= pChunk->nUsed) {
+		nFromTail -= pChunk->nUsed;
+		pChunk = pChunk->pPrev;
+		nSteps++;
+	}
+	LIST_STAT_STEPS(pThis, nSteps);
+
+	return (POSITION)CHUNK_SLOT(pStore, pChunk,
+			pChunk->nFirst + pChunk->nUsed - 1 - nFromTail);
+}
+
+static int CListChunkGetCount(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return pThis->nCount;
+}
+
+static int CListChunkIsEmpty(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return (pThis->nCount != 0) ? 1 : 0;
+}
+
+static void CListChunkDestroy(struct CList *pThis) {
+
+	CListChunkRemoveAll(pThis);
+
+	free(pThis->pStorage);
+	pThis->pStorage = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkEmplace
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to insert next to, NULL for head or tail
+ * 	- bAfter : insert after position (or at tail), else before (or at head)
+ *
+ * Return Value:
+ * 	- position of the new, uninitialized element
+ *
+ * Desc:
+ * 	- head inserts fill the head chunk from its end towards slot 0, tail
+ * 	  inserts fill the tail chunk upwards; a new chunk is started when
+ * 	  there is no room. Inserts next to an element go to CListChunkInsertAt.
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListChunkEmplace(struct CList *pThis, POSITION position, int bAfter) {
+
+	ListChunkStore *pStore = CHUNK_STORE(pThis);
+	ListChunk *pChunk;
+	int nSlot;
+
+	if (position != NULL) {
+		pChunk = CHUNK_OF(pStore, position);
+		nSlot = CHUNK_SLOT_INDEX(pStore, pChunk, position);
+		return CListChunkInsertAt(pThis, pChunk, bAfter ? nSlot + 1 : nSlot);
+	}
+
+	if (!bAfter) {
+
+		pChunk = pStore->pHead;
+
+		if (pChunk == NULL || pChunk->nFirst == 0) {
+			pChunk = CListChunkNew(pThis, NULL, pStore->nPerChunk);
+			if (pChunk == NULL)
+				return NULL;
+		}
+
+		pChunk->nFirst--;
+		nSlot = pChunk->nFirst;
+	}
+	else {
+
+		pChunk = pStore->pTail;
+
+		if (pChunk == NULL || pChunk->nFirst + pChunk->nUsed == pStore->nPerChunk) {
+			pChunk = CListChunkNew(pThis, pStore->pTail, 0);
+			if (pChunk == NULL)
+				return NULL;
+		}
+
+		nSlot = pChunk->nFirst + pChunk->nUsed;
+	}
+
+	pChunk->nUsed++;
+	pThis->nCount++;
+	LIST_STAT_COUNT(pThis);
+
+	return (POSITION)CHUNK_SLOT(pStore, pChunk, nSlot);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkNew
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pPrev : chunk to link after, NULL to become the head
+ * 	- nFirst : initial slot, elements are added from there
+ *
+ * Return Value:
+ * 	- new empty chunk, NULL if allocation fails
+ *
+ * Desc:
+ *
+ * --------------------------------------------------------------------------*/
+static ListChunk* CListChunkNew(struct CList *pThis, ListChunk *pPrev, int nFirst) {
+
+	ListChunkStore *pStore = CHUNK_STORE(pThis);
+	ListChunk *pChunk;
+
+	if (pStore->pFree == NULL && CListChunkAddSlab(pThis) != 0)
+		return NULL;
+
+	pChunk = pStore->pFree;
+	pStore->pFree = pChunk->pNext;
+
+	pChunk->nFirst = nFirst;
+	pChunk->nUsed = 0;
+	pChunk->pPrev = pPrev;
+
+	if (pPrev != NULL) {
+		pChunk->pNext = pPrev->pNext;
+		pPrev->pNext = pChunk;
+	}
+	else {
+		pChunk->pNext = pStore->pHead;
+		pStore->pHead = pChunk;
+	}
+
+	if (pChunk->pNext != NULL)
+		pChunk->pNext->pPrev = pChunk;
+	else
+		pStore->pTail = pChunk;
+
+	return pChunk;
+}
+
+static void CListChunkFree(ListChunkStore *pStore, ListChunk *pChunk) {
+
+	if (pChunk->pPrev != NULL)
+		pChunk->pPrev->pNext = pChunk->pNext;
+	else
+		pStore->pHead = pChunk->pNext;
+
+	if (pChunk->pNext != NULL)
+		pChunk->pNext->pPrev = pChunk->pPrev;
+	else
+		pStore->pTail = pChunk->pPrev;
+
+	pChunk->pNext = pStore->pFree;
+	pStore->pFree = pChunk;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkAddSlab
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ * 	- Return -1 if slab can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- allocate a slab aligned to the chunk size and put its cells on the
+ * 	  free list. Slabs double in size up to LIST_CHUNK_SLAB_MAX chunks.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListChunkAddSlab(struct CList *pThis) {
+
+	ListChunkStore *pStore = CHUNK_STORE(pThis);
+	unsigned char *pSlab;
+	ListChunk *pChunk;
+	size_t nSize = pStore->nChunkSize * (size_t)pStore->nSlabChunks;
+	int i;
+
+	pSlab = (unsigned char *)aligned_alloc(pStore->nChunkSize, nSize);
+
+	if (pSlab == NULL) {
+		LIST_STAT_FAIL(pThis);
+		return -1;
+	}
+
+	LIST_STAT_ALLOC(pThis, nSize);
+
+#ifdef CLIST_STATS
+	((ListSlab *)pSlab)->nSize = nSize;
+#endif
+	((ListSlab *)pSlab)->pNext = pStore->pSlabs;
+	pStore->pSlabs = (ListSlab *)pSlab;
+
+	for (i = pStore->nSlabChunks - 1; i > 0; i--) {
+		pChunk = (ListChunk *)(pSlab + (size_t)i * pStore->nChunkSize);
+		pChunk->pNext = pStore->pFree;
+		pStore->pFree = pChunk;
+	}
+
+	if (pStore->nSlabChunks < LIST_CHUNK_SLAB_MAX)
+		pStore->nSlabChunks *= 2;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListChunkInsertAt
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pChunk : chunk to insert into
+ * 	- nSlot : the new element goes in front of the one in this slot, or
+ * 	          after the last one if nSlot is one past it
+ *
+ * Return Value:
+ * 	- position of the new, uninitialized element, NULL if a split can not
+ * 	  allocate
+ *
+ * Desc:
+ * 	- a full chunk is split in halves first. Then the shorter run of
+ * 	  payloads on the side with a free slot moves over by one.
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListChunkInsertAt(struct CList *pThis, ListChunk *pChunk,
+		int nSlot) {
+
+	ListChunkStore *pStore = CHUNK_STORE(pThis);
+	ListChunk *pSplit;
+	int nKeep;
+	int nEnd;
+
+	if (pChunk->nUsed == pStore->nPerChunk) {
+
+		pSplit = CListChunkNew(pThis, pChunk, 0);
+		if (pSplit == NULL)
+			return NULL;
+
+		nKeep = pChunk->nUsed / 2;
+		pSplit->nUsed = pChunk->nUsed - nKeep;
+		memcpy(pSplit->data, CHUNK_SLOT(pStore, pChunk, pChunk->nFirst + nKeep),
+				(size_t)pSplit->nUsed * pStore->nElemSize);
+		pChunk->nUsed = nKeep;
+
+		if (nSlot > pChunk->nFirst + nKeep) {
+			nSlot -= pChunk->nFirst + nKeep;
+			pChunk = pSplit;
+		}
+	}
+
+	nEnd = pChunk->nFirst + pChunk->nUsed;
+
+	if (nEnd < pStore->nPerChunk &&
+			(pChunk->nFirst == 0 || nEnd - nSlot <= nSlot - pChunk->nFirst)) {
+		memmove(CHUNK_SLOT(pStore, pChunk, nSlot + 1), CHUNK_SLOT(pStore, pChunk, nSlot),
+				(size_t)(nEnd - nSlot) * pStore->nElemSize);
+	}
+	else {
+		memmove(CHUNK_SLOT(pStore, pChunk, pChunk->nFirst - 1),
+				CHUNK_SLOT(pStore, pChunk, pChunk->nFirst),
+				(size_t)(nSlot - pChunk->nFirst) * pStore->nElemSize);
+		pChunk->nFirst--;
+		nSlot--;
+	}
+
+	pChunk->nUsed++;
+	pThis->nCount++;
+	LIST_STAT_COUNT(pThis);
+
+	return (POSITION)CHUNK_SLOT(pStore, pChunk, nSlot);
+}
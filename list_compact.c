@@ -0,0 +1,688 @@
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * LIST_STORAGE_COMPACT: array of slots linked by 32-bit indices
+ *
+ * Every element is one slot of a single growable array: two uint32_t links
+ * followed by the payload, so an element costs 8 bytes besides its data
+ * instead of a malloc'd node with two pointers and an allocator header.
+ * Links hold slot numbers counted from 1; 0 is the end of the list. Removed
+ * slots are pushed on a free stack chained through their nNext link and are
+ * reused first, slots beyond nUsed have never been handed out.
+ *
+ * A POSITION is the slot number itself, not an address. It survives the
+ * array growing (realloc), and RemoveAt leaves every other position valid.
+ * Payload addresses returned by GetAt/GetNext are only good until the next
+ * insert that grows the array.
+ * --------------------------------------------------------------------------*/
+
+#define LIST_COMPACT_DEFAULT_CAPACITY	16
+
+typedef struct ListCompactLink {
+
+	uint32_t	nNext;
+	uint32_t	nPrev;
+
+} ListCompactLink;
+
+typedef struct ListCompactStore {
+
+	unsigned char	*pSlots;
+	size_t			nSlotSize;		/* links + payload, pointer aligned */
+
+	uint32_t		nCapacity;		/* slots allocated */
+	uint32_t		nUsed;			/* slots handed out at least once */
+	uint32_t		nFree;			/* top of the free stack, 0 if empty */
+
+	uint32_t		nHead;
+	uint32_t		nTail;
+
+	/* last FindIndex result, like the node list's cursor; 0 if unknown */
+	uint32_t		nCursor;
+	int				nCursorIndex;
+
+} ListCompactStore;
+
+#define COMPACT_STORE(pThis)		((ListCompactStore *)(pThis)->pStorage)
+#define COMPACT_LINK(pStore, nSlot) \
+	((ListCompactLink *)((pStore)->pSlots + (size_t)((nSlot) - 1) * (pStore)->nSlotSize))
+#define COMPACT_DATA(pStore, nSlot) \
+	((unsigned char *)COMPACT_LINK(pStore, nSlot) + sizeof(ListCompactLink))
+
+#define COMPACT_POS(nSlot)			((POSITION)(uintptr_t)(nSlot))
+#define COMPACT_SLOT(position)		((uint32_t)(uintptr_t)(position))
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+/* head, tail access */
+static void* CListCompactGetHead(struct CList *pThis);
+static void* CListCompactGetTail(struct CList *pThis);
+
+/* operation */
+static POSITION CListCompactAddHead(struct CList *pThis, const void* pData);
+static POSITION CListCompactAddTail(struct CList *pThis, const void* pData);
+static int CListCompactRemoveHead(struct CList *pThis);
+static int CListCompactRemoveTail(struct CList *pThis);
+static int CListCompactRemoveAll(struct CList *pThis);
+
+/* for iteration */
+static POSITION CListCompactGetHeadPosition(struct CList *pThis);
+static POSITION CListCompactGetTailPosition(struct CList *pThis);
+static void* CListCompactGetNext(struct CList *pThis, POSITION* position);
+static void* CListCompactGetPrev(struct CList *pThis, POSITION* position);
+static int CListCompactGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+static void* CListCompactGetAt(struct CList *pThis, POSITION position);
+static int CListCompactRemoveAt(struct CList *pThis, POSITION position);
+static int CListCompactSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion */
+static POSITION CListCompactInsertNext(struct CList *pThis, POSITION position, const void* pData);
+static POSITION CListCompactInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+
+/* Searching */
+static POSITION CListCompactFindIndex(struct CList *pThis, int nIndex);
+
+/* Status */
+static int CListCompactGetCount(struct CList *pThis);
+static int CListCompactIsEmpty(struct CList *pThis);
+
+static void CListCompactDestroy(struct CList *pThis);
+static POSITION CListCompactEmplace(struct CList *pThis, POSITION position, int bAfter);
+
+/* slot management */
+static uint32_t CListCompactAllocSlot(struct CList *pThis);
+static void CListCompactUnlink(struct CList *pThis, uint32_t nSlot);
+
+/*--------------------------------------------------------------------------*/
+
+static const CListOps g_CListCompactOps = {
+
+	/* head/tail access */
+	CListCompactGetHead,
+	CListCompactGetTail,
+
+	/* Operation */
+	CListCompactAddHead,
+	CListCompactAddTail,
+	CListCompactRemoveHead,
+	CListCompactRemoveTail,
+	CListCompactRemoveAll,
+
+	/* for iteration */
+	CListCompactGetHeadPosition,
+	CListCompactGetTailPosition,
+	CListCompactGetNext,
+	CListCompactGetPrev,
+
+	/* Retrieval, modification */
+	CListCompactGetAt,
+	CListCompactRemoveAt,
+	CListCompactSetAt,
+
+	/* Insertion */
+	CListCompactInsertNext,
+	CListCompactInsertPrev,
+
+	/* Search */
+	CListCompactFindIndex,
+
+	/* Status */
+	CListCompactGetCount,
+	CListCompactIsEmpty,
+
+	CListCompactDestroy,
+	CListCompactEmplace,
+	CListCompactGetNextBatch,
+	NULL			/* RemoveAt keeps later positions */
+};
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListCompact
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nMaxDataSize : Max size of list element
+ * 	- nCapacity : expected number of elements, sizes the slot array;
+ * 	  0 picks a small default
+ *
+ * Return Value:
+ * 	- Return -1 if the slot array can not be allocated, else returns 0
+ *
+ * Desc: Initialize list instance with LIST_STORAGE_COMPACT, for very large
+ *       lists: elements are slots of one array linked by 32-bit indices,
+ *       8 bytes of links per element and no allocator header. Traversal
+ *       walks one array. The array doubles when it runs out of slots and
+ *       is kept, not shrunk, until DestroyList.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListCompact(struct CList *pThis, int nMaxDataSize, int nCapacity) {
+
+	if (pThis == NULL || nMaxDataSize <= 0 || nCapacity < 0)
+		return -1;
+
+	InitList(pThis, nMaxDataSize);
+
+	return CListCompactInit(pThis, nCapacity);
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListCompactInit
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer, freshly initialized by InitList
+ * 	- nCapacity : initial slot count, 0 for the default
+ *
+ * Return Value:
+ * 	- Return -1 if storage state can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- allocate the slot array and bind the compact operations
+ *
+ * --------------------------------------------------------------------------*/
+int CListCompactInit(struct CList *pThis, int nCapacity) {
+
+	ListCompactStore *pStore;
+
+	if (nCapacity <= 0)
+		nCapacity = LIST_COMPACT_DEFAULT_CAPACITY;
+
+	pStore = (ListCompactStore *)calloc(1, sizeof(ListCompactStore));
+
+	if (pStore == NULL)
+		return -1;
+
+	pStore->nSlotSize = LIST_ALIGN_UP(sizeof(ListCompactLink) +
+			(size_t)pThis->nMaxDataSize, LIST_NODE_ALIGN);
+	pStore->nCapacity = (uint32_t)nCapacity;
+	pStore->pSlots = (unsigned char *)malloc((size_t)nCapacity * pStore->nSlotSize);
+
+	if (pStore->pSlots == NULL) {
+		free(pStore);
+		return -1;
+	}
+
+	LIST_STAT_ALLOC(pThis, (size_t)nCapacity * pStore->nSlotSize);
+
+	pThis->pStorage = pStore;
+	CListBindOps(pThis, &g_CListCompactOps);
+
+	return 0;
+}
+
+static void* CListCompactGetHead(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return COMPACT_DATA(COMPACT_STORE(pThis), COMPACT_STORE(pThis)->nHead);
+}
+
+static void* CListCompactGetTail(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return COMPACT_DATA(COMPACT_STORE(pThis), COMPACT_STORE(pThis)->nTail);
+}
+
+static POSITION CListCompactAddHead(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListCompactEmplace(pThis, NULL, 0);
+
+	if (pos != NULL)
+		memcpy(CListCompactGetAt(pThis, pos), pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListCompactAddTail(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListCompactEmplace(pThis, NULL, 1);
+
+	if (pos != NULL)
+		memcpy(CListCompactGetAt(pThis, pos), pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static int CListCompactRemoveHead(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	CListCompactUnlink(pThis, COMPACT_STORE(pThis)->nHead);
+
+	return 0;
+}
+
+static int CListCompactRemoveTail(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	CListCompactUnlink(pThis, COMPACT_STORE(pThis)->nTail);
+
+	return 0;
+}
+
+static int CListCompactRemoveAll(struct CList *pThis) {
+
+	ListCompactStore *pStore;
+
+	if (pThis == NULL)
+		return 0;
+
+	/* the slot array stays for the next elements */
+	pStore = COMPACT_STORE(pThis);
+	pStore->nUsed = 0;
+	pStore->nFree = 0;
+	pStore->nHead = 0;
+	pStore->nTail = 0;
+	pStore->nCursor = 0;
+	pThis->nCount = 0;
+
+	return 0;
+}
+
+static POSITION CListCompactGetHeadPosition(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return COMPACT_POS(COMPACT_STORE(pThis)->nHead);
+}
+
+static POSITION CListCompactGetTailPosition(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return COMPACT_POS(COMPACT_STORE(pThis)->nTail);
+}
+
+static void* CListCompactGetNext(struct CList *pThis, POSITION* position) {
+
+	ListCompactStore *pStore;
+	uint32_t nSlot;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = COMPACT_STORE(pThis);
+	nSlot = COMPACT_SLOT(*position);
+
+	*position = COMPACT_POS(COMPACT_LINK(pStore, nSlot)->nNext);
+
+	return COMPACT_DATA(pStore, nSlot);
+}
+
+/* like the node walk, each nNext depends on the slot before; the payload
+ * lines past the link and the slot the next batch starts at are prefetched */
+static int CListCompactGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	ListCompactStore *pStore;
+	uint32_t nSlot;
+	int nGot = 0;
+
+	if (pThis == NULL || position == NULL || ppData == NULL || nMax < 0)
+		return -1;
+
+	pStore = COMPACT_STORE(pThis);
+	nSlot = COMPACT_SLOT(*position);
+
+	while (nGot < nMax && nSlot != 0) {
+		CListPrefetchPayload(COMPACT_DATA(pStore, nSlot), (size_t)pThis->nMaxDataSize);
+		ppData[nGot++] = COMPACT_DATA(pStore, nSlot);
+		nSlot = COMPACT_LINK(pStore, nSlot)->nNext;
+	}
+
+	if (nSlot != 0)
+		LIST_PREFETCH(COMPACT_LINK(pStore, nSlot));
+
+	*position = COMPACT_POS(nSlot);
+
+	return nGot;
+}
+
+static void* CListCompactGetPrev(struct CList *pThis, POSITION* position) {
+
+	ListCompactStore *pStore;
+	uint32_t nSlot;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = COMPACT_STORE(pThis);
+	nSlot = COMPACT_SLOT(*position);
+
+	*position = COMPACT_POS(COMPACT_LINK(pStore, nSlot)->nPrev);
+
+	return COMPACT_DATA(pStore, nSlot);
+}
+
+static void* CListCompactGetAt(struct CList *pThis, POSITION position) {
+
+	if (pThis == NULL || position == NULL)
+		return NULL;
+
+	return COMPACT_DATA(COMPACT_STORE(pThis), COMPACT_SLOT(position));
+}
+
+static int CListCompactRemoveAt(struct CList *pThis, POSITION position) {
+
+	if (pThis == NULL || position == NULL || pThis->nCount == 0)
+		return -1;
+
+	CListCompactUnlink(pThis, COMPACT_SLOT(position));
+
+	return 0;
+}
+
+static int CListCompactSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return -1;
+
+	memcpy(CListCompactGetAt(pThis, position), pData, (size_t)pThis->nMaxDataSize);
+
+	return 0;
+}
+
+static POSITION CListCompactInsertNext(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListCompactEmplace(pThis, position, 1);
+
+	if (pos != NULL)
+		memcpy(CListCompactGetAt(pThis, pos), pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListCompactInsertPrev(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListCompactEmplace(pThis, position, 0);
+
+	if (pos != NULL)
+		memcpy(CListCompactGetAt(pThis, pos), pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCompactFindIndex
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nIndex : zero based index
+ *
+ * Return Value:
+ * 	- position at nIndex, NULL if out of range
+ *
+ * Desc:
+ * 	- walk from the nearest of head, tail and the last FindIndex result,
+ * 	  so loops over consecutive indexes take one step each
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListCompactFindIndex(struct CList *pThis, int nIndex) {
+
+	ListCompactStore *pStore;
+	uint32_t nSlot;
+	int nAt;
+
+	if (pThis == NULL || nIndex < 0 || nIndex >= pThis->nCount)
+		return NULL;
+
+	pStore = COMPACT_STORE(pThis);
+
+	if (nIndex <= pThis->nCount - 1 - nIndex) {
+		nSlot = pStore->nHead;
+		nAt = 0;
+	}
+	else {
+		nSlot = pStore->nTail;
+		nAt = pThis->nCount - 1;
+	}
+
+	if (pStore->nCursor != 0 &&
+			abs(nIndex - pStore->nCursorIndex) < abs(nIndex - nAt)) {
+		nSlot = pStore->nCursor;
+		nAt = pStore->nCursorIndex;
+	}
+
+	LIST_STAT_STEPS(pThis, abs(nIndex - nAt));
+
+	for (; nAt < nIndex; nAt++)
+		nSlot = COMPACT_LINK(pStore, nSlot)->nNext;
+	for (; nAt > nIndex; nAt--)
+		nSlot = COMPACT_LINK(pStore, nSlot)->nPrev;
+
+	pStore->nCursor = nSlot;
+	pStore->nCursorIndex = nIndex;
+
+	return COMPACT_POS(nSlot);
+}
+
+static int CListCompactGetCount(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return pThis->nCount;
+}
+
+static int CListCompactIsEmpty(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return (pThis->nCount != 0) ? 1 : 0;
+}
+
+static void CListCompactDestroy(struct CList *pThis) {
+
+	ListCompactStore *pStore = COMPACT_STORE(pThis);
+
+	if (pStore != NULL) {
+		LIST_STAT_FREE(pThis, (size_t)pStore->nCapacity * pStore->nSlotSize);
+		free(pStore->pSlots);
+	}
+
+	free(pStore);
+	pThis->pStorage = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCompactEmplace
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to insert next to, NULL for head or tail
+ * 	- bAfter : insert after position (or at tail), else before (or at head)
+ *
+ * Return Value:
+ * 	- position of the new, uninitialized element, NULL if the array can
+ * 	  not grow
+ *
+ * Desc:
+ * 	- take a slot and link it in. The cursor keeps its index when the
+ * 	  element goes in behind it and shifts by one when it goes in at head.
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListCompactEmplace(struct CList *pThis, POSITION position, int bAfter) {
+
+	ListCompactStore *pStore = COMPACT_STORE(pThis);
+	ListCompactLink *pLink;
+	uint32_t nSlot;
+	uint32_t nPrev;
+	uint32_t nNext;
+
+	if (pThis->nCount == INT_MAX)
+		return NULL;
+
+	nSlot = CListCompactAllocSlot(pThis);
+
+	if (nSlot == 0) {
+		LIST_STAT_FAIL(pThis);
+		return NULL;
+	}
+
+	if (position == NULL) {
+		nPrev = bAfter ? pStore->nTail : 0;
+		nNext = bAfter ? 0 : pStore->nHead;
+	}
+	else if (bAfter) {
+		nPrev = COMPACT_SLOT(position);
+		nNext = COMPACT_LINK(pStore, nPrev)->nNext;
+	}
+	else {
+		nNext = COMPACT_SLOT(position);
+		nPrev = COMPACT_LINK(pStore, nNext)->nPrev;
+	}
+
+	pLink = COMPACT_LINK(pStore, nSlot);
+	pLink->nPrev = nPrev;
+	pLink->nNext = nNext;
+
+	if (nPrev != 0)
+		COMPACT_LINK(pStore, nPrev)->nNext = nSlot;
+	else
+		pStore->nHead = nSlot;
+
+	if (nNext != 0)
+		COMPACT_LINK(pStore, nNext)->nPrev = nSlot;
+	else
+		pStore->nTail = nSlot;
+
+	if (pStore->nCursor != 0 && nNext != 0) {
+		if (nPrev == 0)
+			pStore->nCursorIndex++;
+		else
+			pStore->nCursor = 0;
+	}
+
+	pThis->nCount++;
+	LIST_STAT_COUNT(pThis);
+
+	return COMPACT_POS(nSlot);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCompactAllocSlot
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ * 	- number of an unlinked slot, 0 if the array can not grow
+ *
+ * Desc:
+ * 	- pop the free stack, else hand out the next never used slot, doubling
+ * 	  the array when all of them are taken
+ *
+ * --------------------------------------------------------------------------*/
+static uint32_t CListCompactAllocSlot(struct CList *pThis) {
+
+	ListCompactStore *pStore = COMPACT_STORE(pThis);
+	unsigned char *pSlots;
+	uint32_t nSlot;
+	uint32_t nCapacity;
+
+	if (pStore->nFree != 0) {
+		nSlot = pStore->nFree;
+		pStore->nFree = COMPACT_LINK(pStore, nSlot)->nNext;
+		return nSlot;
+	}
+
+	if (pStore->nUsed == pStore->nCapacity) {
+
+		if (pStore->nCapacity > INT_MAX / 2)
+			nCapacity = INT_MAX;
+		else
+			nCapacity = pStore->nCapacity * 2;
+
+		if (nCapacity == pStore->nCapacity)
+			return 0;
+
+		pSlots = (unsigned char *)realloc(pStore->pSlots,
+				(size_t)nCapacity * pStore->nSlotSize);
+
+		if (pSlots == NULL)
+			return 0;
+
+		/* a realloc gives the old array back and takes a bigger one */
+		LIST_STAT_FREE(pThis, (size_t)pStore->nCapacity * pStore->nSlotSize);
+		LIST_STAT_ALLOC(pThis, (size_t)nCapacity * pStore->nSlotSize);
+
+		pStore->pSlots = pSlots;
+		pStore->nCapacity = nCapacity;
+	}
+
+	return ++pStore->nUsed;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListCompactUnlink
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nSlot : linked slot
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- unlink slot and push it on the free stack. The cursor survives
+ * 	  removal at either end unless it is the removed slot.
+ *
+ * --------------------------------------------------------------------------*/
+static void CListCompactUnlink(struct CList *pThis, uint32_t nSlot) {
+
+	ListCompactStore *pStore = COMPACT_STORE(pThis);
+	ListCompactLink *pLink = COMPACT_LINK(pStore, nSlot);
+
+	if (pStore->nCursor != 0) {
+		if (nSlot == pStore->nCursor)
+			pStore->nCursor = 0;
+		else if (pLink->nPrev == 0)
+			pStore->nCursorIndex--;
+		else if (pLink->nNext != 0)
+			pStore->nCursor = 0;
+	}
+
+	if (pLink->nPrev != 0)
+		COMPACT_LINK(pStore, pLink->nPrev)->nNext = pLink->nNext;
+	else
+		pStore->nHead = pLink->nNext;
+
+	if (pLink->nNext != 0)
+		COMPACT_LINK(pStore, pLink->nNext)->nPrev = pLink->nPrev;
+	else
+		pStore->nTail = pLink->nPrev;
+
+	pLink->nNext = pStore->nFree;
+	pStore->nFree = nSlot;
+
+	pThis->nCount--;
+}
@@ -0,0 +1,866 @@
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * LIST_STORAGE_DEQUE: map of fixed size blocks, like std::deque
+ *
+ * Payloads sit back to back in blocks of nPerBlock slots, and a map (array
+ * of block pointers) keeps the blocks in list order. Logical index i lives
+ * in slot nFirstSlot + i counted from the first block, so FindIndex is one
+ * division and a map lookup. AddHead/AddTail/RemoveHead/RemoveTail touch one
+ * slot and at most one block; an emptied block is kept as a spare for the
+ * next one needed, so a queue going back and forth over a block boundary
+ * does not call malloc. Unlike LIST_STORAGE_RING, growing never moves a
+ * payload: only the map is copied, and POSITIONs stay valid across adds and
+ * removes at either end.
+ *
+ * Blocks have a power of two size and are allocated aligned to it; a
+ * POSITION is the address of the payload and its block is found by masking
+ * the low bits. The block header holds the block's map slot, rewritten
+ * whenever the map is moved.
+ *
+ * The trade-off is the middle of the list. InsertNext/InsertPrev and
+ * RemoveAt move the elements on the shorter side of the position one slot
+ * over, up to half the list, and invalidate POSITIONs of the moved
+ * elements. Unlike the other storages, RemoveAt may move the elements that
+ * follow the removed one, so a POSITION saved by GetNext before a RemoveAt
+ * can not be used afterwards, its block may even be freed. Removing while
+ * walking goes through ListErase, which hands back the position of the
+ * next element.
+ * --------------------------------------------------------------------------*/
+
+/* blocks span at least 512 bytes and aim at 16 payloads, up to 4 KiB
+ * unless one payload needs more */
+#define LIST_DEQUE_MIN_BLOCK		512
+#define LIST_DEQUE_MAX_BLOCK		4096
+#define LIST_DEQUE_TARGET_ELEMS		16
+
+/* block pointers of a new map */
+#define LIST_DEQUE_MIN_MAP			8
+
+typedef struct ListDequeBlock {
+
+	size_t	nMapIndex;		/* slot in ppMap */
+
+	unsigned char	data[];
+
+} ListDequeBlock;
+
+typedef struct ListDequeStore {
+
+	ListDequeBlock	**ppMap;
+	int		nMapSize;
+	int		nFirstBlock;		/* map slot of the first block in use */
+	int		nBlocks;			/* blocks in use, 0 while the list is empty */
+	int		nFirstSlot;			/* slot of the head element in the first block */
+
+	ListDequeBlock	*pSpare;	/* emptied block kept for reuse */
+
+	size_t	nBlockSize;			/* power of two, block alignment */
+	size_t	nElemSize;			/* slot stride, pointer aligned */
+	int		nPerBlock;
+
+} ListDequeStore;
+
+#define DEQUE_STORE(pThis)		((ListDequeStore *)(pThis)->pStorage)
+#define DEQUE_BLOCK_OF(pStore, pos) \
+	((ListDequeBlock *)((uintptr_t)(pos) & ~(uintptr_t)((pStore)->nBlockSize - 1)))
+#define DEQUE_SLOT(pStore, pBlock, nSlot) \
+	((pBlock)->data + (size_t)(nSlot) * (pStore)->nElemSize)
+#define DEQUE_SLOT_INDEX(pStore, pBlock, pos) \
+	((int)(((unsigned char *)(pos) - (pBlock)->data) / (pStore)->nElemSize))
+#define DEQUE_HEAD(pStore) \
+	DEQUE_SLOT(pStore, (pStore)->ppMap[(pStore)->nFirstBlock], (pStore)->nFirstSlot)
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+/* head, tail access */
+static void* CListDequeGetHead(struct CList *pThis);
+static void* CListDequeGetTail(struct CList *pThis);
+
+/* operation */
+static POSITION CListDequeAddHead(struct CList *pThis, const void* pData);
+static POSITION CListDequeAddTail(struct CList *pThis, const void* pData);
+static int CListDequeRemoveHead(struct CList *pThis);
+static int CListDequeRemoveTail(struct CList *pThis);
+static int CListDequeRemoveAll(struct CList *pThis);
+
+/* for iteration */
+static POSITION CListDequeGetHeadPosition(struct CList *pThis);
+static POSITION CListDequeGetTailPosition(struct CList *pThis);
+static void* CListDequeGetNext(struct CList *pThis, POSITION* position);
+static void* CListDequeGetPrev(struct CList *pThis, POSITION* position);
+static int CListDequeGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+static void* CListDequeGetAt(struct CList *pThis, POSITION position);
+static int CListDequeRemoveAt(struct CList *pThis, POSITION position);
+static int CListDequeErase(struct CList *pThis, POSITION* position);
+static int CListDequeSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion */
+static POSITION CListDequeInsertNext(struct CList *pThis, POSITION position, const void* pData);
+static POSITION CListDequeInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+
+/* Searching */
+static POSITION CListDequeFindIndex(struct CList *pThis, int nIndex);
+
+/* Status */
+static int CListDequeGetCount(struct CList *pThis);
+static int CListDequeIsEmpty(struct CList *pThis);
+
+static void CListDequeDestroy(struct CList *pThis);
+static POSITION CListDequeEmplace(struct CList *pThis, POSITION position, int bAfter);
+
+/* block management */
+static unsigned char* CListDequeAt(ListDequeStore *pStore, int nIndex);
+static unsigned char* CListDequeTail(ListDequeStore *pStore, int nCount);
+static int CListDequeIndexOf(ListDequeStore *pStore, POSITION position);
+static int CListDequeAddBlock(struct CList *pThis, int bBack);
+static void CListDequeDropBlock(struct CList *pThis, int bBack);
+static void CListDequeDropAll(struct CList *pThis);
+static int CListDequeMoveMap(struct CList *pThis);
+
+/*--------------------------------------------------------------------------*/
+
+static const CListOps g_CListDequeOps = {
+
+	/* head/tail access */
+	CListDequeGetHead,
+	CListDequeGetTail,
+
+	/* Operation */
+	CListDequeAddHead,
+	CListDequeAddTail,
+	CListDequeRemoveHead,
+	CListDequeRemoveTail,
+	CListDequeRemoveAll,
+
+	/* for iteration */
+	CListDequeGetHeadPosition,
+	CListDequeGetTailPosition,
+	CListDequeGetNext,
+	CListDequeGetPrev,
+
+	/* Retrieval, modification */
+	CListDequeGetAt,
+	CListDequeRemoveAt,
+	CListDequeSetAt,
+
+	/* Insertion */
+	CListDequeInsertNext,
+	CListDequeInsertPrev,
+
+	/* Search */
+	CListDequeFindIndex,
+
+	/* Status */
+	CListDequeGetCount,
+	CListDequeIsEmpty,
+
+	CListDequeDestroy,
+	CListDequeEmplace,
+	CListDequeGetNextBatch,
+	CListDequeErase
+};
+
+/*-----------------------------------------------------------------------------
+ * Function: CListDequeInit
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer, freshly initialized by InitList
+ *
+ * Return Value:
+ * 	- Return -1 if storage state can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- size the blocks for the payload, allocate the map and bind the deque
+ * 	  operations. The first block is allocated with the first element.
+ *
+ * --------------------------------------------------------------------------*/
+int CListDequeInit(struct CList *pThis) {
+
+	ListDequeStore *pStore;
+	size_t nElemSize = LIST_ALIGN_UP((size_t)pThis->nMaxDataSize, LIST_NODE_ALIGN);
+	size_t nBlockSize = LIST_DEQUE_MIN_BLOCK;
+
+	while (nBlockSize < LIST_DEQUE_MAX_BLOCK &&
+			(nBlockSize - sizeof(ListDequeBlock)) / nElemSize < LIST_DEQUE_TARGET_ELEMS)
+		nBlockSize *= 2;
+
+	while (nBlockSize - sizeof(ListDequeBlock) < nElemSize)
+		nBlockSize *= 2;
+
+	pStore = (ListDequeStore *)calloc(1, sizeof(ListDequeStore));
+
+	if (pStore == NULL)
+		return -1;
+
+	pStore->ppMap = (ListDequeBlock **)malloc(LIST_DEQUE_MIN_MAP * sizeof(ListDequeBlock *));
+
+	if (pStore->ppMap == NULL) {
+		free(pStore);
+		return -1;
+	}
+
+	LIST_STAT_ALLOC(pThis, LIST_DEQUE_MIN_MAP * sizeof(ListDequeBlock *));
+
+	pStore->nMapSize = LIST_DEQUE_MIN_MAP;
+	pStore->nBlockSize = nBlockSize;
+	pStore->nElemSize = nElemSize;
+	pStore->nPerBlock = (int)((nBlockSize - sizeof(ListDequeBlock)) / nElemSize);
+
+	pThis->pStorage = pStore;
+	CListBindOps(pThis, &g_CListDequeOps);
+
+	return 0;
+}
+
+static void* CListDequeGetHead(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return DEQUE_HEAD(DEQUE_STORE(pThis));
+}
+
+static void* CListDequeGetTail(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return CListDequeTail(DEQUE_STORE(pThis), pThis->nCount);
+}
+
+static POSITION CListDequeAddHead(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListDequeEmplace(pThis, NULL, 0);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListDequeAddTail(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListDequeEmplace(pThis, NULL, 1);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static int CListDequeRemoveHead(struct CList *pThis) {
+
+	ListDequeStore *pStore;
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = DEQUE_STORE(pThis);
+
+	pStore->nFirstSlot++;
+	pThis->nCount--;
+
+	if (pThis->nCount == 0) {
+		CListDequeDropAll(pThis);
+	}
+	else if (pStore->nFirstSlot == pStore->nPerBlock) {
+		CListDequeDropBlock(pThis, 0);
+		pStore->nFirstSlot = 0;
+	}
+
+	return 0;
+}
+
+static int CListDequeRemoveTail(struct CList *pThis) {
+
+	ListDequeStore *pStore;
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = DEQUE_STORE(pThis);
+
+	pThis->nCount--;
+
+	if (pThis->nCount == 0)
+		CListDequeDropAll(pThis);
+	else if (pStore->nFirstSlot + pThis->nCount <= (pStore->nBlocks - 1) * pStore->nPerBlock)
+		CListDequeDropBlock(pThis, 1);
+
+	return 0;
+}
+
+static int CListDequeRemoveAll(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	/* the map and one spare block stay for the next elements */
+	CListDequeDropAll(pThis);
+	pThis->nCount = 0;
+
+	return 0;
+}
+
+static POSITION CListDequeGetHeadPosition(struct CList *pThis) {
+
+	return (POSITION)CListDequeGetHead(pThis);
+}
+
+static POSITION CListDequeGetTailPosition(struct CList *pThis) {
+
+	return (POSITION)CListDequeGetTail(pThis);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListDequeGetNext
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position next to current list element
+ *
+ * Return Value:
+ * 	- data pointer next to current element
+ *
+ * Desc:
+ * 	- step one slot, or to the first slot of the next block in the map;
+ * 	  the tail slot ends the walk
+ *
+ * --------------------------------------------------------------------------*/
+static void* CListDequeGetNext(struct CList *pThis, POSITION* position) {
+
+	ListDequeStore *pStore;
+	ListDequeBlock *pBlock;
+	unsigned char *pSlot;
+	unsigned char *pNext;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = DEQUE_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+
+	if (pSlot == CListDequeTail(pStore, pThis->nCount)) {
+		*position = NULL;
+	}
+	else {
+		pBlock = DEQUE_BLOCK_OF(pStore, pSlot);
+		pNext = pSlot + pStore->nElemSize;
+		if (pNext == DEQUE_SLOT(pStore, pBlock, pStore->nPerBlock))
+			pNext = pStore->ppMap[pBlock->nMapIndex + 1]->data;
+		*position = (POSITION)pNext;
+	}
+
+	return pSlot;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListDequeGetNextBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position of the first element wanted, advanced past the
+ * 	  last one handed out (NULL at the end)
+ * 	- ppData : receives the payload pointers
+ * 	- nMax : size of ppData
+ *
+ * Return Value:
+ * 	- number of payload pointers stored, 0 at the end of the list, -1 if
+ * 	  arguments are invalid
+ *
+ * Desc:
+ * 	- the slots of a block follow each other and are streamed by the
+ * 	  hardware prefetcher; the jump to the next block is not, so the start
+ * 	  of the block after the current one is hinted.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListDequeGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	ListDequeStore *pStore;
+	ListDequeBlock *pBlock;
+	unsigned char *pSlot;
+	unsigned char *pEnd;
+	size_t nLastBlock;
+	int nIndex;
+	int nGot;
+
+	if (pThis == NULL || position == NULL || ppData == NULL || nMax < 0)
+		return -1;
+
+	if (*position == NULL)
+		return 0;
+
+	pStore = DEQUE_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+	pBlock = DEQUE_BLOCK_OF(pStore, pSlot);
+	pEnd = DEQUE_SLOT(pStore, pBlock, pStore->nPerBlock);
+	nLastBlock = (size_t)(pStore->nFirstBlock + pStore->nBlocks - 1);
+	nIndex = CListDequeIndexOf(pStore, *position);
+
+	if (nMax > pThis->nCount - nIndex)
+		nMax = pThis->nCount - nIndex;
+
+	if (pBlock->nMapIndex < nLastBlock)
+		LIST_PREFETCH(pStore->ppMap[pBlock->nMapIndex + 1]->data);
+
+	for (nGot = 0; nGot < nMax; nGot++) {
+
+		if (pSlot == pEnd) {
+			pBlock = pStore->ppMap[pBlock->nMapIndex + 1];
+			pSlot = pBlock->data;
+			pEnd = DEQUE_SLOT(pStore, pBlock, pStore->nPerBlock);
+			if (pBlock->nMapIndex < nLastBlock)
+				LIST_PREFETCH(pStore->ppMap[pBlock->nMapIndex + 1]->data);
+		}
+
+		ppData[nGot] = pSlot;
+		pSlot += pStore->nElemSize;
+	}
+
+	if (nIndex + nGot == pThis->nCount)
+		*position = NULL;
+	else if (pSlot == pEnd)
+		*position = (POSITION)pStore->ppMap[pBlock->nMapIndex + 1]->data;
+	else
+		*position = (POSITION)pSlot;
+
+	return nGot;
+}
+
+static void* CListDequeGetPrev(struct CList *pThis, POSITION* position) {
+
+	ListDequeStore *pStore;
+	ListDequeBlock *pBlock;
+	unsigned char *pSlot;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = DEQUE_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+	pBlock = DEQUE_BLOCK_OF(pStore, pSlot);
+
+	if (pSlot == DEQUE_HEAD(pStore))
+		*position = NULL;
+	else if (pSlot == pBlock->data)
+		*position = (POSITION)DEQUE_SLOT(pStore, pStore->ppMap[pBlock->nMapIndex - 1],
+				pStore->nPerBlock - 1);
+	else
+		*position = (POSITION)(pSlot - pStore->nElemSize);
+
+	return pSlot;
+}
+
+static void* CListDequeGetAt(struct CList *pThis, POSITION position) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return (void *)position;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListDequeRemoveAt
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position want to remove.
+ *
+ * Return Value:
+ *  - Return -1 if pThis is NULL.
+ *
+ * Desc:
+ * 	- close the gap from the shorter side, like std::deque::erase: the
+ * 	  elements in front of position move back one slot and the head slot
+ * 	  is dropped, or the elements after it move forward and the tail slot
+ * 	  is dropped. POSITIONs of the moved side are invalidated, those of
+ * 	  the other side stay valid.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListDequeRemoveAt(struct CList *pThis, POSITION position) {
+
+	ListDequeStore *pStore;
+	int nIndex;
+	int i;
+
+	if (pThis == NULL || position == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = DEQUE_STORE(pThis);
+	nIndex = CListDequeIndexOf(pStore, position);
+
+	if (nIndex < pThis->nCount - 1 - nIndex) {
+		for (i = nIndex; i > 0; i--)
+			memcpy(CListDequeAt(pStore, i), CListDequeAt(pStore, i - 1), pStore->nElemSize);
+		return CListDequeRemoveHead(pThis);
+	}
+
+	for (i = nIndex; i < pThis->nCount - 1; i++)
+		memcpy(CListDequeAt(pStore, i), CListDequeAt(pStore, i + 1), pStore->nElemSize);
+
+	return CListDequeRemoveTail(pThis);
+}
+
+/* RemoveAt, then *position is the element that followed: whichever side
+ * moved, it now has the removed element's index */
+static int CListDequeErase(struct CList *pThis, POSITION* position) {
+
+	int nIndex;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return -1;
+
+	nIndex = CListDequeIndexOf(DEQUE_STORE(pThis), *position);
+
+	if (CListDequeRemoveAt(pThis, *position) != 0)
+		return -1;
+
+	*position = (nIndex < pThis->nCount) ?
+			(POSITION)CListDequeAt(DEQUE_STORE(pThis), nIndex) : NULL;
+
+	return 0;
+}
+
+static int CListDequeSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return -1;
+
+	memcpy(position, pData, (size_t)pThis->nMaxDataSize);
+
+	return 0;
+}
+
+static POSITION CListDequeInsertNext(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListDequeEmplace(pThis, position, 1);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListDequeInsertPrev(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListDequeEmplace(pThis, position, 0);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListDequeFindIndex(struct CList *pThis, int nIndex) {
+
+	if (pThis == NULL || nIndex < 0 || nIndex >= pThis->nCount)
+		return NULL;
+
+	return (POSITION)CListDequeAt(DEQUE_STORE(pThis), nIndex);
+}
+
+static int CListDequeGetCount(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return pThis->nCount;
+}
+
+static int CListDequeIsEmpty(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return (pThis->nCount != 0) ? 1 : 0;
+}
+
+static void CListDequeDestroy(struct CList *pThis) {
+
+	ListDequeStore *pStore = DEQUE_STORE(pThis);
+
+	if (pStore != NULL) {
+
+		CListDequeDropAll(pThis);
+
+		if (pStore->pSpare != NULL) {
+			LIST_STAT_FREE(pThis, pStore->nBlockSize);
+			free(pStore->pSpare);
+		}
+
+		LIST_STAT_FREE(pThis, (size_t)pStore->nMapSize * sizeof(ListDequeBlock *));
+		free(pStore->ppMap);
+	}
+
+	free(pStore);
+	pThis->pStorage = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListDequeEmplace
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to insert next to, NULL for head or tail
+ * 	- bAfter : insert after position (or at tail), else before (or at head)
+ *
+ * Return Value:
+ * 	- position of the new, uninitialized element
+ *
+ * Desc:
+ * 	- open a slot at the end nearer to the insert point, adding a block if
+ * 	  that end's block is full, then move the elements between the two one
+ * 	  slot over. At head or tail nothing moves.
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListDequeEmplace(struct CList *pThis, POSITION position, int bAfter) {
+
+	ListDequeStore *pStore = DEQUE_STORE(pThis);
+	int nCount = pThis->nCount;
+	int nIndex;
+	int i;
+
+	if (position != NULL)
+		nIndex = CListDequeIndexOf(pStore, position) + (bAfter ? 1 : 0);
+	else
+		nIndex = bAfter ? nCount : 0;
+
+	if (nIndex < nCount - nIndex) {
+
+		if (pStore->nFirstSlot == 0 && CListDequeAddBlock(pThis, 0) != 0) {
+			LIST_STAT_FAIL(pThis);
+			return NULL;
+		}
+
+		/* the new head slot takes the old index 0 */
+		pStore->nFirstSlot--;
+		for (i = 0; i < nIndex; i++)
+			memcpy(CListDequeAt(pStore, i), CListDequeAt(pStore, i + 1), pStore->nElemSize);
+	}
+	else {
+
+		/* an empty list gets its first block here */
+		if (pStore->nFirstSlot + nCount == pStore->nBlocks * pStore->nPerBlock &&
+				CListDequeAddBlock(pThis, 1) != 0) {
+			LIST_STAT_FAIL(pThis);
+			return NULL;
+		}
+
+		for (i = nCount; i > nIndex; i--)
+			memcpy(CListDequeAt(pStore, i), CListDequeAt(pStore, i - 1), pStore->nElemSize);
+	}
+
+	pThis->nCount++;
+	LIST_STAT_COUNT(pThis);
+
+	return (POSITION)CListDequeAt(pStore, nIndex);
+}
+
+/* slot of logical index nIndex, which may be one past the tail */
+static unsigned char* CListDequeAt(ListDequeStore *pStore, int nIndex) {
+
+	int nSlot = pStore->nFirstSlot + nIndex;
+
+	return DEQUE_SLOT(pStore, pStore->ppMap[pStore->nFirstBlock + nSlot / pStore->nPerBlock],
+			nSlot % pStore->nPerBlock);
+}
+
+/* slot of the last of nCount elements, without dividing */
+static unsigned char* CListDequeTail(ListDequeStore *pStore, int nCount) {
+
+	int nLastBlock = pStore->nBlocks - 1;
+
+	return DEQUE_SLOT(pStore, pStore->ppMap[pStore->nFirstBlock + nLastBlock],
+			pStore->nFirstSlot + nCount - 1 - nLastBlock * pStore->nPerBlock);
+}
+
+/* logical index of the element in slot position */
+static int CListDequeIndexOf(ListDequeStore *pStore, POSITION position) {
+
+	ListDequeBlock *pBlock = DEQUE_BLOCK_OF(pStore, position);
+
+	return ((int)pBlock->nMapIndex - pStore->nFirstBlock) * pStore->nPerBlock +
+		DEQUE_SLOT_INDEX(pStore, pBlock, position) - pStore->nFirstSlot;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListDequeAddBlock
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- bBack : add after the last block, else in front of the first
+ *
+ * Return Value:
+ * 	- Return -1 if the block or a bigger map can not be allocated, else
+ * 	  returns 0
+ *
+ * Desc:
+ * 	- take the spare block or allocate one, and put it into the map,
+ * 	  moving the map first if that end is full. A block in front shifts
+ * 	  nFirstSlot by a block. The first block of an empty list goes to the
+ * 	  middle of the map, its head slot to the middle of the block, so
+ * 	  either end can grow first.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListDequeAddBlock(struct CList *pThis, int bBack) {
+
+	ListDequeStore *pStore = DEQUE_STORE(pThis);
+	ListDequeBlock *pBlock;
+	int nMapIndex;
+
+	if (pStore->nBlocks > 0 &&
+			(bBack ? pStore->nFirstBlock + pStore->nBlocks == pStore->nMapSize :
+			 pStore->nFirstBlock == 0) &&
+			CListDequeMoveMap(pThis) != 0)
+		return -1;
+
+	if (pStore->pSpare != NULL) {
+		pBlock = pStore->pSpare;
+		pStore->pSpare = NULL;
+	}
+	else {
+		pBlock = (ListDequeBlock *)aligned_alloc(pStore->nBlockSize, pStore->nBlockSize);
+
+		if (pBlock == NULL)
+			return -1;
+
+		LIST_STAT_ALLOC(pThis, pStore->nBlockSize);
+	}
+
+	if (pStore->nBlocks == 0) {
+		pStore->nFirstBlock = pStore->nMapSize / 2;
+		pStore->nFirstSlot = pStore->nPerBlock / 2;
+		nMapIndex = pStore->nFirstBlock;
+	}
+	else if (bBack) {
+		nMapIndex = pStore->nFirstBlock + pStore->nBlocks;
+	}
+	else {
+		nMapIndex = --pStore->nFirstBlock;
+		pStore->nFirstSlot += pStore->nPerBlock;
+	}
+
+	pBlock->nMapIndex = (size_t)nMapIndex;
+	pStore->ppMap[nMapIndex] = pBlock;
+	pStore->nBlocks++;
+
+	return 0;
+}
+
+/* take the first or last block out of the map, keep it as the spare or
+ * free it */
+static void CListDequeDropBlock(struct CList *pThis, int bBack) {
+
+	ListDequeStore *pStore = DEQUE_STORE(pThis);
+	ListDequeBlock *pBlock;
+
+	if (bBack) {
+		pBlock = pStore->ppMap[pStore->nFirstBlock + pStore->nBlocks - 1];
+	}
+	else {
+		pBlock = pStore->ppMap[pStore->nFirstBlock];
+		pStore->nFirstBlock++;
+	}
+
+	pStore->nBlocks--;
+
+	if (pStore->pSpare == NULL) {
+		pStore->pSpare = pBlock;
+	}
+	else {
+		LIST_STAT_FREE(pThis, pStore->nBlockSize);
+		free(pBlock);
+	}
+}
+
+/* drop every block in use, leaving the store as after CListDequeInit */
+static void CListDequeDropAll(struct CList *pThis) {
+
+	ListDequeStore *pStore = DEQUE_STORE(pThis);
+
+	while (pStore->nBlocks > 0)
+		CListDequeDropBlock(pThis, 1);
+
+	pStore->nFirstSlot = 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListDequeMoveMap
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ * 	- Return -1 if a bigger map can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- one end of the map is full. Center the blocks in use so both ends
+ * 	  have room for another one, in place if the map is at most half used,
+ * 	  else in a map twice the size. The blocks themselves do not move, only
+ * 	  their map slots are rewritten.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListDequeMoveMap(struct CList *pThis) {
+
+	ListDequeStore *pStore = DEQUE_STORE(pThis);
+	ListDequeBlock **ppMap = pStore->ppMap;
+	int nMapSize = pStore->nMapSize;
+	int nFirstBlock;
+	int i;
+
+	if (pStore->nBlocks + 1 > nMapSize / 2) {
+
+		if (nMapSize > INT_MAX / 2)
+			return -1;
+
+		nMapSize *= 2;
+		ppMap = (ListDequeBlock **)malloc((size_t)nMapSize * sizeof(ListDequeBlock *));
+
+		if (ppMap == NULL)
+			return -1;
+
+		LIST_STAT_ALLOC(pThis, (size_t)nMapSize * sizeof(ListDequeBlock *));
+	}
+
+	nFirstBlock = (nMapSize - pStore->nBlocks) / 2;
+
+	memmove(ppMap + nFirstBlock, pStore->ppMap + pStore->nFirstBlock,
+			(size_t)pStore->nBlocks * sizeof(ListDequeBlock *));
+
+	if (ppMap != pStore->ppMap) {
+		LIST_STAT_FREE(pThis, (size_t)pStore->nMapSize * sizeof(ListDequeBlock *));
+		free(pStore->ppMap);
+		pStore->ppMap = ppMap;
+		pStore->nMapSize = nMapSize;
+	}
+
+	pStore->nFirstBlock = nFirstBlock;
+
+	for (i = 0; i < pStore->nBlocks; i++)
+		ppMap[nFirstBlock + i]->nMapIndex = (size_t)(nFirstBlock + i);
+
+	return 0;
+}
@@ -0,0 +1,300 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+static size_t CListHashBytes(const void *pKey, size_t nKeyLen);
+static const void* CListHashKey(struct CList *pThis, ListElem *pListElem);
+static void CListHashGrow(struct CList *pThis);
+static void CListHashPush(struct CList *pThis, ListElem **ppBucket, ListElem *pListElem);
+
+/*--------------------------------------------------------------------------*/
+
+#define HASH(pThis, pListElem)		LIST_HASH_NODE(pThis, pListElem)
+#define BUCKET(pHash, nHash)		((pHash)->ppBuckets[(nHash) & ((pHash)->nBuckets - 1)])
+
+/*-----------------------------------------------------------------------------
+ * Function: CListHashCreate
+ *
+ * Parameter:
+ * 	- nKeyOffset : offset of the key in every payload
+ * 	- nKeyLen : key size in bytes
+ * 	- pfnHash : hash function, NULL for CListHashBytes
+ *
+ * Return Value:
+ * 	- empty index, NULL if allocation fails
+ *
+ * Desc:
+ * 	- allocate key hash index for an empty list
+ *
+ * --------------------------------------------------------------------------*/
+struct ListHashIndex* CListHashCreate(size_t nKeyOffset, size_t nKeyLen,
+		CListHashFn pfnHash) {
+
+	struct ListHashIndex *pHash;
+
+	pHash = (struct ListHashIndex *)calloc(1, sizeof(struct ListHashIndex));
+
+	if (pHash == NULL)
+		return NULL;
+
+	pHash->ppBuckets = (ListElem **)calloc(LIST_HASH_MIN_BUCKETS, sizeof(ListElem *));
+
+	if (pHash->ppBuckets == NULL) {
+		free(pHash);
+		return NULL;
+	}
+
+	pHash->nBuckets = LIST_HASH_MIN_BUCKETS;
+	pHash->nKeyOffset = nKeyOffset;
+	pHash->nKeyLen = nKeyLen;
+	pHash->pfnHash = (pfnHash != NULL) ? pfnHash : CListHashBytes;
+
+	return pHash;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashDestroy
+ *
+ * Parameter:
+ * 	- pHash : key hash index, may be NULL
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- release the index; the nodes it chained are not touched
+ *
+ * --------------------------------------------------------------------------*/
+void CListHashDestroy(struct ListHashIndex *pHash) {
+
+	if (pHash == NULL)
+		return;
+
+	free(pHash->ppBuckets);
+	free(pHash);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashInsert
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : element just linked into the list, payload written
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- hash the element's key and push it on its bucket's chain
+ *
+ * --------------------------------------------------------------------------*/
+void CListHashInsert(struct CList *pThis, ListElem *pListElem) {
+
+	struct ListHashIndex *pHash = pThis->pHash;
+	ListHashNode *pNode = HASH(pThis, pListElem);
+
+	if (pHash->nItems >= pHash->nBuckets)
+		CListHashGrow(pThis);
+
+	pNode->nHash = pHash->pfnHash(CListHashKey(pThis, pListElem), pHash->nKeyLen);
+	CListHashPush(pThis, &BUCKET(pHash, pNode->nHash), pListElem);
+
+	pHash->nItems++;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashRemove
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : element in the index
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- unchain the element in O(1), also among many equal keys. The key is
+ * 	  not read again.
+ *
+ * --------------------------------------------------------------------------*/
+void CListHashRemove(struct CList *pThis, ListElem *pListElem) {
+
+	ListHashNode *pNode = HASH(pThis, pListElem);
+
+	*pNode->ppLink = pNode->pNext;
+
+	if (pNode->pNext != NULL)
+		HASH(pThis, pNode->pNext)->ppLink = pNode->ppLink;
+
+	pThis->pHash->nItems--;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashClear
+ *
+ * Parameter:
+ * 	- pHash : key hash index
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- forget every element at once, for RemoveAll. The buckets keep their
+ * 	  size for the next fill.
+ *
+ * --------------------------------------------------------------------------*/
+void CListHashClear(struct ListHashIndex *pHash) {
+
+	memset(pHash->ppBuckets, 0, pHash->nBuckets * sizeof(ListElem *));
+	pHash->nItems = 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashFind
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pKey : nKeyLen bytes to look up
+ *
+ * Return Value:
+ * 	- an element whose key equals pKey, NULL if there is none
+ *
+ * Desc:
+ * 	- walk the key's bucket, comparing stored hashes before keys
+ *
+ * --------------------------------------------------------------------------*/
+ListElem* CListHashFind(struct CList *pThis, const void* pKey) {
+
+	struct ListHashIndex *pHash = pThis->pHash;
+	ListElem *pListElem;
+	size_t nHash;
+
+	nHash = pHash->pfnHash(pKey, pHash->nKeyLen);
+
+	for (pListElem = BUCKET(pHash, nHash); pListElem != NULL;
+			pListElem = HASH(pThis, pListElem)->pNext) {
+
+		if (HASH(pThis, pListElem)->nHash == nHash &&
+				memcmp(CListHashKey(pThis, pListElem), pKey, pHash->nKeyLen) == 0)
+			return pListElem;
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashBytes
+ *
+ * Parameter:
+ * 	- pKey : key bytes
+ * 	- nKeyLen : key size in bytes
+ *
+ * Return Value:
+ * 	- hash value
+ *
+ * Desc:
+ * 	- default hash: FNV-1a, with a final mix so the low bits used as the
+ * 	  bucket number depend on every byte
+ *
+ * --------------------------------------------------------------------------*/
+static size_t CListHashBytes(const void *pKey, size_t nKeyLen) {
+
+	const unsigned char *pByte = (const unsigned char *)pKey;
+	unsigned long long nHash = 14695981039346656037ULL;
+	size_t i;
+
+	for (i = 0; i < nKeyLen; i++) {
+		nHash ^= pByte[i];
+		nHash *= 1099511628211ULL;
+	}
+
+	nHash ^= nHash >> 32;
+
+	return (size_t)nHash;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashKey
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pListElem : list element
+ *
+ * Return Value:
+ * 	- address of the element's key
+ *
+ * Desc:
+ * 	- by-reference lists keep the key in the object they point at
+ *
+ * --------------------------------------------------------------------------*/
+static const void* CListHashKey(struct CList *pThis, ListElem *pListElem) {
+
+	const unsigned char *pData = pListElem->data;
+
+	if (pThis->pOps == &g_CListRefOps)
+		pData = *(const unsigned char **)pData;
+
+	return pData + pThis->pHash->nKeyOffset;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashGrow
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- double the bucket array and redistribute the chains by their stored
+ * 	  hashes. Left as it is if the new array can not be allocated.
+ *
+ * --------------------------------------------------------------------------*/
+static void CListHashGrow(struct CList *pThis) {
+
+	struct ListHashIndex *pHash = pThis->pHash;
+	ListElem	**ppOld = pHash->ppBuckets;
+	ListElem	*pListElem;
+	ListElem	*pNext;
+	size_t		nOld = pHash->nBuckets;
+	size_t		i;
+
+	pHash->ppBuckets = (ListElem **)calloc(nOld * 2, sizeof(ListElem *));
+
+	if (pHash->ppBuckets == NULL) {
+		pHash->ppBuckets = ppOld;
+		return;
+	}
+
+	LIST_STAT_ALLOC(pThis, nOld * 2 * sizeof(ListElem *));
+
+	pHash->nBuckets = nOld * 2;
+
+	for (i = 0; i < nOld; i++) {
+		for (pListElem = ppOld[i]; pListElem != NULL; pListElem = pNext) {
+			pNext = HASH(pThis, pListElem)->pNext;
+			CListHashPush(pThis, &BUCKET(pHash, HASH(pThis, pListElem)->nHash), pListElem);
+		}
+	}
+
+	LIST_STAT_FREE(pThis, nOld * sizeof(ListElem *));
+	free(ppOld);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListHashPush
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- ppBucket : bucket slot
+ * 	- pListElem : element to put in front of the bucket's chain
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- link element at the chain head, keeping the back links in step
+ *
+ * --------------------------------------------------------------------------*/
+static void CListHashPush(struct CList *pThis, ListElem **ppBucket, ListElem *pListElem) {
+
+	ListHashNode *pNode = HASH(pThis, pListElem);
+
+	pNode->pNext = *ppBucket;
+	pNode->ppLink = ppBucket;
+
+	if (*ppBucket != NULL)
+		HASH(pThis, *ppBucket)->ppLink = &pNode->pNext;
+
+	*ppBucket = pListElem;
+}
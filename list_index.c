@@ -0,0 +1,303 @@
+#include <stdlib.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+static unsigned int CListIndexRandom(struct ListRankIndex *pIndex);
+static void CListIndexRotateUp(struct ListRankIndex *pIndex, ListElem *pListElem);
+
+/*--------------------------------------------------------------------------*/
+
+#define RANK(pListElem)			LIST_RANK_NODE(pListElem)
+#define RANK_SIZE(pListElem)	((pListElem) != NULL ? RANK(pListElem)->nSize : 0)
+
+/*-----------------------------------------------------------------------------
+ * Function: CListIndexCreate
+ *
+ * Parameter:
+ *
+ * Return Value:
+ * 	- empty index, NULL if allocation fails
+ *
+ * Desc:
+ * 	- allocate order statistic index for an empty list
+ *
+ * --------------------------------------------------------------------------*/
+struct ListRankIndex* CListIndexCreate(void) {
+
+	struct ListRankIndex *pIndex;
+
+	pIndex = (struct ListRankIndex *)calloc(1, sizeof(struct ListRankIndex));
+
+	if (pIndex == NULL)
+		return NULL;
+
+	pIndex->nSeed = 0x9e3779b9u;
+
+	return pIndex;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIndexInsert
+ *
+ * Parameter:
+ * 	- pIndex : order statistic index
+ * 	- pListElem : element just linked into the list
+ * 	- pPrev, pNext : its list neighbours, NULL at head/tail
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- add element to the tree at its list position. In order, pNext is the
+ * 	  successor of pPrev, so the new node becomes either the right child of
+ * 	  pPrev or the left child of pNext, whichever slot is free. It is then
+ * 	  rotated up to restore the heap order of priorities.
+ *
+ * --------------------------------------------------------------------------*/
+void CListIndexInsert(struct ListRankIndex *pIndex, ListElem *pListElem,
+		ListElem *pPrev, ListElem *pNext) {
+
+	ListRankNode	*pRank = RANK(pListElem);
+	ListElem		*pParent;
+
+	pRank->pLeft = NULL;
+	pRank->pRight = NULL;
+	pRank->nSize = 1;
+	pRank->nPriority = CListIndexRandom(pIndex);
+
+	if (pIndex->pRoot == NULL) {
+		pRank->pParent = NULL;
+		pIndex->pRoot = pListElem;
+		return;
+	}
+
+	if (pPrev != NULL && RANK(pPrev)->pRight == NULL) {
+		RANK(pPrev)->pRight = pListElem;
+		pParent = pPrev;
+	}
+	else {
+		RANK(pNext)->pLeft = pListElem;
+		pParent = pNext;
+	}
+
+	pRank->pParent = pParent;
+
+	for (; pParent != NULL; pParent = RANK(pParent)->pParent)
+		RANK(pParent)->nSize++;
+
+	while (pRank->pParent != NULL &&
+			pRank->nPriority < RANK(pRank->pParent)->nPriority)
+		CListIndexRotateUp(pIndex, pListElem);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIndexRemove
+ *
+ * Parameter:
+ * 	- pIndex : order statistic index
+ * 	- pListElem : element about to be unlinked from the list
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- rotate element down until it has at most one child, then splice it
+ * 	  out and shrink the subtree sizes above it
+ *
+ * --------------------------------------------------------------------------*/
+void CListIndexRemove(struct ListRankIndex *pIndex, ListElem *pListElem) {
+
+	ListRankNode	*pRank = RANK(pListElem);
+	ListElem		*pChild;
+	ListElem		*pParent;
+
+	while (pRank->pLeft != NULL && pRank->pRight != NULL) {
+		if (RANK(pRank->pLeft)->nPriority < RANK(pRank->pRight)->nPriority)
+			CListIndexRotateUp(pIndex, pRank->pLeft);
+		else
+			CListIndexRotateUp(pIndex, pRank->pRight);
+	}
+
+	pChild = (pRank->pLeft != NULL) ? pRank->pLeft : pRank->pRight;
+	pParent = pRank->pParent;
+
+	if (pChild != NULL)
+		RANK(pChild)->pParent = pParent;
+
+	if (pParent == NULL)
+		pIndex->pRoot = pChild;
+	else if (RANK(pParent)->pLeft == pListElem)
+		RANK(pParent)->pLeft = pChild;
+	else
+		RANK(pParent)->pRight = pChild;
+
+	for (; pParent != NULL; pParent = RANK(pParent)->pParent)
+		RANK(pParent)->nSize--;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIndexFind
+ *
+ * Parameter:
+ * 	- pIndex : order statistic index
+ * 	- nIndex : zero based list index, must be in range
+ *
+ * Return Value:
+ * 	- element at nIndex
+ *
+ * Desc:
+ * 	- descend from the root using subtree sizes
+ *
+ * --------------------------------------------------------------------------*/
+ListElem* CListIndexFind(struct ListRankIndex *pIndex, int nIndex) {
+
+	ListElem		*pListElem = pIndex->pRoot;
+	unsigned int	nRemain = (unsigned int)nIndex;
+	unsigned int	nLeft;
+
+	while (pListElem != NULL) {
+
+		nLeft = RANK_SIZE(RANK(pListElem)->pLeft);
+
+		if (nRemain < nLeft) {
+			pListElem = RANK(pListElem)->pLeft;
+		}
+		else if (nRemain == nLeft) {
+			break;
+		}
+		else {
+			nRemain -= nLeft + 1;
+			pListElem = RANK(pListElem)->pRight;
+		}
+	}
+
+	return pListElem;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIndexBuild
+ *
+ * Parameter:
+ * 	- pIndex : order statistic index
+ * 	- pHead : first element of the list, whose elements were reordered
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- rebuild the tree for the current list order in O(n). Each node keeps
+ * 	  its priority; the elements are added in list order along the right
+ * 	  spine, which is walked with the parent links instead of a stack. A
+ * 	  node leaves the spine only once its subtree is complete, so its size
+ * 	  is summed then.
+ *
+ * --------------------------------------------------------------------------*/
+void CListIndexBuild(struct ListRankIndex *pIndex, ListElem *pHead) {
+
+	ListElem	*pListElem;
+	ListElem	*pLast = NULL;
+	ListElem	*pTop;
+	ListElem	*pChild;
+	ListRankNode	*pRank;
+
+	pIndex->pRoot = NULL;
+
+	for (pListElem = pHead; pListElem != NULL; pListElem = pListElem->next) {
+
+		pRank = RANK(pListElem);
+		pChild = NULL;
+
+		for (pTop = pLast; pTop != NULL && RANK(pTop)->nPriority > pRank->nPriority;
+				pTop = RANK(pTop)->pParent) {
+			RANK(pTop)->nSize = 1 + RANK_SIZE(RANK(pTop)->pLeft) +
+					RANK_SIZE(RANK(pTop)->pRight);
+			pChild = pTop;
+		}
+
+		pRank->pLeft = pChild;
+		pRank->pRight = NULL;
+		pRank->pParent = pTop;
+
+		if (pChild != NULL)
+			RANK(pChild)->pParent = pListElem;
+
+		if (pTop != NULL)
+			RANK(pTop)->pRight = pListElem;
+		else
+			pIndex->pRoot = pListElem;
+
+		pLast = pListElem;
+	}
+
+	for (pTop = pLast; pTop != NULL; pTop = RANK(pTop)->pParent)
+		RANK(pTop)->nSize = 1 + RANK_SIZE(RANK(pTop)->pLeft) + RANK_SIZE(RANK(pTop)->pRight);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIndexRotateUp
+ *
+ * Parameter:
+ * 	- pIndex : order statistic index
+ * 	- pListElem : node to move above its parent
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- single rotation keeping in-order (list) order and subtree sizes
+ *
+ * --------------------------------------------------------------------------*/
+static void CListIndexRotateUp(struct ListRankIndex *pIndex, ListElem *pListElem) {
+
+	ListRankNode	*pRank = RANK(pListElem);
+	ListElem		*pParent = pRank->pParent;
+	ListRankNode	*pParentRank = RANK(pParent);
+	ListElem		*pGrand = pParentRank->pParent;
+	ListElem		*pMoved;
+
+	if (pParentRank->pLeft == pListElem) {
+		pMoved = pRank->pRight;
+		pParentRank->pLeft = pMoved;
+		pRank->pRight = pParent;
+	}
+	else {
+		pMoved = pRank->pLeft;
+		pParentRank->pRight = pMoved;
+		pRank->pLeft = pParent;
+	}
+
+	if (pMoved != NULL)
+		RANK(pMoved)->pParent = pParent;
+
+	pParentRank->pParent = pListElem;
+	pRank->pParent = pGrand;
+
+	if (pGrand == NULL)
+		pIndex->pRoot = pListElem;
+	else if (RANK(pGrand)->pLeft == pParent)
+		RANK(pGrand)->pLeft = pListElem;
+	else
+		RANK(pGrand)->pRight = pListElem;
+
+	pRank->nSize = pParentRank->nSize;
+	pParentRank->nSize = 1 + RANK_SIZE(pParentRank->pLeft) +
+		RANK_SIZE(pParentRank->pRight);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIndexRandom
+ *
+ * Parameter:
+ * 	- pIndex : order statistic index
+ *
+ * Return Value:
+ * 	- next treap priority
+ *
+ * Desc:
+ * 	- xorshift32, deterministic per index
+ *
+ * --------------------------------------------------------------------------*/
+static unsigned int CListIndexRandom(struct ListRankIndex *pIndex) {
+
+	unsigned int x = pIndex->nSeed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	pIndex->nSeed = x;
+
+	return x;
+}
@@ -0,0 +1,282 @@
+/******************************************************************************
+    Internal declarations shared by the list implementation files.
+    Not part of the public interface, do not include from user code.
+******************************************************************************/
+
+#ifndef LIST_INTERNAL_H
+#define LIST_INTERNAL_H
+
+#include <stdint.h>
+
+#include "list.h"
+#include "list_alloc.h"
+
+/*-----------------------------------------------------------------------------
+ * storage setup
+ * --------------------------------------------------------------------------*/
+/* point list at its operation table (list.c) */
+void CListBindOps(struct CList *pThis, const CListOps *pOps);
+
+/* switch a freshly initialized list to LIST_STORAGE_CHUNK (list_chunk.c) */
+int CListChunkInit(struct CList *pThis);
+
+/* switch a freshly initialized list to LIST_STORAGE_RING (list_ring.c) */
+int CListRingInit(struct CList *pThis, int nCapacity);
+
+/* switch a freshly initialized list to LIST_STORAGE_COMPACT (list_compact.c) */
+int CListCompactInit(struct CList *pThis, int nCapacity);
+
+/* switch a freshly initialized list to LIST_STORAGE_DEQUE (list_deque.c) */
+int CListDequeInit(struct CList *pThis);
+
+/* node lists holding caller pointers (InitListByRef, list_ref.c) share the
+ * node layout and the node teardown */
+extern const CListOps g_CListRefOps;
+void CListDestroyNodes(struct CList *pThis);
+
+#define LIST_IS_NODE_LINKED(pThis) \
+	((pThis)->pOps == &g_CListNodeOps || (pThis)->pOps == &g_CListRefOps)
+
+/* variable-length lists (InitListSized, list_sized.c) chain nodes like node
+ * lists, but a payload may be shorter than nMaxDataSize: nothing may copy
+ * or compare nMaxDataSize bytes of it */
+extern const CListOps g_CListSizedOps;
+long long CListSizedPayloadBytes(struct CList *pThis);
+
+#define LIST_IS_SIZED(pThis)		((pThis)->pOps == &g_CListSizedOps)
+
+/* snapshot views (InitListMapped, list_snapshot.c) refuse every change; bulk
+ * calls check for them up front, a refused remove in the middle of a copy
+ * would leave the element in both lists */
+extern const CListOps g_CListMappedOps;
+
+#define LIST_IS_READ_ONLY(pThis)	((pThis)->pOps == &g_CListMappedOps)
+
+/* link a node between two others, or unlink it, keeping nCount, the
+ * FindIndex cursor and the indexes in step (list.c) */
+void CListLinkElem(struct CList *pThis, ListElem *pListElem,
+		ListElem *pPrev, ListElem *pNext);
+void CListUnlinkElem(struct CList *pThis, ListElem *pListElem);
+
+/* nodes of one list may be freed by the other: no pool of their own (or the
+ * same list) and the same InitListWithAllocator allocator */
+#define LIST_SAME_ALLOCATOR(pA, pB) \
+	((pA)->pPool == (pB)->pPool && (pA)->pfnAlloc == (pB)->pfnAlloc && \
+	 (pA)->pfnFree == (pB)->pfnFree && (pA)->pAllocContext == (pB)->pAllocContext)
+
+/*-----------------------------------------------------------------------------
+ * statistics (CLIST_STATS, list_stats.c)
+ *
+ * Storage code reports through these hooks, which compile to nothing
+ * without CLIST_STATS. ALLOC and FREE take the bytes handed out or given
+ * back, FREE_BLOCKS nBlocks of them given back at once (an arena reset),
+ * MOVE and SWAP follow storage that changes lists by relinking.
+ * --------------------------------------------------------------------------*/
+#ifdef CLIST_STATS
+
+void CListStatAlloc(struct CList *pThis, size_t nBytes);
+void CListStatFree(struct CList *pThis, size_t nBytes);
+void CListStatFreeBlocks(struct CList *pThis, int nBlocks, size_t nBytes);
+void CListStatFail(struct CList *pThis);
+void CListStatPeak(struct CList *pThis);
+void CListStatSteps(struct CList *pThis, int nSteps);
+void CListStatSwap(struct CList *pDst, struct CList *pSrc);
+
+#define LIST_STAT_ALLOC(pThis, nBytes)	CListStatAlloc(pThis, nBytes)
+#define LIST_STAT_FREE(pThis, nBytes)	CListStatFree(pThis, nBytes)
+#define LIST_STAT_FREE_BLOCKS(pThis, nBlocks, nBytes) \
+	CListStatFreeBlocks(pThis, nBlocks, nBytes)
+#define LIST_STAT_FAIL(pThis)			CListStatFail(pThis)
+#define LIST_STAT_STEPS(pThis, nSteps)	CListStatSteps(pThis, nSteps)
+
+/* after nCount grew */
+#define LIST_STAT_COUNT(pThis) \
+	(((pThis)->nCount > (pThis)->stats.nPeakCount) ? CListStatPeak(pThis) : (void)0)
+
+#define LIST_STAT_MOVE(pDst, pSrc, nBytes) \
+	((pDst)->stats.nHeldBytes += (long long)(nBytes), \
+	 (pSrc)->stats.nHeldBytes -= (long long)(nBytes))
+
+#define LIST_STAT_SWAP(pDst, pSrc)		CListStatSwap(pDst, pSrc)
+
+#else
+
+#define LIST_STAT_ALLOC(pThis, nBytes)		((void)(pThis))
+#define LIST_STAT_FREE(pThis, nBytes)		((void)(pThis))
+#define LIST_STAT_FREE_BLOCKS(pThis, nBlocks, nBytes)	((void)(pThis))
+#define LIST_STAT_FAIL(pThis)				((void)(pThis))
+#define LIST_STAT_STEPS(pThis, nSteps)		((void)(pThis), (void)(nSteps))
+#define LIST_STAT_COUNT(pThis)				((void)(pThis))
+#define LIST_STAT_MOVE(pDst, pSrc, nBytes)	((void)0)
+#define LIST_STAT_SWAP(pDst, pSrc)			((void)0)
+
+#endif
+
+/*-----------------------------------------------------------------------------
+ * node layout
+ *
+ * Every node is one block: nNodeHeader bytes of per-node bookkeeping for the
+ * optional features enabled on the list, then the ListElem (links and inline
+ * payload). POSITION always points at the ListElem.
+ * --------------------------------------------------------------------------*/
+#define LIST_NODE_ALIGN			sizeof(void *)
+#define LIST_ALIGN_UP(n, a)		(((n) + (a) - 1) / (a) * (a))
+
+#define LIST_NODE_BLOCK(pThis, pListElem) \
+	((unsigned char *)(pListElem) - (pThis)->nNodeHeader)
+
+/*-----------------------------------------------------------------------------
+ * node pool (InitListWithCapacity)
+ * --------------------------------------------------------------------------*/
+/* slab sizing when no usable capacity hint was given, and growth limit */
+#define LIST_POOL_DEFAULT_NODES		64
+#define LIST_POOL_MAX_SLAB_NODES	65536
+
+typedef struct ListSlab {
+
+	struct ListSlab	*pNext;
+
+#ifdef CLIST_STATS
+	size_t			nSize;			/* bytes of the slab, header included */
+#endif
+
+} ListSlab;
+
+struct ListNodePool {
+
+	ListSlab	*pSlabs;		/* every slab owned by the pool */
+	void		*pFree;			/* removed node blocks, chained through
+								   their first word */
+
+	unsigned char	*pCursor;	/* uncarved part of the newest slab */
+	unsigned char	*pLimit;
+
+	size_t		nNodeSize;
+	int			nCapacity;		/* node count of the first slab */
+	int			nSlabNodes;		/* node count of the next slab */
+};
+
+#define LIST_SLAB_HEADER_SIZE	LIST_ALIGN_UP(sizeof(ListSlab), LIST_NODE_ALIGN)
+
+/*-----------------------------------------------------------------------------
+ * node arena (InitListWithArena)
+ *
+ * The list's allocator context. Nodes are carved from the arena; removed
+ * ones are kept for reuse, and RemoveAll takes all of them back at once by
+ * resetting the arena.
+ * --------------------------------------------------------------------------*/
+struct ListNodeArena {
+
+	CListArena	arena;
+	void		*pFree;			/* removed node blocks, chained through
+								   their first word */
+};
+
+/*-----------------------------------------------------------------------------
+ * order statistic index (ListEnableIndex, list_index.c)
+ *
+ * A treap ordered by list position; each node carries the size of its
+ * subtree, so the element at an index is found in O(log n) expected.
+ * --------------------------------------------------------------------------*/
+typedef struct ListRankNode {
+
+	ListElem		*pLeft;
+	ListElem		*pRight;
+	ListElem		*pParent;
+	unsigned int	nSize;			/* nodes in this subtree */
+	unsigned int	nPriority;		/* treap heap key, smaller is higher */
+
+} ListRankNode;
+
+/* the rank node sits right in front of the ListElem */
+#define LIST_RANK_NODE(pListElem) \
+	((ListRankNode *)((unsigned char *)(pListElem) - sizeof(ListRankNode)))
+
+/* FindIndex walks up to this many links before using the tree */
+#define LIST_INDEX_WALK_LIMIT	16
+
+struct ListRankIndex {
+
+	ListElem		*pRoot;
+	unsigned int	nSeed;
+};
+
+struct ListRankIndex* CListIndexCreate(void);
+void CListIndexInsert(struct ListRankIndex *pIndex, ListElem *pListElem,
+		ListElem *pPrev, ListElem *pNext);
+void CListIndexRemove(struct ListRankIndex *pIndex, ListElem *pListElem);
+ListElem* CListIndexFind(struct ListRankIndex *pIndex, int nIndex);
+void CListIndexBuild(struct ListRankIndex *pIndex, ListElem *pHead);
+
+/*-----------------------------------------------------------------------------
+ * key hash index (ListEnableHashIndex, list_hash.c)
+ *
+ * Separate chaining through a link in every node. The bucket array doubles
+ * whenever the list outgrows it; if that allocation fails the chains just
+ * get longer, so linking an element never fails because of the index.
+ * --------------------------------------------------------------------------*/
+typedef struct ListHashNode {
+
+	ListElem	*pNext;			/* next element in the same bucket */
+	ListElem	**ppLink;		/* bucket slot or pNext pointing here, so
+								   removal does not walk the chain */
+	size_t		nHash;			/* hash of the key, kept for rehashing */
+
+} ListHashNode;
+
+/* the hash node opens the node block, a rank node stays next to the
+ * ListElem whichever of the two was enabled first */
+#define LIST_HASH_NODE(pThis, pListElem) \
+	((ListHashNode *)LIST_NODE_BLOCK(pThis, pListElem))
+
+/* bucket count of a new index, a power of two */
+#define LIST_HASH_MIN_BUCKETS	16
+
+struct ListHashIndex {
+
+	ListElem	**ppBuckets;
+	size_t		nBuckets;		/* power of two */
+	size_t		nItems;
+
+	size_t		nKeyOffset;
+	size_t		nKeyLen;
+	CListHashFn	pfnHash;
+};
+
+struct ListHashIndex* CListHashCreate(size_t nKeyOffset, size_t nKeyLen,
+		CListHashFn pfnHash);
+void CListHashDestroy(struct ListHashIndex *pHash);
+void CListHashInsert(struct CList *pThis, ListElem *pListElem);
+void CListHashRemove(struct CList *pThis, ListElem *pListElem);
+void CListHashClear(struct ListHashIndex *pHash);
+ListElem* CListHashFind(struct CList *pThis, const void* pKey);
+
+/*-----------------------------------------------------------------------------
+ * prefetch (GetNextBatch)
+ *
+ * Hints only: a prefetch never faults, and compiles to nothing where the
+ * compiler has no builtin for it. Payloads get at most a few lines past
+ * their first, a caller reading only a key should not pull in all of a
+ * large record.
+ * --------------------------------------------------------------------------*/
+#if defined(__GNUC__) || defined(__clang__)
+#define LIST_PREFETCH(p)		__builtin_prefetch((p), 0, 3)
+#else
+#define LIST_PREFETCH(p)		((void)(p))
+#endif
+
+#define LIST_CACHE_LINE					64
+#define LIST_PREFETCH_PAYLOAD_LINES		4
+
+/* the lines of a payload after the one holding pData, up to the limit */
+static inline void CListPrefetchPayload(const void *pData, size_t nSize) {
+
+	uintptr_t nLine = ((uintptr_t)pData & ~(uintptr_t)(LIST_CACHE_LINE - 1)) + LIST_CACHE_LINE;
+	uintptr_t nEnd = (uintptr_t)pData + nSize;
+	int i;
+
+	for (i = 0; i < LIST_PREFETCH_PAYLOAD_LINES && nLine < nEnd; i++, nLine += LIST_CACHE_LINE)
+		LIST_PREFETCH((const void *)nLine);
+}
+
+#endif
@@ -0,0 +1,341 @@
+#include "list_intrusive.h"
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+static void CListIntrusiveLink(struct CListIntrusive *pThis, CListLink *pLink,
+		CListLink *pPrev, CListLink *pNext);
+static void CListIntrusiveUnlink(struct CListIntrusive *pThis, CListLink *pLink);
+
+/*--------------------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListIntrusive
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: Initialize an empty intrusive list. There is nothing to destroy;
+ *       the list holds no memory of its own.
+ *
+ * --------------------------------------------------------------------------*/
+void InitListIntrusive(struct CListIntrusive *pThis) {
+
+	if (pThis == NULL)
+		return;
+
+	pThis->nCount = 0;
+	pThis->pHeadNode = NULL;
+	pThis->pTailNode = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveAddHead
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pLink : link of the object to add, not on any list
+ *
+ * Return Value:
+ * 	- Return -1 if pThis or pLink is NULL, else returns 0
+ *
+ * Desc: link object at list head
+ *
+ * --------------------------------------------------------------------------*/
+int ListIntrusiveAddHead(struct CListIntrusive *pThis, CListLink *pLink) {
+
+	if (pThis == NULL || pLink == NULL)
+		return -1;
+
+	CListIntrusiveLink(pThis, pLink, NULL, pThis->pHeadNode);
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveAddTail
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pLink : link of the object to add, not on any list
+ *
+ * Return Value:
+ * 	- Return -1 if pThis or pLink is NULL, else returns 0
+ *
+ * Desc: link object at list tail
+ *
+ * --------------------------------------------------------------------------*/
+int ListIntrusiveAddTail(struct CListIntrusive *pThis, CListLink *pLink) {
+
+	if (pThis == NULL || pLink == NULL)
+		return -1;
+
+	CListIntrusiveLink(pThis, pLink, pThis->pTailNode, NULL);
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveRemoveHead
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ *
+ * Return Value:
+ * 	- the removed link, NULL if the list is empty
+ *
+ * Desc: unlink head object
+ *
+ * --------------------------------------------------------------------------*/
+CListLink* ListIntrusiveRemoveHead(struct CListIntrusive *pThis) {
+
+	CListLink *pLink;
+
+	if (pThis == NULL || pThis->pHeadNode == NULL)
+		return NULL;
+
+	pLink = pThis->pHeadNode;
+	CListIntrusiveUnlink(pThis, pLink);
+
+	return pLink;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveRemoveTail
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ *
+ * Return Value:
+ * 	- the removed link, NULL if the list is empty
+ *
+ * Desc: unlink tail object
+ *
+ * --------------------------------------------------------------------------*/
+CListLink* ListIntrusiveRemoveTail(struct CListIntrusive *pThis) {
+
+	CListLink *pLink;
+
+	if (pThis == NULL || pThis->pTailNode == NULL)
+		return NULL;
+
+	pLink = pThis->pTailNode;
+	CListIntrusiveUnlink(pThis, pLink);
+
+	return pLink;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveRemoveAll
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: forget every object in O(1). Their links are left as they were and
+ *       may be added to a list again.
+ *
+ * --------------------------------------------------------------------------*/
+void ListIntrusiveRemoveAll(struct CListIntrusive *pThis) {
+
+	if (pThis == NULL)
+		return;
+
+	pThis->nCount = 0;
+	pThis->pHeadNode = NULL;
+	pThis->pTailNode = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveRemoveAt
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pLink : link on this list
+ *
+ * Return Value:
+ * 	- Return -1 if pThis or pLink is NULL or the list is empty, else
+ * 	  returns 0
+ *
+ * Desc: unlink object in O(1)
+ *
+ * --------------------------------------------------------------------------*/
+int ListIntrusiveRemoveAt(struct CListIntrusive *pThis, CListLink *pLink) {
+
+	if (pThis == NULL || pLink == NULL || pThis->nCount == 0)
+		return -1;
+
+	CListIntrusiveUnlink(pThis, pLink);
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveReplace
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pLink : link on this list
+ * 	- pNewLink : link of an object not on any list
+ *
+ * Return Value:
+ * 	- Return -1 if an argument is NULL, else returns 0
+ *
+ * Desc: put pNewLink's object where pLink's is and unlink pLink, the
+ *       counterpart of SetAt
+ *
+ * --------------------------------------------------------------------------*/
+int ListIntrusiveReplace(struct CListIntrusive *pThis, CListLink *pLink,
+		CListLink *pNewLink) {
+
+	if (pThis == NULL || pLink == NULL || pNewLink == NULL)
+		return -1;
+
+	if (pNewLink == pLink)
+		return 0;
+
+	pNewLink->prev = pLink->prev;
+	pNewLink->next = pLink->next;
+
+	if (pLink->prev != NULL)
+		pLink->prev->next = pNewLink;
+	else
+		pThis->pHeadNode = pNewLink;
+
+	if (pLink->next != NULL)
+		pLink->next->prev = pNewLink;
+	else
+		pThis->pTailNode = pNewLink;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveInsertNext
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pAt : link on this list
+ * 	- pLink : link of the object to insert, not on any list
+ *
+ * Return Value:
+ * 	- Return -1 if an argument is NULL, else returns 0
+ *
+ * Desc: link object next to pAt
+ *
+ * --------------------------------------------------------------------------*/
+int ListIntrusiveInsertNext(struct CListIntrusive *pThis, CListLink *pAt,
+		CListLink *pLink) {
+
+	if (pThis == NULL || pAt == NULL || pLink == NULL)
+		return -1;
+
+	CListIntrusiveLink(pThis, pLink, pAt, pAt->next);
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveInsertPrev
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pAt : link on this list
+ * 	- pLink : link of the object to insert, not on any list
+ *
+ * Return Value:
+ * 	- Return -1 if an argument is NULL, else returns 0
+ *
+ * Desc: link object previous to pAt
+ *
+ * --------------------------------------------------------------------------*/
+int ListIntrusiveInsertPrev(struct CListIntrusive *pThis, CListLink *pAt,
+		CListLink *pLink) {
+
+	if (pThis == NULL || pAt == NULL || pLink == NULL)
+		return -1;
+
+	CListIntrusiveLink(pThis, pLink, pAt->prev, pAt);
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListIntrusiveFindIndex
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- nIndex : zero based index
+ *
+ * Return Value:
+ * 	- link at nIndex, NULL if out of range
+ *
+ * Desc: walk from whichever end is nearer
+ *
+ * --------------------------------------------------------------------------*/
+CListLink* ListIntrusiveFindIndex(struct CListIntrusive *pThis, int nIndex) {
+
+	CListLink *pLink;
+	int i;
+
+	if (pThis == NULL || nIndex < 0 || nIndex >= pThis->nCount)
+		return NULL;
+
+	if (nIndex <= pThis->nCount / 2) {
+		for (pLink = pThis->pHeadNode, i = 0; i < nIndex; i++)
+			pLink = pLink->next;
+	}
+	else {
+		for (pLink = pThis->pTailNode, i = pThis->nCount - 1; i > nIndex; i--)
+			pLink = pLink->prev;
+	}
+
+	return pLink;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIntrusiveLink
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pLink : link to add
+ * 	- pPrev, pNext : adjacent links to link between, NULL at head/tail
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- link and count
+ *
+ * --------------------------------------------------------------------------*/
+static void CListIntrusiveLink(struct CListIntrusive *pThis, CListLink *pLink,
+		CListLink *pPrev, CListLink *pNext) {
+
+	pLink->prev = pPrev;
+	pLink->next = pNext;
+
+	if (pPrev != NULL)
+		pPrev->next = pLink;
+	else
+		pThis->pHeadNode = pLink;
+
+	if (pNext != NULL)
+		pNext->prev = pLink;
+	else
+		pThis->pTailNode = pLink;
+
+	pThis->nCount++;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListIntrusiveUnlink
+ *
+ * Parameter:
+ * 	- pThis : CListIntrusive instance pointer
+ * 	- pLink : link on this list
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- unlink and count
+ *
+ * --------------------------------------------------------------------------*/
+static void CListIntrusiveUnlink(struct CListIntrusive *pThis, CListLink *pLink) {
+
+	if (pLink->prev != NULL)
+		pLink->prev->next = pLink->next;
+	else
+		pThis->pHeadNode = pLink->next;
+
+	if (pLink->next != NULL)
+		pLink->next->prev = pLink->prev;
+	else
+		pThis->pTailNode = pLink->prev;
+
+	pThis->nCount--;
+}
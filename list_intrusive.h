@@ -0,0 +1,137 @@
+/******************************************************************************
+    Intrusive doubly linked list.
+
+    The caller embeds a CListLink in each object and the list links those
+    objects directly: no allocation, no copy, and no per-element memory
+    besides the two pointers of the link. An object sits on as many lists at
+    once as it has links, and LIST_CONTAINER_OF gets it back from a link.
+
+        typedef struct Conn {
+            int         fd;
+            CListLink   ready;      // on the ready list
+            CListLink   timer;      // on the timer list
+        } Conn;
+
+        ListIntrusiveAddTail(&readyList, &pConn->ready);
+        ...
+        for (pLink = ListIntrusiveGetHeadPosition(&readyList); pLink != NULL; ) {
+            Conn *pConn = LIST_CONTAINER_OF(
+                    ListIntrusiveGetNext(&readyList, &pLink), Conn, ready);
+            ...
+        }
+
+    The operations mirror the CList table, with the link standing in for
+    both POSITION and payload. The list never owns the objects; removing a
+    link leaves its object alone, and a link may be on one list at a time.
+******************************************************************************/
+
+#ifndef LIST_INTRUSIVE_H
+#define LIST_INTRUSIVE_H
+
+#include <stddef.h>
+
+typedef struct CListLink {
+
+	struct CListLink	*next;
+	struct CListLink	*prev;
+
+} CListLink;
+
+/* the object of type Type whose member named member is *pLink */
+#define LIST_CONTAINER_OF(pLink, Type, member) \
+	((Type *)(void *)((char *)(pLink) - offsetof(Type, member)))
+
+typedef struct CListIntrusive {
+
+	int			nCount;
+
+	CListLink	*pHeadNode;
+	CListLink	*pTailNode;
+
+} CListIntrusive;
+
+void InitListIntrusive(struct CListIntrusive *pThis);
+
+/* operation */
+int ListIntrusiveAddHead(struct CListIntrusive *pThis, CListLink *pLink);
+int ListIntrusiveAddTail(struct CListIntrusive *pThis, CListLink *pLink);
+CListLink* ListIntrusiveRemoveHead(struct CListIntrusive *pThis);
+CListLink* ListIntrusiveRemoveTail(struct CListIntrusive *pThis);
+void ListIntrusiveRemoveAll(struct CListIntrusive *pThis);
+
+/* retrieval, modification */
+int ListIntrusiveRemoveAt(struct CListIntrusive *pThis, CListLink *pLink);
+int ListIntrusiveReplace(struct CListIntrusive *pThis, CListLink *pLink,
+		CListLink *pNewLink);
+
+/* Insertion */
+int ListIntrusiveInsertNext(struct CListIntrusive *pThis, CListLink *pAt,
+		CListLink *pLink);
+int ListIntrusiveInsertPrev(struct CListIntrusive *pThis, CListLink *pAt,
+		CListLink *pLink);
+
+/* Searching */
+CListLink* ListIntrusiveFindIndex(struct CListIntrusive *pThis, int nIndex);
+
+/* head, tail access and iteration, expanded in place */
+static inline CListLink* ListIntrusiveGetHead(struct CListIntrusive *pThis) {
+
+	return pThis->pHeadNode;
+}
+
+static inline CListLink* ListIntrusiveGetTail(struct CListIntrusive *pThis) {
+
+	return pThis->pTailNode;
+}
+
+static inline CListLink* ListIntrusiveGetHeadPosition(struct CListIntrusive *pThis) {
+
+	return pThis->pHeadNode;
+}
+
+static inline CListLink* ListIntrusiveGetTailPosition(struct CListIntrusive *pThis) {
+
+	return pThis->pTailNode;
+}
+
+/* return *ppPosition and step it forward; the returned link may then be
+ * removed without breaking the walk */
+static inline CListLink* ListIntrusiveGetNext(struct CListIntrusive *pThis,
+		CListLink **ppPosition) {
+
+	CListLink *pLink = *ppPosition;
+
+	(void)pThis;
+
+	if (pLink != NULL)
+		*ppPosition = pLink->next;
+
+	return pLink;
+}
+
+static inline CListLink* ListIntrusiveGetPrev(struct CListIntrusive *pThis,
+		CListLink **ppPosition) {
+
+	CListLink *pLink = *ppPosition;
+
+	(void)pThis;
+
+	if (pLink != NULL)
+		*ppPosition = pLink->prev;
+
+	return pLink;
+}
+
+/* Status */
+static inline int ListIntrusiveGetCount(struct CListIntrusive *pThis) {
+
+	return pThis->nCount;
+}
+
+/* like ListIsEmpty: 0 if the list has no element, else 1 */
+static inline int ListIntrusiveIsEmpty(struct CListIntrusive *pThis) {
+
+	return (pThis->nCount != 0) ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include <string.h>
+
+#include "list_lru.h"
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListLru
+ *
+ * Parameter:
+ * 	- pThis : CListLru instance pointer
+ * 	- nMaxDataSize : size of an entry
+ * 	- nKeyOffset, nKeyLen : where the key lies in an entry, see
+ * 	                        ListEnableHashIndex
+ * 	- nCapacity : entries kept before Put starts to evict
+ * 	- hash : key hash function, NULL for the built-in one
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid or allocation fails, else
+ * 	  returns 0
+ *
+ * Desc: Initialize an empty cache. Nodes for nCapacity entries are
+ *       preallocated in a pool, so filling the cache does not call malloc
+ *       per entry and a full cache does not allocate at all.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListLru(struct CListLru *pThis, int nMaxDataSize, int nKeyOffset,
+		int nKeyLen, int nCapacity, CListHashFn hash) {
+
+	if (pThis == NULL || nMaxDataSize <= 0 || nCapacity <= 0)
+		return -1;
+
+	if (InitListWithCapacity(&pThis->list, nMaxDataSize, nCapacity) != 0 ||
+			ListEnableHashIndex(&pThis->list, nKeyOffset, nKeyLen, hash) != 0) {
+		DestroyList(&pThis->list);
+		return -1;
+	}
+
+	pThis->nCapacity = nCapacity;
+	pThis->nKeyOffset = nKeyOffset;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: DestroyListLru
+ *
+ * Parameter:
+ * 	- pThis : CListLru instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: release every entry and the cache's memory
+ *
+ * --------------------------------------------------------------------------*/
+void DestroyListLru(struct CListLru *pThis) {
+
+	if (pThis == NULL)
+		return;
+
+	DestroyList(&pThis->list);
+	pThis->nCapacity = 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListLruGet
+ *
+ * Parameter:
+ * 	- pThis : CListLru instance pointer
+ * 	- pKey : nKeyLen bytes of key
+ *
+ * Return Value:
+ * 	- the cached entry, valid until it is evicted or removed; NULL on a
+ * 	  miss
+ *
+ * Desc:
+ * 	- look up an entry and make it the most recently used one
+ *
+ * --------------------------------------------------------------------------*/
+void* ListLruGet(struct CListLru *pThis, const void* pKey) {
+
+	POSITION pos;
+
+	if (pThis == NULL)
+		return NULL;
+
+	pos = ListFindKey(&pThis->list, pKey);
+
+	if (pos == NULL)
+		return NULL;
+
+	ListMoveToHead(&pThis->list, pos);
+
+	return ListGetAt(&pThis->list, pos);
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListLruPeek
+ *
+ * Parameter:
+ * 	- pThis : CListLru instance pointer
+ * 	- pKey : nKeyLen bytes of key
+ *
+ * Return Value:
+ * 	- the cached entry, NULL on a miss
+ *
+ * Desc:
+ * 	- look up an entry without changing the eviction order
+ *
+ * --------------------------------------------------------------------------*/
+void* ListLruPeek(struct CListLru *pThis, const void* pKey) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return ListGetAt(&pThis->list, ListFindKey(&pThis->list, pKey));
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListLruPut
+ *
+ * Parameter:
+ * 	- pThis : CListLru instance pointer
+ * 	- pData : entry to store, its key at nKeyOffset
+ * 	- pEvicted : receives the evicted entry, may be NULL
+ *
+ * Return Value:
+ * 	- 1 if the least recently used entry was evicted, 0 if not
+ * 	- Return -1 if arguments are invalid or allocation fails
+ *
+ * Desc:
+ * 	- store an entry as the most recently used one, replacing an entry
+ * 	  with the same key. A full cache overwrites its tail node with the
+ * 	  new entry and relinks it to the head instead of freeing one node
+ * 	  and allocating another.
+ *
+ * --------------------------------------------------------------------------*/
+int ListLruPut(struct CListLru *pThis, const void* pData, void* pEvicted) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return -1;
+
+	pos = ListFindKey(&pThis->list, (const unsigned char *)pData + pThis->nKeyOffset);
+
+	if (pos != NULL) {
+		ListSetAt(&pThis->list, pos, pData);
+		ListMoveToHead(&pThis->list, pos);
+		return 0;
+	}
+
+	if (pThis->list.nCount < pThis->nCapacity)
+		return (ListAddHead(&pThis->list, pData) != NULL) ? 0 : -1;
+
+	pos = ListGetTailPosition(&pThis->list);
+
+	if (pEvicted != NULL)
+		memcpy(pEvicted, ListGetAt(&pThis->list, pos), pThis->list.nMaxDataSize);
+
+	ListSetAt(&pThis->list, pos, pData);
+	ListMoveToHead(&pThis->list, pos);
+
+	return 1;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListLruRemove
+ *
+ * Parameter:
+ * 	- pThis : CListLru instance pointer
+ * 	- pKey : nKeyLen bytes of key
+ *
+ * Return Value:
+ * 	- Return -1 if there is no such entry, else returns 0
+ *
+ * Desc: drop an entry from the cache
+ *
+ * --------------------------------------------------------------------------*/
+int ListLruRemove(struct CListLru *pThis, const void* pKey) {
+
+	POSITION pos;
+
+	if (pThis == NULL)
+		return -1;
+
+	pos = ListFindKey(&pThis->list, pKey);
+
+	if (pos == NULL)
+		return -1;
+
+	return ListRemoveAt(&pThis->list, pos);
+}
@@ -0,0 +1,43 @@
+/******************************************************************************
+    LRU cache on top of CList.
+
+    Entries are records of nMaxDataSize bytes with a key of nKeyLen bytes at
+    nKeyOffset, kept in a node list from most to least recently used. The
+    list's hash index maps keys to nodes, so a lookup is O(1) on average and
+    a hit only relinks the node to the head: no allocation, no copy. When
+    the cache is full, Put recycles the tail node for the new entry.
+
+    Not thread-safe; callers sharing a cache between threads lock around it.
+******************************************************************************/
+
+#ifndef LIST_LRU_H
+#define LIST_LRU_H
+
+#include "list.h"
+
+typedef struct CListLru {
+
+	CList	list;			/* head is the most recently used entry */
+	int		nCapacity;
+	int		nKeyOffset;
+
+} CListLru;
+
+int InitListLru(struct CListLru *pThis, int nMaxDataSize, int nKeyOffset,
+		int nKeyLen, int nCapacity, CListHashFn hash);
+void DestroyListLru(struct CListLru *pThis);
+
+/* lookup; Get marks the entry most recently used, Peek leaves order alone */
+void* ListLruGet(struct CListLru *pThis, const void* pKey);
+void* ListLruPeek(struct CListLru *pThis, const void* pKey);
+
+/* insert or replace, returns 1 if an entry was evicted into pEvicted */
+int ListLruPut(struct CListLru *pThis, const void* pData, void* pEvicted);
+int ListLruRemove(struct CListLru *pThis, const void* pKey);
+
+static inline int ListLruGetCount(struct CListLru *pThis) {
+
+	return pThis->list.nCount;
+}
+
+#endif
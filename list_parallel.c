@@ -0,0 +1,613 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <threads.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * Parallel traversal (ListParallelForEach, ListParallelReduce)
+ *
+ * The list is cut into nRanges near-equal ranges of consecutive elements,
+ * several per thread. Each taking thread starts with a contiguous span of
+ * ranges, takes them from the front of its span and, once that is empty,
+ * steals from the back of another thread's span. A span is one atomic word
+ * (begin | end << 16), so a take or a steal is a single CAS. Uneven
+ * per-element cost then evens out at range granularity.
+ *
+ * The range starts of a node list are found by one walk and kept in
+ * pThis->pSplits together with nLinkVersion. Every relink of the chain bumps
+ * that, so the next traversal of an unchanged list splits without walking.
+ * Other storages find the starts with FindIndex.
+ *
+ * Threads come from a process wide pool that is started on first use and
+ * grows up to the largest nThreads asked for. It runs one traversal at a
+ * time; a traversal that finds it busy, e.g. one started from inside a
+ * visit callback, runs on the calling thread alone.
+ * --------------------------------------------------------------------------*/
+
+#define LIST_PARALLEL_MAX_THREADS	64
+
+/* the split never makes ranges shorter than this many elements */
+#define LIST_PARALLEL_MIN_RANGE		1024
+
+/* ranges of a split, a few per thread to steal from; fits a span half */
+#define LIST_PARALLEL_MAX_RANGES	256
+
+#define LIST_SPAN(nBegin, nEnd)		((unsigned int)(nBegin) | ((unsigned int)(nEnd) << 16))
+#define LIST_SPAN_BEGIN(nSpan)		((int)((nSpan) & 0xffffu))
+#define LIST_SPAN_END(nSpan)		((int)((nSpan) >> 16))
+
+struct ListSplitCache {
+
+	unsigned int	nVersion;		/* nLinkVersion of the list when split */
+	int				nCount;
+	int				nRanges;
+
+	/* range i covers elements anIndex[i] .. anIndex[i + 1] - 1 */
+	int				anIndex[LIST_PARALLEL_MAX_RANGES + 1];
+	POSITION		aStart[LIST_PARALLEL_MAX_RANGES];
+};
+
+/* one traversal, shared by the threads running it */
+typedef struct ListParallelJob {
+
+	struct CList					*pList;
+	const struct ListSplitCache		*pSplits;
+
+	CListVisitFn	pfnVisit;		/* ForEach, else reduce */
+	CListReduceFn	pfnReduce;
+	void			*pContext;
+
+	unsigned char	*pAccums;		/* one accumulator per range */
+	const void		*pIdentity;		/* every range starts from a copy */
+	size_t			nAccumSize;
+
+	int				nWorkers;
+	atomic_uint		anSpans[LIST_PARALLEL_MAX_THREADS];
+
+} ListParallelJob;
+
+typedef struct ListParallelPool {
+
+	mtx_t	lock;					/* guards the fields below */
+	cnd_t	cndWork;				/* a job was posted */
+	cnd_t	cndDone;				/* a worker left the job */
+
+	int		nThreads;				/* pool threads started */
+	unsigned int	nGeneration;	/* bumped per posted job */
+
+	ListParallelJob	*pJob;			/* NULL between jobs */
+	int		nJoined;				/* workers given a number, caller is 0 */
+	int		nActive;				/* pool threads still in the job */
+
+	int		bBusy;					/* a caller owns the pool */
+	int		bReady;					/* lock and conditions initialized */
+
+} ListParallelPool;
+
+static ListParallelPool g_ListParallelPool;
+static once_flag g_ListParallelPoolOnce = ONCE_FLAG_INIT;
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+static int CListParallelRun(struct CList *pThis, ListParallelJob *pJob, int nThreads);
+static struct ListSplitCache* CListParallelSplit(struct CList *pThis);
+static void CListParallelWork(ListParallelJob *pJob, int nWorker);
+static int CListParallelTake(ListParallelJob *pJob, int nWorker);
+static void CListParallelRange(ListParallelJob *pJob, int nRange);
+
+static void CListPoolInit(void);
+static int CListPoolAcquire(int nHelpers);
+static void CListPoolRelease(void);
+static int CListPoolThread(void *pArg);
+
+/*--------------------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------------------
+ * Function: ListParallelForEach
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- visit : called once per element with its payload (the stored pointer
+ * 	  for InitListByRef lists), from several threads at once
+ * 	- pContext : passed to visit
+ * 	- nThreads : threads to use, the calling one included
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid, else returns 0
+ *
+ * Desc: Visit every element on up to nThreads threads. Elements are handed
+ *       out in ranges of consecutive elements, so visit sees each of them
+ *       exactly once but in no particular order across ranges. visit may
+ *       change the payload it is given and nothing else of the list; the
+ *       list must not be changed by anyone until the call returns. Lists
+ *       shorter than two ranges, and nThreads below 2, run on the calling
+ *       thread.
+ *
+ * --------------------------------------------------------------------------*/
+int ListParallelForEach(struct CList *pThis, CListVisitFn visit, void *pContext,
+		int nThreads) {
+
+	ListParallelJob job;
+
+	if (pThis == NULL || pThis->pOps == NULL || visit == NULL)
+		return -1;
+
+	memset(&job, 0, sizeof(job));
+	job.pfnVisit = visit;
+	job.pContext = pContext;
+
+	return CListParallelRun(pThis, &job, nThreads);
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListParallelReduce
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- reduce : folds one payload into an accumulator
+ * 	- combine : folds the second accumulator into the first
+ * 	- pAccum : nAccumSize bytes, the identity value on entry, the result
+ * 	  on return
+ * 	- nAccumSize : accumulator size
+ * 	- pContext : passed to reduce and combine
+ * 	- nThreads : threads to use, the calling one included
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid or the accumulators can not be
+ * 	  allocated, else returns 0
+ *
+ * Desc: Fold the list on up to nThreads threads. Every range starts from a
+ *       copy of the identity in pAccum and is reduced in list order; the
+ *       range results are then combined into pAccum in list order on the
+ *       calling thread. The result therefore only depends on the list and
+ *       the split, not on which thread ran what: an associative reduce and
+ *       combine give the same value as a sequential fold.
+ *
+ * --------------------------------------------------------------------------*/
+int ListParallelReduce(struct CList *pThis, CListReduceFn reduce,
+		CListCombineFn combine, void *pAccum, int nAccumSize, void *pContext,
+		int nThreads) {
+
+	ListParallelJob job;
+	int nRanges;
+	int i;
+
+	if (pThis == NULL || pThis->pOps == NULL || reduce == NULL ||
+			combine == NULL || pAccum == NULL || nAccumSize <= 0)
+		return -1;
+
+	memset(&job, 0, sizeof(job));
+	job.pfnReduce = reduce;
+	job.pContext = pContext;
+	job.nAccumSize = (size_t)nAccumSize;
+	job.pIdentity = pAccum;
+	job.pAccums = (unsigned char *)malloc((size_t)nAccumSize * LIST_PARALLEL_MAX_RANGES);
+
+	if (job.pAccums == NULL)
+		return -1;
+
+	/* fills the range accumulators, combined below */
+	if (CListParallelRun(pThis, &job, nThreads) != 0) {
+		free(job.pAccums);
+		return -1;
+	}
+
+	nRanges = (job.pSplits != NULL) ? job.pSplits->nRanges : 0;
+	for (i = 0; i < nRanges; i++)
+		combine(pAccum, job.pAccums + (size_t)i * nAccumSize, pContext);
+
+	free(job.pAccums);
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListParallelRun
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pJob : job with its callbacks set
+ * 	- nThreads : threads to use, the calling one included
+ *
+ * Return Value:
+ * 	- Return -1 if the split can not be stored, else returns 0
+ *
+ * Desc:
+ * 	- split the list, hand the spans to the pool threads and work on the
+ * 	  calling thread as worker 0 until every range is done. pJob->pSplits
+ * 	  is left pointing at the split, NULL for an empty list.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListParallelRun(struct CList *pThis, ListParallelJob *pJob, int nThreads) {
+
+	struct ListSplitCache	*pSplits;
+	ListParallelPool		*pPool = &g_ListParallelPool;
+	int		nRanges;
+	int		i;
+
+	if (pThis->nCount == 0)
+		return 0;
+
+	pSplits = CListParallelSplit(pThis);
+
+	if (pSplits == NULL)
+		return -1;
+
+	nRanges = pSplits->nRanges;
+
+	if (nThreads > LIST_PARALLEL_MAX_THREADS)
+		nThreads = LIST_PARALLEL_MAX_THREADS;
+	if (nThreads > nRanges)
+		nThreads = nRanges;
+	if (nThreads < 1)
+		nThreads = 1;
+
+	pJob->pList = pThis;
+	pJob->pSplits = pSplits;
+
+	if (nThreads > 1)
+		nThreads = CListPoolAcquire(nThreads - 1) + 1;
+
+	pJob->nWorkers = nThreads;
+	for (i = 0; i < nThreads; i++) {
+		atomic_init(&pJob->anSpans[i], LIST_SPAN(nRanges * i / nThreads,
+				nRanges * (i + 1) / nThreads));
+	}
+
+	if (nThreads == 1) {
+		CListParallelWork(pJob, 0);
+	}
+	else {
+		mtx_lock(&pPool->lock);
+		pPool->pJob = pJob;
+		pPool->nJoined = 1;
+		pPool->nGeneration++;
+		cnd_broadcast(&pPool->cndWork);
+		mtx_unlock(&pPool->lock);
+
+		CListParallelWork(pJob, 0);
+
+		/* every range is taken; wait for the threads still running one */
+		mtx_lock(&pPool->lock);
+		while (pPool->nActive > 0)
+			cnd_wait(&pPool->cndDone, &pPool->lock);
+		pPool->pJob = NULL;
+		mtx_unlock(&pPool->lock);
+
+		CListPoolRelease();
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListParallelSplit
+ *
+ * Parameter:
+ * 	- pThis : non-empty list
+ *
+ * Return Value:
+ * 	- pThis->pSplits, NULL if it can not be allocated
+ *
+ * Desc:
+ * 	- cut the list into near-equal ranges. Node lists reuse the split
+ * 	  while nLinkVersion and nCount are unchanged and walk the chain once
+ * 	  otherwise; other storages look the starts up with FindIndex every
+ * 	  time, as they keep no link version.
+ *
+ * --------------------------------------------------------------------------*/
+static struct ListSplitCache* CListParallelSplit(struct CList *pThis) {
+
+	struct ListSplitCache *pSplits;
+	ListElem	*pListElem;
+	int			nRanges;
+	int			nAt;
+	int			i;
+
+	pSplits = pThis->pSplits;
+
+	if (pSplits != NULL && LIST_IS_NODE_LINKED(pThis) &&
+			pSplits->nVersion == pThis->nLinkVersion &&
+			pSplits->nCount == pThis->nCount)
+		return pSplits;
+
+	if (pSplits == NULL) {
+		pSplits = (struct ListSplitCache *)malloc(sizeof(struct ListSplitCache));
+		if (pSplits == NULL)
+			return NULL;
+		pThis->pSplits = pSplits;
+	}
+
+	nRanges = pThis->nCount / LIST_PARALLEL_MIN_RANGE;
+	if (nRanges > LIST_PARALLEL_MAX_RANGES)
+		nRanges = LIST_PARALLEL_MAX_RANGES;
+	if (nRanges < 1)
+		nRanges = 1;
+
+	pSplits->nVersion = pThis->nLinkVersion;
+	pSplits->nCount = pThis->nCount;
+	pSplits->nRanges = nRanges;
+
+	for (i = 0; i <= nRanges; i++)
+		pSplits->anIndex[i] = (int)((long long)pThis->nCount * i / nRanges);
+
+	if (LIST_IS_NODE_LINKED(pThis)) {
+		pListElem = pThis->pHeadNode;
+		nAt = 0;
+		for (i = 0; i < nRanges; i++) {
+			for (; nAt < pSplits->anIndex[i]; nAt++)
+				pListElem = pListElem->next;
+			pSplits->aStart[i] = (POSITION)pListElem;
+		}
+	}
+	else {
+		for (i = 0; i < nRanges; i++)
+			pSplits->aStart[i] = pThis->pOps->FindIndex(pThis, pSplits->anIndex[i]);
+	}
+
+	return pSplits;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListParallelWork
+ *
+ * Parameter:
+ * 	- pJob : running job
+ * 	- nWorker : this thread's span
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- run ranges until no span has one left
+ *
+ * --------------------------------------------------------------------------*/
+static void CListParallelWork(ListParallelJob *pJob, int nWorker) {
+
+	int nRange;
+
+	while ((nRange = CListParallelTake(pJob, nWorker)) >= 0)
+		CListParallelRange(pJob, nRange);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListParallelTake
+ *
+ * Parameter:
+ * 	- pJob : running job
+ * 	- nWorker : this thread's span
+ *
+ * Return Value:
+ * 	- a range nobody else runs, -1 if all of them are taken
+ *
+ * Desc:
+ * 	- pop the front of the own span, else steal the back of the next
+ * 	  non-empty span. Owner and thieves work at opposite ends, so they
+ * 	  only contend over the last range of a span.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListParallelTake(ListParallelJob *pJob, int nWorker) {
+
+	unsigned int	nSpan;
+	int		nBegin;
+	int		nEnd;
+	int		nVictim;
+	int		i;
+
+	nSpan = atomic_load_explicit(&pJob->anSpans[nWorker], memory_order_relaxed);
+	for (;;) {
+		nBegin = LIST_SPAN_BEGIN(nSpan);
+		nEnd = LIST_SPAN_END(nSpan);
+		if (nBegin >= nEnd)
+			break;
+		if (atomic_compare_exchange_weak(&pJob->anSpans[nWorker], &nSpan,
+				LIST_SPAN(nBegin + 1, nEnd)))
+			return nBegin;
+	}
+
+	for (i = 1; i < pJob->nWorkers; i++) {
+
+		nVictim = (nWorker + i) % pJob->nWorkers;
+		nSpan = atomic_load_explicit(&pJob->anSpans[nVictim], memory_order_relaxed);
+
+		for (;;) {
+			nBegin = LIST_SPAN_BEGIN(nSpan);
+			nEnd = LIST_SPAN_END(nSpan);
+			if (nBegin >= nEnd)
+				break;
+			if (atomic_compare_exchange_weak(&pJob->anSpans[nVictim], &nSpan,
+					LIST_SPAN(nBegin, nEnd - 1)))
+				return nEnd - 1;
+		}
+	}
+
+	return -1;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListParallelRange
+ *
+ * Parameter:
+ * 	- pJob : running job
+ * 	- nRange : range to run
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- visit or reduce the elements of one range. Node lists are walked
+ * 	  through their links; other storages through GetNext, which does not
+ * 	  change the list.
+ *
+ * --------------------------------------------------------------------------*/
+static void CListParallelRange(ListParallelJob *pJob, int nRange) {
+
+	struct CList	*pThis = pJob->pList;
+	const struct ListSplitCache *pSplits = pJob->pSplits;
+	ListElem		*pListElem;
+	POSITION		pos;
+	void			*pData;
+	void			*pAccum = NULL;
+	int				bNode = LIST_IS_NODE_LINKED(pThis);
+	int				bRef = (pThis->pOps == &g_CListRefOps);
+	int				nItems;
+
+	nItems = pSplits->anIndex[nRange + 1] - pSplits->anIndex[nRange];
+	pos = pSplits->aStart[nRange];
+
+	if (pJob->pAccums != NULL) {
+		pAccum = pJob->pAccums + (size_t)nRange * pJob->nAccumSize;
+		memcpy(pAccum, pJob->pIdentity, pJob->nAccumSize);
+	}
+
+	for (; nItems > 0; nItems--) {
+
+		if (bNode) {
+			pListElem = (ListElem *)pos;
+			pData = bRef ? *(void **)pListElem->data : (void *)pListElem->data;
+			pos = (POSITION)pListElem->next;
+		}
+		else {
+			pData = pThis->pOps->GetNext(pThis, &pos);
+		}
+
+		if (pAccum != NULL)
+			pJob->pfnReduce(pAccum, pData, pJob->pContext);
+		else
+			pJob->pfnVisit(pData, pJob->pContext);
+	}
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListPoolInit
+ *
+ * Parameter:
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- set up the pool's lock and conditions, once per process
+ *
+ * --------------------------------------------------------------------------*/
+static void CListPoolInit(void) {
+
+	ListParallelPool *pPool = &g_ListParallelPool;
+
+	if (mtx_init(&pPool->lock, mtx_plain) != thrd_success)
+		return;
+
+	if (cnd_init(&pPool->cndWork) != thrd_success) {
+		mtx_destroy(&pPool->lock);
+		return;
+	}
+
+	if (cnd_init(&pPool->cndDone) != thrd_success) {
+		cnd_destroy(&pPool->cndWork);
+		mtx_destroy(&pPool->lock);
+		return;
+	}
+
+	pPool->bReady = 1;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListPoolAcquire
+ *
+ * Parameter:
+ * 	- nHelpers : pool threads wanted besides the caller
+ *
+ * Return Value:
+ * 	- pool threads the caller may count on joining, 0 if the pool is busy
+ * 	  or can not be set up
+ *
+ * Desc:
+ * 	- claim the pool for one job, starting threads until it has nHelpers.
+ * 	  A nonzero result must be given back with CListPoolRelease.
+ *
+ * --------------------------------------------------------------------------*/
+static int CListPoolAcquire(int nHelpers) {
+
+	ListParallelPool *pPool = &g_ListParallelPool;
+	thrd_t thread;
+
+	call_once(&g_ListParallelPoolOnce, CListPoolInit);
+
+	if (!pPool->bReady)
+		return 0;
+
+	mtx_lock(&pPool->lock);
+
+	if (pPool->bBusy) {
+		mtx_unlock(&pPool->lock);
+		return 0;
+	}
+
+	/* a new thread counts from the current generation, so it joins the
+	 * job the caller is about to post even if it first runs after that */
+	while (pPool->nThreads < nHelpers &&
+			thrd_create(&thread, CListPoolThread,
+					(void *)(uintptr_t)pPool->nGeneration) == thrd_success) {
+		thrd_detach(thread);
+		pPool->nThreads++;
+	}
+
+	if (nHelpers > pPool->nThreads)
+		nHelpers = pPool->nThreads;
+
+	if (nHelpers > 0)
+		pPool->bBusy = 1;
+
+	mtx_unlock(&pPool->lock);
+
+	return nHelpers;
+}
+
+static void CListPoolRelease(void) {
+
+	ListParallelPool *pPool = &g_ListParallelPool;
+
+	mtx_lock(&pPool->lock);
+	pPool->bBusy = 0;
+	mtx_unlock(&pPool->lock);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListPoolThread
+ *
+ * Parameter:
+ * 	- pArg : pool generation when the thread was started
+ *
+ * Return Value:
+ * 	- never returns, pool threads live as long as the process
+ *
+ * Desc:
+ * 	- sleep until a job is posted, join it as the next worker if it still
+ * 	  has a span without a thread, and run ranges until none is left
+ *
+ * --------------------------------------------------------------------------*/
+static int CListPoolThread(void *pArg) {
+
+	ListParallelPool *pPool = &g_ListParallelPool;
+	ListParallelJob *pJob;
+	unsigned int nSeen;
+	int nWorker;
+
+	nSeen = (unsigned int)(uintptr_t)pArg;
+
+	mtx_lock(&pPool->lock);
+
+	for (;;) {
+
+		while (pPool->nGeneration == nSeen)
+			cnd_wait(&pPool->cndWork, &pPool->lock);
+		nSeen = pPool->nGeneration;
+
+		pJob = pPool->pJob;
+		if (pJob == NULL || pPool->nJoined >= pJob->nWorkers)
+			continue;
+
+		nWorker = pPool->nJoined++;
+		pPool->nActive++;
+		mtx_unlock(&pPool->lock);
+
+		CListParallelWork(pJob, nWorker);
+
+		mtx_lock(&pPool->lock);
+		if (--pPool->nActive == 0)
+			cnd_signal(&pPool->cndDone);
+	}
+
+	return 0;
+}
@@ -0,0 +1,703 @@
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "list_queue.h"
+
+/*-----------------------------------------------------------------------------
+ * Lock-free queue (Michael & Scott)
+ *
+ * A singly linked list with a dummy node in front: pHead points at the dummy,
+ * whose successor holds the first element, and pTail at the last node (or
+ * one behind it while an AddTail is half done; every thread helps to advance
+ * it). AddTail links a node with one CAS on pTail->pNext, TryRemoveHead
+ * swings pHead to the successor with one CAS, copies the payload out of the
+ * new dummy and retires the old one.
+ *
+ * A node that left the queue may still be read by threads that loaded it
+ * just before, so it is not freed right away. Every thread publishes the
+ * nodes it is about to dereference in its hazard pointer slots and frees its
+ * retired nodes only once no slot of any thread holds them.
+ *
+ * pHead and pTail live on separate cache lines so that producers and
+ * consumers do not invalidate each other's line on every CAS.
+ * --------------------------------------------------------------------------*/
+
+#define LIST_QUEUE_CACHE_LINE	64
+
+/* hazard slots per thread: TryRemoveHead needs head and its successor */
+#define LIST_HP_SLOTS			2
+
+/* retired nodes a thread collects before it scans the hazard slots */
+#define LIST_HP_SCAN_MIN		64
+
+typedef struct ListQNode {
+
+	_Atomic(struct ListQNode *)	pNext;
+	unsigned char				data[];
+
+} ListQNode;
+
+struct ListQueueState {
+
+	_Alignas(LIST_QUEUE_CACHE_LINE) _Atomic(ListQNode *) pHead;
+	_Alignas(LIST_QUEUE_CACHE_LINE) _Atomic(ListQNode *) pTail;
+};
+
+/*-----------------------------------------------------------------------------
+ * Single producer, single consumer ring
+ *
+ * nHead and nTail count removed and added elements since init and wrap only
+ * at SIZE_MAX; the slot of count n is n & nMask. Only the consumer stores
+ * nHead and only the producer stores nTail, so each call is one acquire load
+ * of the other side's index, a copy and one release store: wait-free.
+ *
+ * Each index shares its cache line with its owner's cached copy of the
+ * other index. The other line is read only when the cached copy says the
+ * ring is full (producer) or empty (consumer), so in steady state each
+ * side keeps its line to itself.
+ * --------------------------------------------------------------------------*/
+struct ListSpscState {
+
+	/* consumer */
+	_Alignas(LIST_QUEUE_CACHE_LINE) atomic_size_t nHead;
+	size_t			nTailCache;
+
+	/* producer */
+	_Alignas(LIST_QUEUE_CACHE_LINE) atomic_size_t nTail;
+	size_t			nHeadCache;
+
+	/* read-only after init */
+	_Alignas(LIST_QUEUE_CACHE_LINE) unsigned char *pSlots;
+	size_t			nElemSize;
+	size_t			nMask;
+};
+
+#define SPSC_SLOT(pState, n) \
+	((pState)->pSlots + ((n) & (pState)->nMask) * (pState)->nElemSize)
+
+/*-----------------------------------------------------------------------------
+ * hazard pointers
+ *
+ * One record per thread, shared by all queues. Records are only ever pushed
+ * onto s_pHpRecords; a thread that exits marks its record inactive and the
+ * next new thread takes it over along with the nodes still waiting on it.
+ * --------------------------------------------------------------------------*/
+typedef struct ListHpRecord {
+
+	_Atomic(void *)			apHazard[LIST_HP_SLOTS];
+	atomic_int				bActive;
+	struct ListHpRecord		*pNext;		/* fixed once published */
+
+	void	**ppRetired;	/* owner thread only */
+	int		nRetired;
+	int		nRetiredCap;
+
+} ListHpRecord;
+
+static _Atomic(ListHpRecord *) s_pHpRecords;
+static atomic_int s_nHpRecords;
+
+static once_flag s_hpOnce = ONCE_FLAG_INIT;
+static tss_t s_hpKey;
+static int s_bHpKey;
+
+static _Thread_local ListHpRecord *s_pHpRecord;
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+static void CListHpCreateKey(void);
+static void CListHpRelease(void *pArg);
+static ListHpRecord* CListHpAcquire(void);
+static ListQNode* CListHpProtect(ListHpRecord *pRec, int nSlot,
+		_Atomic(ListQNode *) *ppSrc);
+static void CListHpRetire(ListHpRecord *pRec, void *pNode);
+static void CListHpScan(ListHpRecord *pRec);
+static int CListHpCompare(const void *pA, const void *pB);
+
+static ListQNode* CListQueueAllocNode(int nMaxDataSize, const void* pData);
+
+/*--------------------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListQueue
+ *
+ * Parameter:
+ * 	- pThis : CListQueue instance pointer
+ * 	- nMaxDataSize : Max size of queue element
+ *
+ * Return Value:
+ * 	- Return -1 if queue can not be allocated, else returns 0
+ *
+ * Desc: Initialize an empty concurrent queue. Init and DestroyListQueue must
+ *       not run concurrently with other calls on the same queue; AddTail
+ *       and TryRemoveHead may be called from any number of threads.
+ *
+ *       There is no GetCount: a shared element counter would be a second
+ *       contended cache line on every call. Callers that need one keep it
+ *       themselves.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListQueue(struct CListQueue *pThis, int nMaxDataSize) {
+
+	struct ListQueueState *pState;
+	ListQNode *pDummy;
+
+	if (pThis == NULL || nMaxDataSize <= 0)
+		return -1;
+
+	pThis->pState = NULL;
+	pThis->nMaxDataSize = nMaxDataSize;
+
+	pState = (struct ListQueueState *)aligned_alloc(LIST_QUEUE_CACHE_LINE,
+			sizeof(struct ListQueueState));
+	if (pState == NULL)
+		return -1;
+
+	pDummy = CListQueueAllocNode(nMaxDataSize, NULL);
+	if (pDummy == NULL) {
+		free(pState);
+		return -1;
+	}
+
+	atomic_init(&pState->pHead, pDummy);
+	atomic_init(&pState->pTail, pDummy);
+
+	pThis->pState = pState;
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: DestroyListQueue
+ *
+ * Parameter:
+ * 	- pThis : CListQueue instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: Free the queue and the elements left in it. No other thread may use
+ *       the queue any more. Nodes removed earlier may still wait in the
+ *       hazard pointer records of the threads that removed them; those are
+ *       freed by the owners' later scans or at their thread exit.
+ *
+ * --------------------------------------------------------------------------*/
+void DestroyListQueue(struct CListQueue *pThis) {
+
+	ListQNode *pNode;
+	ListQNode *pNext;
+
+	if (pThis == NULL || pThis->pState == NULL)
+		return;
+
+	pNode = atomic_load_explicit(&pThis->pState->pHead, memory_order_relaxed);
+
+	while (pNode != NULL) {
+		pNext = atomic_load_explicit(&pNode->pNext, memory_order_relaxed);
+		free(pNode);
+		pNode = pNext;
+	}
+
+	free(pThis->pState);
+	pThis->pState = NULL;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListQueueAddTail
+ *
+ * Parameter:
+ * 	- pThis : CListQueue instance pointer
+ * 	- pData : element to copy into the queue, nMaxDataSize bytes
+ *
+ * Return Value:
+ * 	- Return -1 on bad arguments or if no memory is left, else returns 0
+ *
+ * Desc: Append a copy of pData. Lock-free; safe to call from any thread.
+ *
+ * --------------------------------------------------------------------------*/
+int ListQueueAddTail(struct CListQueue *pThis, const void* pData) {
+
+	struct ListQueueState *pState;
+	ListHpRecord *pRec;
+	ListQNode *pNode;
+	ListQNode *pTail;
+	ListQNode *pNext;
+
+	if (pThis == NULL || pThis->pState == NULL || pData == NULL)
+		return -1;
+
+	pRec = CListHpAcquire();
+	if (pRec == NULL)
+		return -1;
+
+	pNode = CListQueueAllocNode(pThis->nMaxDataSize, pData);
+	if (pNode == NULL)
+		return -1;
+
+	pState = pThis->pState;
+
+	for (;;) {
+		pTail = CListHpProtect(pRec, 0, &pState->pTail);
+		pNext = atomic_load(&pTail->pNext);
+
+		if (pTail != atomic_load(&pState->pTail))
+			continue;
+
+		/* tail lags behind, help the other AddTail finish */
+		if (pNext != NULL) {
+			atomic_compare_exchange_weak(&pState->pTail, &pTail, pNext);
+			continue;
+		}
+
+		if (atomic_compare_exchange_weak(&pTail->pNext, &pNext, pNode)) {
+			/* failing is fine, someone else advanced it */
+			atomic_compare_exchange_strong(&pState->pTail, &pTail, pNode);
+			break;
+		}
+	}
+
+	atomic_store(&pRec->apHazard[0], NULL);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListQueueTryRemoveHead
+ *
+ * Parameter:
+ * 	- pThis : CListQueue instance pointer
+ * 	- pData : receives the removed element, nMaxDataSize bytes
+ *
+ * Return Value:
+ * 	- Return -1 if the queue is empty or on bad arguments, else returns 0
+ *
+ * Desc: Remove the first element and copy it to pData. Lock-free; safe to
+ *       call from any thread. Never blocks on an empty queue.
+ *
+ * --------------------------------------------------------------------------*/
+int ListQueueTryRemoveHead(struct CListQueue *pThis, void* pData) {
+
+	struct ListQueueState *pState;
+	ListHpRecord *pRec;
+	ListQNode *pHead;
+	ListQNode *pTail;
+	ListQNode *pNext;
+
+	if (pThis == NULL || pThis->pState == NULL || pData == NULL)
+		return -1;
+
+	pRec = CListHpAcquire();
+	if (pRec == NULL)
+		return -1;
+
+	pState = pThis->pState;
+
+	for (;;) {
+		pHead = CListHpProtect(pRec, 0, &pState->pHead);
+		pTail = atomic_load(&pState->pTail);
+		pNext = atomic_load(&pHead->pNext);
+		atomic_store(&pRec->apHazard[1], pNext);
+
+		/* pHead still in place means pNext was not retired before the
+		 * hazard became visible */
+		if (pHead != atomic_load(&pState->pHead))
+			continue;
+
+		if (pNext == NULL) {
+			atomic_store(&pRec->apHazard[0], NULL);
+			atomic_store(&pRec->apHazard[1], NULL);
+			return -1;
+		}
+
+		if (pHead == pTail) {
+			atomic_compare_exchange_weak(&pState->pTail, &pTail, pNext);
+			continue;
+		}
+
+		if (atomic_compare_exchange_weak(&pState->pHead, &pHead, pNext))
+			break;
+	}
+
+	/* pNext is the new dummy; its payload is ours */
+	memcpy(pData, pNext->data, (size_t)pThis->nMaxDataSize);
+
+	atomic_store(&pRec->apHazard[0], NULL);
+	atomic_store(&pRec->apHazard[1], NULL);
+
+	CListHpRetire(pRec, pHead);
+
+	return 0;
+}
+
+static ListQNode* CListQueueAllocNode(int nMaxDataSize, const void* pData) {
+
+	ListQNode *pNode;
+
+	pNode = (ListQNode *)malloc(offsetof(ListQNode, data) + (size_t)nMaxDataSize);
+	if (pNode == NULL)
+		return NULL;
+
+	atomic_init(&pNode->pNext, NULL);
+
+	if (pData != NULL)
+		memcpy(pNode->data, pData, (size_t)nMaxDataSize);
+
+	return pNode;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListSpscQueue
+ *
+ * Parameter:
+ * 	- pThis : CListSpscQueue instance pointer
+ * 	- nMaxDataSize : Max size of queue element
+ * 	- nCapacity : element slots, rounded up to a power of two
+ *
+ * Return Value:
+ * 	- Return -1 on bad arguments or if the ring can not be allocated, else
+ * 	  returns 0
+ *
+ * Desc: Initialize an empty ring for one producer and one consumer thread.
+ *       The capacity is fixed: growing would need the two sides to agree
+ *       on the new array, which the wait-free calls can not do, so AddTail
+ *       reports a full ring instead.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListSpscQueue(struct CListSpscQueue *pThis, int nMaxDataSize, int nCapacity) {
+
+	struct ListSpscState *pState;
+	size_t nSlots = 1;
+	size_t nElemSize;
+
+	if (pThis == NULL || nMaxDataSize <= 0 || nCapacity <= 0)
+		return -1;
+
+	pThis->pState = NULL;
+	pThis->nMaxDataSize = nMaxDataSize;
+
+	while (nSlots < (size_t)nCapacity)
+		nSlots *= 2;
+
+	/* keep payloads pointer aligned, like list nodes */
+	nElemSize = ((size_t)nMaxDataSize + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+	pState = (struct ListSpscState *)aligned_alloc(LIST_QUEUE_CACHE_LINE,
+			sizeof(struct ListSpscState));
+	if (pState == NULL)
+		return -1;
+
+	pState->pSlots = (unsigned char *)malloc(nSlots * nElemSize);
+	if (pState->pSlots == NULL) {
+		free(pState);
+		return -1;
+	}
+
+	atomic_init(&pState->nHead, 0);
+	atomic_init(&pState->nTail, 0);
+	pState->nTailCache = 0;
+	pState->nHeadCache = 0;
+	pState->nElemSize = nElemSize;
+	pState->nMask = nSlots - 1;
+
+	pThis->pState = pState;
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: DestroyListSpscQueue
+ *
+ * Parameter:
+ * 	- pThis : CListSpscQueue instance pointer
+ *
+ * Return Value:
+ *
+ * Desc: Free the ring and the elements left in it, once neither thread
+ *       uses it any more.
+ *
+ * --------------------------------------------------------------------------*/
+void DestroyListSpscQueue(struct CListSpscQueue *pThis) {
+
+	if (pThis == NULL || pThis->pState == NULL)
+		return;
+
+	free(pThis->pState->pSlots);
+	free(pThis->pState);
+	pThis->pState = NULL;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListSpscQueueAddTail
+ *
+ * Parameter:
+ * 	- pThis : CListSpscQueue instance pointer
+ * 	- pData : element to copy into the ring, nMaxDataSize bytes
+ *
+ * Return Value:
+ * 	- Return -1 if the ring is full or on bad arguments, else returns 0
+ *
+ * Desc: Append a copy of pData. Call from the producer thread only.
+ *
+ * --------------------------------------------------------------------------*/
+int ListSpscQueueAddTail(struct CListSpscQueue *pThis, const void* pData) {
+
+	struct ListSpscState *pState;
+	size_t nTail;
+
+	if (pThis == NULL || pThis->pState == NULL || pData == NULL)
+		return -1;
+
+	pState = pThis->pState;
+	nTail = atomic_load_explicit(&pState->nTail, memory_order_relaxed);
+
+	if (nTail - pState->nHeadCache > pState->nMask) {
+		pState->nHeadCache = atomic_load_explicit(&pState->nHead, memory_order_acquire);
+		if (nTail - pState->nHeadCache > pState->nMask)
+			return -1;
+	}
+
+	memcpy(SPSC_SLOT(pState, nTail), pData, (size_t)pThis->nMaxDataSize);
+
+	atomic_store_explicit(&pState->nTail, nTail + 1, memory_order_release);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListSpscQueueTryRemoveHead
+ *
+ * Parameter:
+ * 	- pThis : CListSpscQueue instance pointer
+ * 	- pData : receives the removed element, nMaxDataSize bytes
+ *
+ * Return Value:
+ * 	- Return -1 if the ring is empty or on bad arguments, else returns 0
+ *
+ * Desc: Remove the first element and copy it to pData. Call from the
+ *       consumer thread only.
+ *
+ * --------------------------------------------------------------------------*/
+int ListSpscQueueTryRemoveHead(struct CListSpscQueue *pThis, void* pData) {
+
+	struct ListSpscState *pState;
+	size_t nHead;
+
+	if (pThis == NULL || pThis->pState == NULL || pData == NULL)
+		return -1;
+
+	pState = pThis->pState;
+	nHead = atomic_load_explicit(&pState->nHead, memory_order_relaxed);
+
+	if (nHead == pState->nTailCache) {
+		pState->nTailCache = atomic_load_explicit(&pState->nTail, memory_order_acquire);
+		if (nHead == pState->nTailCache)
+			return -1;
+	}
+
+	memcpy(pData, SPSC_SLOT(pState, nHead), (size_t)pThis->nMaxDataSize);
+
+	atomic_store_explicit(&pState->nHead, nHead + 1, memory_order_release);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListSpscQueueGetCount
+ *
+ * Parameter:
+ * 	- pThis : CListSpscQueue instance pointer
+ *
+ * Return Value:
+ * 	- number of queued elements at some moment during the call
+ *
+ * Desc: Exact when called by the producer or the consumer while the other
+ *       side is idle; otherwise already stale when it returns.
+ *
+ * --------------------------------------------------------------------------*/
+int ListSpscQueueGetCount(struct CListSpscQueue *pThis) {
+
+	size_t nHead;
+	size_t nTail;
+
+	if (pThis == NULL || pThis->pState == NULL)
+		return 0;
+
+	/* head first: the tail read after it can only be further along */
+	nHead = atomic_load_explicit(&pThis->pState->nHead, memory_order_acquire);
+	nTail = atomic_load_explicit(&pThis->pState->nTail, memory_order_acquire);
+
+	return (int)(nTail - nHead);
+}
+
+/*-----------------------------------------------------------------------------
+ * hazard pointer records
+ * --------------------------------------------------------------------------*/
+static void CListHpCreateKey(void) {
+
+	s_bHpKey = (tss_create(&s_hpKey, CListHpRelease) == thrd_success);
+}
+
+/* thread exit: free what can be freed and hand the record to the next thread */
+static void CListHpRelease(void *pArg) {
+
+	ListHpRecord *pRec = (ListHpRecord *)pArg;
+	int i;
+
+	for (i = 0; i < LIST_HP_SLOTS; i++)
+		atomic_store(&pRec->apHazard[i], NULL);
+
+	if (pRec->nRetired > 0)
+		CListHpScan(pRec);
+
+	s_pHpRecord = NULL;
+	atomic_store(&pRec->bActive, 0);
+}
+
+static ListHpRecord* CListHpAcquire(void) {
+
+	ListHpRecord *pRec = s_pHpRecord;
+	ListHpRecord *pTop;
+	int bActive;
+
+	if (pRec != NULL)
+		return pRec;
+
+	call_once(&s_hpOnce, CListHpCreateKey);
+	if (!s_bHpKey)
+		return NULL;
+
+	/* take over the record of a thread that has exited */
+	for (pRec = atomic_load(&s_pHpRecords); pRec != NULL; pRec = pRec->pNext) {
+		bActive = 0;
+		if (atomic_compare_exchange_strong(&pRec->bActive, &bActive, 1))
+			break;
+	}
+
+	if (pRec == NULL) {
+		pRec = (ListHpRecord *)calloc(1, sizeof(ListHpRecord));
+		if (pRec == NULL)
+			return NULL;
+
+		atomic_init(&pRec->bActive, 1);
+
+		pTop = atomic_load(&s_pHpRecords);
+		do {
+			pRec->pNext = pTop;
+		} while (!atomic_compare_exchange_weak(&s_pHpRecords, &pTop, pRec));
+
+		atomic_fetch_add(&s_nHpRecords, 1);
+	}
+
+	if (tss_set(s_hpKey, pRec) != thrd_success) {
+		atomic_store(&pRec->bActive, 0);
+		return NULL;
+	}
+
+	s_pHpRecord = pRec;
+
+	return pRec;
+}
+
+/* publish *ppSrc in hazard slot nSlot and return it once the slot is known
+ * to have been visible while *ppSrc still held that node */
+static ListQNode* CListHpProtect(ListHpRecord *pRec, int nSlot,
+		_Atomic(ListQNode *) *ppSrc) {
+
+	ListQNode *pNode;
+	ListQNode *pCheck = atomic_load(ppSrc);
+
+	do {
+		pNode = pCheck;
+		atomic_store(&pRec->apHazard[nSlot], pNode);
+		pCheck = atomic_load(ppSrc);
+	} while (pCheck != pNode);
+
+	return pNode;
+}
+
+static void CListHpRetire(ListHpRecord *pRec, void *pNode) {
+
+	void **ppRetired;
+	int nCap;
+
+	while (pRec->nRetired == pRec->nRetiredCap) {
+		nCap = (pRec->nRetiredCap > 0) ? pRec->nRetiredCap * 2 : LIST_HP_SCAN_MIN * 2;
+		ppRetired = (void **)realloc(pRec->ppRetired, (size_t)nCap * sizeof(void *));
+
+		if (ppRetired != NULL) {
+			pRec->ppRetired = ppRetired;
+			pRec->nRetiredCap = nCap;
+			break;
+		}
+
+		/* out of memory: wait until a reader lets go of something */
+		CListHpScan(pRec);
+		if (pRec->nRetired == pRec->nRetiredCap)
+			thrd_yield();
+	}
+
+	pRec->ppRetired[pRec->nRetired++] = pNode;
+
+	/* scanning costs O(threads); amortize it over as many retirements */
+	if (pRec->nRetired >= LIST_HP_SCAN_MIN
+			+ 2 * LIST_HP_SLOTS * atomic_load(&s_nHpRecords))
+		CListHpScan(pRec);
+}
+
+/* free the retired nodes no hazard slot points at */
+static void CListHpScan(ListHpRecord *pRec) {
+
+	ListHpRecord *pFirst;
+	ListHpRecord *pOther;
+	void **ppHazards;
+	void *pHazard;
+	int nRecords = 0;
+	int nHazards = 0;
+	int nKept = 0;
+	int i;
+
+	/* a record pushed after this load belongs to a thread that started its
+	 * access after our nodes were unlinked, so it can not hold them */
+	pFirst = atomic_load(&s_pHpRecords);
+
+	for (pOther = pFirst; pOther != NULL; pOther = pOther->pNext)
+		nRecords++;
+
+	ppHazards = (void **)malloc((size_t)nRecords * LIST_HP_SLOTS * sizeof(void *));
+	if (ppHazards == NULL)
+		return;
+
+	for (pOther = pFirst; pOther != NULL; pOther = pOther->pNext) {
+		for (i = 0; i < LIST_HP_SLOTS; i++) {
+			pHazard = atomic_load(&pOther->apHazard[i]);
+			if (pHazard != NULL)
+				ppHazards[nHazards++] = pHazard;
+		}
+	}
+
+	qsort(ppHazards, (size_t)nHazards, sizeof(void *), CListHpCompare);
+
+	for (i = 0; i < pRec->nRetired; i++) {
+		if (bsearch(&pRec->ppRetired[i], ppHazards, (size_t)nHazards,
+				sizeof(void *), CListHpCompare) != NULL)
+			pRec->ppRetired[nKept++] = pRec->ppRetired[i];
+		else
+			free(pRec->ppRetired[i]);
+	}
+
+	pRec->nRetired = nKept;
+
+	free(ppHazards);
+}
+
+static int CListHpCompare(const void *pA, const void *pB) {
+
+	uintptr_t a = (uintptr_t)*(void * const *)pA;
+	uintptr_t b = (uintptr_t)*(void * const *)pB;
+
+	return (a > b) - (a < b);
+}
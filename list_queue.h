@@ -0,0 +1,51 @@
+/******************************************************************************
+    Concurrent FIFO queues with the CList AddTail / RemoveHead semantics.
+
+    CListQueue: any number of threads may call ListQueueAddTail and
+    ListQueueTryRemoveHead at the same time without a lock.
+
+    CListSpscQueue: a bounded ring for exactly one producer thread and one
+    consumer thread; both calls are wait-free.
+
+    Payloads are copied in and out, so a removed element never aliases
+    queue memory.
+******************************************************************************/
+
+#ifndef LIST_QUEUE_H
+#define LIST_QUEUE_H
+
+/* head/tail and memory reclamation state, private to list_queue.c */
+struct ListQueueState;
+struct ListSpscState;
+
+typedef struct CListQueue {
+
+	struct ListQueueState	*pState;
+	int						nMaxDataSize;
+
+} CListQueue;
+
+int InitListQueue(struct CListQueue *pThis, int nMaxDataSize);
+void DestroyListQueue(struct CListQueue *pThis);
+
+int ListQueueAddTail(struct CListQueue *pThis, const void* pData);
+int ListQueueTryRemoveHead(struct CListQueue *pThis, void* pData);
+
+typedef struct CListSpscQueue {
+
+	struct ListSpscState	*pState;
+	int						nMaxDataSize;
+
+} CListSpscQueue;
+
+int InitListSpscQueue(struct CListSpscQueue *pThis, int nMaxDataSize, int nCapacity);
+void DestroyListSpscQueue(struct CListSpscQueue *pThis);
+
+/* producer thread only */
+int ListSpscQueueAddTail(struct CListSpscQueue *pThis, const void* pData);
+/* consumer thread only */
+int ListSpscQueueTryRemoveHead(struct CListSpscQueue *pThis, void* pData);
+/* either thread, a snapshot */
+int ListSpscQueueGetCount(struct CListSpscQueue *pThis);
+
+#endif
@@ -0,0 +1,190 @@
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * By-reference lists (InitListByRef)
+ *
+ * The payload of every node is the caller's pointer itself. AddTail(&l, p)
+ * stores p without touching the object it points at, and GetAt/GetNext/...
+ * hand p back. Apart from that the list is an ordinary node list, so the
+ * node operations do the work and this table only converts the payload.
+ * --------------------------------------------------------------------------*/
+
+/* the stored pointer, for a payload address that may be NULL */
+static inline void* CListRefPayload(void *pSlot) {
+
+	return (pSlot != NULL) ? *(void **)pSlot : NULL;
+}
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+/* head, tail access */
+static void* CListRefGetHead(struct CList *pThis);
+static void* CListRefGetTail(struct CList *pThis);
+
+/* operation */
+static POSITION CListRefAddHead(struct CList *pThis, const void* pData);
+static POSITION CListRefAddTail(struct CList *pThis, const void* pData);
+
+/* for iteration */
+static void* CListRefGetNext(struct CList *pThis, POSITION* position);
+static void* CListRefGetPrev(struct CList *pThis, POSITION* position);
+static int CListRefGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+static void* CListRefGetAt(struct CList *pThis, POSITION position);
+static int CListRefSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion */
+static POSITION CListRefInsertNext(struct CList *pThis, POSITION position, const void* pData);
+static POSITION CListRefInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+
+/*--------------------------------------------------------------------------*/
+
+const CListOps g_CListRefOps = {
+
+	/* head/tail access */
+	CListRefGetHead,
+	CListRefGetTail,
+
+	/* Operation */
+	CListRefAddHead,
+	CListRefAddTail,
+	CListRemoveHead,
+	CListRemoveTail,
+	CListRemoveAll,
+
+	/* for iteration */
+	CListGetHeadPosition,
+	CListGetTailPosition,
+	CListRefGetNext,
+	CListRefGetPrev,
+
+	/* Retrieval, modification */
+	CListRefGetAt,
+	CListRemoveAt,
+	CListRefSetAt,
+
+	/* Insertion */
+	CListRefInsertNext,
+	CListRefInsertPrev,
+
+	/* Search */
+	CListFindIndex,
+
+	/* Status */
+	CListGetCount,
+	CListIsEmpty,
+
+	CListDestroyNodes,
+
+	/* there is no payload to build in place */
+	NULL,
+
+	CListRefGetNextBatch,
+	NULL			/* RemoveAt keeps later positions */
+};
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListByRef
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ *
+ * Return Value:
+ *
+ * Desc: Initialize list instance that stores the pData pointers passed to
+ *       AddTail, SetAt, ... instead of copies of what they point at. The
+ *       accessors return those pointers, and the batch calls take an
+ *       array of them. Meant for lists of handles to objects owned
+ *       elsewhere; the list never frees them.
+ *
+ * --------------------------------------------------------------------------*/
+void InitListByRef(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return;
+
+	InitList(pThis, (int)sizeof(void *));
+	CListBindOps(pThis, &g_CListRefOps);
+}
+
+static void* CListRefGetHead(struct CList *pThis) {
+
+	return CListRefPayload(CListGetHead(pThis));
+}
+
+static void* CListRefGetTail(struct CList *pThis) {
+
+	return CListRefPayload(CListGetTail(pThis));
+}
+
+static POSITION CListRefAddHead(struct CList *pThis, const void* pData) {
+
+	if (pData == NULL)
+		return NULL;
+
+	return CListAddHead(pThis, &pData);
+}
+
+static POSITION CListRefAddTail(struct CList *pThis, const void* pData) {
+
+	if (pData == NULL)
+		return NULL;
+
+	return CListAddTail(pThis, &pData);
+}
+
+static void* CListRefGetNext(struct CList *pThis, POSITION* position) {
+
+	return CListRefPayload(CListGetNext(pThis, position));
+}
+
+static void* CListRefGetPrev(struct CList *pThis, POSITION* position) {
+
+	return CListRefPayload(CListGetPrev(pThis, position));
+}
+
+/* the stored pointers are all known once the nodes are walked, so the
+ * objects they point at are prefetched together before the caller reads them */
+static int CListRefGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	int nGot = CListGetNextBatch(pThis, position, ppData, nMax);
+	int i;
+
+	for (i = 0; i < nGot; i++) {
+		ppData[i] = *(void **)ppData[i];
+		LIST_PREFETCH(ppData[i]);
+	}
+
+	return nGot;
+}
+
+static void* CListRefGetAt(struct CList *pThis, POSITION position) {
+
+	return CListRefPayload(CListGetAt(pThis, position));
+}
+
+static int CListRefSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pData == NULL)
+		return -1;
+
+	return CListSetAt(pThis, position, &pData);
+}
+
+static POSITION CListRefInsertNext(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pData == NULL)
+		return NULL;
+
+	return CListInsertNext(pThis, position, &pData);
+}
+
+static POSITION CListRefInsertPrev(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pData == NULL)
+		return NULL;
+
+	return CListInsertPrev(pThis, position, &pData);
+}
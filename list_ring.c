@@ -0,0 +1,616 @@
+#include <limits.h>
+#include <string.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * LIST_STORAGE_RING: circular array of payload slots
+ *
+ * Elements sit in one power of two sized array, logical index i in slot
+ * (nHead + i) & (nCapacity - 1). AddTail, AddHead, RemoveHead and RemoveTail
+ * touch one slot and never allocate while there is room, so a FIFO that stays
+ * below its capacity runs without malloc or free. A full ring doubles: the
+ * elements are copied into a new array in order, which invalidates every
+ * POSITION.
+ *
+ * A POSITION is the address of the payload slot. InsertNext/InsertPrev move
+ * the elements on the shorter side of the insert point one slot over.
+ * RemoveAt moves the elements in front of the removed one, never the ones
+ * after it, so removing while iterating forward with GetNext stays safe as
+ * with the other storages.
+ * --------------------------------------------------------------------------*/
+
+#define LIST_RING_DEFAULT_CAPACITY	16
+
+typedef struct ListRingStore {
+
+	unsigned char	*pSlots;
+	size_t			nElemSize;		/* slot stride, pointer aligned */
+	int				nCapacity;		/* power of two */
+	int				nHead;			/* slot of the first element */
+
+} ListRingStore;
+
+#define RING_STORE(pThis)		((ListRingStore *)(pThis)->pStorage)
+#define RING_SLOT(pStore, nSlot) \
+	((pStore)->pSlots + (size_t)(nSlot) * (pStore)->nElemSize)
+#define RING_AT(pStore, nIndex) \
+	RING_SLOT(pStore, ((pStore)->nHead + (nIndex)) & ((pStore)->nCapacity - 1))
+#define RING_END(pStore)		RING_SLOT(pStore, (pStore)->nCapacity)
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+/* head, tail access */
+static void* CListRingGetHead(struct CList *pThis);
+static void* CListRingGetTail(struct CList *pThis);
+
+/* operation */
+static POSITION CListRingAddHead(struct CList *pThis, const void* pData);
+static POSITION CListRingAddTail(struct CList *pThis, const void* pData);
+static int CListRingRemoveHead(struct CList *pThis);
+static int CListRingRemoveTail(struct CList *pThis);
+static int CListRingRemoveAll(struct CList *pThis);
+
+/* for iteration */
+static POSITION CListRingGetHeadPosition(struct CList *pThis);
+static POSITION CListRingGetTailPosition(struct CList *pThis);
+static void* CListRingGetNext(struct CList *pThis, POSITION* position);
+static void* CListRingGetPrev(struct CList *pThis, POSITION* position);
+static int CListRingGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+static void* CListRingGetAt(struct CList *pThis, POSITION position);
+static int CListRingRemoveAt(struct CList *pThis, POSITION position);
+static int CListRingSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion */
+static POSITION CListRingInsertNext(struct CList *pThis, POSITION position, const void* pData);
+static POSITION CListRingInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+
+/* Searching */
+static POSITION CListRingFindIndex(struct CList *pThis, int nIndex);
+
+/* Status */
+static int CListRingGetCount(struct CList *pThis);
+static int CListRingIsEmpty(struct CList *pThis);
+
+static void CListRingDestroy(struct CList *pThis);
+static POSITION CListRingEmplace(struct CList *pThis, POSITION position, int bAfter);
+
+/* slot management */
+static int CListRingIndexOf(ListRingStore *pStore, POSITION position);
+static int CListRingGrow(struct CList *pThis);
+
+/*--------------------------------------------------------------------------*/
+
+static const CListOps g_CListRingOps = {
+
+	/* head/tail access */
+	CListRingGetHead,
+	CListRingGetTail,
+
+	/* Operation */
+	CListRingAddHead,
+	CListRingAddTail,
+	CListRingRemoveHead,
+	CListRingRemoveTail,
+	CListRingRemoveAll,
+
+	/* for iteration */
+	CListRingGetHeadPosition,
+	CListRingGetTailPosition,
+	CListRingGetNext,
+	CListRingGetPrev,
+
+	/* Retrieval, modification */
+	CListRingGetAt,
+	CListRingRemoveAt,
+	CListRingSetAt,
+
+	/* Insertion */
+	CListRingInsertNext,
+	CListRingInsertPrev,
+
+	/* Search */
+	CListRingFindIndex,
+
+	/* Status */
+	CListRingGetCount,
+	CListRingIsEmpty,
+
+	CListRingDestroy,
+	CListRingEmplace,
+	CListRingGetNextBatch,
+	NULL			/* RemoveAt keeps later positions */
+};
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListRing
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nMaxDataSize : Max size of list element
+ * 	- nCapacity : expected upper bound of elements, rounded up to a power
+ * 	  of two; 0 picks a small default
+ *
+ * Return Value:
+ * 	- Return -1 if the slot array can not be allocated, else returns 0
+ *
+ * Desc: Initialize list instance with LIST_STORAGE_RING. All elements live
+ *       in one circular array, which suits FIFO use (AddTail + RemoveHead):
+ *       no per-element allocation and O(1) FindIndex. The array doubles
+ *       when it is full and is kept, not shrunk, until DestroyList.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListRing(struct CList *pThis, int nMaxDataSize, int nCapacity) {
+
+	if (pThis == NULL || nMaxDataSize <= 0 || nCapacity < 0)
+		return -1;
+
+	InitList(pThis, nMaxDataSize);
+
+	return CListRingInit(pThis, nCapacity);
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListRingInit
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer, freshly initialized by InitList
+ * 	- nCapacity : initial slot count hint, 0 for the default
+ *
+ * Return Value:
+ * 	- Return -1 if storage state can not be allocated, else returns 0
+ *
+ * Desc:
+ * 	- allocate the slot array and bind the ring operations
+ *
+ * --------------------------------------------------------------------------*/
+int CListRingInit(struct CList *pThis, int nCapacity) {
+
+	ListRingStore *pStore;
+	int nSlots = LIST_RING_DEFAULT_CAPACITY;
+
+	if (nCapacity > 0) {
+		for (nSlots = 1; nSlots < nCapacity; nSlots *= 2) {
+			if (nSlots > INT_MAX / 2)
+				return -1;
+		}
+	}
+
+	pStore = (ListRingStore *)calloc(1, sizeof(ListRingStore));
+
+	if (pStore == NULL)
+		return -1;
+
+	pStore->nElemSize = LIST_ALIGN_UP((size_t)pThis->nMaxDataSize, LIST_NODE_ALIGN);
+	pStore->nCapacity = nSlots;
+	pStore->pSlots = (unsigned char *)malloc((size_t)nSlots * pStore->nElemSize);
+
+	if (pStore->pSlots == NULL) {
+		free(pStore);
+		return -1;
+	}
+
+	LIST_STAT_ALLOC(pThis, (size_t)nSlots * pStore->nElemSize);
+
+	pThis->pStorage = pStore;
+	CListBindOps(pThis, &g_CListRingOps);
+
+	return 0;
+}
+
+static void* CListRingGetHead(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return RING_AT(RING_STORE(pThis), 0);
+}
+
+static void* CListRingGetTail(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return RING_AT(RING_STORE(pThis), pThis->nCount - 1);
+}
+
+static POSITION CListRingAddHead(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListRingEmplace(pThis, NULL, 0);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListRingAddTail(struct CList *pThis, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListRingEmplace(pThis, NULL, 1);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static int CListRingRemoveHead(struct CList *pThis) {
+
+	ListRingStore *pStore;
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = RING_STORE(pThis);
+
+	pStore->nHead = (pStore->nHead + 1) & (pStore->nCapacity - 1);
+	pThis->nCount--;
+
+	return 0;
+}
+
+static int CListRingRemoveTail(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return -1;
+
+	pThis->nCount--;
+
+	return 0;
+}
+
+static int CListRingRemoveAll(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	/* the slot array stays for the next elements */
+	RING_STORE(pThis)->nHead = 0;
+	pThis->nCount = 0;
+
+	return 0;
+}
+
+static POSITION CListRingGetHeadPosition(struct CList *pThis) {
+
+	return (POSITION)CListRingGetHead(pThis);
+}
+
+static POSITION CListRingGetTailPosition(struct CList *pThis) {
+
+	return (POSITION)CListRingGetTail(pThis);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListRingGetNext
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position next to current list element
+ *
+ * Return Value:
+ * 	- data pointer next to current element
+ *
+ * Desc:
+ * 	- step one slot, wrapping at the array end; the tail slot ends the walk
+ *
+ * --------------------------------------------------------------------------*/
+static void* CListRingGetNext(struct CList *pThis, POSITION* position) {
+
+	ListRingStore *pStore;
+	unsigned char *pSlot;
+	unsigned char *pNext;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = RING_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+
+	if (pSlot == RING_AT(pStore, pThis->nCount - 1)) {
+		*position = NULL;
+	}
+	else {
+		pNext = pSlot + pStore->nElemSize;
+		*position = (POSITION)((pNext == RING_END(pStore)) ? pStore->pSlots : pNext);
+	}
+
+	return pSlot;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListRingGetNextBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position of the first element wanted, advanced past the
+ * 	  last one handed out (NULL at the end)
+ * 	- ppData : receives the payload pointers
+ * 	- nMax : size of ppData
+ *
+ * Return Value:
+ * 	- number of payload pointers stored, 0 at the end of the list, -1 if
+ * 	  arguments are invalid
+ *
+ * Desc:
+ * 	- the slots follow each other, wrapping once at the array end; the
+ * 	  hardware prefetcher already streams them, so nothing is hinted
+ *
+ * --------------------------------------------------------------------------*/
+static int CListRingGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	ListRingStore *pStore;
+	unsigned char *pSlot;
+	int nIndex;
+	int nGot;
+
+	if (pThis == NULL || position == NULL || ppData == NULL || nMax < 0)
+		return -1;
+
+	if (*position == NULL)
+		return 0;
+
+	pStore = RING_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+	nIndex = ((int)((size_t)(pSlot - pStore->pSlots) / pStore->nElemSize) - pStore->nHead) &
+		(pStore->nCapacity - 1);
+
+	if (nMax > pThis->nCount - nIndex)
+		nMax = pThis->nCount - nIndex;
+
+	for (nGot = 0; nGot < nMax; nGot++) {
+		ppData[nGot] = pSlot;
+		pSlot += pStore->nElemSize;
+		if (pSlot == RING_END(pStore))
+			pSlot = pStore->pSlots;
+	}
+
+	*position = (nIndex + nGot == pThis->nCount) ? NULL : (POSITION)pSlot;
+
+	return nGot;
+}
+
+static void* CListRingGetPrev(struct CList *pThis, POSITION* position) {
+
+	ListRingStore *pStore;
+	unsigned char *pSlot;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pStore = RING_STORE(pThis);
+	pSlot = (unsigned char *)*position;
+
+	if (pSlot == RING_AT(pStore, 0))
+		*position = NULL;
+	else if (pSlot == pStore->pSlots)
+		*position = (POSITION)(RING_END(pStore) - pStore->nElemSize);
+	else
+		*position = (POSITION)(pSlot - pStore->nElemSize);
+
+	return pSlot;
+}
+
+static void* CListRingGetAt(struct CList *pThis, POSITION position) {
+
+	if (pThis == NULL)
+		return NULL;
+
+	return (void *)position;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListRingRemoveAt
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position want to remove.
+ *
+ * Return Value:
+ *  - Return -1 if pThis is NULL.
+ *
+ * Desc:
+ * 	- close the gap by moving the elements in front of it back one slot,
+ * 	  then advance the head; the elements after position stay in place
+ *
+ * --------------------------------------------------------------------------*/
+static int CListRingRemoveAt(struct CList *pThis, POSITION position) {
+
+	ListRingStore *pStore;
+	int nIndex;
+
+	if (pThis == NULL || position == NULL || pThis->nCount == 0)
+		return -1;
+
+	pStore = RING_STORE(pThis);
+
+	for (nIndex = CListRingIndexOf(pStore, position); nIndex > 0; nIndex--)
+		memcpy(RING_AT(pStore, nIndex), RING_AT(pStore, nIndex - 1), pStore->nElemSize);
+
+	pStore->nHead = (pStore->nHead + 1) & (pStore->nCapacity - 1);
+	pThis->nCount--;
+
+	return 0;
+}
+
+static int CListRingSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return -1;
+
+	memcpy(position, pData, (size_t)pThis->nMaxDataSize);
+
+	return 0;
+}
+
+static POSITION CListRingInsertNext(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListRingEmplace(pThis, position, 1);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListRingInsertPrev(struct CList *pThis, POSITION position, const void* pData) {
+
+	POSITION pos;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	pos = CListRingEmplace(pThis, position, 0);
+
+	if (pos != NULL)
+		memcpy(pos, pData, (size_t)pThis->nMaxDataSize);
+
+	return pos;
+}
+
+static POSITION CListRingFindIndex(struct CList *pThis, int nIndex) {
+
+	if (pThis == NULL || nIndex < 0 || nIndex >= pThis->nCount)
+		return NULL;
+
+	return (POSITION)RING_AT(RING_STORE(pThis), nIndex);
+}
+
+static int CListRingGetCount(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return pThis->nCount;
+}
+
+static int CListRingIsEmpty(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return (pThis->nCount != 0) ? 1 : 0;
+}
+
+static void CListRingDestroy(struct CList *pThis) {
+
+	ListRingStore *pStore = RING_STORE(pThis);
+
+	if (pStore != NULL) {
+		LIST_STAT_FREE(pThis, (size_t)pStore->nCapacity * pStore->nElemSize);
+		free(pStore->pSlots);
+	}
+
+	free(pStore);
+	pThis->pStorage = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListRingEmplace
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to insert next to, NULL for head or tail
+ * 	- bAfter : insert after position (or at tail), else before (or at head)
+ *
+ * Return Value:
+ * 	- position of the new, uninitialized element
+ *
+ * Desc:
+ * 	- double the array if it is full, then open a slot at the insert point
+ * 	  by moving the elements between it and the nearer end
+ *
+ * --------------------------------------------------------------------------*/
+static POSITION CListRingEmplace(struct CList *pThis, POSITION position, int bAfter) {
+
+	ListRingStore *pStore = RING_STORE(pThis);
+	int nCount = pThis->nCount;
+	int nIndex;
+	int i;
+
+	if (position != NULL)
+		nIndex = CListRingIndexOf(pStore, position) + (bAfter ? 1 : 0);
+	else
+		nIndex = bAfter ? nCount : 0;
+
+	if (nCount == pStore->nCapacity && CListRingGrow(pThis) != 0) {
+		LIST_STAT_FAIL(pThis);
+		return NULL;
+	}
+
+	if (nIndex < nCount - nIndex) {
+		/* the new head slot takes the old index 0 */
+		pStore->nHead = (pStore->nHead - 1) & (pStore->nCapacity - 1);
+		for (i = 0; i < nIndex; i++)
+			memcpy(RING_AT(pStore, i), RING_AT(pStore, i + 1), pStore->nElemSize);
+	}
+	else {
+		for (i = nCount; i > nIndex; i--)
+			memcpy(RING_AT(pStore, i), RING_AT(pStore, i - 1), pStore->nElemSize);
+	}
+
+	pThis->nCount++;
+	LIST_STAT_COUNT(pThis);
+
+	return (POSITION)RING_AT(pStore, nIndex);
+}
+
+/* logical index of the element in slot position */
+static int CListRingIndexOf(ListRingStore *pStore, POSITION position) {
+
+	int nSlot = (int)(((unsigned char *)position - pStore->pSlots) / pStore->nElemSize);
+
+	return (nSlot - pStore->nHead) & (pStore->nCapacity - 1);
+}
+
+/* move the elements into an array twice the size, head at slot 0 */
+static int CListRingGrow(struct CList *pThis) {
+
+	ListRingStore *pStore = RING_STORE(pThis);
+	int nCount = pThis->nCount;
+	unsigned char *pSlots;
+	size_t nFirstRun;
+
+	if (pStore->nCapacity > INT_MAX / 2)
+		return -1;
+
+	pSlots = (unsigned char *)malloc((size_t)pStore->nCapacity * 2 * pStore->nElemSize);
+
+	if (pSlots == NULL)
+		return -1;
+
+	/* elements from the head up to the array end, then the wrapped rest */
+	nFirstRun = (size_t)(pStore->nCapacity - pStore->nHead);
+	if (nFirstRun > (size_t)nCount)
+		nFirstRun = (size_t)nCount;
+
+	memcpy(pSlots, RING_SLOT(pStore, pStore->nHead), nFirstRun * pStore->nElemSize);
+	memcpy(pSlots + nFirstRun * pStore->nElemSize, pStore->pSlots,
+			((size_t)nCount - nFirstRun) * pStore->nElemSize);
+
+	free(pStore->pSlots);
+
+	LIST_STAT_FREE(pThis, (size_t)pStore->nCapacity * pStore->nElemSize);
+	LIST_STAT_ALLOC(pThis, (size_t)pStore->nCapacity * 2 * pStore->nElemSize);
+
+	pStore->pSlots = pSlots;
+	pStore->nCapacity *= 2;
+	pStore->nHead = 0;
+
+	return 0;
+}
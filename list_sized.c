@@ -0,0 +1,702 @@
+#include <string.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * Variable-length lists (InitListSized)
+ *
+ * Nodes are chained through the list's own head, tail and FindIndex cursor
+ * like node lists, but every node is allocated for the payload it holds
+ * instead of nMaxDataSize bytes. The node header keeps the stored length
+ * and the room the block has; block sizes are rounded up to a size class,
+ * so a payload rewritten with a somewhat longer one usually stays in place
+ * and blocks fit the allocator's own bins.
+ *
+ * The plain operations store nMaxDataSize bytes. The ListAddTailSized
+ * family takes the length, and ListGetAtSized hands it back.
+ * --------------------------------------------------------------------------*/
+typedef struct ListSizedHeader {
+
+	uint32_t	nSize;			/* payload bytes stored */
+	uint32_t	nCapacity;		/* payload bytes the block has room for */
+
+} ListSizedHeader;
+
+#define SIZED_HEADER(pThis, pListElem) \
+	((ListSizedHeader *)LIST_NODE_BLOCK(pThis, pListElem))
+
+/* block of the node, header included */
+#define SIZED_BLOCK_SIZE(pThis, nCapacity) \
+	((size_t)(pThis)->nNodeHeader + LIST_ELEM_SIZE(nCapacity))
+
+/* size classes: multiples of 16 bytes up to 128, then four per power of two,
+ * so at most a quarter of a block is left unused */
+#define LIST_SIZED_SMALL_BLOCK		128
+#define LIST_SIZED_SMALL_STEP		16
+#define LIST_SIZED_CLASS_STEPS		4
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+/* operation */
+static POSITION CListSizedAddHead(struct CList *pThis, const void* pData);
+static POSITION CListSizedAddTail(struct CList *pThis, const void* pData);
+static int CListSizedRemoveHead(struct CList *pThis);
+static int CListSizedRemoveTail(struct CList *pThis);
+static int CListSizedRemoveAll(struct CList *pThis);
+
+/* for iteration */
+static int CListSizedGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+static int CListSizedRemoveAt(struct CList *pThis, POSITION position);
+static int CListSizedSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion */
+static POSITION CListSizedInsertNext(struct CList *pThis, POSITION position, const void* pData);
+static POSITION CListSizedInsertPrev(struct CList *pThis, POSITION position, const void* pData);
+
+static void CListSizedDestroy(struct CList *pThis);
+static POSITION CListSizedEmplace(struct CList *pThis, POSITION position, int bAfter);
+
+/* nodes */
+static size_t CListSizedClass(size_t nBlockSize);
+static ListElem* CListSizedAllocElem(struct CList *pThis, const void* pData, int nSize);
+static void CListSizedFreeElem(struct CList *pThis, ListElem *pListElem);
+static POSITION CListSizedLink(struct CList *pThis, const void* pData, int nSize,
+		ListElem *pPrev, ListElem *pNext);
+
+/*--------------------------------------------------------------------------*/
+
+const CListOps g_CListSizedOps = {
+
+	/* head/tail access */
+	CListGetHead,
+	CListGetTail,
+
+	/* Operation */
+	CListSizedAddHead,
+	CListSizedAddTail,
+	CListSizedRemoveHead,
+	CListSizedRemoveTail,
+	CListSizedRemoveAll,
+
+	/* for iteration */
+	CListGetHeadPosition,
+	CListGetTailPosition,
+	CListGetNext,
+	CListGetPrev,
+
+	/* Retrieval, modification */
+	CListGetAt,
+	CListSizedRemoveAt,
+	CListSizedSetAt,
+
+	/* Insertion */
+	CListSizedInsertNext,
+	CListSizedInsertPrev,
+
+	/* Search */
+	CListFindIndex,
+
+	/* Status */
+	CListGetCount,
+	CListIsEmpty,
+
+	CListSizedDestroy,
+	CListSizedEmplace,
+	CListSizedGetNextBatch,
+	NULL			/* RemoveAt keeps later positions */
+};
+
+/*-----------------------------------------------------------------------------
+ * Function: InitListSized
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- nMaxDataSize : largest payload an element may hold
+ *
+ * Return Value:
+ * 	- Return -1 if pThis is NULL or nMaxDataSize is not positive, else
+ * 	  returns 0
+ *
+ * Desc: Initialize list instance for payloads of different lengths, up to
+ *       nMaxDataSize bytes. Every node takes the size class of its own
+ *       payload, so lists of mostly short records hold far less memory than
+ *       with InitList. ListSort relinks the nodes as for node lists.
+ *       Snapshots, ListMerge and ListSplice out of a sized list, and ListFind
+ *       without cmp are refused: they would copy or compare nMaxDataSize
+ *       bytes of every payload.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListSized(struct CList *pThis, int nMaxDataSize) {
+
+	if (pThis == NULL || nMaxDataSize <= 0)
+		return -1;
+
+	InitList(pThis, nMaxDataSize);
+	pThis->nNodeHeader = (int)LIST_ALIGN_UP(sizeof(ListSizedHeader), LIST_NODE_ALIGN);
+	CListBindOps(pThis, &g_CListSizedOps);
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListAddHeadSized
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : payload to copy, may be NULL if nSize is 0
+ * 	- nSize : bytes at pData, at most nMaxDataSize
+ *
+ * Return Value:
+ * 	- headnode position
+ * 	- Return NULL if arguments are invalid or allocation fails
+ *
+ * Desc:
+ * 	- add an element of nSize bytes to list head. Lists not made by
+ * 	  InitListSized store nMaxDataSize bytes anyway, the rest zeroed; lists
+ * 	  without ListEmplace* support (by-reference, mapped) refuse.
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListAddHeadSized(struct CList *pThis, const void* pData, int nSize) {
+
+	unsigned char *pPayload;
+	POSITION pos = NULL;
+
+	if (pThis == NULL || nSize < 0 || nSize > pThis->nMaxDataSize ||
+			(pData == NULL && nSize > 0))
+		return NULL;
+
+	if (LIST_IS_SIZED(pThis))
+		return CListSizedLink(pThis, pData, nSize, NULL, pThis->pHeadNode);
+
+	pPayload = (unsigned char *)ListEmplaceHead(pThis, &pos);
+
+	if (pPayload == NULL)
+		return NULL;
+
+	if (nSize > 0)
+		memcpy(pPayload, pData, (size_t)nSize);
+	memset(pPayload + nSize, 0, (size_t)(pThis->nMaxDataSize - nSize));
+
+	return pos;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListAddTailSized
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : payload to copy, may be NULL if nSize is 0
+ * 	- nSize : bytes at pData, at most nMaxDataSize
+ *
+ * Return Value:
+ * 	- tail node position
+ * 	- Return NULL if arguments are invalid or allocation fails
+ *
+ * Desc:
+ * 	- add an element of nSize bytes to list tail, see ListAddHeadSized
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListAddTailSized(struct CList *pThis, const void* pData, int nSize) {
+
+	unsigned char *pPayload;
+	POSITION pos = NULL;
+
+	if (pThis == NULL || nSize < 0 || nSize > pThis->nMaxDataSize ||
+			(pData == NULL && nSize > 0))
+		return NULL;
+
+	if (LIST_IS_SIZED(pThis))
+		return CListSizedLink(pThis, pData, nSize, pThis->pTailNode, NULL);
+
+	pPayload = (unsigned char *)ListEmplaceTail(pThis, &pos);
+
+	if (pPayload == NULL)
+		return NULL;
+
+	if (nSize > 0)
+		memcpy(pPayload, pData, (size_t)nSize);
+	memset(pPayload + nSize, 0, (size_t)(pThis->nMaxDataSize - nSize));
+
+	return pos;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListInsertNextSized
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : list element location which to insert
+ * 	- pData : payload to copy, may be NULL if nSize is 0
+ * 	- nSize : bytes at pData, at most nMaxDataSize
+ *
+ * Return Value:
+ * 	- position of the new element
+ * 	- Return NULL if arguments are invalid or allocation fails
+ *
+ * Desc:
+ * 	- insert an element of nSize bytes next to position, see
+ * 	  ListAddHeadSized
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListInsertNextSized(struct CList *pThis, POSITION position,
+		const void* pData, int nSize) {
+
+	ListElem *pAt = (ListElem *)position;
+	unsigned char *pPayload;
+	POSITION pos = NULL;
+
+	if (pThis == NULL || position == NULL || nSize < 0 ||
+			nSize > pThis->nMaxDataSize || (pData == NULL && nSize > 0))
+		return NULL;
+
+	if (LIST_IS_SIZED(pThis))
+		return CListSizedLink(pThis, pData, nSize, pAt, pAt->next);
+
+	pPayload = (unsigned char *)ListEmplaceNext(pThis, position, &pos);
+
+	if (pPayload == NULL)
+		return NULL;
+
+	if (nSize > 0)
+		memcpy(pPayload, pData, (size_t)nSize);
+	memset(pPayload + nSize, 0, (size_t)(pThis->nMaxDataSize - nSize));
+
+	return pos;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListInsertPrevSized
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : list element location which to insert
+ * 	- pData : payload to copy, may be NULL if nSize is 0
+ * 	- nSize : bytes at pData, at most nMaxDataSize
+ *
+ * Return Value:
+ * 	- position of the new element
+ * 	- Return NULL if arguments are invalid or allocation fails
+ *
+ * Desc:
+ * 	- insert an element of nSize bytes previous to position, see
+ * 	  ListAddHeadSized
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListInsertPrevSized(struct CList *pThis, POSITION position,
+		const void* pData, int nSize) {
+
+	ListElem *pAt = (ListElem *)position;
+	unsigned char *pPayload;
+	POSITION pos = NULL;
+
+	if (pThis == NULL || position == NULL || nSize < 0 ||
+			nSize > pThis->nMaxDataSize || (pData == NULL && nSize > 0))
+		return NULL;
+
+	if (LIST_IS_SIZED(pThis))
+		return CListSizedLink(pThis, pData, nSize, pAt->prev, pAt);
+
+	pPayload = (unsigned char *)ListEmplacePrev(pThis, position, &pos);
+
+	if (pPayload == NULL)
+		return NULL;
+
+	if (nSize > 0)
+		memcpy(pPayload, pData, (size_t)nSize);
+	memset(pPayload + nSize, 0, (size_t)(pThis->nMaxDataSize - nSize));
+
+	return pos;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListSetAtSized
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to replace; receives its new position if the
+ * 	  element had to move
+ * 	- pData : payload to copy, may be NULL if nSize is 0
+ * 	- nSize : bytes at pData, at most nMaxDataSize
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid or allocation fails, the element is
+ * 	  unchanged then, else returns 0
+ *
+ * Desc:
+ * 	- replace the payload of an element. On a sized list a payload that
+ * 	  does not fit the node's block, or would leave most of it unused,
+ * 	  gets a new node in the same place: *position changes and the old
+ * 	  position must not be used any more. Other lists zero the bytes past
+ * 	  nSize and never move the element; like ListEmplace*, payloads
+ * 	  shorter than nMaxDataSize are refused by lists that have a hash
+ * 	  index or do not take ListEmplace*.
+ *
+ * --------------------------------------------------------------------------*/
+int ListSetAtSized(struct CList *pThis, POSITION* position, const void* pData, int nSize) {
+
+	ListSizedHeader *pHeader;
+	ListElem *pListElem;
+	ListElem *pNew;
+	unsigned char *pPayload;
+
+	if (pThis == NULL || position == NULL || *position == NULL || nSize < 0 ||
+			nSize > pThis->nMaxDataSize || (pData == NULL && nSize > 0))
+		return -1;
+
+	if (!LIST_IS_SIZED(pThis)) {
+
+		if (nSize == pThis->nMaxDataSize)
+			return pThis->pOps->SetAt(pThis, *position, pData);
+
+		/* written in place like an emplaced payload, hashed keys would go stale */
+		if (pThis->pOps->Emplace == NULL || pThis->pHash != NULL)
+			return -1;
+
+		pPayload = (unsigned char *)pThis->pOps->GetAt(pThis, *position);
+
+		if (nSize > 0)
+			memcpy(pPayload, pData, (size_t)nSize);
+		memset(pPayload + nSize, 0, (size_t)(pThis->nMaxDataSize - nSize));
+
+		return 0;
+	}
+
+	pListElem = (ListElem *)*position;
+	pHeader = SIZED_HEADER(pThis, pListElem);
+
+	/* keep the block unless it is too small or twice the class needed */
+	if ((uint32_t)nSize <= pHeader->nCapacity &&
+			CListSizedClass(SIZED_BLOCK_SIZE(pThis, nSize)) * 2 >
+			SIZED_BLOCK_SIZE(pThis, pHeader->nCapacity)) {
+
+		if (nSize > 0)
+			memcpy(pListElem->data, pData, (size_t)nSize);
+		pHeader->nSize = (uint32_t)nSize;
+
+		return 0;
+	}
+
+	pNew = CListSizedAllocElem(pThis, pData, nSize);
+
+	if (pNew == NULL)
+		return -1;
+
+	/* the new node takes the old one's links and, if it had it, the cursor */
+	pNew->prev = pListElem->prev;
+	pNew->next = pListElem->next;
+
+	if (pNew->prev != NULL)
+		pNew->prev->next = pNew;
+	else
+		pThis->pHeadNode = pNew;
+
+	if (pNew->next != NULL)
+		pNew->next->prev = pNew;
+	else
+		pThis->pTailNode = pNew;
+
+	if (pThis->pCursorNode == pListElem)
+		pThis->pCursorNode = pNew;
+
+	pThis->nLinkVersion++;
+
+	CListSizedFreeElem(pThis, pListElem);
+	*position = (POSITION)pNew;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: ListGetAtSized
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : element to read
+ * 	- pnSize : receives the payload length, may be NULL
+ *
+ * Return Value:
+ * 	- payload of the element, NULL if position is NULL
+ *
+ * Desc:
+ * 	- the length is the one the payload was stored with on sized lists,
+ * 	  nMaxDataSize on other lists
+ *
+ * --------------------------------------------------------------------------*/
+void* ListGetAtSized(struct CList *pThis, POSITION position, int *pnSize) {
+
+	if (pThis == NULL || position == NULL)
+		return NULL;
+
+	if (pnSize != NULL) {
+		if (LIST_IS_SIZED(pThis))
+			*pnSize = (int)SIZED_HEADER(pThis, (ListElem *)position)->nSize;
+		else
+			*pnSize = pThis->nMaxDataSize;
+	}
+
+	return pThis->pOps->GetAt(pThis, position);
+}
+
+/* payload bytes stored, for ListGetStats; walks the list */
+long long CListSizedPayloadBytes(struct CList *pThis) {
+
+	ListElem *pListElem;
+	long long nBytes = 0;
+
+	for (pListElem = pThis->pHeadNode; pListElem != NULL; pListElem = pListElem->next)
+		nBytes += SIZED_HEADER(pThis, pListElem)->nSize;
+
+	return nBytes;
+}
+
+static POSITION CListSizedAddHead(struct CList *pThis, const void* pData) {
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	return CListSizedLink(pThis, pData, pThis->nMaxDataSize, NULL, pThis->pHeadNode);
+}
+
+static POSITION CListSizedAddTail(struct CList *pThis, const void* pData) {
+
+	if (pThis == NULL || pData == NULL)
+		return NULL;
+
+	return CListSizedLink(pThis, pData, pThis->nMaxDataSize, pThis->pTailNode, NULL);
+}
+
+static int CListSizedRemoveHead(struct CList *pThis) {
+
+	return CListSizedRemoveAt(pThis, (POSITION)pThis->pHeadNode);
+}
+
+static int CListSizedRemoveTail(struct CList *pThis) {
+
+	return CListSizedRemoveAt(pThis, (POSITION)pThis->pTailNode);
+}
+
+static int CListSizedRemoveAll(struct CList *pThis) {
+
+	ListElem *pListElem;
+	ListElem *pNext;
+
+	if (pThis == NULL)
+		return 0;
+
+	for (pListElem = pThis->pHeadNode; pListElem != NULL; pListElem = pNext) {
+		pNext = pListElem->next;
+		CListSizedFreeElem(pThis, pListElem);
+	}
+
+	pThis->pHeadNode = NULL;
+	pThis->pTailNode = NULL;
+	pThis->pCursorNode = NULL;
+	pThis->nCount = 0;
+	pThis->nLinkVersion++;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListSizedGetNextBatch
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- position : position of the first element wanted, advanced past the
+ * 	  last one handed out (NULL at the end)
+ * 	- ppData : receives the payload pointers
+ * 	- nMax : size of ppData
+ *
+ * Return Value:
+ * 	- number of payload pointers stored, 0 at the end of the list, -1 if
+ * 	  arguments are invalid
+ *
+ * Desc:
+ * 	- CListGetNextBatch with the payload prefetch bounded by the stored
+ * 	  length instead of nMaxDataSize
+ *
+ * --------------------------------------------------------------------------*/
+static int CListSizedGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	ListElem *pListElem;
+	int nGot = 0;
+
+	if (pThis == NULL || position == NULL || ppData == NULL || nMax < 0)
+		return -1;
+
+	pListElem = (ListElem *)*position;
+
+	while (nGot < nMax && pListElem != NULL) {
+		CListPrefetchPayload(pListElem->data, SIZED_HEADER(pThis, pListElem)->nSize);
+		ppData[nGot++] = pListElem->data;
+		pListElem = pListElem->next;
+	}
+
+	if (pListElem != NULL)
+		LIST_PREFETCH(SIZED_HEADER(pThis, pListElem));
+
+	*position = (POSITION)pListElem;
+
+	return nGot;
+}
+
+static int CListSizedRemoveAt(struct CList *pThis, POSITION position) {
+
+	if (pThis == NULL || position == NULL || pThis->nCount == 0)
+		return -1;
+
+	CListUnlinkElem(pThis, (ListElem *)position);
+	CListSizedFreeElem(pThis, (ListElem *)position);
+
+	return 0;
+}
+
+/* a full-size payload, in place only: SetAt may not move the element */
+static int CListSizedSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	ListSizedHeader *pHeader;
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return -1;
+
+	pHeader = SIZED_HEADER(pThis, (ListElem *)position);
+
+	if (pHeader->nCapacity < (uint32_t)pThis->nMaxDataSize)
+		return -1;
+
+	memcpy(((ListElem *)position)->data, pData, (size_t)pThis->nMaxDataSize);
+	pHeader->nSize = (uint32_t)pThis->nMaxDataSize;
+
+	return 0;
+}
+
+static POSITION CListSizedInsertNext(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	return CListSizedLink(pThis, pData, pThis->nMaxDataSize, (ListElem *)position,
+			((ListElem *)position)->next);
+}
+
+static POSITION CListSizedInsertPrev(struct CList *pThis, POSITION position, const void* pData) {
+
+	if (pThis == NULL || position == NULL || pData == NULL)
+		return NULL;
+
+	return CListSizedLink(pThis, pData, pThis->nMaxDataSize,
+			((ListElem *)position)->prev, (ListElem *)position);
+}
+
+static void CListSizedDestroy(struct CList *pThis) {
+
+	CListSizedRemoveAll(pThis);
+}
+
+/* a full-size node, the caller may write up to nMaxDataSize bytes */
+static POSITION CListSizedEmplace(struct CList *pThis, POSITION position, int bAfter) {
+
+	ListElem *pAt = (ListElem *)position;
+
+	if (pAt == NULL)
+		return bAfter ?
+			CListSizedLink(pThis, NULL, pThis->nMaxDataSize, pThis->pTailNode, NULL) :
+			CListSizedLink(pThis, NULL, pThis->nMaxDataSize, NULL, pThis->pHeadNode);
+
+	return bAfter ?
+		CListSizedLink(pThis, NULL, pThis->nMaxDataSize, pAt, pAt->next) :
+		CListSizedLink(pThis, NULL, pThis->nMaxDataSize, pAt->prev, pAt);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListSizedClass
+ *
+ * Parameter:
+ * 	- nBlockSize : bytes a node needs, header and links included
+ *
+ * Return Value:
+ * 	- block size to allocate, nBlockSize rounded up to its size class
+ *
+ * Desc:
+ * 	- multiples of LIST_SIZED_SMALL_STEP up to LIST_SIZED_SMALL_BLOCK, then
+ * 	  LIST_SIZED_CLASS_STEPS classes between two powers of two
+ *
+ * --------------------------------------------------------------------------*/
+static size_t CListSizedClass(size_t nBlockSize) {
+
+	size_t nPower = LIST_SIZED_SMALL_BLOCK;
+	size_t nStep;
+
+	if (nBlockSize <= LIST_SIZED_SMALL_BLOCK)
+		return LIST_ALIGN_UP(nBlockSize, LIST_SIZED_SMALL_STEP);
+
+	while (nPower * 2 < nBlockSize)
+		nPower *= 2;
+
+	nStep = nPower / LIST_SIZED_CLASS_STEPS;
+
+	return LIST_ALIGN_UP(nBlockSize, nStep);
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListSizedAllocElem
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : nSize bytes copied into the new element, NULL to leave the
+ * 	          payload uninitialized
+ * 	- nSize : payload length
+ *
+ * Return Value:
+ * 	- new unlinked list element, NULL if allocation fails
+ *
+ * Desc:
+ * 	- allocate a node of the size class for nSize bytes; the room left in
+ * 	  the class is recorded as the node's capacity
+ *
+ * --------------------------------------------------------------------------*/
+static ListElem* CListSizedAllocElem(struct CList *pThis, const void* pData, int nSize) {
+
+	ListSizedHeader *pHeader;
+	ListElem *pListElem;
+	unsigned char *pBlock;
+	size_t nBlockSize = CListSizedClass(SIZED_BLOCK_SIZE(pThis, nSize));
+
+	pBlock = (unsigned char *)malloc(nBlockSize);
+
+	if (pBlock == NULL) {
+		LIST_STAT_FAIL(pThis);
+		return NULL;
+	}
+
+	LIST_STAT_ALLOC(pThis, nBlockSize);
+
+	pHeader = (ListSizedHeader *)pBlock;
+	pHeader->nSize = (uint32_t)nSize;
+	pHeader->nCapacity = (uint32_t)(nBlockSize - SIZED_BLOCK_SIZE(pThis, 0));
+
+	pListElem = (ListElem *)(pBlock + pThis->nNodeHeader);
+	pListElem->next = NULL;
+	pListElem->prev = NULL;
+
+	if (pData != NULL && nSize > 0)
+		memcpy(pListElem->data, pData, (size_t)nSize);
+
+	return pListElem;
+}
+
+static void CListSizedFreeElem(struct CList *pThis, ListElem *pListElem) {
+
+	ListSizedHeader *pHeader = SIZED_HEADER(pThis, pListElem);
+
+	LIST_STAT_FREE(pThis, SIZED_BLOCK_SIZE(pThis, pHeader->nCapacity));
+	free(pHeader);
+}
+
+/* allocate and link between pPrev and pNext, returns the new position */
+static POSITION CListSizedLink(struct CList *pThis, const void* pData, int nSize,
+		ListElem *pPrev, ListElem *pNext) {
+
+	ListElem *pListElem = CListSizedAllocElem(pThis, pData, nSize);
+
+	if (pListElem == NULL)
+		return NULL;
+
+	CListLinkElem(pThis, pListElem, pPrev, pNext);
+
+	return (POSITION)pListElem;
+}
@@ -0,0 +1,603 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * Binary snapshots (SaveList, LoadList, InitListMapped)
+ *
+ * A snapshot file is a fixed header followed by nCount payloads of
+ * nMaxDataSize bytes, back to back in list order:
+ *
+ *     [ListSnapshotHeader, nDataOffset bytes][payload 0][payload 1]...
+ *
+ * The header is written in host byte order; nByteOrder tells a reader on a
+ * host of the other order to refuse the file instead of misreading it.
+ * nVersion changes whenever the layout does, nDataOffset lets a later
+ * version grow the header without moving old readers off the payloads.
+ *
+ * LoadList maps the file and hands the payload array to ListAddTailBatch,
+ * which allocates the nodes and links them in one pass.
+ * InitListMapped does not copy at all: its read-only storage serves the
+ * payloads straight from the mapping, a POSITION being the payload's address
+ * in it.
+ * --------------------------------------------------------------------------*/
+
+#define LIST_SNAPSHOT_MAGIC			"CLST"
+#define LIST_SNAPSHOT_VERSION		1
+#define LIST_SNAPSHOT_BYTE_ORDER	0x01020304u
+
+/* payloads start on a cache line of the page aligned mapping */
+#define LIST_SNAPSHOT_DATA_OFFSET	64
+
+/* SaveList gathers payloads into writes of about this many bytes */
+#define LIST_SNAPSHOT_WRITE_BYTES	(1024 * 1024)
+
+typedef struct ListSnapshotHeader {
+
+	char		acMagic[4];
+	uint32_t	nVersion;
+	uint32_t	nByteOrder;
+	uint32_t	nMaxDataSize;
+	uint64_t	nCount;
+	uint64_t	nDataOffset;	/* file offset of payload 0 */
+
+} ListSnapshotHeader;
+
+typedef struct ListMappedStore {
+
+	void			*pMap;
+	size_t			nMapSize;
+	unsigned char	*pRecords;		/* payload 0 */
+	unsigned char	*pEnd;			/* one past the last payload */
+
+} ListMappedStore;
+
+#define MAPPED_STORE(pThis)		((ListMappedStore *)(pThis)->pStorage)
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+/* head, tail access */
+static void* CListMappedGetHead(struct CList *pThis);
+static void* CListMappedGetTail(struct CList *pThis);
+
+/* operation, refused: the list is read-only */
+static POSITION CListMappedAdd(struct CList *pThis, const void* pData);
+static int CListMappedRemove(struct CList *pThis);
+
+/* for iteration */
+static POSITION CListMappedGetHeadPosition(struct CList *pThis);
+static POSITION CListMappedGetTailPosition(struct CList *pThis);
+static void* CListMappedGetNext(struct CList *pThis, POSITION* position);
+static void* CListMappedGetPrev(struct CList *pThis, POSITION* position);
+static int CListMappedGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax);
+
+/* retrieval, modification */
+static void* CListMappedGetAt(struct CList *pThis, POSITION position);
+static int CListMappedRemoveAt(struct CList *pThis, POSITION position);
+static int CListMappedSetAt(struct CList *pThis, POSITION position, const void* pData);
+
+/* Insertion, refused */
+static POSITION CListMappedInsert(struct CList *pThis, POSITION position, const void* pData);
+
+/* Searching */
+static POSITION CListMappedFindIndex(struct CList *pThis, int nIndex);
+
+/* Status */
+static int CListMappedGetCount(struct CList *pThis);
+static int CListMappedIsEmpty(struct CList *pThis);
+
+static void CListMappedDestroy(struct CList *pThis);
+
+/* file access */
+static int CListSnapshotMap(int fd, void **ppMap, size_t *pnMapSize,
+		const ListSnapshotHeader **ppHeader);
+static int CListWriteAll(int fd, const void *pBuffer, size_t nBytes);
+
+/*--------------------------------------------------------------------------*/
+
+const CListOps g_CListMappedOps = {
+
+	/* head/tail access */
+	CListMappedGetHead,
+	CListMappedGetTail,
+
+	/* Operation */
+	CListMappedAdd,
+	CListMappedAdd,
+	CListMappedRemove,
+	CListMappedRemove,
+	CListMappedRemove,
+
+	/* for iteration */
+	CListMappedGetHeadPosition,
+	CListMappedGetTailPosition,
+	CListMappedGetNext,
+	CListMappedGetPrev,
+
+	/* Retrieval, modification */
+	CListMappedGetAt,
+	CListMappedRemoveAt,
+	CListMappedSetAt,
+
+	/* Insertion */
+	CListMappedInsert,
+	CListMappedInsert,
+
+	/* Search */
+	CListMappedFindIndex,
+
+	/* Status */
+	CListMappedGetCount,
+	CListMappedIsEmpty,
+
+	CListMappedDestroy,
+	NULL,			/* no ListEmplace* on a read-only list */
+	CListMappedGetNextBatch,
+	NULL			/* nothing is ever removed */
+};
+
+/*-----------------------------------------------------------------------------
+ * Function: SaveList
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- fd : file open for writing, positioned at the start of an empty file
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid, the list holds caller pointers
+ * 	  (InitListByRef) or payloads of different lengths (InitListSized), or
+ * 	  a write fails, else returns 0
+ *
+ * Desc: Write the list as a snapshot for LoadList and InitListMapped: a
+ *       header with nCount and nMaxDataSize, then the payloads in list
+ *       order. Payloads are gathered into large writes. The file is not
+ *       synced; callers that need it durable fsync it, or write a temporary
+ *       file and rename it over the old one.
+ *
+ * --------------------------------------------------------------------------*/
+int SaveList(struct CList *pThis, int fd) {
+
+	ListSnapshotHeader	header;
+	unsigned char		*pBuffer;
+	size_t				nSize;
+	size_t				nFill = 0;
+	size_t				nBufferSize;
+	POSITION			pos;
+	int					nResult = 0;
+
+	if (pThis == NULL || pThis->pOps == NULL || fd < 0 ||
+			pThis->pOps == &g_CListRefOps || LIST_IS_SIZED(pThis))
+		return -1;
+
+	nSize = (size_t)pThis->nMaxDataSize;
+	nBufferSize = (nSize < LIST_SNAPSHOT_WRITE_BYTES) ?
+		LIST_SNAPSHOT_WRITE_BYTES / nSize * nSize : nSize;
+
+	pBuffer = (unsigned char *)calloc(1, (nBufferSize > LIST_SNAPSHOT_DATA_OFFSET) ?
+			nBufferSize : LIST_SNAPSHOT_DATA_OFFSET);
+
+	if (pBuffer == NULL)
+		return -1;
+
+	/* the header goes out zero padded to nDataOffset */
+	memcpy(header.acMagic, LIST_SNAPSHOT_MAGIC, sizeof(header.acMagic));
+	header.nVersion = LIST_SNAPSHOT_VERSION;
+	header.nByteOrder = LIST_SNAPSHOT_BYTE_ORDER;
+	header.nMaxDataSize = (uint32_t)pThis->nMaxDataSize;
+	header.nCount = (uint64_t)pThis->nCount;
+	header.nDataOffset = LIST_SNAPSHOT_DATA_OFFSET;
+	memcpy(pBuffer, &header, sizeof(header));
+
+	if (CListWriteAll(fd, pBuffer, LIST_SNAPSHOT_DATA_OFFSET) != 0) {
+		free(pBuffer);
+		return -1;
+	}
+
+	pos = ListGetHeadPosition(pThis);
+
+	while (pos != NULL) {
+
+		memcpy(pBuffer + nFill, ListGetNext(pThis, &pos), nSize);
+		nFill += nSize;
+
+		if (nFill == nBufferSize || pos == NULL) {
+			if (CListWriteAll(fd, pBuffer, nFill) != 0) {
+				nResult = -1;
+				break;
+			}
+			nFill = 0;
+		}
+	}
+
+	free(pBuffer);
+
+	return nResult;
+}
+/*-----------------------------------------------------------------------------
+ * Function: LoadList
+ *
+ * Parameter:
+ * 	- pThis : initialized list with the snapshot's nMaxDataSize
+ * 	- fd : snapshot file written by SaveList, open for reading
+ *
+ * Return Value:
+ * 	- Return -1 if the file is not a valid snapshot, its payload size
+ * 	  differs from the list's, or allocation fails, else returns 0
+ *
+ * Desc: Append a snapshot's payloads to the list tail. The file is mapped
+ *       and read sequentially, and the payloads go to ListAddTailBatch in
+ *       one call, linked in one pass; a list of InitListWithCapacity takes
+ *       all of its nodes from a single slab of its pool.
+ *       Lists with a rank or hash index keep it up to date. On failure a
+ *       node list is left as it was. fd may be closed afterwards.
+ *
+ * --------------------------------------------------------------------------*/
+int LoadList(struct CList *pThis, int fd) {
+
+	const ListSnapshotHeader	*pHeader;
+	void		*pMap;
+	size_t		nMapSize;
+	int			nResult = 0;
+
+	if (pThis == NULL || pThis->pOps == NULL || pThis->pOps == &g_CListRefOps)
+		return -1;
+
+	if (CListSnapshotMap(fd, &pMap, &nMapSize, &pHeader) != 0)
+		return -1;
+
+	if (pHeader->nMaxDataSize != (uint32_t)pThis->nMaxDataSize ||
+			pHeader->nCount > (uint64_t)(INT_MAX - pThis->nCount)) {
+		nResult = -1;
+	}
+	else if (pHeader->nCount > 0) {
+
+		posix_madvise(pMap, nMapSize, POSIX_MADV_SEQUENTIAL);
+
+		if (ListAddTailBatch(pThis, (const unsigned char *)pMap + pHeader->nDataOffset,
+				(int)pHeader->nCount) == NULL)
+			nResult = -1;
+	}
+
+	munmap(pMap, nMapSize);
+
+	return nResult;
+}
+/*-----------------------------------------------------------------------------
+ * Function: InitListMapped
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- fd : snapshot file written by SaveList, open for reading
+ *
+ * Return Value:
+ * 	- Return -1 if the file is not a valid snapshot or can not be mapped,
+ * 	  else returns 0
+ *
+ * Desc: Initialize list instance as a read-only view of a snapshot:
+ *       nMaxDataSize and the elements come from the file and the payloads
+ *       are read in place from the mapping, nothing is copied or allocated
+ *       per element. FindIndex is O(1). Adding, removing, SetAt and moving
+ *       elements in or out (ListSplice, ListMerge, ...) fail. Payloads are
+ *       aligned as in an array of them, on top of a 64 byte aligned start.
+ *
+ *       fd may be closed afterwards; the mapping lasts until DestroyList.
+ *       The file must not be truncated or rewritten in the meantime.
+ *
+ * --------------------------------------------------------------------------*/
+int InitListMapped(struct CList *pThis, int fd) {
+
+	const ListSnapshotHeader	*pHeader;
+	ListMappedStore	*pStore;
+	void		*pMap;
+	size_t		nMapSize;
+
+	if (pThis == NULL)
+		return -1;
+
+	if (CListSnapshotMap(fd, &pMap, &nMapSize, &pHeader) != 0)
+		return -1;
+
+	pStore = (ListMappedStore *)malloc(sizeof(ListMappedStore));
+
+	if (pStore == NULL || pHeader->nCount > INT_MAX ||
+			pHeader->nMaxDataSize > INT_MAX) {
+		free(pStore);
+		munmap(pMap, nMapSize);
+		return -1;
+	}
+
+	pStore->pMap = pMap;
+	pStore->nMapSize = nMapSize;
+	pStore->pRecords = (unsigned char *)pMap + pHeader->nDataOffset;
+	pStore->pEnd = pStore->pRecords + pHeader->nCount * pHeader->nMaxDataSize;
+
+	InitList(pThis, (int)pHeader->nMaxDataSize);
+
+	pThis->nCount = (int)pHeader->nCount;
+	pThis->pStorage = pStore;
+	CListBindOps(pThis, &g_CListMappedOps);
+
+	LIST_STAT_ALLOC(pThis, nMapSize);
+	LIST_STAT_COUNT(pThis);
+
+	return 0;
+}
+
+static void* CListMappedGetHead(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return MAPPED_STORE(pThis)->pRecords;
+}
+
+static void* CListMappedGetTail(struct CList *pThis) {
+
+	if (pThis == NULL || pThis->nCount == 0)
+		return NULL;
+
+	return MAPPED_STORE(pThis)->pEnd - pThis->nMaxDataSize;
+}
+
+static POSITION CListMappedAdd(struct CList *pThis, const void* pData) {
+
+	(void)pThis;
+	(void)pData;
+
+	return NULL;
+}
+
+static int CListMappedRemove(struct CList *pThis) {
+
+	(void)pThis;
+
+	return -1;
+}
+
+static POSITION CListMappedGetHeadPosition(struct CList *pThis) {
+
+	return (POSITION)CListMappedGetHead(pThis);
+}
+
+static POSITION CListMappedGetTailPosition(struct CList *pThis) {
+
+	return (POSITION)CListMappedGetTail(pThis);
+}
+
+static void* CListMappedGetNext(struct CList *pThis, POSITION* position) {
+
+	unsigned char *pRecord;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pRecord = (unsigned char *)*position;
+
+	if (pRecord + pThis->nMaxDataSize == MAPPED_STORE(pThis)->pEnd)
+		*position = NULL;
+	else
+		*position = (POSITION)(pRecord + pThis->nMaxDataSize);
+
+	return pRecord;
+}
+
+/* the records are one array, a batch is a run of it */
+static int CListMappedGetNextBatch(struct CList *pThis, POSITION* position, void** ppData, int nMax) {
+
+	unsigned char *pRecord;
+	unsigned char *pEnd;
+	int nGot;
+
+	if (pThis == NULL || position == NULL || ppData == NULL || nMax < 0)
+		return -1;
+
+	if (*position == NULL)
+		return 0;
+
+	pRecord = (unsigned char *)*position;
+	pEnd = MAPPED_STORE(pThis)->pEnd;
+
+	for (nGot = 0; nGot < nMax && pRecord != pEnd; nGot++) {
+		ppData[nGot] = pRecord;
+		pRecord += pThis->nMaxDataSize;
+	}
+
+	*position = (pRecord == pEnd) ? NULL : (POSITION)pRecord;
+
+	return nGot;
+}
+
+static void* CListMappedGetPrev(struct CList *pThis, POSITION* position) {
+
+	unsigned char *pRecord;
+
+	if (pThis == NULL || position == NULL || *position == NULL)
+		return NULL;
+
+	pRecord = (unsigned char *)*position;
+
+	if (pRecord == MAPPED_STORE(pThis)->pRecords)
+		*position = NULL;
+	else
+		*position = (POSITION)(pRecord - pThis->nMaxDataSize);
+
+	return pRecord;
+}
+
+static void* CListMappedGetAt(struct CList *pThis, POSITION position) {
+
+	(void)pThis;
+
+	return (void *)position;
+}
+
+static int CListMappedRemoveAt(struct CList *pThis, POSITION position) {
+
+	(void)pThis;
+	(void)position;
+
+	return -1;
+}
+
+static int CListMappedSetAt(struct CList *pThis, POSITION position, const void* pData) {
+
+	(void)pThis;
+	(void)position;
+	(void)pData;
+
+	return -1;
+}
+
+static POSITION CListMappedInsert(struct CList *pThis, POSITION position, const void* pData) {
+
+	(void)pThis;
+	(void)position;
+	(void)pData;
+
+	return NULL;
+}
+
+static POSITION CListMappedFindIndex(struct CList *pThis, int nIndex) {
+
+	if (pThis == NULL || nIndex < 0 || nIndex >= pThis->nCount)
+		return NULL;
+
+	return (POSITION)(MAPPED_STORE(pThis)->pRecords +
+			(size_t)nIndex * pThis->nMaxDataSize);
+}
+
+static int CListMappedGetCount(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return pThis->nCount;
+}
+
+static int CListMappedIsEmpty(struct CList *pThis) {
+
+	if (pThis == NULL)
+		return 0;
+
+	return (pThis->nCount != 0) ? 1 : 0;
+}
+
+static void CListMappedDestroy(struct CList *pThis) {
+
+	ListMappedStore *pStore = MAPPED_STORE(pThis);
+
+	if (pStore != NULL) {
+		LIST_STAT_FREE(pThis, pStore->nMapSize);
+		munmap(pStore->pMap, pStore->nMapSize);
+	}
+
+	free(pStore);
+	pThis->pStorage = NULL;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListSnapshotMap
+ *
+ * Parameter:
+ * 	- fd : file to map
+ * 	- ppMap, pnMapSize : receive the read-only mapping of the whole file
+ * 	- ppHeader : receives the snapshot header at the start of the mapping
+ *
+ * Return Value:
+ * 	- Return -1 if the file can not be mapped or is not a snapshot this
+ * 	  version reads, else returns 0
+ *
+ * Desc:
+ * 	- map the file and check the header, including that every payload it
+ * 	  announces lies inside the file
+ *
+ * --------------------------------------------------------------------------*/
+static int CListSnapshotMap(int fd, void **ppMap, size_t *pnMapSize,
+		const ListSnapshotHeader **ppHeader) {
+
+	const ListSnapshotHeader *pHeader;
+	struct stat	st;
+	void		*pMap;
+	size_t		nMapSize;
+	uint64_t	nDataSize;
+
+	if (fd < 0 || fstat(fd, &st) != 0 ||
+			st.st_size < (off_t)sizeof(ListSnapshotHeader) ||
+			(uint64_t)st.st_size > SIZE_MAX)
+		return -1;
+
+	nMapSize = (size_t)st.st_size;
+	pMap = mmap(NULL, nMapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (pMap == MAP_FAILED)
+		return -1;
+
+	pHeader = (const ListSnapshotHeader *)pMap;
+
+	if (memcmp(pHeader->acMagic, LIST_SNAPSHOT_MAGIC, sizeof(pHeader->acMagic)) != 0 ||
+			pHeader->nVersion != LIST_SNAPSHOT_VERSION ||
+			pHeader->nByteOrder != LIST_SNAPSHOT_BYTE_ORDER ||
+			pHeader->nMaxDataSize == 0 ||
+			pHeader->nDataOffset < sizeof(ListSnapshotHeader) ||
+			pHeader->nDataOffset > nMapSize) {
+		munmap(pMap, nMapSize);
+		return -1;
+	}
+
+	/* nCount * nMaxDataSize must not overflow on the way to the size check */
+	nDataSize = nMapSize - pHeader->nDataOffset;
+
+	if (pHeader->nCount > nDataSize / pHeader->nMaxDataSize) {
+		munmap(pMap, nMapSize);
+		return -1;
+	}
+
+	*ppMap = pMap;
+	*pnMapSize = nMapSize;
+	*ppHeader = pHeader;
+
+	return 0;
+}
+/*-----------------------------------------------------------------------------
+ * Function: CListWriteAll
+ *
+ * Parameter:
+ * 	- fd : file open for writing
+ * 	- pBuffer, nBytes : bytes to write
+ *
+ * Return Value:
+ * 	- Return -1 if a write fails, else returns 0
+ *
+ * Desc:
+ * 	- write all of the buffer, resuming after short writes and signals
+ *
+ * --------------------------------------------------------------------------*/
+static int CListWriteAll(int fd, const void *pBuffer, size_t nBytes) {
+
+	const unsigned char *pBytes = (const unsigned char *)pBuffer;
+	ssize_t nWritten;
+
+	while (nBytes > 0) {
+
+		nWritten = write(fd, pBytes, nBytes);
+
+		if (nWritten < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		pBytes += nWritten;
+		nBytes -= (size_t)nWritten;
+	}
+
+	return 0;
+}
@@ -0,0 +1,607 @@
+#include <string.h>
+#include <threads.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * Sorting and sorted insertion
+ *
+ * Node lists are sorted by relinking: the elements are detached as a chain
+ * through next, merge sorted bottom-up and then given their prev links back.
+ * No node is allocated, copied or moved in memory, so every POSITION stays
+ * valid and keeps its payload. Merging takes from the earlier run on ties,
+ * which makes the sort stable.
+ *
+ * Other storages keep payloads in arrays; they sort a table of payload
+ * pointers the same way and write the payloads back in order, which needs
+ * a temporary copy of the elements.
+ * --------------------------------------------------------------------------*/
+
+/* pending runs of the bottom-up sort, run i holds 2^i elements */
+#define LIST_SORT_MAX_RUNS			32
+
+/* ListSortParallel sorts shorter lists on the calling thread */
+#define LIST_SORT_PARALLEL_MIN		16384
+#define LIST_SORT_MAX_THREADS		64
+
+/* one run sorted or merged by a ListSortParallel worker */
+typedef struct ListSortTask {
+
+	ListElem		*pHead;
+	ListElem		*pOther;		/* run following pHead, may be NULL */
+	int				bMerge;			/* merge pOther into pHead, else sort */
+	CListCompareFn	cmp;
+	int				bRef;
+
+} ListSortTask;
+
+/*-----------------------------------------------------------------------------
+ * static function declaration
+ * --------------------------------------------------------------------------*/
+static ListElem* CListSortChain(ListElem *pHead, CListCompareFn cmp, int bRef);
+static ListElem* CListMergeChains(ListElem *pA, ListElem *pB, CListCompareFn cmp,
+		int bRef);
+static void CListRelinkChain(struct CList *pThis, ListElem *pHead);
+static int CListSortTaskRun(void *pArg);
+static void CListSortRound(ListSortTask *pTasks, int nTasks);
+static int CListSortCopies(struct CList *pThis, CListCompareFn cmp);
+static void CListSortPointers(const void **ppItems, const void **ppTemp, int nItems,
+		CListCompareFn cmp);
+static POSITION CListFindSortedIndexed(struct CList *pThis, const void* pData,
+		CListCompareFn cmp);
+
+/*--------------------------------------------------------------------------*/
+
+/* what cmp is given for a node: the payload, or the pointer stored in it */
+static inline const void* CListSortKey(const ListElem *pListElem, int bRef) {
+
+	return bRef ? *(void * const *)pListElem->data : (const void *)pListElem->data;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListSort
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- cmp : payload comparator, negative / 0 / positive like qsort's
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid or a temporary copy can not be
+ * 	  allocated, else returns 0
+ *
+ * Desc: Stable sort in ascending cmp order. Node lists are merge sorted
+ *       bottom-up by relinking their nodes: O(n log n) compares, no
+ *       allocation, and POSITIONs keep their elements; so are sized
+ *       lists. An index is rebuilt in O(n). Other storages sort through a
+ *       temporary copy and their POSITIONs then hold other elements.
+ *
+ * --------------------------------------------------------------------------*/
+int ListSort(struct CList *pThis, CListCompareFn cmp) {
+
+	if (pThis == NULL || cmp == NULL)
+		return -1;
+
+	if (pThis->nCount < 2)
+		return 0;
+
+	/* sized lists are node chains too, copies would cut their payloads */
+	if (!LIST_IS_NODE_LINKED(pThis) && !LIST_IS_SIZED(pThis))
+		return CListSortCopies(pThis, cmp);
+
+	pThis->pTailNode->next = NULL;
+	CListRelinkChain(pThis, CListSortChain(pThis->pHeadNode, cmp,
+			pThis->pOps == &g_CListRefOps));
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListSortParallel
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- cmp : payload comparator, called from several threads at once
+ * 	- nThreads : threads to use, the calling one included
+ *
+ * Return Value:
+ * 	- Return -1 if arguments are invalid, else returns 0
+ *
+ * Desc: ListSort for long node lists on several threads. The chain is cut
+ *       into nThreads runs of equal length that are sorted concurrently,
+ *       then merged pairwise, each round of merges again in parallel. The
+ *       result is the same stable order as ListSort. Lists shorter than
+ *       LIST_SORT_PARALLEL_MIN elements and other storages are sorted by
+ *       ListSort; a task whose thread can not be started runs on the
+ *       calling thread.
+ *
+ * --------------------------------------------------------------------------*/
+int ListSortParallel(struct CList *pThis, CListCompareFn cmp, int nThreads) {
+
+	ListSortTask	aTasks[LIST_SORT_MAX_THREADS];
+	ListElem		*pListElem;
+	ListElem		*pNext;
+	int				nRuns;
+	int				nRunLength;
+	int				nTasks;
+	int				i;
+	int				j;
+
+	if (pThis == NULL || cmp == NULL)
+		return -1;
+
+	if (nThreads > LIST_SORT_MAX_THREADS)
+		nThreads = LIST_SORT_MAX_THREADS;
+
+	if (nThreads < 2 || pThis->nCount < LIST_SORT_PARALLEL_MIN ||
+			!LIST_IS_NODE_LINKED(pThis))
+		return ListSort(pThis, cmp);
+
+	/* cut the chain into nThreads runs, the last one takes the remainder */
+	nRuns = nThreads;
+	nRunLength = pThis->nCount / nRuns;
+	pListElem = pThis->pHeadNode;
+	pThis->pTailNode->next = NULL;
+
+	for (i = 0; i < nRuns; i++) {
+		aTasks[i].pHead = pListElem;
+		aTasks[i].pOther = NULL;
+		aTasks[i].bMerge = 0;
+		aTasks[i].cmp = cmp;
+		aTasks[i].bRef = (pThis->pOps == &g_CListRefOps);
+
+		if (i == nRuns - 1)
+			break;
+
+		for (j = 1; j < nRunLength; j++)
+			pListElem = pListElem->next;
+
+		pNext = pListElem->next;
+		pListElem->next = NULL;
+		pListElem = pNext;
+	}
+
+	CListSortRound(aTasks, nRuns);
+
+	/* merge neighbouring runs until one is left */
+	while (nRuns > 1) {
+		nTasks = (nRuns + 1) / 2;
+		for (i = 0; i < nTasks; i++) {
+			aTasks[i].pHead = aTasks[2 * i].pHead;
+			aTasks[i].pOther = (2 * i + 1 < nRuns) ? aTasks[2 * i + 1].pHead : NULL;
+			aTasks[i].bMerge = 1;
+		}
+		CListSortRound(aTasks, nTasks);
+		nRuns = nTasks;
+	}
+
+	CListRelinkChain(pThis, aTasks[0].pHead);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListInsertSorted
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pData : data insert to list
+ * 	- cmp : payload comparator the list is sorted by
+ *
+ * Return Value:
+ * 	- position of the new element, NULL if arguments are invalid or
+ * 	  allocation fails
+ *
+ * Desc: Insert pData after the last element that does not compare greater,
+ *       so the list stays sorted and equal elements keep insertion order.
+ *       The search walks back from the tail, which is O(1) for input that
+ *       arrives mostly in order; lists with ListEnableIndex binary search
+ *       in O(log^2 n) instead.
+ *
+ * --------------------------------------------------------------------------*/
+POSITION ListInsertSorted(struct CList *pThis, const void* pData, CListCompareFn cmp) {
+
+	POSITION	pos;
+	POSITION	posAt;
+	const void	*pItem;
+
+	if (pThis == NULL || pData == NULL || cmp == NULL)
+		return NULL;
+
+	posAt = NULL;
+
+	if (pThis->pIndex != NULL && pThis->nCount > LIST_INDEX_WALK_LIMIT) {
+		posAt = CListFindSortedIndexed(pThis, pData, cmp);
+	}
+	else {
+		pos = pThis->pOps->GetTailPosition(pThis);
+		while (pos != NULL) {
+			posAt = pos;
+			pItem = pThis->pOps->GetPrev(pThis, &pos);
+			if (cmp(pItem, pData) <= 0)
+				break;
+			posAt = NULL;
+		}
+	}
+
+	if (posAt == NULL)
+		return pThis->pOps->AddHead(pThis, pData);
+
+	return pThis->pOps->InsertNext(pThis, posAt, pData);
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListMerge
+ *
+ * Parameter:
+ * 	- pDst : sorted list receiving the elements
+ * 	- pSrc : another list sorted by cmp, empty afterwards
+ * 	- cmp : payload comparator both lists are sorted by
+ *
+ * Return Value:
+ * 	- number of elements moved from pSrc
+ * 	- Return -1 if arguments are invalid, the lists hold different data
+ * 	  sizes, either list is read-only (InitListMapped) or pSrc is a sized
+ * 	  list (InitListSized). A failed allocation while copying also
+ * 	  returns -1; elements moved until then stay in pDst.
+ *
+ * Desc: Merge pSrc into pDst, keeping pDst sorted; on ties pDst's elements
+ *       come first. Node lists with the same node layout and allocator
+ *       and neither a pool nor a hash index are merged in one pass by
+ *       relinking, O(n + m) with no allocation. Otherwise each pSrc
+ *       element is inserted at its place in pDst and removed from pSrc.
+ *
+ * --------------------------------------------------------------------------*/
+int ListMerge(struct CList *pDst, struct CList *pSrc, CListCompareFn cmp) {
+
+	POSITION	pos;
+	POSITION	posAt;
+	const void	*pData;
+	int			nItems;
+	int			i;
+
+	if (pDst == NULL || pSrc == NULL || pDst == pSrc || cmp == NULL ||
+			pDst->nMaxDataSize != pSrc->nMaxDataSize)
+		return -1;
+
+	/* a copy would store the payload address in place of the pointer, or
+	 * read past the end of a sized payload */
+	if ((pDst->pOps == &g_CListRefOps) != (pSrc->pOps == &g_CListRefOps) ||
+			LIST_IS_SIZED(pSrc))
+		return -1;
+
+	if (LIST_IS_READ_ONLY(pDst) || LIST_IS_READ_ONLY(pSrc))
+		return -1;
+
+	nItems = pSrc->nCount;
+
+	if (nItems == 0)
+		return 0;
+
+	if (LIST_IS_NODE_LINKED(pDst) && LIST_IS_NODE_LINKED(pSrc) &&
+			pDst->nNodeHeader == pSrc->nNodeHeader &&
+			pDst->pPool == NULL && LIST_SAME_ALLOCATOR(pDst, pSrc) &&
+			pDst->pHash == NULL && pSrc->pHash == NULL) {
+
+		if (pDst->nCount > 0)
+			pDst->pTailNode->next = NULL;
+		pSrc->pTailNode->next = NULL;
+
+		pDst->nCount += nItems;
+		CListRelinkChain(pDst, CListMergeChains(pDst->pHeadNode, pSrc->pHeadNode,
+				cmp, pDst->pOps == &g_CListRefOps));
+		LIST_STAT_COUNT(pDst);
+		LIST_STAT_MOVE(pDst, pSrc, (size_t)nItems *
+				(pSrc->nNodeHeader + LIST_ELEM_SIZE(pSrc->nMaxDataSize)));
+
+		pSrc->nCount = 0;
+		pSrc->pHeadNode = NULL;
+		pSrc->pTailNode = NULL;
+		pSrc->pCursorNode = NULL;
+		pSrc->nLinkVersion++;
+		if (pSrc->pIndex != NULL)
+			pSrc->pIndex->pRoot = NULL;
+
+		return nItems;
+	}
+
+	/* pos walks pDst and only moves forward, so the merge stays linear */
+	pos = pDst->pOps->GetHeadPosition(pDst);
+
+	for (i = 0; i < nItems; i++) {
+
+		pData = pSrc->pOps->GetHead(pSrc);
+
+		posAt = NULL;
+		while (pos != NULL) {
+			posAt = pos;
+			if (cmp(pDst->pOps->GetNext(pDst, &pos), pData) > 0)
+				break;
+			posAt = NULL;
+		}
+
+		if (posAt == NULL)
+			posAt = pDst->pOps->AddTail(pDst, pData);
+		else
+			posAt = pDst->pOps->InsertPrev(pDst, posAt, pData);
+
+		if (posAt == NULL)
+			return -1;
+
+		/* inserts may move payloads; continue behind the new element */
+		pos = posAt;
+		pDst->pOps->GetNext(pDst, &pos);
+
+		if (pSrc->pOps->RemoveHead(pSrc) != 0)
+			return -1;
+	}
+
+	return nItems;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListSortChain
+ *
+ * Parameter:
+ * 	- pHead : NULL terminated chain of nodes linked through next
+ * 	- cmp : payload comparator
+ * 	- bRef : nodes hold caller pointers (InitListByRef)
+ *
+ * Return Value:
+ * 	- head of the sorted chain, prev links are not maintained
+ *
+ * Desc:
+ * 	- bottom-up merge sort: every node starts as a run of one; run i holds
+ * 	  2^i nodes and two runs of equal size are merged as soon as both
+ * 	  exist, like a binary counter. Runs are merged while they are still
+ * 	  likely in cache, and no recursion or allocation is needed.
+ *
+ * --------------------------------------------------------------------------*/
+static ListElem* CListSortChain(ListElem *pHead, CListCompareFn cmp, int bRef) {
+
+	ListElem	*apRuns[LIST_SORT_MAX_RUNS];
+	ListElem	*pRun;
+	ListElem	*pNext;
+	int			nMaxRun = 0;
+	int			i;
+
+	while (pHead != NULL) {
+
+		pNext = pHead->next;
+		pHead->next = NULL;
+		pRun = pHead;
+
+		/* earlier elements are in the pending run, keep them first */
+		for (i = 0; i < nMaxRun && apRuns[i] != NULL; i++) {
+			pRun = CListMergeChains(apRuns[i], pRun, cmp, bRef);
+			apRuns[i] = NULL;
+		}
+
+		if (i == nMaxRun)
+			nMaxRun++;
+
+		apRuns[i] = pRun;
+		pHead = pNext;
+	}
+
+	/* higher runs hold the earlier elements */
+	pRun = NULL;
+	for (i = 0; i < nMaxRun; i++) {
+		if (apRuns[i] != NULL)
+			pRun = (pRun != NULL) ? CListMergeChains(apRuns[i], pRun, cmp, bRef) : apRuns[i];
+	}
+
+	return pRun;
+}
+
+/* merge two sorted chains, taking from pA on ties */
+static ListElem* CListMergeChains(ListElem *pA, ListElem *pB, CListCompareFn cmp,
+		int bRef) {
+
+	ListElem	head;
+	ListElem	*pTail = &head;
+
+	while (pA != NULL && pB != NULL) {
+		if (cmp(CListSortKey(pB, bRef), CListSortKey(pA, bRef)) < 0) {
+			pTail->next = pB;
+			pB = pB->next;
+		}
+		else {
+			pTail->next = pA;
+			pA = pA->next;
+		}
+		pTail = pTail->next;
+	}
+
+	pTail->next = (pA != NULL) ? pA : pB;
+
+	return head.next;
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListRelinkChain
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer, nCount already covers the chain
+ * 	- pHead : reordered chain of all list nodes, linked through next
+ *
+ * Return Value:
+ *
+ * Desc:
+ * 	- restore prev links, head and tail, and rebuild what depends on the
+ * 	  order: the FindIndex cursor and the index
+ *
+ * --------------------------------------------------------------------------*/
+static void CListRelinkChain(struct CList *pThis, ListElem *pHead) {
+
+	ListElem *pListElem;
+	ListElem *pPrev = NULL;
+
+	for (pListElem = pHead; pListElem != NULL; pListElem = pListElem->next) {
+		pListElem->prev = pPrev;
+		pPrev = pListElem;
+	}
+
+	pThis->pHeadNode = pHead;
+	pThis->pTailNode = pPrev;
+	pThis->pCursorNode = NULL;
+	pThis->nLinkVersion++;
+
+	if (pThis->pIndex != NULL)
+		CListIndexBuild(pThis->pIndex, pHead);
+}
+
+static int CListSortTaskRun(void *pArg) {
+
+	ListSortTask *pTask = (ListSortTask *)pArg;
+
+	if (!pTask->bMerge)
+		pTask->pHead = CListSortChain(pTask->pHead, pTask->cmp, pTask->bRef);
+	else if (pTask->pOther != NULL)
+		pTask->pHead = CListMergeChains(pTask->pHead, pTask->pOther, pTask->cmp, pTask->bRef);
+
+	return 0;
+}
+
+/* run the tasks, 1 .. nTasks - 1 on new threads and task 0 on this one */
+static void CListSortRound(ListSortTask *pTasks, int nTasks) {
+
+	thrd_t	aThreads[LIST_SORT_MAX_THREADS];
+	int		abStarted[LIST_SORT_MAX_THREADS];
+	int		i;
+
+	for (i = 1; i < nTasks; i++)
+		abStarted[i] = (thrd_create(&aThreads[i], CListSortTaskRun, &pTasks[i]) == thrd_success);
+
+	CListSortTaskRun(&pTasks[0]);
+
+	for (i = 1; i < nTasks; i++) {
+		if (abStarted[i])
+			thrd_join(aThreads[i], NULL);
+		else
+			CListSortTaskRun(&pTasks[i]);
+	}
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: CListSortCopies
+ *
+ * Parameter:
+ * 	- pThis : list with storage other than nodes
+ * 	- cmp : payload comparator
+ *
+ * Return Value:
+ * 	- Return -1 if the temporary tables can not be allocated or the
+ * 	  storage refuses SetAt, else 0
+ *
+ * Desc:
+ * 	- sort pointers to the payloads, copy the payloads out in sorted order
+ * 	  and write them back along the list
+ *
+ * --------------------------------------------------------------------------*/
+static int CListSortCopies(struct CList *pThis, CListCompareFn cmp) {
+
+	size_t			nSize = (size_t)pThis->nMaxDataSize;
+	int				nItems = pThis->nCount;
+	const void		**ppItems;
+	unsigned char	*pCopy;
+	POSITION		pos;
+	POSITION		posAt;
+	int				i;
+
+	ppItems = (const void **)malloc(sizeof(void *) * 2 * (size_t)nItems);
+	pCopy = (unsigned char *)malloc(nSize * (size_t)nItems);
+
+	if (ppItems == NULL || pCopy == NULL) {
+		free(ppItems);
+		free(pCopy);
+		return -1;
+	}
+
+	pos = pThis->pOps->GetHeadPosition(pThis);
+	for (i = 0; i < nItems; i++)
+		ppItems[i] = pThis->pOps->GetNext(pThis, &pos);
+
+	CListSortPointers(ppItems, ppItems + nItems, nItems, cmp);
+
+	for (i = 0; i < nItems; i++)
+		memcpy(pCopy + (size_t)i * nSize, ppItems[i], nSize);
+
+	pos = pThis->pOps->GetHeadPosition(pThis);
+	for (i = 0; i < nItems; i++) {
+		posAt = pos;
+		pThis->pOps->GetNext(pThis, &pos);
+		/* a read-only list refuses the first write already */
+		if (pThis->pOps->SetAt(pThis, posAt, pCopy + (size_t)i * nSize) != 0)
+			break;
+	}
+
+	free(ppItems);
+	free(pCopy);
+
+	return (i == nItems) ? 0 : -1;
+}
+
+/* stable bottom-up merge sort of nItems pointers, ppTemp has room for as
+ * many */
+static void CListSortPointers(const void **ppItems, const void **ppTemp, int nItems,
+		CListCompareFn cmp) {
+
+	const void	**ppFrom = ppItems;
+	const void	**ppTo = ppTemp;
+	const void	**ppSwap;
+	int			nWidth;
+	int			nLeft;
+	int			nMid;
+	int			nRight;
+	int			a;
+	int			b;
+	int			k;
+
+	for (nWidth = 1; nWidth < nItems; nWidth *= 2) {
+
+		for (nLeft = 0; nLeft < nItems; nLeft += 2 * nWidth) {
+
+			nMid = (nLeft + nWidth < nItems) ? nLeft + nWidth : nItems;
+			nRight = (nMid + nWidth < nItems) ? nMid + nWidth : nItems;
+
+			for (a = nLeft, b = nMid, k = nLeft; k < nRight; k++) {
+				if (a < nMid && (b >= nRight || cmp(ppFrom[b], ppFrom[a]) >= 0))
+					ppTo[k] = ppFrom[a++];
+				else
+					ppTo[k] = ppFrom[b++];
+			}
+		}
+
+		ppSwap = ppFrom;
+		ppFrom = ppTo;
+		ppTo = ppSwap;
+	}
+
+	if (ppFrom != ppItems)
+		memcpy(ppItems, ppFrom, sizeof(void *) * (size_t)nItems);
+}
+
+/* last element of an indexed node list not greater than pData, NULL if
+ * every element is greater */
+static POSITION CListFindSortedIndexed(struct CList *pThis, const void* pData,
+		CListCompareFn cmp) {
+
+	int bRef = (pThis->pOps == &g_CListRefOps);
+	int nLow = 0;
+	int nHigh = pThis->nCount;
+	int nMid;
+
+	/* first index whose element compares greater */
+	while (nLow < nHigh) {
+		nMid = nLow + (nHigh - nLow) / 2;
+		if (cmp(CListSortKey(CListIndexFind(pThis->pIndex, nMid), bRef), pData) <= 0)
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	if (nLow == 0)
+		return NULL;
+
+	return (POSITION)CListIndexFind(pThis->pIndex, nLow - 1);
+}
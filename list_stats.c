@@ -0,0 +1,216 @@
+#include <stdatomic.h>
+#include <string.h>
+
+#include "list_internal.h"
+
+/*-----------------------------------------------------------------------------
+ * Statistics (CLIST_STATS)
+ *
+ * Every list keeps its own counters in pThis->stats, updated without
+ * synchronization like the rest of the list. The process wide totals are
+ * relaxed atomics so lists used on different threads can share them; they
+ * are only read for reporting. nPayloadBytes and nNodeBytes are computed
+ * from nCount when a list is queried, so there is nothing to total for
+ * them across lists.
+ *
+ * Without CLIST_STATS this file only provides the queries, which report
+ * that nothing was counted.
+ * --------------------------------------------------------------------------*/
+
+#ifdef CLIST_STATS
+
+static atomic_ullong	g_nListStatAllocs;
+static atomic_ullong	g_nListStatFrees;
+static atomic_ullong	g_nListStatFailedAllocs;
+static atomic_llong		g_nListStatHeldBytes;
+static atomic_int		g_nListStatPeakCount;
+static atomic_ullong	g_nListStatFindIndexSteps;
+
+void CListStatAlloc(struct CList *pThis, size_t nBytes) {
+
+	pThis->stats.nAllocs++;
+	pThis->stats.nHeldBytes += (long long)nBytes;
+
+	atomic_fetch_add_explicit(&g_nListStatAllocs, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&g_nListStatHeldBytes, (long long)nBytes,
+			memory_order_relaxed);
+}
+
+void CListStatFree(struct CList *pThis, size_t nBytes) {
+
+	pThis->stats.nFrees++;
+	pThis->stats.nHeldBytes -= (long long)nBytes;
+
+	atomic_fetch_add_explicit(&g_nListStatFrees, 1, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&g_nListStatHeldBytes, (long long)nBytes,
+			memory_order_relaxed);
+}
+
+/* nBlocks allocations of nBytes in all, released together */
+void CListStatFreeBlocks(struct CList *pThis, int nBlocks, size_t nBytes) {
+
+	pThis->stats.nFrees += (unsigned long long)nBlocks;
+	pThis->stats.nHeldBytes -= (long long)nBytes;
+
+	atomic_fetch_add_explicit(&g_nListStatFrees, (unsigned long long)nBlocks,
+			memory_order_relaxed);
+	atomic_fetch_sub_explicit(&g_nListStatHeldBytes, (long long)nBytes,
+			memory_order_relaxed);
+}
+
+void CListStatFail(struct CList *pThis) {
+
+	pThis->stats.nFailedAllocs++;
+
+	atomic_fetch_add_explicit(&g_nListStatFailedAllocs, 1, memory_order_relaxed);
+}
+
+void CListStatPeak(struct CList *pThis) {
+
+	int nPeak = atomic_load_explicit(&g_nListStatPeakCount, memory_order_relaxed);
+
+	pThis->stats.nPeakCount = pThis->nCount;
+
+	while (nPeak < pThis->nCount &&
+			!atomic_compare_exchange_weak_explicit(&g_nListStatPeakCount, &nPeak,
+				pThis->nCount, memory_order_relaxed, memory_order_relaxed))
+		;
+}
+
+void CListStatSteps(struct CList *pThis, int nSteps) {
+
+	pThis->stats.nFindIndexSteps += (unsigned long long)nSteps;
+
+	atomic_fetch_add_explicit(&g_nListStatFindIndexSteps, (unsigned long long)nSteps,
+			memory_order_relaxed);
+}
+
+/* the storage of two lists was exchanged, so is what they hold */
+void CListStatSwap(struct CList *pDst, struct CList *pSrc) {
+
+	long long nHeldBytes = pDst->stats.nHeldBytes;
+
+	pDst->stats.nHeldBytes = pSrc->stats.nHeldBytes;
+	pSrc->stats.nHeldBytes = nHeldBytes;
+
+	LIST_STAT_COUNT(pDst);
+	LIST_STAT_COUNT(pSrc);
+}
+
+#endif
+
+/*-----------------------------------------------------------------------------
+ * Function: ListGetStats
+ *
+ * Parameter:
+ * 	- pThis : CList instance pointer (emulates c++ this pointer)
+ * 	- pStats : receives the counters of the list
+ *
+ * Return Value:
+ * 	- Return -1 if the library was built without CLIST_STATS, else returns 0
+ *
+ * Desc:
+ * 	- counters since InitList. The payload part of nHeldBytes is what the
+ * 	  elements stored right now take, the rest is node overhead and spare
+ * 	  capacity of slabs and arrays. Lists holding pointers (InitListByRef)
+ * 	  count the pointers as payload, sized lists (InitListSized) the
+ * 	  lengths stored, which takes a walk over the list.
+ *
+ * --------------------------------------------------------------------------*/
+int ListGetStats(struct CList *pThis, CListStats *pStats) {
+
+	if (pStats == NULL)
+		return -1;
+
+	memset(pStats, 0, sizeof(CListStats));
+
+	if (pThis == NULL)
+		return -1;
+
+#ifdef CLIST_STATS
+	*pStats = pThis->stats;
+	pStats->nPayloadBytes = LIST_IS_SIZED(pThis) ? CListSizedPayloadBytes(pThis) :
+		(long long)pThis->nCount * pThis->nMaxDataSize;
+	pStats->nNodeBytes = pStats->nHeldBytes - pStats->nPayloadBytes;
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListGetGlobalStats
+ *
+ * Parameter:
+ * 	- pStats : receives the counters of all lists together
+ *
+ * Return Value:
+ * 	- Return -1 if the library was built without CLIST_STATS, else returns 0
+ *
+ * Desc:
+ * 	- totals over every list since the process started, destroyed lists
+ * 	  included. nPeakCount is the largest nCount any single list reached;
+ * 	  nPayloadBytes and nNodeBytes are -1.
+ *
+ * --------------------------------------------------------------------------*/
+int ListGetGlobalStats(CListStats *pStats) {
+
+	if (pStats == NULL)
+		return -1;
+
+	memset(pStats, 0, sizeof(CListStats));
+
+#ifdef CLIST_STATS
+	pStats->nAllocs = atomic_load_explicit(&g_nListStatAllocs, memory_order_relaxed);
+	pStats->nFrees = atomic_load_explicit(&g_nListStatFrees, memory_order_relaxed);
+	pStats->nFailedAllocs = atomic_load_explicit(&g_nListStatFailedAllocs,
+			memory_order_relaxed);
+	pStats->nHeldBytes = atomic_load_explicit(&g_nListStatHeldBytes, memory_order_relaxed);
+	pStats->nPayloadBytes = -1;
+	pStats->nNodeBytes = -1;
+	pStats->nPeakCount = atomic_load_explicit(&g_nListStatPeakCount, memory_order_relaxed);
+	pStats->nFindIndexSteps = atomic_load_explicit(&g_nListStatFindIndexSteps,
+			memory_order_relaxed);
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/*-----------------------------------------------------------------------------
+ * Function: ListDumpStats
+ *
+ * Parameter:
+ * 	- pFile : stream to write to, NULL for stderr
+ *
+ * Return Value:
+ * 	- Return -1 if the library was built without CLIST_STATS or the write
+ * 	  fails, else returns 0
+ *
+ * Desc:
+ * 	- write the global counters as one "clist stats:" line of name=value
+ * 	  pairs, e.g. from an atexit handler
+ *
+ * --------------------------------------------------------------------------*/
+int ListDumpStats(FILE *pFile) {
+
+	CListStats stats;
+
+	if (pFile == NULL)
+		pFile = stderr;
+
+	if (ListGetGlobalStats(&stats) != 0) {
+		fprintf(pFile, "clist stats: not built with CLIST_STATS\n");
+		return -1;
+	}
+
+	if (fprintf(pFile, "clist stats: allocs=%llu frees=%llu failed_allocs=%llu "
+			"held_bytes=%lld peak_count=%d find_index_steps=%llu\n",
+			stats.nAllocs, stats.nFrees, stats.nFailedAllocs, stats.nHeldBytes,
+			stats.nPeakCount, stats.nFindIndexSteps) < 0)
+		return -1;
+
+	return 0;
+}
@@ -0,0 +1,306 @@
+/******************************************************************************
+    Typed lists generated at compile time.
+
+    CLIST_DEFINE(Name, Type) declares a list of Type: the payload is a Type
+    member of the node instead of nMaxDataSize bytes behind a void*, and
+    every operation is a static inline function. Copies are struct
+    assignments of a known size, so for small types an add or a walk step
+    compiles to a few moves instead of a memcpy call.
+
+        typedef struct Point { int x, y; } Point;
+
+        CLIST_DEFINE(PointList, Point)
+
+        PointList           list;
+        PointListNode       *pos;
+        Point               pt = { 1, 2 };
+
+        InitPointList(&list);
+        PointListAddTail(&list, &pt);
+        for (pos = PointListGetHeadPosition(&list); pos != NULL; ) {
+            Point *p = PointListGetNext(&list, &pos);
+            ...
+        }
+        DestroyPointList(&list);
+
+    The generated calls are named like the List* API with Name in place of
+    List (PointListAddTail, PointListFindIndex, ...) plus InitName and
+    DestroyName, take and return the same things with Type* for void* and
+    Name##Node* for POSITION, and behave the same way. Name may be used with
+    CLIST_DEFINE only once per translation unit; a header doing it can be
+    included from several, everything generated is static.
+
+    Nodes come from malloc one by one, like InitList; pThis must be an
+    initialized list.
+******************************************************************************/
+
+#ifndef LIST_TYPED_H
+#define LIST_TYPED_H
+
+#include <stdlib.h>
+
+/* the node and list types, Name##Node and Name */
+#define CLIST_DEFINE_TYPES(Name, Type) \
+	typedef struct Name##Node { \
+	\
+		struct Name##Node	*next; \
+		struct Name##Node	*prev; \
+		Type				data; \
+	\
+	} Name##Node; \
+	\
+	typedef struct Name { \
+	\
+		int			nCount; \
+	\
+		Name##Node	*pHeadNode; \
+		Name##Node	*pTailNode; \
+	\
+	} Name;
+
+/* the operations on a list declared by CLIST_DEFINE_TYPES */
+#define CLIST_DEFINE_FUNCS(Name, Type) \
+	static inline void Init##Name(Name *pThis) { \
+	\
+		pThis->nCount = 0; \
+		pThis->pHeadNode = NULL; \
+		pThis->pTailNode = NULL; \
+	} \
+	\
+	/* link pNode between pPrev and pNext, either may be NULL at an end */ \
+	static inline void Name##LinkNode(Name *pThis, Name##Node *pNode, \
+			Name##Node *pPrev, Name##Node *pNext) { \
+	\
+		pNode->prev = pPrev; \
+		pNode->next = pNext; \
+	\
+		if (pPrev != NULL) \
+			pPrev->next = pNode; \
+		else \
+			pThis->pHeadNode = pNode; \
+	\
+		if (pNext != NULL) \
+			pNext->prev = pNode; \
+		else \
+			pThis->pTailNode = pNode; \
+	\
+		pThis->nCount++; \
+	} \
+	\
+	static inline void Name##UnlinkNode(Name *pThis, Name##Node *pNode) { \
+	\
+		if (pNode->prev != NULL) \
+			pNode->prev->next = pNode->next; \
+		else \
+			pThis->pHeadNode = pNode->next; \
+	\
+		if (pNode->next != NULL) \
+			pNode->next->prev = pNode->prev; \
+		else \
+			pThis->pTailNode = pNode->prev; \
+	\
+		pThis->nCount--; \
+	} \
+	\
+	/* a new node holding a copy of *pData, linked between pPrev and pNext */ \
+	static inline Name##Node* Name##NewNode(Name *pThis, const Type *pData, \
+			Name##Node *pPrev, Name##Node *pNext) { \
+	\
+		Name##Node *pNode; \
+	\
+		if (pData == NULL) \
+			return NULL; \
+	\
+		pNode = (Name##Node *)malloc(sizeof(Name##Node)); \
+	\
+		if (pNode == NULL) \
+			return NULL; \
+	\
+		pNode->data = *pData; \
+		Name##LinkNode(pThis, pNode, pPrev, pNext); \
+	\
+		return pNode; \
+	} \
+	\
+	/* head, tail access */ \
+	static inline Type* Name##GetHead(Name *pThis) { \
+	\
+		return (pThis->pHeadNode != NULL) ? &pThis->pHeadNode->data : NULL; \
+	} \
+	\
+	static inline Type* Name##GetTail(Name *pThis) { \
+	\
+		return (pThis->pTailNode != NULL) ? &pThis->pTailNode->data : NULL; \
+	} \
+	\
+	/* operation */ \
+	static inline Name##Node* Name##AddHead(Name *pThis, const Type *pData) { \
+	\
+		return Name##NewNode(pThis, pData, NULL, pThis->pHeadNode); \
+	} \
+	\
+	static inline Name##Node* Name##AddTail(Name *pThis, const Type *pData) { \
+	\
+		return Name##NewNode(pThis, pData, pThis->pTailNode, NULL); \
+	} \
+	\
+	static inline int Name##RemoveAt(Name *pThis, Name##Node *position) { \
+	\
+		if (position == NULL) \
+			return -1; \
+	\
+		Name##UnlinkNode(pThis, position); \
+		free(position); \
+	\
+		return 0; \
+	} \
+	\
+	static inline int Name##RemoveHead(Name *pThis) { \
+	\
+		return Name##RemoveAt(pThis, pThis->pHeadNode); \
+	} \
+	\
+	static inline int Name##RemoveTail(Name *pThis) { \
+	\
+		return Name##RemoveAt(pThis, pThis->pTailNode); \
+	} \
+	\
+	static inline int Name##RemoveAll(Name *pThis) { \
+	\
+		Name##Node *pNode = pThis->pHeadNode; \
+		Name##Node *pNext; \
+	\
+		while (pNode != NULL) { \
+			pNext = pNode->next; \
+			free(pNode); \
+			pNode = pNext; \
+		} \
+	\
+		Init##Name(pThis); \
+	\
+		return 0; \
+	} \
+	\
+	static inline void Destroy##Name(Name *pThis) { \
+	\
+		Name##RemoveAll(pThis); \
+	} \
+	\
+	/* for iteration */ \
+	static inline Name##Node* Name##GetHeadPosition(Name *pThis) { \
+	\
+		return pThis->pHeadNode; \
+	} \
+	\
+	static inline Name##Node* Name##GetTailPosition(Name *pThis) { \
+	\
+		return pThis->pTailNode; \
+	} \
+	\
+	static inline Type* Name##GetNext(Name *pThis, Name##Node **position) { \
+	\
+		Name##Node *pNode = *position; \
+	\
+		(void)pThis; \
+	\
+		if (pNode == NULL) \
+			return NULL; \
+	\
+		*position = pNode->next; \
+	\
+		return &pNode->data; \
+	} \
+	\
+	static inline Type* Name##GetPrev(Name *pThis, Name##Node **position) { \
+	\
+		Name##Node *pNode = *position; \
+	\
+		(void)pThis; \
+	\
+		if (pNode == NULL) \
+			return NULL; \
+	\
+		*position = pNode->prev; \
+	\
+		return &pNode->data; \
+	} \
+	\
+	/* retrieval, modification */ \
+	static inline Type* Name##GetAt(Name *pThis, Name##Node *position) { \
+	\
+		(void)pThis; \
+	\
+		return (position != NULL) ? &position->data : NULL; \
+	} \
+	\
+	static inline int Name##SetAt(Name *pThis, Name##Node *position, \
+			const Type *pData) { \
+	\
+		(void)pThis; \
+	\
+		if (position == NULL || pData == NULL) \
+			return -1; \
+	\
+		position->data = *pData; \
+	\
+		return 0; \
+	} \
+	\
+	/* Insertion */ \
+	static inline Name##Node* Name##InsertNext(Name *pThis, Name##Node *position, \
+			const Type *pData) { \
+	\
+		if (position == NULL) \
+			return NULL; \
+	\
+		return Name##NewNode(pThis, pData, position, position->next); \
+	} \
+	\
+	static inline Name##Node* Name##InsertPrev(Name *pThis, Name##Node *position, \
+			const Type *pData) { \
+	\
+		if (position == NULL) \
+			return NULL; \
+	\
+		return Name##NewNode(pThis, pData, position->prev, position); \
+	} \
+	\
+	/* Searching, walks from the nearer end */ \
+	static inline Name##Node* Name##FindIndex(Name *pThis, int nIndex) { \
+	\
+		Name##Node *pNode; \
+		int i; \
+	\
+		if (nIndex < 0 || nIndex >= pThis->nCount) \
+			return NULL; \
+	\
+		if (nIndex < pThis->nCount / 2) { \
+			for (pNode = pThis->pHeadNode, i = 0; i < nIndex; i++) \
+				pNode = pNode->next; \
+		} \
+		else { \
+			pNode = pThis->pTailNode; \
+			for (i = pThis->nCount - 1; i > nIndex; i--) \
+				pNode = pNode->prev; \
+		} \
+	\
+		return pNode; \
+	} \
+	\
+	/* Status */ \
+	static inline int Name##GetCount(Name *pThis) { \
+	\
+		return pThis->nCount; \
+	} \
+	\
+	static inline int Name##IsEmpty(Name *pThis) { \
+	\
+		return (pThis->nCount != 0) ? 1 : 0; \
+	}
+
+/* a typed list Name of Type, see the top of this file */
+#define CLIST_DEFINE(Name, Type) \
+	CLIST_DEFINE_TYPES(Name, Type) \
+	CLIST_DEFINE_FUNCS(Name, Type)
+
+#endif
@@ -0,0 +1,290 @@
+/******************************************************************************
+    clist_intrusive_test: CListIntrusive against a reference array of the
+    objects on it.
+
+    basic: IsEmpty and GetCount of an empty and a filled list (IsEmpty
+    returns 1 for a list with elements, like ListIsEmpty), removing while
+    walking with GetNext, and one object on two lists through two links.
+
+    random: random adds, inserts, RemoveAt, Replace, RemoveHead/RemoveTail
+    and RemoveAll on a pool of objects, the list walked both ways and
+    compared with the reference after every step.
+******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "list_intrusive.h"
+#include "test.h"
+
+#define TEST_OBJECTS		64
+#define TEST_STEPS			20000
+
+typedef struct TestObject {
+
+	int			nId;
+	CListLink	link;			/* on the list under test */
+	CListLink	other;			/* on a second list in TestBasic */
+	int			bOnList;
+
+} TestObject;
+
+static TestObject g_aObjects[TEST_OBJECTS];
+
+#define TEST_OBJECT(pLink)	LIST_CONTAINER_OF(pLink, TestObject, link)
+
+/* object ids on the list, in list order */
+typedef struct TestRef {
+
+	int		anIds[TEST_OBJECTS];
+	int		nCount;
+
+} TestRef;
+
+static void TestRefInsert(TestRef *pRef, int nIndex, int nId) {
+
+	memmove(&pRef->anIds[nIndex + 1], &pRef->anIds[nIndex],
+			(size_t)(pRef->nCount - nIndex) * sizeof(int));
+	pRef->anIds[nIndex] = nId;
+	pRef->nCount++;
+}
+
+static void TestRefRemove(TestRef *pRef, int nIndex) {
+
+	memmove(&pRef->anIds[nIndex], &pRef->anIds[nIndex + 1],
+			(size_t)(pRef->nCount - nIndex - 1) * sizeof(int));
+	pRef->nCount--;
+}
+
+/* an object not on the list, NULL if all are */
+static TestObject* TestFreeObject(unsigned int *pnRand) {
+
+	int nStart = (int)(TestRand(pnRand) % TEST_OBJECTS);
+	int i;
+
+	for (i = 0; i < TEST_OBJECTS; i++) {
+		if (!g_aObjects[(nStart + i) % TEST_OBJECTS].bOnList)
+			return &g_aObjects[(nStart + i) % TEST_OBJECTS];
+	}
+
+	return NULL;
+}
+
+static int TestCheckList(CListIntrusive *pList, const TestRef *pRef) {
+
+	CListLink	*pos;
+	CListLink	*pLink;
+	int			i;
+
+	TEST_CHECK(ListIntrusiveGetCount(pList) == pRef->nCount);
+	TEST_CHECK(ListIntrusiveIsEmpty(pList) == (pRef->nCount != 0));
+
+	if (pRef->nCount == 0) {
+		TEST_CHECK(ListIntrusiveGetHead(pList) == NULL);
+		TEST_CHECK(ListIntrusiveGetTail(pList) == NULL);
+		return 0;
+	}
+
+	TEST_CHECK(TEST_OBJECT(ListIntrusiveGetHead(pList))->nId == pRef->anIds[0]);
+	TEST_CHECK(TEST_OBJECT(ListIntrusiveGetTail(pList))->nId == pRef->anIds[pRef->nCount - 1]);
+
+	for (pos = ListIntrusiveGetHeadPosition(pList), i = 0; pos != NULL; i++) {
+		pLink = ListIntrusiveGetNext(pList, &pos);
+		TEST_CHECK(i < pRef->nCount && TEST_OBJECT(pLink)->nId == pRef->anIds[i]);
+	}
+	TEST_CHECK(i == pRef->nCount);
+
+	for (pos = ListIntrusiveGetTailPosition(pList); pos != NULL; ) {
+		pLink = ListIntrusiveGetPrev(pList, &pos);
+		TEST_CHECK(TEST_OBJECT(pLink)->nId == pRef->anIds[--i]);
+	}
+	TEST_CHECK(i == 0);
+
+	i = pRef->nCount / 2;
+	TEST_CHECK(TEST_OBJECT(ListIntrusiveFindIndex(pList, i))->nId == pRef->anIds[i]);
+	TEST_CHECK(ListIntrusiveFindIndex(pList, pRef->nCount) == NULL);
+
+	return 0;
+}
+
+static int TestBasic(void) {
+
+	CListIntrusive	list;
+	CListIntrusive	other;
+	CListLink		*pos;
+	CListLink		*pLink;
+	int				i;
+
+	InitListIntrusive(&list);
+	InitListIntrusive(&other);
+
+	TEST_CHECK(ListIntrusiveIsEmpty(&list) == 0);
+	TEST_CHECK(ListIntrusiveGetCount(&list) == 0);
+	TEST_CHECK(ListIntrusiveRemoveHead(&list) == NULL);
+	TEST_CHECK(ListIntrusiveRemoveTail(&list) == NULL);
+	TEST_CHECK(ListIntrusiveRemoveAt(&list, &g_aObjects[0].link) == -1);
+
+	for (i = 0; i < 10; i++) {
+		g_aObjects[i].nId = i;
+		TEST_CHECK(ListIntrusiveAddTail(&list, &g_aObjects[i].link) == 0);
+		TEST_CHECK(ListIntrusiveAddHead(&other, &g_aObjects[i].other) == 0);
+	}
+	TEST_CHECK(ListIntrusiveIsEmpty(&list) == 1);
+	TEST_CHECK(ListIntrusiveGetCount(&list) == 10);
+
+	/* removing the link GetNext just returned keeps the walk going */
+	for (pos = ListIntrusiveGetHeadPosition(&list); pos != NULL; ) {
+		pLink = ListIntrusiveGetNext(&list, &pos);
+		if (TEST_OBJECT(pLink)->nId % 2 == 0)
+			TEST_CHECK(ListIntrusiveRemoveAt(&list, pLink) == 0);
+	}
+	TEST_CHECK(ListIntrusiveGetCount(&list) == 5);
+	for (pos = ListIntrusiveGetHeadPosition(&list), i = 1; pos != NULL; i += 2)
+		TEST_CHECK(TEST_OBJECT(ListIntrusiveGetNext(&list, &pos))->nId == i);
+
+	/* the second list saw none of it */
+	TEST_CHECK(ListIntrusiveGetCount(&other) == 10);
+	for (pos = ListIntrusiveGetHeadPosition(&other), i = 9; pos != NULL; i--) {
+		pLink = ListIntrusiveGetNext(&other, &pos);
+		TEST_CHECK(LIST_CONTAINER_OF(pLink, TestObject, other)->nId == i);
+	}
+
+	ListIntrusiveRemoveAll(&list);
+	TEST_CHECK(ListIntrusiveIsEmpty(&list) == 0);
+	TEST_CHECK(ListIntrusiveGetHeadPosition(&list) == NULL);
+
+	return 0;
+}
+
+static int TestStep(CListIntrusive *pList, TestRef *pRef, unsigned int *pnRand) {
+
+	TestObject	*pObject = TestFreeObject(pnRand);
+	CListLink	*pLink;
+	int			nCount = pRef->nCount;
+	int			nIndex = (nCount > 0) ? (int)(TestRand(pnRand) % (unsigned int)nCount) : 0;
+	int			nOp = (int)(TestRand(pnRand) % 9);
+
+	/* adds need a free object, the rest an element */
+	if (nOp <= 3 && pObject == NULL)
+		nOp = 4;
+	if (nOp >= 2 && nCount == 0)
+		nOp = (pObject != NULL) ? 0 : 8;
+	if (nOp == 6 && pObject == NULL)
+		nOp = 4;
+
+	switch (nOp) {
+
+	case 0:
+		TEST_CHECK(ListIntrusiveAddHead(pList, &pObject->link) == 0);
+		TestRefInsert(pRef, 0, pObject->nId);
+		break;
+
+	case 1:
+		TEST_CHECK(ListIntrusiveAddTail(pList, &pObject->link) == 0);
+		TestRefInsert(pRef, nCount, pObject->nId);
+		break;
+
+	case 2:
+		TEST_CHECK(ListIntrusiveInsertNext(pList, ListIntrusiveFindIndex(pList, nIndex),
+				&pObject->link) == 0);
+		TestRefInsert(pRef, nIndex + 1, pObject->nId);
+		break;
+
+	case 3:
+		TEST_CHECK(ListIntrusiveInsertPrev(pList, ListIntrusiveFindIndex(pList, nIndex),
+				&pObject->link) == 0);
+		TestRefInsert(pRef, nIndex, pObject->nId);
+		break;
+
+	case 4:
+		pLink = ListIntrusiveFindIndex(pList, nIndex);
+		TEST_CHECK(ListIntrusiveRemoveAt(pList, pLink) == 0);
+		TEST_OBJECT(pLink)->bOnList = 0;
+		TestRefRemove(pRef, nIndex);
+		return 0;
+
+	case 5:
+		pLink = ListIntrusiveRemoveHead(pList);
+		TEST_CHECK(pLink != NULL && TEST_OBJECT(pLink)->nId == pRef->anIds[0]);
+		TEST_OBJECT(pLink)->bOnList = 0;
+		TestRefRemove(pRef, 0);
+		return 0;
+
+	case 6:
+		pLink = ListIntrusiveFindIndex(pList, nIndex);
+		TEST_CHECK(ListIntrusiveReplace(pList, pLink, &pObject->link) == 0);
+		TEST_OBJECT(pLink)->bOnList = 0;
+		pRef->anIds[nIndex] = pObject->nId;
+		break;
+
+	case 7:
+		pLink = ListIntrusiveRemoveTail(pList);
+		TEST_CHECK(pLink != NULL && TEST_OBJECT(pLink)->nId == pRef->anIds[nCount - 1]);
+		TEST_OBJECT(pLink)->bOnList = 0;
+		TestRefRemove(pRef, nCount - 1);
+		return 0;
+
+	case 8:
+		if (TestRand(pnRand) % 16 != 0)
+			return 0;
+		ListIntrusiveRemoveAll(pList);
+		for (nIndex = 0; nIndex < TEST_OBJECTS; nIndex++)
+			g_aObjects[nIndex].bOnList = 0;
+		pRef->nCount = 0;
+		return 0;
+	}
+
+	pObject->bOnList = 1;
+
+	return 0;
+}
+
+static int TestRandom(unsigned int nSeed) {
+
+	CListIntrusive	list;
+	TestRef			ref;
+	unsigned int	nRand = nSeed;
+	int				nStep;
+	int				i;
+
+	for (i = 0; i < TEST_OBJECTS; i++) {
+		g_aObjects[i].nId = i;
+		g_aObjects[i].bOnList = 0;
+	}
+
+	InitListIntrusive(&list);
+	ref.nCount = 0;
+
+	for (nStep = 0; nStep < TEST_STEPS; nStep++) {
+		if (TestStep(&list, &ref, &nRand) != 0 || TestCheckList(&list, &ref) != 0) {
+			fprintf(stderr, "random: failed at step %d (seed %u)\n", nStep, nSeed);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	unsigned int nSeed = 1;
+	int nFailed = 0;
+
+	if (argc > 1)
+		nSeed = (unsigned int)strtoul(argv[1], NULL, 10);
+
+	if (TestBasic() != 0) {
+		fprintf(stderr, "basic: failed\n");
+		nFailed++;
+	}
+
+	if (TestRandom(nSeed) != 0) {
+		fprintf(stderr, "random: failed\n");
+		nFailed++;
+	}
+
+	if (nFailed == 0)
+		printf("clist_intrusive_test: basic and random passed (seed %u)\n", nSeed);
+
+	return (nFailed == 0) ? 0 : 1;
+}
@@ -0,0 +1,1367 @@
+/******************************************************************************
+    clist_test: differential test of every storage and allocator mode.
+
+    Two lists of one mode take random steps (adds, removes, inserts, SetAt,
+    the batch calls, splices between the two, sorts) next to a reference
+    array of record numbers each. After every step both lists are walked
+    forward, backward and by GetNextBatch and compared with their
+    reference; FindIndex is checked for a few indexes every step and for
+    all of them now and then. Snapshots are checked by saving a list and
+    reading it back with LoadList and InitListMapped. A CLIST_DEFINE list
+    takes the same random steps as a CList next to one reference. The
+    ListXxxSized calls are run on a sized list and on a chunk list with a
+    reference of record numbers and lengths. ListInsertSorted and ListMerge
+    are checked against a stable merge of the references, on the relinking
+    and on the copying path.
+
+    usage: clist_test [seed]
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "list.h"
+#include "list_alloc.h"
+#include "list_typed.h"
+#include "test.h"
+
+#define TEST_STEPS				4000
+#define TEST_MAX_LENGTH			256		/* lists this long only shrink */
+#define TEST_MAX_BATCH			8
+#define TEST_REF_SIZE			(2 * TEST_MAX_LENGTH + 2 * TEST_MAX_BATCH)
+#define TEST_MAX_RECORDS		((TEST_STEPS + 1) * TEST_MAX_BATCH)
+
+/* few keys, so sorts have ties to keep in order */
+#define TEST_KEYS				16
+
+/* every FindIndex is checked after this many steps, a few of them always */
+#define TEST_FULL_CHECK_STEPS	64
+#define TEST_SAMPLED_INDEXES	4
+
+/* GetNextBatch array size, small so walks take several calls */
+#define TEST_WALK_BATCH			5
+
+/* nMaxDataSize of the lists the ListXxxSized calls are run on */
+#define TEST_SIZED_MAX			120
+
+typedef struct TestRecord {
+
+	int				nKey;
+	int				nSeq;			/* record number, unique */
+	unsigned char	acFill[24];		/* derived from nSeq */
+
+} TestRecord;
+
+CLIST_DEFINE(TestTypedList, TestRecord)
+
+/* what a mode supports besides the CList operations */
+#define TEST_BY_REF			0x01	/* stores record pointers (InitListByRef) */
+#define TEST_NO_EMPLACE		0x02	/* ListEmplace* refused */
+#define TEST_NO_SPLICE		0x04	/* ListSplice refused, copies would cut payloads */
+#define TEST_HASHED			0x08	/* ListFindKey by nSeq */
+#define TEST_NODE_LINKED	0x10	/* ListMoveToHead/ListMoveToTail work */
+#define TEST_ERASE_ONLY		0x20	/* RemoveAt may move later elements, walk with ListErase */
+
+typedef struct TestMode {
+
+	const char	*pszName;
+	int			(*Init)(CList *pList);
+	int			nFlags;
+
+} TestMode;
+
+/* record numbers of a list's elements in list order */
+typedef struct TestRef {
+
+	int		anSeq[TEST_REF_SIZE];
+	int		nCount;
+
+} TestRef;
+
+static TestRecord		g_aRecords[TEST_MAX_RECORDS];
+static int				g_nRecords;
+
+/* allocators shared by both lists of their mode */
+static CListFixedPool	g_fixedPool;
+static CListArena		g_arena;
+
+/*-----------------------------------------------------------------------------
+ * modes
+ * --------------------------------------------------------------------------*/
+static int TestInitNode(CList *pList) {
+
+	InitList(pList, (int)sizeof(TestRecord));
+	return 0;
+}
+
+static int TestInitPool(CList *pList) {
+
+	return InitListWithCapacity(pList, (int)sizeof(TestRecord), 32);
+}
+
+static int TestInitFixedPool(CList *pList) {
+
+	return InitListWithAllocator(pList, (int)sizeof(TestRecord),
+			ListFixedPoolAlloc, ListFixedPoolFree, &g_fixedPool);
+}
+
+static int TestInitArenaAllocator(CList *pList) {
+
+	return InitListWithAllocator(pList, (int)sizeof(TestRecord),
+			ListArenaAlloc, ListArenaFree, &g_arena);
+}
+
+static int TestInitArena(CList *pList) {
+
+	return InitListWithArena(pList, (int)sizeof(TestRecord), 0);
+}
+
+static int TestInitIndexed(CList *pList) {
+
+	InitList(pList, (int)sizeof(TestRecord));
+	return ListEnableIndex(pList);
+}
+
+static int TestInitHashed(CList *pList) {
+
+	InitList(pList, (int)sizeof(TestRecord));
+	return ListEnableHashIndex(pList, (int)offsetof(TestRecord, nSeq), (int)sizeof(int), NULL);
+}
+
+static int TestInitByRef(CList *pList) {
+
+	InitListByRef(pList);
+	return 0;
+}
+
+static int TestInitSized(CList *pList) {
+
+	return InitListSized(pList, (int)sizeof(TestRecord));
+}
+
+static int TestInitChunk(CList *pList) {
+
+	return InitListStorage(pList, (int)sizeof(TestRecord), LIST_STORAGE_CHUNK);
+}
+
+static int TestInitRing(CList *pList) {
+
+	return InitListRing(pList, (int)sizeof(TestRecord), 0);
+}
+
+static int TestInitCompact(CList *pList) {
+
+	return InitListCompact(pList, (int)sizeof(TestRecord), 0);
+}
+
+static int TestInitDeque(CList *pList) {
+
+	return InitListStorage(pList, (int)sizeof(TestRecord), LIST_STORAGE_DEQUE);
+}
+
+static const TestMode g_aModes[] = {
+
+	{ "node",			TestInitNode,			TEST_NODE_LINKED },
+	{ "pool",			TestInitPool,			TEST_NODE_LINKED },
+	{ "fixed_pool",		TestInitFixedPool,		TEST_NODE_LINKED },
+	{ "arena_alloc",	TestInitArenaAllocator,	TEST_NODE_LINKED },
+	{ "arena",			TestInitArena,			TEST_NODE_LINKED },
+	{ "indexed",		TestInitIndexed,		TEST_NODE_LINKED },
+	{ "hashed",			TestInitHashed,			TEST_NODE_LINKED | TEST_HASHED | TEST_NO_EMPLACE },
+	{ "by_ref",			TestInitByRef,			TEST_NODE_LINKED | TEST_BY_REF | TEST_NO_EMPLACE },
+	{ "sized",			TestInitSized,			TEST_NO_SPLICE },
+	{ "chunk",			TestInitChunk,			0 },
+	{ "ring",			TestInitRing,			0 },
+	{ "compact",		TestInitCompact,		0 },
+	{ "deque",			TestInitDeque,			TEST_ERASE_ONLY }
+};
+
+/*-----------------------------------------------------------------------------
+ * records and references
+ * --------------------------------------------------------------------------*/
+/* nItems new records, consecutive in g_aRecords */
+static TestRecord* TestNewRecords(int nItems, unsigned int *pnRand) {
+
+	TestRecord *pFirst = &g_aRecords[g_nRecords];
+	TestRecord *pRecord;
+	size_t i;
+
+	for (pRecord = pFirst; pRecord < pFirst + nItems; pRecord++) {
+		pRecord->nKey = (int)(TestRand(pnRand) % TEST_KEYS);
+		pRecord->nSeq = g_nRecords++;
+		for (i = 0; i < sizeof(pRecord->acFill); i++)
+			pRecord->acFill[i] = (unsigned char)(pRecord->nSeq * 31 + (int)i);
+	}
+
+	return pFirst;
+}
+
+static void TestRefInsert(TestRef *pRef, int nIndex, int nSeq) {
+
+	memmove(&pRef->anSeq[nIndex + 1], &pRef->anSeq[nIndex],
+			(size_t)(pRef->nCount - nIndex) * sizeof(int));
+	pRef->anSeq[nIndex] = nSeq;
+	pRef->nCount++;
+}
+
+static void TestRefRemove(TestRef *pRef, int nIndex, int nItems) {
+
+	memmove(&pRef->anSeq[nIndex], &pRef->anSeq[nIndex + nItems],
+			(size_t)(pRef->nCount - nIndex - nItems) * sizeof(int));
+	pRef->nCount -= nItems;
+}
+
+/* stable, like ListSort */
+static void TestRefSort(TestRef *pRef) {
+
+	int nSeq;
+	int i;
+	int j;
+
+	for (i = 1; i < pRef->nCount; i++) {
+		nSeq = pRef->anSeq[i];
+		for (j = i; j > 0 && g_aRecords[pRef->anSeq[j - 1]].nKey > g_aRecords[nSeq].nKey; j--)
+			pRef->anSeq[j] = pRef->anSeq[j - 1];
+		pRef->anSeq[j] = nSeq;
+	}
+}
+
+static int TestCompareKeys(const void *pA, const void *pB) {
+
+	return ((const TestRecord *)pA)->nKey - ((const TestRecord *)pB)->nKey;
+}
+
+/* the payload, or for by-reference lists the object, holds record nSeq */
+static int TestSame(const void *pData, int nSeq) {
+
+	return pData != NULL && memcmp(pData, &g_aRecords[nSeq], sizeof(TestRecord)) == 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * checks
+ * --------------------------------------------------------------------------*/
+static int TestCheckList(CList *pList, const TestRef *pRef, int nFlags, int bAllIndexes,
+		unsigned int *pnRand) {
+
+	void		*apData[TEST_WALK_BATCH];
+	POSITION	pos;
+	int			nGot;
+	int			i;
+	int			j;
+
+	TEST_CHECK(ListGetCount(pList) == pRef->nCount);
+	TEST_CHECK(ListIsEmpty(pList) == (pRef->nCount != 0));
+
+	if (pRef->nCount == 0) {
+		TEST_CHECK(ListGetHeadPosition(pList) == NULL);
+		TEST_CHECK(ListGetTailPosition(pList) == NULL);
+		return 0;
+	}
+
+	TEST_CHECK(TestSame(ListGetHead(pList), pRef->anSeq[0]));
+	TEST_CHECK(TestSame(ListGetTail(pList), pRef->anSeq[pRef->nCount - 1]));
+
+	pos = ListGetHeadPosition(pList);
+	for (i = 0; i < pRef->nCount; i++) {
+		TEST_CHECK(pos != NULL);
+		TEST_CHECK(TestSame(ListGetNext(pList, &pos), pRef->anSeq[i]));
+	}
+	TEST_CHECK(pos == NULL);
+
+	pos = ListGetTailPosition(pList);
+	for (i = pRef->nCount - 1; i >= 0; i--) {
+		TEST_CHECK(pos != NULL);
+		TEST_CHECK(TestSame(ListGetPrev(pList, &pos), pRef->anSeq[i]));
+	}
+	TEST_CHECK(pos == NULL);
+
+	pos = ListGetHeadPosition(pList);
+	for (i = 0; i < pRef->nCount; i += nGot) {
+		nGot = ListGetNextBatch(pList, &pos, apData, TEST_WALK_BATCH);
+		TEST_CHECK(nGot > 0);
+		for (j = 0; j < nGot; j++)
+			TEST_CHECK(TestSame(apData[j], pRef->anSeq[i + j]));
+	}
+	TEST_CHECK(i == pRef->nCount);
+	TEST_CHECK(pos == NULL);
+	TEST_CHECK(ListGetNextBatch(pList, &pos, apData, TEST_WALK_BATCH) == 0);
+
+	if (bAllIndexes) {
+		for (i = 0; i < pRef->nCount; i++)
+			TEST_CHECK(TestSame(ListGetAt(pList, ListFindIndex(pList, i)), pRef->anSeq[i]));
+	}
+	else {
+		for (j = 0; j < TEST_SAMPLED_INDEXES; j++) {
+			i = (int)(TestRand(pnRand) % (unsigned int)pRef->nCount);
+			TEST_CHECK(TestSame(ListGetAt(pList, ListFindIndex(pList, i)), pRef->anSeq[i]));
+		}
+	}
+	TEST_CHECK(ListFindIndex(pList, pRef->nCount) == NULL);
+	TEST_CHECK(ListFindIndex(pList, -1) == NULL);
+
+	if (nFlags & TEST_HASHED) {
+		for (i = 0; i < pRef->nCount; i++)
+			TEST_CHECK(TestSame(ListGetAt(pList, ListFindKey(pList, &pRef->anSeq[i])),
+					pRef->anSeq[i]));
+	}
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * steps
+ * --------------------------------------------------------------------------*/
+enum {
+
+	TEST_ADD_HEAD = 0,
+	TEST_ADD_TAIL,
+	TEST_INSERT_NEXT,
+	TEST_INSERT_PREV,
+	TEST_EMPLACE,
+	TEST_BATCH,
+	TEST_REMOVE_HEAD,
+	TEST_REMOVE_TAIL,
+	TEST_REMOVE_AT,
+	TEST_SET_AT,
+	TEST_REMOVE_RANGE,
+	TEST_REMOVE_HEAD_N,
+	TEST_SPLICE,
+	TEST_MOVE,
+	TEST_SORT,
+	TEST_REMOVE_WALKING,
+	TEST_REMOVE_ALL,
+
+	TEST_OPS
+};
+
+/* batch adds: AddHeadBatch, AddTailBatch or InsertNextBatch */
+static int TestBatch(CList *pList, TestRef *pRef, int nFlags, unsigned int *pnRand) {
+
+	const void	*apRecords[TEST_MAX_BATCH];
+	const void	*pData;
+	TestRecord	*pFirst;
+	POSITION	pos;
+	int			nItems = 1 + (int)(TestRand(pnRand) % TEST_MAX_BATCH);
+	int			nWhere = (int)(TestRand(pnRand) % 3);
+	int			nIndex;
+	int			i;
+
+	pFirst = TestNewRecords(nItems, pnRand);
+
+	/* by-reference lists take an array of the pointers */
+	for (i = 0; i < nItems; i++)
+		apRecords[i] = &pFirst[i];
+	pData = (nFlags & TEST_BY_REF) ? (const void *)apRecords : (const void *)pFirst;
+
+	if (nWhere == 0 || pRef->nCount == 0) {
+		TEST_CHECK(ListAddTailBatch(pList, pData, nItems) != NULL);
+		nIndex = pRef->nCount;
+	}
+	else if (nWhere == 1) {
+		TEST_CHECK(ListAddHeadBatch(pList, pData, nItems) != NULL);
+		nIndex = 0;
+	}
+	else {
+		nIndex = (int)(TestRand(pnRand) % (unsigned int)pRef->nCount);
+		pos = ListInsertNextBatch(pList, ListFindIndex(pList, nIndex), pData, nItems);
+		TEST_CHECK(TestSame(ListGetAt(pList, pos), pFirst->nSeq));
+		nIndex++;
+	}
+
+	for (i = 0; i < nItems; i++)
+		TestRefInsert(pRef, nIndex + i, pFirst[i].nSeq);
+
+	return 0;
+}
+
+/* move a random range of pSrc in front of a random pDst element or to its
+ * tail */
+static int TestSplice(CList *pDst, TestRef *pDstRef, CList *pSrc, TestRef *pSrcRef,
+		int nFlags, unsigned int *pnRand) {
+
+	int		nFirst;
+	int		nItems;
+	int		nMoved;
+	int		nAt;
+	int		i;
+
+	if (pSrcRef->nCount == 0)
+		return 0;
+
+	nFirst = (int)(TestRand(pnRand) % (unsigned int)pSrcRef->nCount);
+	nItems = 1 + (int)(TestRand(pnRand) % (unsigned int)(pSrcRef->nCount - nFirst));
+
+	if (pDstRef->nCount + nItems > TEST_REF_SIZE)
+		return 0;
+
+	nAt = (int)(TestRand(pnRand) % (unsigned int)(pDstRef->nCount + 1));
+
+	nMoved = ListSplice(pDst, ListFindIndex(pDst, nAt), pSrc,
+			ListFindIndex(pSrc, nFirst), ListFindIndex(pSrc, nFirst + nItems - 1));
+
+	/* those still take a whole list into an empty one, by swapping */
+	if (nFlags & TEST_NO_SPLICE) {
+		TEST_CHECK(nMoved == -1 || (nMoved == nItems && pSrcRef->nCount == nItems &&
+				pDstRef->nCount == 0));
+		if (nMoved == -1)
+			return 0;
+	}
+
+	TEST_CHECK(nMoved == nItems);
+
+	for (i = 0; i < nItems; i++)
+		TestRefInsert(pDstRef, nAt + i, pSrcRef->anSeq[nFirst + i]);
+	TestRefRemove(pSrcRef, nFirst, nItems);
+
+	return 0;
+}
+
+/* remove the elements of one key while walking forward: with ListErase, or
+ * with the usual GetNext before RemoveAt where that keeps positions valid */
+static int TestRemoveWalking(CList *pList, TestRef *pRef, int nFlags, unsigned int *pnRand) {
+
+	POSITION	pos;
+	POSITION	posAt;
+	int			nKey = (int)(TestRand(pnRand) % TEST_KEYS);
+	int			bErase = (nFlags & TEST_ERASE_ONLY) || (TestRand(pnRand) & 1);
+	int			nIndex = 0;
+
+	for (pos = ListGetHeadPosition(pList); pos != NULL; ) {
+
+		TEST_CHECK(nIndex < pRef->nCount);
+		TEST_CHECK(TestSame(ListGetAt(pList, pos), pRef->anSeq[nIndex]));
+
+		if (g_aRecords[pRef->anSeq[nIndex]].nKey != nKey) {
+			ListGetNext(pList, &pos);
+			nIndex++;
+			continue;
+		}
+
+		if (bErase)
+			TEST_CHECK(ListErase(pList, &pos) == 0);
+		else {
+			posAt = pos;
+			ListGetNext(pList, &pos);
+			TEST_CHECK(ListRemoveAt(pList, posAt) == 0);
+		}
+		TestRefRemove(pRef, nIndex, 1);
+	}
+
+	TEST_CHECK(nIndex == pRef->nCount);
+
+	return 0;
+}
+
+static int TestStep(CList *apList[2], TestRef *apRef[2], int nFlags, unsigned int *pnRand) {
+
+	int			nList = (int)(TestRand(pnRand) & 1);
+	CList		*pList = apList[nList];
+	TestRef		*pRef = apRef[nList];
+	TestRecord	*pRecord;
+	POSITION	pos;
+	void		*pPayload;
+	int			nCount = pRef->nCount;
+	int			nIndex = (nCount > 0) ? (int)(TestRand(pnRand) % (unsigned int)nCount) : 0;
+	int			nItems;
+	int			nOp = (int)(TestRand(pnRand) % TEST_OPS);
+	int			nSeq;
+
+	/* adds only while the list is short, the rest of the steps shrink it */
+	if (nOp <= TEST_BATCH && nCount >= TEST_MAX_LENGTH)
+		nOp = TEST_REMOVE_HEAD_N;
+
+	/* inserts next to an element, the others need none */
+	if (nCount == 0 && nOp != TEST_ADD_HEAD && nOp != TEST_ADD_TAIL && nOp != TEST_EMPLACE &&
+			nOp != TEST_BATCH && nOp != TEST_SPLICE)
+		nOp = TEST_ADD_TAIL;
+
+	switch (nOp) {
+
+	case TEST_ADD_HEAD:
+		pRecord = TestNewRecords(1, pnRand);
+		TEST_CHECK(TestSame(ListGetAt(pList, ListAddHead(pList, pRecord)), pRecord->nSeq));
+		TestRefInsert(pRef, 0, pRecord->nSeq);
+		break;
+
+	case TEST_ADD_TAIL:
+		pRecord = TestNewRecords(1, pnRand);
+		TEST_CHECK(TestSame(ListGetAt(pList, ListAddTail(pList, pRecord)), pRecord->nSeq));
+		TestRefInsert(pRef, nCount, pRecord->nSeq);
+		break;
+
+	case TEST_INSERT_NEXT:
+		pRecord = TestNewRecords(1, pnRand);
+		pos = ListInsertNext(pList, ListFindIndex(pList, nIndex), pRecord);
+		TEST_CHECK(TestSame(ListGetAt(pList, pos), pRecord->nSeq));
+		TestRefInsert(pRef, nIndex + 1, pRecord->nSeq);
+		break;
+
+	case TEST_INSERT_PREV:
+		pRecord = TestNewRecords(1, pnRand);
+		pos = ListInsertPrev(pList, ListFindIndex(pList, nIndex), pRecord);
+		TEST_CHECK(TestSame(ListGetAt(pList, pos), pRecord->nSeq));
+		TestRefInsert(pRef, nIndex, pRecord->nSeq);
+		break;
+
+	case TEST_EMPLACE:
+		pPayload = ListEmplaceTail(pList, &pos);
+		if (nFlags & TEST_NO_EMPLACE) {
+			TEST_CHECK(pPayload == NULL);
+			break;
+		}
+		TEST_CHECK(pPayload != NULL);
+		pRecord = TestNewRecords(1, pnRand);
+		memcpy(pPayload, pRecord, sizeof(TestRecord));
+		TEST_CHECK(TestSame(ListGetAt(pList, pos), pRecord->nSeq));
+		TestRefInsert(pRef, nCount, pRecord->nSeq);
+		break;
+
+	case TEST_BATCH:
+		return TestBatch(pList, pRef, nFlags, pnRand);
+
+	case TEST_REMOVE_HEAD:
+		TEST_CHECK(ListRemoveHead(pList) == 0);
+		TestRefRemove(pRef, 0, 1);
+		break;
+
+	case TEST_REMOVE_TAIL:
+		TEST_CHECK(ListRemoveTail(pList) == 0);
+		TestRefRemove(pRef, nCount - 1, 1);
+		break;
+
+	case TEST_REMOVE_AT:
+		TEST_CHECK(ListRemoveAt(pList, ListFindIndex(pList, nIndex)) == 0);
+		TestRefRemove(pRef, nIndex, 1);
+		break;
+
+	case TEST_SET_AT:
+		pRecord = TestNewRecords(1, pnRand);
+		TEST_CHECK(ListSetAt(pList, ListFindIndex(pList, nIndex), pRecord) == 0);
+		pRef->anSeq[nIndex] = pRecord->nSeq;
+		break;
+
+	case TEST_REMOVE_RANGE:
+		nItems = 1 + (int)(TestRand(pnRand) % (unsigned int)(nCount - nIndex));
+		TEST_CHECK(ListRemoveRange(pList, ListFindIndex(pList, nIndex),
+				ListFindIndex(pList, nIndex + nItems - 1)) == nItems);
+		TestRefRemove(pRef, nIndex, nItems);
+		break;
+
+	case TEST_REMOVE_HEAD_N:
+		nItems = 1 + (int)(TestRand(pnRand) % TEST_MAX_BATCH);
+		if (nItems > nCount)
+			nItems = nCount;
+		TEST_CHECK(ListRemoveHeadN(pList, nItems) == nItems);
+		TestRefRemove(pRef, 0, nItems);
+		break;
+
+	case TEST_SPLICE:
+		return TestSplice(pList, pRef, apList[1 - nList], apRef[1 - nList], nFlags, pnRand);
+
+	case TEST_MOVE:
+		pos = ListFindIndex(pList, nIndex);
+		if (!(nFlags & TEST_NODE_LINKED)) {
+			TEST_CHECK(ListMoveToHead(pList, pos) == -1);
+			break;
+		}
+		nSeq = pRef->anSeq[nIndex];
+		TestRefRemove(pRef, nIndex, 1);
+		if (TestRand(pnRand) & 1) {
+			TEST_CHECK(ListMoveToHead(pList, pos) == 0);
+			TestRefInsert(pRef, 0, nSeq);
+		}
+		else {
+			TEST_CHECK(ListMoveToTail(pList, pos) == 0);
+			TestRefInsert(pRef, nCount - 1, nSeq);
+		}
+		TEST_CHECK(TestSame(ListGetAt(pList, pos), nSeq));
+		break;
+
+	case TEST_SORT:
+		if (TestRand(pnRand) % 4 != 0)
+			break;
+		TEST_CHECK(ListSort(pList, TestCompareKeys) == 0);
+		TestRefSort(pRef);
+		break;
+
+	case TEST_REMOVE_WALKING:
+		return TestRemoveWalking(pList, pRef, nFlags, pnRand);
+
+	case TEST_REMOVE_ALL:
+		if (TestRand(pnRand) % 8 != 0)
+			break;
+		TEST_CHECK(ListRemoveAll(pList) == 0);
+		pRef->nCount = 0;
+		break;
+	}
+
+	return 0;
+}
+
+static int TestRunMode(const TestMode *pMode, unsigned int nSeed) {
+
+	static TestRef	aRefs[2];
+	CList		aLists[2];
+	CList		*apList[2] = { &aLists[0], &aLists[1] };
+	TestRef		*apRef[2] = { &aRefs[0], &aRefs[1] };
+	unsigned int	nRand = nSeed;
+	int			nResult = 0;
+	int			nStep;
+	int			i;
+
+	g_nRecords = 0;
+	InitListFixedPool(&g_fixedPool, 0, 0);
+	InitListArena(&g_arena, 0);
+
+	for (i = 0; i < 2; i++) {
+		aRefs[i].nCount = 0;
+		if (pMode->Init(&aLists[i]) != 0) {
+			fprintf(stderr, "%s: init failed\n", pMode->pszName);
+			return -1;
+		}
+	}
+
+	for (nStep = 0; nStep < TEST_STEPS && nResult == 0; nStep++) {
+
+		nResult = TestStep(apList, apRef, pMode->nFlags, &nRand);
+
+		for (i = 0; i < 2 && nResult == 0; i++)
+			nResult = TestCheckList(apList[i], apRef[i], pMode->nFlags,
+					nStep % TEST_FULL_CHECK_STEPS == 0, &nRand);
+	}
+
+	if (nResult != 0)
+		fprintf(stderr, "%s: failed at step %d (seed %u)\n", pMode->pszName, nStep - 1, nSeed);
+
+	for (i = 0; i < 2; i++)
+		DestroyList(&aLists[i]);
+
+	DestroyListFixedPool(&g_fixedPool);
+	DestroyListArena(&g_arena);
+
+	return nResult;
+}
+
+/*-----------------------------------------------------------------------------
+ * snapshots
+ * --------------------------------------------------------------------------*/
+static int TestSnapshot(unsigned int nSeed) {
+
+	CList		list;
+	CList		loaded;
+	CList		mapped;
+	CList		other;
+	TestRef		ref;
+	TestRecord	*pRecords;
+	FILE		*pFile;
+	POSITION	pos;
+	unsigned int	nRand = nSeed;
+	int			i;
+
+	g_nRecords = 0;
+	pRecords = TestNewRecords(100, &nRand);
+
+	InitList(&list, (int)sizeof(TestRecord));
+	TEST_CHECK(ListAddTailBatch(&list, pRecords, 100) != NULL);
+	for (i = 0; i < 100; i++)
+		ref.anSeq[i] = i;
+	ref.nCount = 100;
+
+	pFile = tmpfile();
+	TEST_CHECK(pFile != NULL);
+	TEST_CHECK(SaveList(&list, fileno(pFile)) == 0);
+
+	InitList(&loaded, (int)sizeof(TestRecord));
+	TEST_CHECK(LoadList(&loaded, fileno(pFile)) == 0);
+	TEST_CHECK(TestCheckList(&loaded, &ref, 0, 1, &nRand) == 0);
+
+	/* loaded nodes come from malloc like the list's own, so they relink */
+	InitList(&other, (int)sizeof(TestRecord));
+	TEST_CHECK(ListAddTail(&other, pRecords) != NULL);
+	pos = ListGetHeadPosition(&loaded);
+	TEST_CHECK(ListConcat(&other, &loaded) == 100);
+	TEST_CHECK(ListFindIndex(&other, 1) == pos);
+	TEST_CHECK(ListRemoveHead(&other) == 0);
+	TEST_CHECK(ListConcat(&loaded, &other) == 100);
+	TEST_CHECK(ListGetHeadPosition(&loaded) == pos);
+	TEST_CHECK(TestCheckList(&loaded, &ref, 0, 1, &nRand) == 0);
+	DestroyList(&other);
+
+	TEST_CHECK(InitListMapped(&mapped, fileno(pFile)) == 0);
+	fclose(pFile);
+	TEST_CHECK(TestCheckList(&mapped, &ref, 0, 1, &nRand) == 0);
+
+	/* read-only: every change is refused and nothing moves */
+	InitList(&other, (int)sizeof(TestRecord));
+	TEST_CHECK(ListAddTail(&mapped, pRecords) == NULL);
+	TEST_CHECK(ListRemoveHead(&mapped) == -1);
+	pos = ListGetHeadPosition(&mapped);
+	TEST_CHECK(ListErase(&mapped, &pos) == -1 && pos == ListGetHeadPosition(&mapped));
+	TEST_CHECK(ListRemoveHeadN(&mapped, 3) == -1);
+	TEST_CHECK(ListRemoveRange(&mapped, ListFindIndex(&mapped, 0), ListFindIndex(&mapped, 9)) == -1);
+	TEST_CHECK(ListConcat(&other, &mapped) == -1);
+	TEST_CHECK(ListSplitAt(&mapped, ListFindIndex(&mapped, 50), &other) == -1);
+	TEST_CHECK(ListMerge(&other, &mapped, TestCompareKeys) == -1);
+	TEST_CHECK(ListGetCount(&other) == 0);
+	TEST_CHECK(TestCheckList(&mapped, &ref, 0, 1, &nRand) == 0);
+
+	DestroyList(&other);
+	DestroyList(&mapped);
+	DestroyList(&loaded);
+	DestroyList(&list);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * CLIST_DEFINE lists, stepped together with a CList
+ * --------------------------------------------------------------------------*/
+static int TestCheckTyped(TestTypedList *pList, const TestRef *pRef) {
+
+	TestTypedListNode	*pos;
+	int					i;
+
+	TEST_CHECK(TestTypedListGetCount(pList) == pRef->nCount);
+	TEST_CHECK(TestTypedListIsEmpty(pList) == (pRef->nCount != 0));
+
+	if (pRef->nCount == 0) {
+		TEST_CHECK(TestTypedListGetHead(pList) == NULL);
+		TEST_CHECK(TestTypedListGetTail(pList) == NULL);
+		TEST_CHECK(TestTypedListGetHeadPosition(pList) == NULL);
+		return 0;
+	}
+
+	TEST_CHECK(TestSame(TestTypedListGetHead(pList), pRef->anSeq[0]));
+	TEST_CHECK(TestSame(TestTypedListGetTail(pList), pRef->anSeq[pRef->nCount - 1]));
+
+	pos = TestTypedListGetHeadPosition(pList);
+	for (i = 0; i < pRef->nCount; i++) {
+		TEST_CHECK(pos != NULL);
+		TEST_CHECK(TestSame(TestTypedListGetNext(pList, &pos), pRef->anSeq[i]));
+	}
+	TEST_CHECK(pos == NULL);
+
+	pos = TestTypedListGetTailPosition(pList);
+	for (i = pRef->nCount - 1; i >= 0; i--) {
+		TEST_CHECK(pos != NULL);
+		TEST_CHECK(TestSame(TestTypedListGetPrev(pList, &pos), pRef->anSeq[i]));
+	}
+	TEST_CHECK(pos == NULL);
+
+	for (i = 0; i < pRef->nCount; i++)
+		TEST_CHECK(TestSame(TestTypedListGetAt(pList, TestTypedListFindIndex(pList, i)),
+				pRef->anSeq[i]));
+	TEST_CHECK(TestTypedListFindIndex(pList, pRef->nCount) == NULL);
+	TEST_CHECK(TestTypedListFindIndex(pList, -1) == NULL);
+
+	return 0;
+}
+
+/* one step on both lists, the operations CLIST_DEFINE generates */
+static int TestTypedStep(TestTypedList *pTyped, CList *pList, TestRef *pRef,
+		unsigned int *pnRand) {
+
+	TestTypedListNode	*posTyped;
+	TestTypedListNode	*posTypedAt;
+	TestRecord			*pRecord;
+	POSITION			pos;
+	POSITION			posAt;
+	int					nCount = pRef->nCount;
+	int					nIndex = (nCount > 0) ? (int)(TestRand(pnRand) % (unsigned int)nCount) : 0;
+	int					nOp = (int)(TestRand(pnRand) % 10);
+	int					nKey;
+
+	if (nOp <= 3 && nCount >= TEST_MAX_LENGTH)
+		nOp = 4;
+	if (nCount == 0 && nOp >= 2)
+		nOp = 1;
+
+	switch (nOp) {
+
+	case 0:
+		pRecord = TestNewRecords(1, pnRand);
+		posTyped = TestTypedListAddHead(pTyped, pRecord);
+		TEST_CHECK(TestSame(TestTypedListGetAt(pTyped, posTyped), pRecord->nSeq));
+		TEST_CHECK(ListAddHead(pList, pRecord) != NULL);
+		TestRefInsert(pRef, 0, pRecord->nSeq);
+		break;
+
+	case 1:
+		pRecord = TestNewRecords(1, pnRand);
+		posTyped = TestTypedListAddTail(pTyped, pRecord);
+		TEST_CHECK(TestSame(TestTypedListGetAt(pTyped, posTyped), pRecord->nSeq));
+		TEST_CHECK(ListAddTail(pList, pRecord) != NULL);
+		TestRefInsert(pRef, nCount, pRecord->nSeq);
+		break;
+
+	case 2:
+		pRecord = TestNewRecords(1, pnRand);
+		posTyped = TestTypedListInsertNext(pTyped, TestTypedListFindIndex(pTyped, nIndex),
+				pRecord);
+		TEST_CHECK(TestSame(TestTypedListGetAt(pTyped, posTyped), pRecord->nSeq));
+		TEST_CHECK(ListInsertNext(pList, ListFindIndex(pList, nIndex), pRecord) != NULL);
+		TestRefInsert(pRef, nIndex + 1, pRecord->nSeq);
+		break;
+
+	case 3:
+		pRecord = TestNewRecords(1, pnRand);
+		posTyped = TestTypedListInsertPrev(pTyped, TestTypedListFindIndex(pTyped, nIndex),
+				pRecord);
+		TEST_CHECK(TestSame(TestTypedListGetAt(pTyped, posTyped), pRecord->nSeq));
+		TEST_CHECK(ListInsertPrev(pList, ListFindIndex(pList, nIndex), pRecord) != NULL);
+		TestRefInsert(pRef, nIndex, pRecord->nSeq);
+		break;
+
+	case 4:
+		TEST_CHECK(TestTypedListRemoveHead(pTyped) == 0);
+		TEST_CHECK(ListRemoveHead(pList) == 0);
+		TestRefRemove(pRef, 0, 1);
+		break;
+
+	case 5:
+		TEST_CHECK(TestTypedListRemoveTail(pTyped) == 0);
+		TEST_CHECK(ListRemoveTail(pList) == 0);
+		TestRefRemove(pRef, nCount - 1, 1);
+		break;
+
+	case 6:
+		TEST_CHECK(TestTypedListRemoveAt(pTyped, TestTypedListFindIndex(pTyped, nIndex)) == 0);
+		TEST_CHECK(ListRemoveAt(pList, ListFindIndex(pList, nIndex)) == 0);
+		TestRefRemove(pRef, nIndex, 1);
+		break;
+
+	case 7:
+		pRecord = TestNewRecords(1, pnRand);
+		TEST_CHECK(TestTypedListSetAt(pTyped, TestTypedListFindIndex(pTyped, nIndex),
+				pRecord) == 0);
+		TEST_CHECK(ListSetAt(pList, ListFindIndex(pList, nIndex), pRecord) == 0);
+		pRef->anSeq[nIndex] = pRecord->nSeq;
+		break;
+
+	case 8:
+		/* drop every element with the key of element nIndex, removing the
+		   node GetNext just stepped over on both lists */
+		nKey = g_aRecords[pRef->anSeq[nIndex]].nKey;
+		posTyped = TestTypedListGetHeadPosition(pTyped);
+		pos = ListGetHeadPosition(pList);
+		for (nIndex = 0; posTyped != NULL; ) {
+			posTypedAt = posTyped;
+			posAt = pos;
+			pRecord = TestTypedListGetNext(pTyped, &posTyped);
+			TEST_CHECK(TestSame(ListGetNext(pList, &pos), pRecord->nSeq));
+			if (pRecord->nKey != nKey) {
+				nIndex++;
+				continue;
+			}
+			TestRefRemove(pRef, nIndex, 1);
+			TEST_CHECK(TestTypedListRemoveAt(pTyped, posTypedAt) == 0);
+			TEST_CHECK(ListRemoveAt(pList, posAt) == 0);
+		}
+		TEST_CHECK(pos == NULL);
+		break;
+
+	case 9:
+		if (TestRand(pnRand) % 8 != 0)
+			break;
+		TEST_CHECK(TestTypedListRemoveAll(pTyped) == 0);
+		TEST_CHECK(ListRemoveAll(pList) == 0);
+		pRef->nCount = 0;
+		break;
+	}
+
+	return 0;
+}
+
+static int TestTyped(unsigned int nSeed) {
+
+	static TestRef	ref;
+	TestTypedList	typed;
+	CList			list;
+	unsigned int	nRand = nSeed;
+	int				nResult = 0;
+	int				nStep;
+
+	g_nRecords = 0;
+	ref.nCount = 0;
+	InitTestTypedList(&typed);
+	InitList(&list, (int)sizeof(TestRecord));
+
+	TEST_CHECK(TestTypedListRemoveHead(&typed) == -1);
+	TEST_CHECK(TestTypedListRemoveAt(&typed, NULL) == -1);
+	TEST_CHECK(TestTypedListInsertNext(&typed, NULL, &g_aRecords[0]) == NULL);
+	TEST_CHECK(TestTypedListAddTail(&typed, NULL) == NULL);
+
+	for (nStep = 0; nStep < TEST_STEPS && nResult == 0; nStep++) {
+		nResult = TestTypedStep(&typed, &list, &ref, &nRand);
+		if (nResult == 0)
+			nResult = TestCheckTyped(&typed, &ref);
+		if (nResult == 0)
+			nResult = TestCheckList(&list, &ref, 0, nStep % TEST_FULL_CHECK_STEPS == 0, &nRand);
+	}
+
+	if (nResult != 0)
+		fprintf(stderr, "typed: failed at step %d (seed %u)\n", nStep - 1, nSeed);
+
+	DestroyTestTypedList(&typed);
+	DestroyList(&list);
+
+	return nResult;
+}
+
+/*-----------------------------------------------------------------------------
+ * ListXxxSized calls
+ * --------------------------------------------------------------------------*/
+/* record numbers and stored lengths of a list's elements in list order */
+typedef struct TestSizedRef {
+
+	int		anSeq[TEST_MAX_LENGTH + 1];
+	int		anSize[TEST_MAX_LENGTH + 1];
+	int		nCount;
+
+} TestSizedRef;
+
+static void TestSizedFill(unsigned char *pData, int nSeq, int nSize) {
+
+	int i;
+
+	for (i = 0; i < nSize; i++)
+		pData[i] = (unsigned char)(nSeq * 31 + i * 7 + 1);
+}
+
+/* a length for a new payload: 0, the maximum or anything between */
+static int TestSizedLength(unsigned int *pnRand) {
+
+	switch (TestRand(pnRand) % 8) {
+
+	case 0:
+		return 0;
+
+	case 1:
+		return TEST_SIZED_MAX;
+
+	default:
+		return (int)(TestRand(pnRand) % TEST_SIZED_MAX);
+	}
+}
+
+static void TestSizedRefInsert(TestSizedRef *pRef, int nIndex, int nSeq, int nSize) {
+
+	memmove(&pRef->anSeq[nIndex + 1], &pRef->anSeq[nIndex],
+			(size_t)(pRef->nCount - nIndex) * sizeof(int));
+	memmove(&pRef->anSize[nIndex + 1], &pRef->anSize[nIndex],
+			(size_t)(pRef->nCount - nIndex) * sizeof(int));
+	pRef->anSeq[nIndex] = nSeq;
+	pRef->anSize[nIndex] = nSize;
+	pRef->nCount++;
+}
+
+/* element nIndex holds record nSeq's nSize bytes, the rest zeroed on
+ * lists that store nMaxDataSize */
+static int TestSizedSame(CList *pList, POSITION pos, const TestSizedRef *pRef, int nIndex,
+		int bSized) {
+
+	unsigned char	acExpected[TEST_SIZED_MAX];
+	unsigned char	*pData;
+	int				nSize = -1;
+
+	memset(acExpected, 0, sizeof(acExpected));
+	TestSizedFill(acExpected, pRef->anSeq[nIndex], pRef->anSize[nIndex]);
+
+	pData = (unsigned char *)ListGetAtSized(pList, pos, &nSize);
+	TEST_CHECK(pData != NULL);
+	TEST_CHECK(nSize == (bSized ? pRef->anSize[nIndex] : TEST_SIZED_MAX));
+	TEST_CHECK(memcmp(pData, acExpected, (size_t)nSize) == 0);
+
+	return 0;
+}
+
+static int TestSizedCheck(CList *pList, const TestSizedRef *pRef, int bSized, int bAllIndexes,
+		unsigned int *pnRand) {
+
+	POSITION	pos;
+	int			i;
+
+	TEST_CHECK(ListGetCount(pList) == pRef->nCount);
+
+	pos = ListGetHeadPosition(pList);
+	for (i = 0; i < pRef->nCount; i++) {
+		TEST_CHECK(pos != NULL);
+		TEST_CHECK(TestSizedSame(pList, pos, pRef, i, bSized) == 0);
+		ListGetNext(pList, &pos);
+	}
+	TEST_CHECK(pos == NULL);
+
+	for (i = 0; i < pRef->nCount; i++) {
+		if (bAllIndexes || TestRand(pnRand) % 16 == 0)
+			TEST_CHECK(TestSizedSame(pList, ListFindIndex(pList, i), pRef, i, bSized) == 0);
+	}
+
+	return 0;
+}
+
+static int TestSizedStep(CList *pList, TestSizedRef *pRef, int bSized, int *pnMoved,
+		unsigned int *pnRand) {
+
+	unsigned char	acData[TEST_SIZED_MAX];
+	POSITION		pos;
+	POSITION		posOld;
+	int				nCount = pRef->nCount;
+	int				nIndex = (nCount > 0) ? (int)(TestRand(pnRand) % (unsigned int)nCount) : 0;
+	int				nOp = (int)(TestRand(pnRand) % 6);
+	int				nSeq = g_nRecords++;
+	int				nSize = TestSizedLength(pnRand);
+
+	if (nOp <= 3 && nCount >= TEST_MAX_LENGTH)
+		nOp = 5;
+	if (nCount == 0)
+		nOp = (int)(TestRand(pnRand) & 1);
+
+	TestSizedFill(acData, nSeq, nSize);
+
+	switch (nOp) {
+
+	case 0:
+		pos = ListAddHeadSized(pList, acData, nSize);
+		TEST_CHECK(pos != NULL && pos == ListGetHeadPosition(pList));
+		TestSizedRefInsert(pRef, 0, nSeq, nSize);
+		break;
+
+	case 1:
+		pos = ListAddTailSized(pList, acData, nSize);
+		TEST_CHECK(pos != NULL && pos == ListGetTailPosition(pList));
+		TestSizedRefInsert(pRef, nCount, nSeq, nSize);
+		break;
+
+	case 2:
+		pos = ListInsertNextSized(pList, ListFindIndex(pList, nIndex), acData, nSize);
+		TEST_CHECK(pos != NULL);
+		TestSizedRefInsert(pRef, nIndex + 1, nSeq, nSize);
+		TEST_CHECK(TestSizedSame(pList, pos, pRef, nIndex + 1, bSized) == 0);
+		break;
+
+	case 3:
+		pos = ListInsertPrevSized(pList, ListFindIndex(pList, nIndex), acData, nSize);
+		TEST_CHECK(pos != NULL);
+		TestSizedRefInsert(pRef, nIndex, nSeq, nSize);
+		TEST_CHECK(TestSizedSame(pList, pos, pRef, nIndex, bSized) == 0);
+		break;
+
+	case 4:
+		/* a length far from the old one makes sized lists move the node;
+		   FindIndex leaves its cursor on it first */
+		if (TestRand(pnRand) & 1)
+			nSize = (pRef->anSize[nIndex] < TEST_SIZED_MAX / 4) ? TEST_SIZED_MAX : 1;
+		TestSizedFill(acData, nSeq, nSize);
+		pos = ListFindIndex(pList, nIndex);
+		posOld = pos;
+		TEST_CHECK(ListSetAtSized(pList, &pos, acData, nSize) == 0);
+		if (!bSized)
+			TEST_CHECK(pos == posOld);
+		else if (pos != posOld)
+			(*pnMoved)++;
+		pRef->anSeq[nIndex] = nSeq;
+		pRef->anSize[nIndex] = nSize;
+		TEST_CHECK(TestSizedSame(pList, pos, pRef, nIndex, bSized) == 0);
+		TEST_CHECK(ListFindIndex(pList, nIndex) == pos);
+		if (nIndex + 1 < nCount)
+			TEST_CHECK(TestSizedSame(pList, ListFindIndex(pList, nIndex + 1), pRef,
+					nIndex + 1, bSized) == 0);
+		if (nIndex > 0)
+			TEST_CHECK(TestSizedSame(pList, ListFindIndex(pList, nIndex - 1), pRef,
+					nIndex - 1, bSized) == 0);
+		break;
+
+	case 5:
+		TEST_CHECK(ListRemoveAt(pList, ListFindIndex(pList, nIndex)) == 0);
+		memmove(&pRef->anSeq[nIndex], &pRef->anSeq[nIndex + 1],
+				(size_t)(nCount - nIndex - 1) * sizeof(int));
+		memmove(&pRef->anSize[nIndex], &pRef->anSize[nIndex + 1],
+				(size_t)(nCount - nIndex - 1) * sizeof(int));
+		pRef->nCount--;
+		break;
+	}
+
+	return 0;
+}
+
+static int TestSizedRun(const char *pszName, int bSized, unsigned int nSeed) {
+
+	static TestSizedRef	ref;
+	unsigned char		acData[TEST_SIZED_MAX + 1];
+	CList				list;
+	POSITION			pos;
+	unsigned int		nRand = nSeed;
+	int					nMoved = 0;
+	int					nResult = 0;
+	int					nStep;
+
+	if (bSized)
+		TEST_CHECK(InitListSized(&list, TEST_SIZED_MAX) == 0);
+	else
+		TEST_CHECK(InitListStorage(&list, TEST_SIZED_MAX, LIST_STORAGE_CHUNK) == 0);
+
+	g_nRecords = 0;
+	ref.nCount = 0;
+	memset(acData, 0, sizeof(acData));
+
+	/* too long, or no bytes for a length, is refused */
+	TEST_CHECK(ListAddTailSized(&list, acData, TEST_SIZED_MAX + 1) == NULL);
+	TEST_CHECK(ListAddHeadSized(&list, NULL, 1) == NULL);
+	TEST_CHECK(ListAddTailSized(&list, acData, -1) == NULL);
+	TEST_CHECK(ListGetCount(&list) == 0);
+	pos = ListAddTailSized(&list, NULL, 0);
+	TEST_CHECK(pos != NULL);
+	TEST_CHECK(ListSetAtSized(&list, &pos, acData, TEST_SIZED_MAX + 1) == -1);
+	TEST_CHECK(ListInsertNextSized(&list, NULL, acData, 1) == NULL);
+	TEST_CHECK(ListRemoveAll(&list) == 0);
+
+	for (nStep = 0; nStep < TEST_STEPS && nResult == 0; nStep++) {
+		nResult = TestSizedStep(&list, &ref, bSized, &nMoved, &nRand);
+		if (nResult == 0)
+			nResult = TestSizedCheck(&list, &ref, bSized,
+					nStep % TEST_FULL_CHECK_STEPS == 0, &nRand);
+	}
+
+	if (nResult != 0)
+		fprintf(stderr, "%s: failed at step %d (seed %u)\n", pszName, nStep - 1, nSeed);
+
+	/* the moving ListSetAtSized path was taken */
+	if (nResult == 0 && bSized && nMoved == 0) {
+		fprintf(stderr, "%s: ListSetAtSized never moved a node\n", pszName);
+		nResult = -1;
+	}
+
+	DestroyList(&list);
+
+	return nResult;
+}
+
+/*-----------------------------------------------------------------------------
+ * ListInsertSorted and ListMerge
+ * --------------------------------------------------------------------------*/
+/* where ListInsertSorted puts a record: after the last one not greater */
+static void TestRefInsertSorted(TestRef *pRef, int nSeq) {
+
+	int i = pRef->nCount;
+
+	while (i > 0 && g_aRecords[pRef->anSeq[i - 1]].nKey > g_aRecords[nSeq].nKey)
+		i--;
+
+	TestRefInsert(pRef, i, nSeq);
+}
+
+/* nItems records added with ListInsertSorted */
+static int TestFillSorted(CList *pList, TestRef *pRef, int nItems, unsigned int *pnRand) {
+
+	TestRecord	*pRecord;
+	POSITION	pos;
+	int			i;
+
+	for (i = 0; i < nItems; i++) {
+		pRecord = TestNewRecords(1, pnRand);
+		pos = ListInsertSorted(pList, pRecord, TestCompareKeys);
+		TEST_CHECK(TestSame(ListGetAt(pList, pos), pRecord->nSeq));
+		TestRefInsertSorted(pRef, pRecord->nSeq);
+	}
+
+	return TestCheckList(pList, pRef, 0, 1, pnRand);
+}
+
+/* ListMerge of a pSrc list into a pDst list: pDst's elements first on
+ * ties, and with bRelink the pSrc nodes themselves end up in pDst */
+static int TestMergePair(int (*InitDst)(CList *pList), int (*InitSrc)(CList *pList),
+		int bRelink, unsigned int *pnRand) {
+
+	static TestRef	dstRef;
+	static TestRef	srcRef;
+	static TestRef	mergedRef;
+	POSITION		apSrcPos[TEST_MAX_LENGTH];
+	CList			dst;
+	CList			src;
+	POSITION		pos;
+	int				nSrc;
+	int				i;
+	int				j;
+
+	TEST_CHECK(InitDst(&dst) == 0);
+	TEST_CHECK(InitSrc(&src) == 0);
+	dstRef.nCount = 0;
+	srcRef.nCount = 0;
+
+	TEST_CHECK(TestFillSorted(&dst, &dstRef, 1 + (int)(TestRand(pnRand) % 120), pnRand) == 0);
+	TEST_CHECK(TestFillSorted(&src, &srcRef, 1 + (int)(TestRand(pnRand) % 120), pnRand) == 0);
+
+	pos = ListGetHeadPosition(&src);
+	for (nSrc = 0; pos != NULL; nSrc++) {
+		apSrcPos[nSrc] = pos;
+		ListGetNext(&src, &pos);
+	}
+
+	/* stable merge of the references, dstRef's records win ties */
+	for (i = 0, j = 0, mergedRef.nCount = 0; i < dstRef.nCount || j < srcRef.nCount; ) {
+		if (j == srcRef.nCount || (i < dstRef.nCount &&
+				g_aRecords[dstRef.anSeq[i]].nKey <= g_aRecords[srcRef.anSeq[j]].nKey))
+			mergedRef.anSeq[mergedRef.nCount++] = dstRef.anSeq[i++];
+		else
+			mergedRef.anSeq[mergedRef.nCount++] = srcRef.anSeq[j++];
+	}
+
+	TEST_CHECK(ListMerge(&dst, &src, TestCompareKeys) == nSrc);
+	TEST_CHECK(ListGetCount(&src) == 0);
+	TEST_CHECK(ListGetHeadPosition(&src) == NULL);
+	TEST_CHECK(TestCheckList(&dst, &mergedRef, 0, 1, pnRand) == 0);
+
+	if (bRelink) {
+		pos = ListGetHeadPosition(&dst);
+		for (i = 0, j = 0; pos != NULL; i++) {
+			if (j < nSrc && mergedRef.anSeq[i] == srcRef.anSeq[j])
+				TEST_CHECK(pos == apSrcPos[j++]);
+			ListGetNext(&dst, &pos);
+		}
+		TEST_CHECK(j == nSrc);
+	}
+
+	/* merging an empty list moves nothing */
+	TEST_CHECK(ListMerge(&dst, &src, TestCompareKeys) == 0);
+
+	DestroyList(&src);
+	DestroyList(&dst);
+
+	return 0;
+}
+
+static int TestSorted(unsigned int nSeed) {
+
+	static TestRef	ref;
+	CList			list;
+	unsigned int	nRand = nSeed;
+	int				nRound;
+
+	g_nRecords = 0;
+
+	/* walking back from the tail, and the indexed binary search */
+	ref.nCount = 0;
+	InitList(&list, (int)sizeof(TestRecord));
+	TEST_CHECK(ListInsertSorted(&list, NULL, TestCompareKeys) == NULL);
+	TEST_CHECK(ListInsertSorted(&list, &g_aRecords[0], NULL) == NULL);
+	TEST_CHECK(TestFillSorted(&list, &ref, 200, &nRand) == 0);
+	DestroyList(&list);
+
+	ref.nCount = 0;
+	TEST_CHECK(TestInitIndexed(&list) == 0);
+	TEST_CHECK(TestFillSorted(&list, &ref, 200, &nRand) == 0);
+	DestroyList(&list);
+
+	ref.nCount = 0;
+	TEST_CHECK(TestInitChunk(&list) == 0);
+	TEST_CHECK(TestFillSorted(&list, &ref, 200, &nRand) == 0);
+	DestroyList(&list);
+
+	for (nRound = 0; nRound < 8; nRound++) {
+
+		g_nRecords = 0;
+
+		/* same node layout and allocator: relinked */
+		TEST_CHECK(TestMergePair(TestInitNode, TestInitNode, 1, &nRand) == 0);
+		TEST_CHECK(TestMergePair(TestInitIndexed, TestInitIndexed, 1, &nRand) == 0);
+
+		/* another node layout, storage or a pool: copied */
+		TEST_CHECK(TestMergePair(TestInitIndexed, TestInitNode, 0, &nRand) == 0);
+		TEST_CHECK(TestMergePair(TestInitNode, TestInitChunk, 0, &nRand) == 0);
+		TEST_CHECK(TestMergePair(TestInitChunk, TestInitNode, 0, &nRand) == 0);
+		TEST_CHECK(TestMergePair(TestInitPool, TestInitNode, 0, &nRand) == 0);
+		TEST_CHECK(TestMergePair(TestInitDeque, TestInitDeque, 0, &nRand) == 0);
+	}
+
+	return 0;
+}
+
+#ifdef CLIST_LEGACY_API
+/*-----------------------------------------------------------------------------
+ * l.AddTail(&l, p) style calls through the per-instance pointers
+ * --------------------------------------------------------------------------*/
+static int TestLegacyApi(void) {
+
+	CList		list;
+	TestRecord	record = { 7, 0, { 0 } };
+	POSITION	pos;
+	int			i;
+
+	InitList(&list, (int)sizeof(TestRecord));
+	for (i = 0; i < 10; i++) {
+		record.nSeq = i;
+		TEST_CHECK(list.AddTail(&list, &record) != NULL);
+	}
+	TEST_CHECK(list.GetCount(&list) == 10);
+	TEST_CHECK(list.IsEmpty(&list) == 1);
+
+	pos = list.FindIndex(&list, 4);
+	TEST_CHECK(pos != NULL && ((TestRecord *)list.GetAt(&list, pos))->nSeq == 4);
+	TEST_CHECK(list.RemoveAt(&list, pos) == 0);
+	TEST_CHECK(((TestRecord *)list.GetHead(&list))->nSeq == 0);
+	TEST_CHECK(((TestRecord *)list.GetTail(&list))->nSeq == 9);
+	TEST_CHECK(list.RemoveAll(&list) == 0);
+	TEST_CHECK(list.IsEmpty(&list) == 0);
+	DestroyList(&list);
+
+	/* other storages fill in their own functions */
+	TEST_CHECK(InitListStorage(&list, (int)sizeof(TestRecord), LIST_STORAGE_CHUNK) == 0);
+	TEST_CHECK(list.AddTail == list.pOps->AddTail);
+	TEST_CHECK(list.AddHead(&list, &record) != NULL);
+	TEST_CHECK(list.GetCount(&list) == 1);
+	DestroyList(&list);
+
+	return 0;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+
+	unsigned int nSeed = 1;
+	int nFailed = 0;
+	size_t i;
+
+	if (argc > 1)
+		nSeed = (unsigned int)strtoul(argv[1], NULL, 10);
+
+	for (i = 0; i < sizeof(g_aModes) / sizeof(g_aModes[0]); i++) {
+		if (TestRunMode(&g_aModes[i], nSeed) != 0)
+			nFailed++;
+	}
+
+	if (TestSnapshot(nSeed) != 0) {
+		fprintf(stderr, "snapshot: failed (seed %u)\n", nSeed);
+		nFailed++;
+	}
+
+	if (TestTyped(nSeed) != 0)
+		nFailed++;
+
+	if (TestSorted(nSeed) != 0) {
+		fprintf(stderr, "sorted inserts and merges: failed (seed %u)\n", nSeed);
+		nFailed++;
+	}
+
+	if (TestSizedRun("sized calls", 1, nSeed) != 0)
+		nFailed++;
+
+	if (TestSizedRun("sized calls on chunk", 0, nSeed) != 0)
+		nFailed++;
+
+#ifdef CLIST_LEGACY_API
+	if (TestLegacyApi() != 0) {
+		fprintf(stderr, "legacy api: failed\n");
+		nFailed++;
+	}
+#endif
+
+	if (nFailed == 0)
+		printf("clist_test: %d modes, snapshots, typed lists, sorted inserts, merges and sized calls passed (seed %u)\n",
+				(int)(sizeof(g_aModes) / sizeof(g_aModes[0])), nSeed);
+
+	return (nFailed == 0) ? 0 : 1;
+}
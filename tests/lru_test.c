@@ -0,0 +1,288 @@
+/******************************************************************************
+    clist_lru_test: CListLru against a reference array of its entries, kept
+    from most to least recently used.
+
+    order: a fixed sequence checks the eviction order, that Put of a cached
+    key replaces the entry without evicting, that Peek leaves the order
+    alone while Get moves the entry to the front, and that the evicted
+    entry is copied out whole.
+
+    random: random Get/Peek/Put/Remove calls on a small key space, each one
+    checked against the reference, the whole cache compared every step.
+******************************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list_lru.h"
+#include "test.h"
+
+#define TEST_CAPACITY		8
+#define TEST_KEYS			20			/* more than fit, so Put evicts */
+#define TEST_STEPS			20000
+
+typedef struct TestEntry {
+
+	int		nKey;
+	int		nValue;
+	char	acName[32];		/* derived from both, checks whole copies */
+
+} TestEntry;
+
+/* the cache's entries, index 0 most recently used */
+typedef struct TestRef {
+
+	TestEntry	aEntries[TEST_CAPACITY];
+	int			nCount;
+
+} TestRef;
+
+static void TestMakeEntry(TestEntry *pEntry, int nKey, int nValue) {
+
+	memset(pEntry, 0, sizeof(TestEntry));
+	pEntry->nKey = nKey;
+	pEntry->nValue = nValue;
+	snprintf(pEntry->acName, sizeof(pEntry->acName), "k%d-v%d", nKey, nValue);
+}
+
+static int TestRefFind(const TestRef *pRef, int nKey) {
+
+	int i;
+
+	for (i = 0; i < pRef->nCount; i++) {
+		if (pRef->aEntries[i].nKey == nKey)
+			return i;
+	}
+
+	return -1;
+}
+
+/* move entry nIndex to the front */
+static void TestRefTouch(TestRef *pRef, int nIndex) {
+
+	TestEntry entry = pRef->aEntries[nIndex];
+
+	memmove(&pRef->aEntries[1], &pRef->aEntries[0], (size_t)nIndex * sizeof(TestEntry));
+	pRef->aEntries[0] = entry;
+}
+
+static void TestRefRemove(TestRef *pRef, int nIndex) {
+
+	memmove(&pRef->aEntries[nIndex], &pRef->aEntries[nIndex + 1],
+			(size_t)(pRef->nCount - nIndex - 1) * sizeof(TestEntry));
+	pRef->nCount--;
+}
+
+/* 0 if the cache holds the reference entries in the same order */
+static int TestCheckLru(CListLru *pLru, const TestRef *pRef) {
+
+	POSITION pos;
+	int i = 0;
+
+	TEST_CHECK(ListLruGetCount(pLru) == pRef->nCount);
+
+	for (pos = ListGetHeadPosition(&pLru->list); pos != NULL; i++) {
+		TEST_CHECK(i < pRef->nCount);
+		TEST_CHECK(memcmp(ListGetNext(&pLru->list, &pos), &pRef->aEntries[i],
+				sizeof(TestEntry)) == 0);
+	}
+
+	TEST_CHECK(i == pRef->nCount);
+
+	return 0;
+}
+
+/* the key order of the cache, most recently used first, is anKeys */
+static int TestCheckOrder(CListLru *pLru, const int *anKeys, int nKeys) {
+
+	POSITION pos;
+	int i = 0;
+
+	TEST_CHECK(ListLruGetCount(pLru) == nKeys);
+
+	for (pos = ListGetHeadPosition(&pLru->list); pos != NULL; i++)
+		TEST_CHECK(((TestEntry *)ListGetNext(&pLru->list, &pos))->nKey == anKeys[i]);
+
+	return 0;
+}
+
+static int TestOrder(void) {
+
+	static const int anFilled[] = { 3, 2, 1 };
+	static const int anPeeked[] = { 3, 2, 1 };
+	static const int anGot[] = { 1, 3, 2 };
+	static const int anReplaced[] = { 2, 1, 3 };
+	static const int anEvicted[] = { 4, 2, 1 };
+
+	CListLru	lru;
+	TestEntry	entry;
+	TestEntry	evicted;
+	TestEntry	*pEntry;
+	int			nKey;
+
+	TEST_CHECK(InitListLru(&lru, (int)sizeof(TestEntry), (int)offsetof(TestEntry, nKey),
+			(int)sizeof(int), 3, NULL) == 0);
+
+	for (nKey = 1; nKey <= 3; nKey++) {
+		TestMakeEntry(&entry, nKey, nKey * 10);
+		TEST_CHECK(ListLruPut(&lru, &entry, &evicted) == 0);
+	}
+	TEST_CHECK(TestCheckOrder(&lru, anFilled, 3) == 0);
+
+	/* Peek finds the entry and keeps the order */
+	nKey = 1;
+	pEntry = (TestEntry *)ListLruPeek(&lru, &nKey);
+	TEST_CHECK(pEntry != NULL && pEntry->nValue == 10);
+	TEST_CHECK(TestCheckOrder(&lru, anPeeked, 3) == 0);
+
+	/* Get makes it the most recently used */
+	pEntry = (TestEntry *)ListLruGet(&lru, &nKey);
+	TEST_CHECK(pEntry != NULL && pEntry->nValue == 10);
+	TEST_CHECK(TestCheckOrder(&lru, anGot, 3) == 0);
+
+	/* Put of a cached key replaces it in place of an eviction */
+	TestMakeEntry(&entry, 2, 99);
+	memset(&evicted, 0x5a, sizeof(evicted));
+	TEST_CHECK(ListLruPut(&lru, &entry, &evicted) == 0);
+	TEST_CHECK(evicted.nKey == 0x5a5a5a5a);
+	TEST_CHECK(TestCheckOrder(&lru, anReplaced, 3) == 0);
+	nKey = 2;
+	pEntry = (TestEntry *)ListLruPeek(&lru, &nKey);
+	TEST_CHECK(pEntry != NULL && memcmp(pEntry, &entry, sizeof(TestEntry)) == 0);
+
+	/* a new key evicts the least recently used entry, copied out whole */
+	TestMakeEntry(&entry, 4, 40);
+	TEST_CHECK(ListLruPut(&lru, &entry, &evicted) == 1);
+	TestMakeEntry(&entry, 3, 30);
+	TEST_CHECK(memcmp(&evicted, &entry, sizeof(TestEntry)) == 0);
+	TEST_CHECK(TestCheckOrder(&lru, anEvicted, 3) == 0);
+	nKey = 3;
+	TEST_CHECK(ListLruGet(&lru, &nKey) == NULL);
+	TEST_CHECK(ListLruPeek(&lru, &nKey) == NULL);
+
+	/* evicting without pEvicted */
+	TestMakeEntry(&entry, 5, 50);
+	TEST_CHECK(ListLruPut(&lru, &entry, NULL) == 1);
+	nKey = 1;
+	TEST_CHECK(ListLruPeek(&lru, &nKey) == NULL);
+
+	TEST_CHECK(ListLruRemove(&lru, &nKey) == -1);
+	nKey = 4;
+	TEST_CHECK(ListLruRemove(&lru, &nKey) == 0);
+	TEST_CHECK(ListLruGetCount(&lru) == 2);
+
+	DestroyListLru(&lru);
+
+	return 0;
+}
+
+static int TestRandom(unsigned int nSeed) {
+
+	CListLru	lru;
+	TestRef		ref;
+	TestEntry	entry;
+	TestEntry	evicted;
+	TestEntry	*pEntry;
+	unsigned int	nRand = nSeed;
+	int			nKey;
+	int			nIndex;
+	int			nStep;
+
+	TEST_CHECK(InitListLru(&lru, (int)sizeof(TestEntry), (int)offsetof(TestEntry, nKey),
+			(int)sizeof(int), TEST_CAPACITY, NULL) == 0);
+	ref.nCount = 0;
+
+	for (nStep = 0; nStep < TEST_STEPS; nStep++) {
+
+		nKey = (int)(TestRand(&nRand) % TEST_KEYS);
+		nIndex = TestRefFind(&ref, nKey);
+
+		switch (TestRand(&nRand) % 4) {
+
+		case 0:
+			pEntry = (TestEntry *)ListLruGet(&lru, &nKey);
+			if (nIndex < 0) {
+				TEST_CHECK(pEntry == NULL);
+				break;
+			}
+			TEST_CHECK(pEntry != NULL &&
+					memcmp(pEntry, &ref.aEntries[nIndex], sizeof(TestEntry)) == 0);
+			TestRefTouch(&ref, nIndex);
+			break;
+
+		case 1:
+			pEntry = (TestEntry *)ListLruPeek(&lru, &nKey);
+			if (nIndex < 0)
+				TEST_CHECK(pEntry == NULL);
+			else
+				TEST_CHECK(pEntry != NULL &&
+						memcmp(pEntry, &ref.aEntries[nIndex], sizeof(TestEntry)) == 0);
+			break;
+
+		case 2:
+			TestMakeEntry(&entry, nKey, nStep);
+			if (nIndex >= 0) {
+				TEST_CHECK(ListLruPut(&lru, &entry, &evicted) == 0);
+				ref.aEntries[nIndex] = entry;
+				TestRefTouch(&ref, nIndex);
+			}
+			else if (ref.nCount < TEST_CAPACITY) {
+				TEST_CHECK(ListLruPut(&lru, &entry, &evicted) == 0);
+				ref.aEntries[ref.nCount++] = entry;
+				TestRefTouch(&ref, ref.nCount - 1);
+			}
+			else {
+				TEST_CHECK(ListLruPut(&lru, &entry, &evicted) == 1);
+				TEST_CHECK(memcmp(&evicted, &ref.aEntries[ref.nCount - 1],
+						sizeof(TestEntry)) == 0);
+				ref.aEntries[ref.nCount - 1] = entry;
+				TestRefTouch(&ref, ref.nCount - 1);
+			}
+			break;
+
+		case 3:
+			if (nIndex < 0) {
+				TEST_CHECK(ListLruRemove(&lru, &nKey) == -1);
+				break;
+			}
+			TEST_CHECK(ListLruRemove(&lru, &nKey) == 0);
+			TestRefRemove(&ref, nIndex);
+			break;
+		}
+
+		if (TestCheckLru(&lru, &ref) != 0) {
+			fprintf(stderr, "random: failed at step %d (seed %u)\n", nStep, nSeed);
+			DestroyListLru(&lru);
+			return -1;
+		}
+	}
+
+	DestroyListLru(&lru);
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	unsigned int nSeed = 1;
+	int nFailed = 0;
+
+	if (argc > 1)
+		nSeed = (unsigned int)strtoul(argv[1], NULL, 10);
+
+	if (TestOrder() != 0) {
+		fprintf(stderr, "order: failed\n");
+		nFailed++;
+	}
+
+	if (TestRandom(nSeed) != 0) {
+		fprintf(stderr, "random: failed\n");
+		nFailed++;
+	}
+
+	if (nFailed == 0)
+		printf("clist_lru_test: order and random passed (seed %u)\n", nSeed);
+
+	return (nFailed == 0) ? 0 : 1;
+}
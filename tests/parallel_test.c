@@ -0,0 +1,293 @@
+/******************************************************************************
+    clist_parallel_test: the parallel calls against their sequential forms.
+
+    foreach: ListParallelForEach updates every element exactly once, the
+    list afterwards equals the same update done by a GetNext walk.
+
+    reduce: ListParallelReduce gives the sequential value for a sum and for
+    a polynomial hash, which is associative but not commutative, so ranges
+    combined out of list order would show.
+
+    threads: a call runs on every thread it asked for, the first one and
+    those that start new pool threads included.
+
+    sort: ListSortParallel on a list long enough to be split gives the same
+    order as ListSort on a copy, ties included.
+
+    Build with -DCLIST_SANITIZE=thread to run them under ThreadSanitizer.
+******************************************************************************/
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <threads.h>
+#include <time.h>
+
+#include "list.h"
+#include "test.h"
+
+#define TEST_THREADS		4
+#define TEST_ITEMS			50000		/* above LIST_SORT_PARALLEL_MIN */
+#define TEST_KEY_RANGE		1000		/* small, so the sort sees many ties */
+#define TEST_HASH_BASE		1000003u
+#define TEST_JOIN_SECONDS	5			/* give up waiting for the other threads */
+
+typedef struct TestRecord {
+
+	int		nKey;
+	int		nSeq;		/* position when added, makes ties distinguishable */
+
+} TestRecord;
+
+typedef struct TestHash {
+
+	uint64_t	nHash;
+	uint64_t	nPower;		/* TEST_HASH_BASE to the number of elements */
+
+} TestHash;
+
+/* threads seen in the current round of TestVisitJoin */
+static atomic_int			g_nJoinRound;
+static atomic_int			g_nJoined;
+static _Thread_local int	s_nJoinRound;
+
+/* element updates and folds */
+static void TestVisitUpdate(void *pData, void *pContext) {
+
+	TestRecord *pRecord = (TestRecord *)pData;
+
+	(void)pContext;
+
+	pRecord->nKey = pRecord->nKey * 2 + 1;
+}
+
+/* count the threads of a call and hold each one until nWanted have come,
+ * so the calling thread can not run every range before the others start */
+static void TestVisitJoin(void *pData, void *pContext) {
+
+	int nWanted = *(const int *)pContext;
+	int nRound = atomic_load(&g_nJoinRound);
+	time_t nDeadline;
+
+	(void)pData;
+
+	if (s_nJoinRound == nRound)
+		return;
+
+	s_nJoinRound = nRound;
+	atomic_fetch_add(&g_nJoined, 1);
+
+	nDeadline = time(NULL) + TEST_JOIN_SECONDS;
+	while (atomic_load(&g_nJoined) < nWanted && time(NULL) < nDeadline)
+		thrd_yield();
+}
+
+static void TestReduceSum(void *pAccum, const void *pData, void *pContext) {
+
+	(void)pContext;
+
+	*(int64_t *)pAccum += ((const TestRecord *)pData)->nKey;
+}
+
+static void TestCombineSum(void *pAccum, const void *pOther, void *pContext) {
+
+	(void)pContext;
+
+	*(int64_t *)pAccum += *(const int64_t *)pOther;
+}
+
+static void TestReduceHash(void *pAccum, const void *pData, void *pContext) {
+
+	TestHash *pHash = (TestHash *)pAccum;
+	const TestRecord *pRecord = (const TestRecord *)pData;
+
+	(void)pContext;
+
+	pHash->nHash = pHash->nHash * TEST_HASH_BASE + (uint64_t)pRecord->nKey;
+	pHash->nPower *= TEST_HASH_BASE;
+}
+
+static void TestCombineHash(void *pAccum, const void *pOther, void *pContext) {
+
+	TestHash *pHash = (TestHash *)pAccum;
+	const TestHash *pTail = (const TestHash *)pOther;
+
+	(void)pContext;
+
+	pHash->nHash = pHash->nHash * pTail->nPower + pTail->nHash;
+	pHash->nPower *= pTail->nPower;
+}
+
+static int TestCompareKey(const void *pA, const void *pB) {
+
+	int nA = ((const TestRecord *)pA)->nKey;
+	int nB = ((const TestRecord *)pB)->nKey;
+
+	return (nA > nB) - (nA < nB);
+}
+
+/* fill pList with TEST_ITEMS records of pseudo random keys */
+static int TestFill(CList *pList, unsigned int nSeed) {
+
+	TestRecord record;
+	int i;
+
+	for (i = 0; i < TEST_ITEMS; i++) {
+		record.nKey = (int)(TestRand(&nSeed) % TEST_KEY_RANGE);
+		record.nSeq = i;
+		TEST_CHECK(ListAddTail(pList, &record) != NULL);
+	}
+
+	return 0;
+}
+
+/* 0 if both lists hold the same records in the same order */
+static int TestCompareLists(CList *pA, CList *pB) {
+
+	POSITION posA;
+	POSITION posB;
+	TestRecord *pRecordA;
+	TestRecord *pRecordB;
+
+	TEST_CHECK(ListGetCount(pA) == ListGetCount(pB));
+
+	posA = ListGetHeadPosition(pA);
+	posB = ListGetHeadPosition(pB);
+
+	while (posA != NULL && posB != NULL) {
+		pRecordA = (TestRecord *)ListGetNext(pA, &posA);
+		pRecordB = (TestRecord *)ListGetNext(pB, &posB);
+		TEST_CHECK(pRecordA != NULL && pRecordB != NULL);
+		TEST_CHECK(pRecordA->nKey == pRecordB->nKey);
+		TEST_CHECK(pRecordA->nSeq == pRecordB->nSeq);
+	}
+
+	TEST_CHECK(posA == NULL && posB == NULL);
+
+	return 0;
+}
+
+static int TestForEach(CList *pList, CList *pExpect) {
+
+	POSITION pos;
+
+	TEST_CHECK(ListParallelForEach(pList, TestVisitUpdate, NULL, TEST_THREADS) == 0);
+
+	for (pos = ListGetHeadPosition(pExpect); pos != NULL; )
+		TestVisitUpdate(ListGetNext(pExpect, &pos), NULL);
+
+	return TestCompareLists(pList, pExpect);
+}
+
+static int TestReduce(CList *pList) {
+
+	POSITION pos;
+	int64_t nSum = 0;
+	int64_t nExpectSum = 0;
+	TestHash hash = { 0, 1 };
+	TestHash expectHash = { 0, 1 };
+	void *pData;
+
+	for (pos = ListGetHeadPosition(pList); pos != NULL; ) {
+		pData = ListGetNext(pList, &pos);
+		TestReduceSum(&nExpectSum, pData, NULL);
+		TestReduceHash(&expectHash, pData, NULL);
+	}
+
+	TEST_CHECK(ListParallelReduce(pList, TestReduceSum, TestCombineSum,
+			&nSum, (int)sizeof(nSum), NULL, TEST_THREADS) == 0);
+	TEST_CHECK(nSum == nExpectSum);
+
+	TEST_CHECK(ListParallelReduce(pList, TestReduceHash, TestCombineHash,
+			&hash, (int)sizeof(hash), NULL, TEST_THREADS) == 0);
+	TEST_CHECK(hash.nHash == expectHash.nHash);
+	TEST_CHECK(hash.nPower == expectHash.nPower);
+
+	return 0;
+}
+
+/* a call with nThreads on the list, 0 if all of them took part */
+static int TestJoinRound(CList *pList, int nThreads) {
+
+	atomic_fetch_add(&g_nJoinRound, 1);
+	atomic_store(&g_nJoined, 0);
+
+	TEST_CHECK(ListParallelForEach(pList, TestVisitJoin, &nThreads, nThreads) == 0);
+	TEST_CHECK(atomic_load(&g_nJoined) == nThreads);
+
+	return 0;
+}
+
+/* the first call and one that grows the pool start their threads late */
+static int TestThreads(CList *pList) {
+
+	TEST_CHECK(TestJoinRound(pList, TEST_THREADS / 2) == 0);
+	TEST_CHECK(TestJoinRound(pList, TEST_THREADS) == 0);
+	TEST_CHECK(TestJoinRound(pList, TEST_THREADS) == 0);
+
+	return 0;
+}
+
+static int TestSort(CList *pList, CList *pExpect) {
+
+	POSITION pos;
+	TestRecord *pRecord;
+	TestRecord *pPrev = NULL;
+
+	TEST_CHECK(ListSortParallel(pList, TestCompareKey, TEST_THREADS) == 0);
+	TEST_CHECK(ListSort(pExpect, TestCompareKey) == 0);
+
+	/* stable: equal keys keep the order they were added in */
+	for (pos = ListGetHeadPosition(pList); pos != NULL; pPrev = pRecord) {
+		pRecord = (TestRecord *)ListGetNext(pList, &pos);
+		if (pPrev != NULL) {
+			TEST_CHECK(pPrev->nKey <= pRecord->nKey);
+			TEST_CHECK(pPrev->nKey != pRecord->nKey || pPrev->nSeq < pRecord->nSeq);
+		}
+	}
+
+	return TestCompareLists(pList, pExpect);
+}
+
+int main(void) {
+
+	CList list;
+	CList expect;
+	int nFailed = 0;
+
+	InitList(&list, (int)sizeof(TestRecord));
+	InitList(&expect, (int)sizeof(TestRecord));
+
+	if (TestFill(&list, 12345) != 0 || TestFill(&expect, 12345) != 0) {
+		fprintf(stderr, "fill: failed\n");
+		nFailed++;
+	}
+
+	/* first, while the pool has no threads yet */
+	if (nFailed == 0 && TestThreads(&list) != 0) {
+		fprintf(stderr, "threads: failed\n");
+		nFailed++;
+	}
+
+	if (nFailed == 0 && TestForEach(&list, &expect) != 0) {
+		fprintf(stderr, "foreach: failed\n");
+		nFailed++;
+	}
+
+	if (nFailed == 0 && TestReduce(&list) != 0) {
+		fprintf(stderr, "reduce: failed\n");
+		nFailed++;
+	}
+
+	if (nFailed == 0 && TestSort(&list, &expect) != 0) {
+		fprintf(stderr, "sort: failed\n");
+		nFailed++;
+	}
+
+	DestroyList(&list);
+	DestroyList(&expect);
+
+	if (nFailed == 0)
+		printf("clist_parallel_test: threads, foreach, reduce and sort passed\n");
+
+	return (nFailed == 0) ? 0 : 1;
+}
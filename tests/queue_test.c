@@ -0,0 +1,252 @@
+/******************************************************************************
+    clist_queue_test: correctness of the concurrent queues.
+
+    mpmc: TEST_PRODUCERS threads add numbered records to one CListQueue
+    while TEST_CONSUMERS threads remove them. Every record must come out
+    exactly once, and each consumer must see the records of one producer in
+    the order they were added.
+
+    spsc: one producer and one consumer thread pass numbered records
+    through a small CListSpscQueue, which wraps and fills up many times;
+    they must arrive complete and in order.
+
+    Build with -DCLIST_SANITIZE=thread to run both under ThreadSanitizer.
+******************************************************************************/
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "list_queue.h"
+#include "test.h"
+
+#define TEST_PRODUCERS			4
+#define TEST_CONSUMERS			4
+#define TEST_ITEMS_PER_PRODUCER	20000
+#define TEST_MPMC_ITEMS			(TEST_PRODUCERS * TEST_ITEMS_PER_PRODUCER)
+
+#define TEST_SPSC_ITEMS			200000
+#define TEST_SPSC_CAPACITY		64
+
+typedef struct TestItem {
+
+	int		nProducer;
+	int		nSeq;			/* per producer, from 0 */
+	int		nCheck;			/* derived from both, catches torn copies */
+
+} TestItem;
+
+#define TEST_ITEM_CHECK(nProducer, nSeq)	((nProducer) * 1000003 + (nSeq) * 7 + 1)
+
+typedef struct TestMpmc {
+
+	CListQueue	queue;
+	atomic_int	anSeen[TEST_MPMC_ITEMS];	/* times each record came out */
+	atomic_int	nRemoved;
+	atomic_int	nErrors;
+	atomic_int	nNextProducer;
+
+} TestMpmc;
+
+static int TestMpmcProducer(void *pArg) {
+
+	TestMpmc *pTest = (TestMpmc *)pArg;
+	TestItem item;
+	int i;
+
+	item.nProducer = atomic_fetch_add(&pTest->nNextProducer, 1);
+
+	for (i = 0; i < TEST_ITEMS_PER_PRODUCER; i++) {
+		item.nSeq = i;
+		item.nCheck = TEST_ITEM_CHECK(item.nProducer, i);
+		while (ListQueueAddTail(&pTest->queue, &item) != 0)
+			thrd_yield();
+	}
+
+	return 0;
+}
+
+static int TestMpmcConsumer(void *pArg) {
+
+	TestMpmc *pTest = (TestMpmc *)pArg;
+	TestItem item;
+	int anLast[TEST_PRODUCERS];
+	int i;
+
+	for (i = 0; i < TEST_PRODUCERS; i++)
+		anLast[i] = -1;
+
+	while (atomic_load(&pTest->nRemoved) < TEST_MPMC_ITEMS) {
+
+		if (ListQueueTryRemoveHead(&pTest->queue, &item) != 0) {
+			thrd_yield();
+			continue;
+		}
+
+		atomic_fetch_add(&pTest->nRemoved, 1);
+
+		if (item.nProducer < 0 || item.nProducer >= TEST_PRODUCERS ||
+				item.nSeq < 0 || item.nSeq >= TEST_ITEMS_PER_PRODUCER ||
+				item.nCheck != TEST_ITEM_CHECK(item.nProducer, item.nSeq)) {
+			atomic_fetch_add(&pTest->nErrors, 1);
+			continue;
+		}
+
+		/* FIFO: one producer's records reach any one consumer in order */
+		if (item.nSeq <= anLast[item.nProducer])
+			atomic_fetch_add(&pTest->nErrors, 1);
+		anLast[item.nProducer] = item.nSeq;
+
+		atomic_fetch_add(&pTest->anSeen[item.nProducer * TEST_ITEMS_PER_PRODUCER + item.nSeq], 1);
+	}
+
+	return 0;
+}
+
+static int TestMpmcRun(void) {
+
+	thrd_t		aThreads[TEST_PRODUCERS + TEST_CONSUMERS];
+	TestMpmc	*pTest;
+	TestItem	item;
+	int			nThreads = 0;
+	int			nResult = 0;
+	int			i;
+
+	pTest = (TestMpmc *)calloc(1, sizeof(TestMpmc));
+	TEST_CHECK(pTest != NULL);
+
+	if (InitListQueue(&pTest->queue, (int)sizeof(TestItem)) != 0) {
+		free(pTest);
+		TEST_CHECK(!"InitListQueue failed");
+	}
+
+	for (i = 0; i < TEST_CONSUMERS; i++) {
+		if (thrd_create(&aThreads[nThreads], TestMpmcConsumer, pTest) == thrd_success)
+			nThreads++;
+	}
+	for (i = 0; i < TEST_PRODUCERS; i++) {
+		if (thrd_create(&aThreads[nThreads], TestMpmcProducer, pTest) == thrd_success)
+			nThreads++;
+	}
+
+	for (i = 0; i < nThreads; i++)
+		thrd_join(aThreads[i], NULL);
+
+	if (nThreads != TEST_PRODUCERS + TEST_CONSUMERS) {
+		fprintf(stderr, "mpmc: could not start the threads\n");
+		nResult = -1;
+	}
+
+	if (nResult == 0 && atomic_load(&pTest->nErrors) != 0) {
+		fprintf(stderr, "mpmc: %d records torn or out of order\n", atomic_load(&pTest->nErrors));
+		nResult = -1;
+	}
+
+	for (i = 0; nResult == 0 && i < TEST_MPMC_ITEMS; i++) {
+		if (atomic_load(&pTest->anSeen[i]) != 1) {
+			fprintf(stderr, "mpmc: record %d of producer %d came out %d times\n",
+					i % TEST_ITEMS_PER_PRODUCER, i / TEST_ITEMS_PER_PRODUCER,
+					atomic_load(&pTest->anSeen[i]));
+			nResult = -1;
+		}
+	}
+
+	if (nResult == 0 && ListQueueTryRemoveHead(&pTest->queue, &item) == 0) {
+		fprintf(stderr, "mpmc: queue not empty at the end\n");
+		nResult = -1;
+	}
+
+	DestroyListQueue(&pTest->queue);
+	free(pTest);
+
+	return nResult;
+}
+
+typedef struct TestSpsc {
+
+	CListSpscQueue	queue;
+	int				nErrors;		/* consumer thread only */
+
+} TestSpsc;
+
+static int TestSpscProducer(void *pArg) {
+
+	TestSpsc *pTest = (TestSpsc *)pArg;
+	TestItem item;
+	int i;
+
+	item.nProducer = 0;
+
+	for (i = 0; i < TEST_SPSC_ITEMS; i++) {
+		item.nSeq = i;
+		item.nCheck = TEST_ITEM_CHECK(0, i);
+		while (ListSpscQueueAddTail(&pTest->queue, &item) != 0)
+			thrd_yield();
+	}
+
+	return 0;
+}
+
+static int TestSpscConsumer(void *pArg) {
+
+	TestSpsc *pTest = (TestSpsc *)pArg;
+	TestItem item;
+	int i;
+
+	for (i = 0; i < TEST_SPSC_ITEMS; i++) {
+
+		while (ListSpscQueueTryRemoveHead(&pTest->queue, &item) != 0)
+			thrd_yield();
+
+		if (item.nSeq != i || item.nCheck != TEST_ITEM_CHECK(0, i))
+			pTest->nErrors++;
+	}
+
+	return 0;
+}
+
+static int TestSpscRun(void) {
+
+	TestSpsc	test;
+	thrd_t		producer;
+	thrd_t		consumer;
+	TestItem	item;
+
+	memset(&test, 0, sizeof(test));
+	TEST_CHECK(InitListSpscQueue(&test.queue, (int)sizeof(TestItem), TEST_SPSC_CAPACITY) == 0);
+
+	TEST_CHECK(thrd_create(&consumer, TestSpscConsumer, &test) == thrd_success);
+	TEST_CHECK(thrd_create(&producer, TestSpscProducer, &test) == thrd_success);
+
+	thrd_join(producer, NULL);
+	thrd_join(consumer, NULL);
+
+	TEST_CHECK(test.nErrors == 0);
+	TEST_CHECK(ListSpscQueueGetCount(&test.queue) == 0);
+	TEST_CHECK(ListSpscQueueTryRemoveHead(&test.queue, &item) == -1);
+
+	DestroyListSpscQueue(&test.queue);
+
+	return 0;
+}
+
+int main(void) {
+
+	int nFailed = 0;
+
+	if (TestMpmcRun() != 0) {
+		fprintf(stderr, "mpmc: failed\n");
+		nFailed++;
+	}
+
+	if (TestSpscRun() != 0) {
+		fprintf(stderr, "spsc: failed\n");
+		nFailed++;
+	}
+
+	if (nFailed == 0)
+		printf("clist_queue_test: mpmc and spsc passed\n");
+
+	return (nFailed == 0) ? 0 : 1;
+}
@@ -0,0 +1,394 @@
+/******************************************************************************
+    clist_stats_test: the CLIST_STATS counters of every storage.
+
+    storages: each storage and allocator mode takes random adds, inserts,
+    removes, SetAt and FindIndex calls while its counters are checked
+    against what the list holds: nPayloadBytes is nCount elements,
+    nNodeBytes the rest of nHeldBytes, nPeakCount the largest nCount seen.
+    After DestroyList every allocation must have been freed and no bytes
+    may be held.
+
+    global: ListGetGlobalStats balances the same way once all the lists
+    are gone, and ListDumpStats writes its line.
+
+    Built against a copy of the library compiled with CLIST_STATS unless
+    the build already has -DCLIST_STATS=ON.
+
+    usage: clist_stats_test [seed]
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "list.h"
+#include "list_alloc.h"
+#include "test.h"
+
+#ifndef CLIST_STATS
+#error "clist_stats_test needs a library built with CLIST_STATS"
+#endif
+
+#define TEST_STEPS			3000
+#define TEST_MAX_LENGTH		200
+
+typedef struct TestRecord {
+
+	int		nKey;
+	int		nSeq;
+	char	acFill[24];
+
+} TestRecord;
+
+typedef struct TestMode {
+
+	const char	*pszName;
+	int			(*Init)(CList *pList);
+	int			bWalks;			/* FindIndex follows links, counts steps */
+
+} TestMode;
+
+/* by-reference lists point into this */
+static TestRecord		g_aRecords[TEST_STEPS];
+
+static CListFixedPool	g_fixedPool;
+static CListArena		g_arena;
+
+/*-----------------------------------------------------------------------------
+ * modes
+ * --------------------------------------------------------------------------*/
+static int TestInitNode(CList *pList) {
+
+	InitList(pList, (int)sizeof(TestRecord));
+	return 0;
+}
+
+static int TestInitPool(CList *pList) {
+
+	return InitListWithCapacity(pList, (int)sizeof(TestRecord), 32);
+}
+
+static int TestInitFixedPool(CList *pList) {
+
+	return InitListWithAllocator(pList, (int)sizeof(TestRecord),
+			ListFixedPoolAlloc, ListFixedPoolFree, &g_fixedPool);
+}
+
+static int TestInitArenaAllocator(CList *pList) {
+
+	return InitListWithAllocator(pList, (int)sizeof(TestRecord),
+			ListArenaAlloc, ListArenaFree, &g_arena);
+}
+
+static int TestInitArena(CList *pList) {
+
+	return InitListWithArena(pList, (int)sizeof(TestRecord), 0);
+}
+
+static int TestInitIndexed(CList *pList) {
+
+	InitList(pList, (int)sizeof(TestRecord));
+	return ListEnableIndex(pList);
+}
+
+static int TestInitHashed(CList *pList) {
+
+	InitList(pList, (int)sizeof(TestRecord));
+	return ListEnableHashIndex(pList, (int)offsetof(TestRecord, nSeq), (int)sizeof(int), NULL);
+}
+
+static int TestInitByRef(CList *pList) {
+
+	InitListByRef(pList);
+	return 0;
+}
+
+static int TestInitSized(CList *pList) {
+
+	return InitListSized(pList, (int)sizeof(TestRecord));
+}
+
+static int TestInitChunk(CList *pList) {
+
+	return InitListStorage(pList, (int)sizeof(TestRecord), LIST_STORAGE_CHUNK);
+}
+
+static int TestInitRing(CList *pList) {
+
+	return InitListRing(pList, (int)sizeof(TestRecord), 0);
+}
+
+static int TestInitCompact(CList *pList) {
+
+	return InitListCompact(pList, (int)sizeof(TestRecord), 0);
+}
+
+static int TestInitDeque(CList *pList) {
+
+	return InitListStorage(pList, (int)sizeof(TestRecord), LIST_STORAGE_DEQUE);
+}
+
+static const TestMode g_aModes[] = {
+
+	{ "node",			TestInitNode,			1 },
+	{ "pool",			TestInitPool,			1 },
+	{ "fixed_pool",		TestInitFixedPool,		1 },
+	{ "arena_alloc",	TestInitArenaAllocator,	1 },
+	{ "arena",			TestInitArena,			1 },
+	{ "indexed",		TestInitIndexed,		1 },
+	{ "hashed",			TestInitHashed,			1 },
+	{ "by_ref",			TestInitByRef,			1 },
+	{ "sized",			TestInitSized,			1 },
+	{ "chunk",			TestInitChunk,			1 },
+	{ "ring",			TestInitRing,			0 },
+	{ "compact",		TestInitCompact,		1 },
+	{ "deque",			TestInitDeque,			0 }
+};
+
+/*-----------------------------------------------------------------------------
+ * checks
+ * --------------------------------------------------------------------------*/
+/* the counters of a live list agree with what it holds */
+static int TestCheckLive(CList *pList, int nPeakCount) {
+
+	CListStats stats;
+
+	TEST_CHECK(ListGetStats(pList, &stats) == 0);
+	TEST_CHECK(stats.nAllocs >= stats.nFrees);
+	TEST_CHECK(stats.nFailedAllocs == 0);
+	TEST_CHECK(stats.nPayloadBytes == (long long)ListGetCount(pList) * pList->nMaxDataSize);
+	TEST_CHECK(stats.nNodeBytes == stats.nHeldBytes - stats.nPayloadBytes);
+	TEST_CHECK(stats.nNodeBytes >= 0);
+	TEST_CHECK(stats.nPeakCount == nPeakCount);
+
+	return 0;
+}
+
+/* everything the list allocated went back */
+static int TestCheckDestroyed(CList *pList) {
+
+	CListStats stats;
+
+	TEST_CHECK(ListGetStats(pList, &stats) == 0);
+	TEST_CHECK(stats.nAllocs > 0);
+	TEST_CHECK(stats.nAllocs == stats.nFrees);
+	TEST_CHECK(stats.nHeldBytes == 0);
+	TEST_CHECK(stats.nPayloadBytes == 0);
+	TEST_CHECK(stats.nNodeBytes == 0);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * storages
+ * --------------------------------------------------------------------------*/
+static int TestStep(CList *pList, int nStep, unsigned int *pnRand) {
+
+	TestRecord	*pRecord = &g_aRecords[nStep];
+	const void	*pData = pRecord;
+	POSITION	pos;
+	int			nCount = ListGetCount(pList);
+	int			nIndex = (nCount > 0) ? (int)(TestRand(pnRand) % (unsigned int)nCount) : 0;
+	int			nOp = (int)(TestRand(pnRand) % 7);
+
+	/* by-reference lists store the pointer itself */
+	if (pList->nMaxDataSize != (int)sizeof(TestRecord))
+		pData = &pRecord;
+
+	if (nOp <= 2 && nCount >= TEST_MAX_LENGTH)
+		nOp = 3;
+	if (nCount == 0)
+		nOp = 0;
+
+	switch (nOp) {
+
+	case 0:
+		TEST_CHECK(ListAddTail(pList, pData) != NULL);
+		break;
+
+	case 1:
+		TEST_CHECK(ListAddHead(pList, pData) != NULL);
+		break;
+
+	case 2:
+		TEST_CHECK(ListInsertNext(pList, ListFindIndex(pList, nIndex), pData) != NULL);
+		break;
+
+	case 3:
+		TEST_CHECK(ListRemoveAt(pList, ListFindIndex(pList, nIndex)) == 0);
+		break;
+
+	case 4:
+		pos = ListFindIndex(pList, nIndex);
+		TEST_CHECK(pos != NULL && ListSetAt(pList, pos, pData) == 0);
+		break;
+
+	case 5:
+		TEST_CHECK(ListRemoveHead(pList) == 0);
+		break;
+
+	case 6:
+		if (TestRand(pnRand) % 32 == 0)
+			TEST_CHECK(ListRemoveAll(pList) == 0);
+		break;
+	}
+
+	return 0;
+}
+
+static int TestRunMode(const TestMode *pMode, unsigned int nSeed) {
+
+	CList		list;
+	CListStats	stats;
+	unsigned int	nRand = nSeed;
+	int			nPeakCount = 0;
+	int			nResult = 0;
+	int			nStep;
+
+	InitListFixedPool(&g_fixedPool, 0, 0);
+	InitListArena(&g_arena, 0);
+
+	if (pMode->Init(&list) != 0) {
+		fprintf(stderr, "%s: init failed\n", pMode->pszName);
+		return -1;
+	}
+
+	for (nStep = 0; nStep < TEST_STEPS && nResult == 0; nStep++) {
+
+		nResult = TestStep(&list, nStep, &nRand);
+
+		if (ListGetCount(&list) > nPeakCount)
+			nPeakCount = ListGetCount(&list);
+
+		if (nResult == 0)
+			nResult = TestCheckLive(&list, nPeakCount);
+	}
+
+	/* ring and deque find an index by arithmetic, the others walk */
+	if (nResult == 0 && pMode->bWalks && ListGetCount(&list) > 4) {
+		ListFindIndex(&list, ListGetCount(&list) / 2);
+		if (ListGetStats(&list, &stats) != 0 || stats.nFindIndexSteps == 0) {
+			fprintf(stderr, "%s: no FindIndex steps counted\n", pMode->pszName);
+			nResult = -1;
+		}
+	}
+
+	if (nResult != 0)
+		fprintf(stderr, "%s: failed at step %d (seed %u)\n", pMode->pszName, nStep - 1, nSeed);
+
+	DestroyList(&list);
+
+	if (nResult == 0 && TestCheckDestroyed(&list) != 0) {
+		fprintf(stderr, "%s: storage left after DestroyList\n", pMode->pszName);
+		nResult = -1;
+	}
+
+	DestroyListFixedPool(&g_fixedPool);
+	DestroyListArena(&g_arena);
+
+	return nResult;
+}
+
+/* a snapshot mapped with InitListMapped is held until DestroyList */
+static int TestMapped(void) {
+
+	CList	list;
+	CList	mapped;
+	FILE	*pFile;
+	int		i;
+
+	InitList(&list, (int)sizeof(TestRecord));
+	for (i = 0; i < 100; i++)
+		TEST_CHECK(ListAddTail(&list, &g_aRecords[i]) != NULL);
+
+	pFile = tmpfile();
+	TEST_CHECK(pFile != NULL);
+	TEST_CHECK(SaveList(&list, fileno(pFile)) == 0);
+	DestroyList(&list);
+	TEST_CHECK(TestCheckDestroyed(&list) == 0);
+
+	TEST_CHECK(InitListMapped(&mapped, fileno(pFile)) == 0);
+	fclose(pFile);
+	TEST_CHECK(ListGetCount(&mapped) == 100);
+	TEST_CHECK(TestCheckLive(&mapped, 100) == 0);
+	DestroyList(&mapped);
+	TEST_CHECK(TestCheckDestroyed(&mapped) == 0);
+
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+ * global counters
+ * --------------------------------------------------------------------------*/
+static int TestGlobal(const CListStats *pBefore) {
+
+	CListStats	stats;
+	FILE		*pFile;
+	char		acLine[256];
+
+	TEST_CHECK(ListGetGlobalStats(&stats) == 0);
+	TEST_CHECK(stats.nAllocs > pBefore->nAllocs);
+	TEST_CHECK(stats.nAllocs - pBefore->nAllocs == stats.nFrees - pBefore->nFrees);
+	TEST_CHECK(stats.nHeldBytes == pBefore->nHeldBytes);
+	TEST_CHECK(stats.nFailedAllocs == pBefore->nFailedAllocs);
+	TEST_CHECK(stats.nPeakCount >= 100);			/* TestMapped's list at least */
+	TEST_CHECK(stats.nFindIndexSteps > pBefore->nFindIndexSteps);
+	TEST_CHECK(stats.nPayloadBytes == -1 && stats.nNodeBytes == -1);
+
+	pFile = tmpfile();
+	TEST_CHECK(pFile != NULL);
+	TEST_CHECK(ListDumpStats(pFile) == 0);
+	rewind(pFile);
+	TEST_CHECK(fgets(acLine, sizeof(acLine), pFile) != NULL);
+	fclose(pFile);
+	TEST_CHECK(strncmp(acLine, "clist stats: allocs=", 20) == 0);
+	TEST_CHECK(strstr(acLine, " held_bytes=") != NULL);
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	CListStats	before;
+	unsigned int nSeed = 1;
+	int nFailed = 0;
+	size_t i;
+
+	if (argc > 1)
+		nSeed = (unsigned int)strtoul(argv[1], NULL, 10);
+
+	for (i = 0; i < TEST_STEPS; i++) {
+		g_aRecords[i].nKey = (int)(i % 16);
+		g_aRecords[i].nSeq = (int)i;
+		memset(g_aRecords[i].acFill, (int)i, sizeof(g_aRecords[i].acFill));
+	}
+
+	if (ListGetGlobalStats(&before) != 0) {
+		fprintf(stderr, "global: ListGetGlobalStats failed\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(g_aModes) / sizeof(g_aModes[0]); i++) {
+		if (TestRunMode(&g_aModes[i], nSeed) != 0)
+			nFailed++;
+	}
+
+	if (TestMapped() != 0) {
+		fprintf(stderr, "mapped: failed\n");
+		nFailed++;
+	}
+
+	if (TestGlobal(&before) != 0) {
+		fprintf(stderr, "global: failed\n");
+		nFailed++;
+	}
+
+	if (nFailed == 0)
+		printf("clist_stats_test: %d storages, mapped and global counters passed (seed %u)\n",
+				(int)(sizeof(g_aModes) / sizeof(g_aModes[0])), nSeed);
+
+	return (nFailed == 0) ? 0 : 1;
+}
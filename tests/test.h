@@ -0,0 +1,28 @@
+/******************************************************************************
+    Shared helpers of the clist tests. Every test is one executable that
+    returns 0 when all of its checks held; ctest runs them.
+******************************************************************************/
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+/* report a failed condition and leave the calling function with -1 */
+#define TEST_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			return -1; \
+		} \
+	} while (0)
+
+/* small deterministic generator, the same sequence on every platform */
+static inline unsigned int TestRand(unsigned int *pnState) {
+
+	*pnState = *pnState * 1103515245u + 12345u;
+
+	return (*pnState >> 16) & 0x7fff;
+}
+
+#endif
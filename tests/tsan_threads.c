@@ -0,0 +1,184 @@
+/******************************************************************************
+    C11 threads on top of pthreads, linked into the tests only when they are
+    built with -DCLIST_SANITIZE=thread.
+
+    glibc implements thrd_create, mtx_lock, cnd_wait, ... by calling its
+    internal pthread functions directly, so a ThreadSanitizer runtime that
+    intercepts only the public pthread calls (GCC 12's does) never sees the
+    threads start or synchronize and crashes in the first new thread. The
+    definitions here take precedence over the ones in libc and forward to
+    the intercepted pthread calls; the C11 types of glibc have the layout of
+    the pthread ones they stand for.
+******************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <threads.h>
+
+typedef struct TsanThreadStart {
+
+	thrd_start_t	func;
+	void			*pArg;
+
+} TsanThreadStart;
+
+static int TsanResult(int nError) {
+
+	if (nError == 0)
+		return thrd_success;
+
+	if (nError == ENOMEM)
+		return thrd_nomem;
+
+	if (nError == EBUSY)
+		return thrd_busy;
+
+	return thrd_error;
+}
+
+static void* TsanThreadRun(void *pArg) {
+
+	TsanThreadStart start = *(TsanThreadStart *)pArg;
+
+	free(pArg);
+
+	return (void *)(intptr_t)start.func(start.pArg);
+}
+
+/* threads */
+int thrd_create(thrd_t *thr, thrd_start_t func, void *arg) {
+
+	TsanThreadStart *pStart;
+	int nError;
+
+	pStart = (TsanThreadStart *)malloc(sizeof(TsanThreadStart));
+
+	if (pStart == NULL)
+		return thrd_nomem;
+
+	pStart->func = func;
+	pStart->pArg = arg;
+
+	nError = pthread_create((pthread_t *)thr, NULL, TsanThreadRun, pStart);
+
+	if (nError != 0)
+		free(pStart);
+
+	return TsanResult(nError);
+}
+
+int thrd_join(thrd_t thr, int *res) {
+
+	void *pResult;
+	int nError;
+
+	nError = pthread_join((pthread_t)thr, &pResult);
+
+	if (nError == 0 && res != NULL)
+		*res = (int)(intptr_t)pResult;
+
+	return TsanResult(nError);
+}
+
+int thrd_detach(thrd_t thr) {
+
+	return TsanResult(pthread_detach((pthread_t)thr));
+}
+
+void thrd_yield(void) {
+
+	sched_yield();
+}
+
+/* mutexes and condition variables */
+int mtx_init(mtx_t *mutex, int type) {
+
+	pthread_mutexattr_t attr;
+	int nError;
+
+	if (pthread_mutexattr_init(&attr) != 0)
+		return thrd_error;
+
+	if (type & mtx_recursive)
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+	nError = pthread_mutex_init((pthread_mutex_t *)mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	return TsanResult(nError);
+}
+
+int mtx_lock(mtx_t *mutex) {
+
+	return TsanResult(pthread_mutex_lock((pthread_mutex_t *)mutex));
+}
+
+int mtx_trylock(mtx_t *mutex) {
+
+	return TsanResult(pthread_mutex_trylock((pthread_mutex_t *)mutex));
+}
+
+int mtx_unlock(mtx_t *mutex) {
+
+	return TsanResult(pthread_mutex_unlock((pthread_mutex_t *)mutex));
+}
+
+void mtx_destroy(mtx_t *mutex) {
+
+	pthread_mutex_destroy((pthread_mutex_t *)mutex);
+}
+
+int cnd_init(cnd_t *cond) {
+
+	return TsanResult(pthread_cond_init((pthread_cond_t *)cond, NULL));
+}
+
+int cnd_wait(cnd_t *cond, mtx_t *mutex) {
+
+	return TsanResult(pthread_cond_wait((pthread_cond_t *)cond,
+			(pthread_mutex_t *)mutex));
+}
+
+int cnd_signal(cnd_t *cond) {
+
+	return TsanResult(pthread_cond_signal((pthread_cond_t *)cond));
+}
+
+int cnd_broadcast(cnd_t *cond) {
+
+	return TsanResult(pthread_cond_broadcast((pthread_cond_t *)cond));
+}
+
+void cnd_destroy(cnd_t *cond) {
+
+	pthread_cond_destroy((pthread_cond_t *)cond);
+}
+
+/* one-time initialization and thread-specific storage */
+void call_once(once_flag *flag, void (*func)(void)) {
+
+	pthread_once((pthread_once_t *)flag, func);
+}
+
+int tss_create(tss_t *key, tss_dtor_t dtor) {
+
+	return TsanResult(pthread_key_create((pthread_key_t *)key, dtor));
+}
+
+void* tss_get(tss_t key) {
+
+	return pthread_getspecific((pthread_key_t)key);
+}
+
+int tss_set(tss_t key, void *val) {
+
+	return TsanResult(pthread_setspecific((pthread_key_t)key, val));
+}
+
+void tss_delete(tss_t key) {
+
+	pthread_key_delete((pthread_key_t)key);
+}